@@ -0,0 +1,366 @@
+#include "beeper.h"
+#include "periodicscheduler.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+// 队列上限：请求风暴时最多积压这么多条不同的提示音
+static const size_t kMaxQueued = 8;
+
+// 按键音排队超过该时间后已无反馈意义，直接丢弃
+static const qint64 kClickExpireNs = 250 * 1000000LL;
+
+// 两条提示音之间至少间隔，避免连续的短音粘成一声
+static const qint64 kMinGapNs = 20 * 1000000LL;
+
+// SCHED_FIFO 优先级：低于 PeriodicScheduler（40）
+static const int kBeeperPriority = 30;
+
+Beeper *Beeper::instance()
+{
+    static Beeper *s_instance = nullptr;
+    if (!s_instance) {
+        s_instance = new Beeper("/dev/beep", QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+Beeper::Beeper(const QString &devicePath, QObject *parent)
+    : QObject(parent)
+    , m_devicePath(devicePath)
+    , m_thread(nullptr)
+    , m_deviceFd(-1)
+    , m_timerFd(-1)
+    , m_wakeFd(-1)
+    , m_quit(false)
+    , m_enabled(true)
+    , m_stopRequested(false)
+    , m_playing(false)
+    , m_remaining(0)
+    , m_outputOn(false)
+    , m_nextEdgeNs(0)
+{
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_timerFd < 0 || m_wakeFd < 0) {
+        qDebug() << "Beeper: failed to create timerfd/eventfd, errno" << errno;
+    }
+
+    // 设备在定时线程中打开，构造函数不访问硬件
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("Beeper");
+    m_thread->start();
+}
+
+Beeper::~Beeper()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+    }
+    wakeThread();
+    m_thread->wait();
+    delete m_thread;
+
+    if (m_timerFd >= 0) {
+        ::close(m_timerFd);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+bool Beeper::play(const Pattern &pattern, Priority priority)
+{
+    if (pattern.onMs <= 0 || pattern.repeat <= 0) {
+        return false;
+    }
+
+    qint64 now = PeriodicScheduler::nowNs();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.requests++;
+
+        if (!m_enabled) {
+            return false;
+        }
+
+        // 同样的提示音正在响，再排一条没有意义
+        if (m_playing && m_remaining > 0 && m_current.priority == priority
+                && m_current.pattern == pattern) {
+            m_stats.coalesced++;
+            return false;
+        }
+        for (const Request &queued : m_queue) {
+            if (queued.priority == priority && queued.pattern == pattern) {
+                m_stats.coalesced++;
+                return false;
+            }
+        }
+
+        // 队列满时挤掉优先级最低、最晚到达的一条（队尾）
+        if (m_queue.size() >= kMaxQueued) {
+            if (m_queue.back().priority >= priority) {
+                m_stats.dropped++;
+                return false;
+            }
+            m_queue.pop_back();
+            m_stats.dropped++;
+        }
+
+        Request request;
+        request.pattern = pattern;
+        request.priority = priority;
+        request.queuedNs = now;
+        request.expireNs = (priority == ClickPriority) ? now + kClickExpireNs : 0;
+
+        // 插到第一条优先级更低的请求之前，同优先级保持先进先出
+        std::deque<Request>::iterator it = m_queue.begin();
+        while (it != m_queue.end() && it->priority >= priority) {
+            ++it;
+        }
+        m_queue.insert(it, request);
+    }
+    wakeThread();
+    return true;
+}
+
+void Beeper::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.clear();
+        m_stopRequested = true;
+    }
+    wakeThread();
+}
+
+void Beeper::setEnabled(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_enabled = enabled;
+    }
+    if (!enabled) {
+        stop();
+    }
+}
+
+bool Beeper::isEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_enabled;
+}
+
+bool Beeper::isAvailable() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deviceFd >= 0;
+}
+
+Beeper::Stats Beeper::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void Beeper::wakeThread()
+{
+    if (m_wakeFd >= 0) {
+        quint64 one = 1;
+        ssize_t ret = ::write(m_wakeFd, &one, sizeof(one));
+        Q_UNUSED(ret);
+    }
+}
+
+void Beeper::armTimer(qint64 deadlineNs)
+{
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = 0;
+    // deadlineNs 为 0 时解除定时器
+    deadlineNs = qMax<qint64>(deadlineNs, 0);
+    spec.it_value.tv_sec = time_t(deadlineNs / 1000000000LL);
+    spec.it_value.tv_nsec = long(deadlineNs % 1000000000LL);
+    timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void Beeper::setOutput(bool on)
+{
+    // 调用方持有 m_mutex；驱动接收一个字节，1 响 0 停
+    m_outputOn = on;
+    if (m_deviceFd < 0) {
+        return;
+    }
+
+    unsigned char value = on ? 1 : 0;
+    ssize_t n;
+    do {
+        n = ::write(m_deviceFd, &value, 1);
+    } while (n < 0 && errno == EINTR);
+    if (n != 1) {
+        m_stats.writeErrors++;
+    }
+}
+
+void Beeper::startNext(qint64 now)
+{
+    // 调用方持有 m_mutex；先丢掉过期的按键音
+    for (std::deque<Request>::iterator it = m_queue.begin(); it != m_queue.end(); ) {
+        if (it->expireNs > 0 && it->expireNs < now) {
+            it = m_queue.erase(it);
+            m_stats.dropped++;
+        } else {
+            ++it;
+        }
+    }
+    if (m_queue.empty()) {
+        return;
+    }
+
+    m_current = m_queue.front();
+    m_queue.pop_front();
+    m_playing = true;
+    m_remaining = m_current.pattern.repeat;
+    m_stats.maxStartDelayNs = qMax(m_stats.maxStartDelayNs, now - m_current.queuedNs);
+
+    setOutput(true);
+    m_nextEdgeNs = now + qint64(m_current.pattern.onMs) * 1000000LL;
+}
+
+void Beeper::advance(qint64 now)
+{
+    // 调用方持有 m_mutex；边沿时间按计划值累加，不随唤醒延迟漂移
+    while (m_playing && m_nextEdgeNs <= now) {
+        m_stats.maxEdgeLatencyNs = qMax(m_stats.maxEdgeLatencyNs, now - m_nextEdgeNs);
+
+        if (m_outputOn) {
+            setOutput(false);
+            m_remaining--;
+            qint64 offNs = qint64(m_current.pattern.offMs) * 1000000LL;
+            if (m_remaining <= 0) {
+                // 最后一声之后保留间隔，再开始下一条
+                offNs = qMax(offNs, kMinGapNs);
+            }
+            m_nextEdgeNs += offNs;
+        } else if (m_remaining > 0) {
+            setOutput(true);
+            m_nextEdgeNs += qint64(m_current.pattern.onMs) * 1000000LL;
+        } else {
+            finishCurrent();
+        }
+    }
+}
+
+void Beeper::finishCurrent()
+{
+    m_playing = false;
+    m_stats.played++;
+}
+
+void Beeper::threadLoop()
+{
+    struct sched_param param;
+    param.sched_priority = kBeeperPriority;
+    bool realtime = (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0);
+
+    // 设备一直保持打开，每次翻转只有一次 write
+    int fd;
+    do {
+        fd = ::open(m_devicePath.toLocal8Bit().constData(), O_WRONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_deviceFd = fd;
+        setOutput(false);
+    }
+    if (fd < 0) {
+        qDebug() << "Beeper: cannot open" << m_devicePath << "errno" << errno;
+    }
+    qDebug() << "Beeper started, SCHED_FIFO:" << realtime;
+
+    struct pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_quit) {
+                break;
+            }
+
+            qint64 now = PeriodicScheduler::nowNs();
+
+            if (m_stopRequested) {
+                m_stopRequested = false;
+                if (m_playing) {
+                    setOutput(false);
+                    m_playing = false;
+                }
+            }
+
+            // 更高优先级的请求到达时立即打断（间隔阶段被打断不算）
+            if (m_playing && !m_queue.empty() && m_queue.front().priority > m_current.priority) {
+                if (m_outputOn) {
+                    setOutput(false);
+                }
+                if (m_remaining > 0) {
+                    m_stats.preempted++;
+                } else {
+                    m_stats.played++;
+                }
+                m_playing = false;
+            }
+
+            if (m_playing) {
+                advance(now);
+            }
+            if (!m_playing) {
+                startNext(now);
+            }
+
+            armTimer(m_playing ? m_nextEdgeNs : 0);
+        }
+
+        int ret = ::poll(fds, 2, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qDebug() << "Beeper: poll failed, errno" << errno;
+            break;
+        }
+
+        quint64 value;
+        if (fds[1].revents & POLLIN) {
+            ssize_t n = ::read(m_wakeFd, &value, sizeof(value));
+            Q_UNUSED(n);
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t n = ::read(m_timerFd, &value, sizeof(value));
+            Q_UNUSED(n);
+        }
+    }
+
+    // 退出时确保蜂鸣器关闭
+    QMutexLocker locker(&m_mutex);
+    if (m_deviceFd >= 0) {
+        setOutput(false);
+        ::close(m_deviceFd);
+        m_deviceFd = -1;
+    }
+}
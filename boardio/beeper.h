@@ -0,0 +1,119 @@
+#ifndef BEEPER_H
+#define BEEPER_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <deque>
+
+class QThread;
+
+/**
+ * @brief 蜂鸣器服务（alientek,beep，/dev/beep）
+ *
+ * 提示音由“响/停时长 + 重复次数”描述，在专用的定时线程中用 timerfd 按绝对时间
+ * 翻转蜂鸣器，设备 fd 常开，调用方线程不会 sleep 或阻塞。
+ *
+ * - 请求带优先级：更高优先级的请求立即打断正在播放的低优先级提示音
+ * - 与正在播放或排队中的同类请求（同一模式、同一优先级）直接合并
+ * - 队列有上限，满时丢弃最低优先级的请求；按键音排队过久会过期丢弃
+ */
+class Beeper : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        ClickPriority = 0,      // 按键/点击反馈
+        NotifyPriority,         // 普通提示
+        AlarmPriority           // 告警、错误
+    };
+
+    // 提示音模式：响 onMs，停 offMs，共 repeat 次
+    struct Pattern {
+        int onMs;
+        int offMs;
+        int repeat;
+
+        bool operator==(const Pattern &other) const {
+            return onMs == other.onMs && offMs == other.offMs && repeat == other.repeat;
+        }
+    };
+
+    struct Stats {
+        quint64 requests = 0;       // 收到的请求数
+        quint64 played = 0;         // 完整播放的请求数
+        quint64 coalesced = 0;      // 被合并的请求数
+        quint64 dropped = 0;        // 队列满或过期丢弃的请求数
+        quint64 preempted = 0;      // 被高优先级打断的请求数
+        quint64 writeErrors = 0;    // 设备写失败次数
+        qint64 maxStartDelayNs = 0; // 请求到开始发声的最大延迟
+        qint64 maxEdgeLatencyNs = 0;// 翻转时刻相对计划时刻的最大延迟
+    };
+
+    static Beeper *instance();
+
+    // 常用模式
+    static Pattern clickPattern()  { return Pattern{ 15, 0, 1 }; }
+    static Pattern notifyPattern() { return Pattern{ 80, 80, 2 }; }
+    static Pattern alarmPattern()  { return Pattern{ 200, 150, 3 }; }
+
+    // 非阻塞，返回 false 表示请求被合并或丢弃
+    bool play(const Pattern &pattern, Priority priority = NotifyPriority);
+
+    void click() { play(clickPattern(), ClickPriority); }
+    void alarm() { play(alarmPattern(), AlarmPriority); }
+
+    // 停止当前提示音并清空队列
+    void stop();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // 设备是否成功打开
+    bool isAvailable() const;
+
+    Stats stats() const;
+
+private:
+    explicit Beeper(const QString &devicePath, QObject *parent = nullptr);
+    ~Beeper();
+
+    struct Request {
+        Pattern pattern;
+        Priority priority;
+        qint64 queuedNs;
+        qint64 expireNs;        // 0 表示不过期
+    };
+
+    void threadLoop();
+    void wakeThread();
+    void armTimer(qint64 deadlineNs);
+    void setOutput(bool on);
+    void startNext(qint64 now);
+    void advance(qint64 now);
+    void finishCurrent();
+
+    QString m_devicePath;
+    QThread *m_thread;
+    int m_deviceFd;
+    int m_timerFd;
+    int m_wakeFd;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    bool m_quit;
+    bool m_enabled;
+    bool m_stopRequested;
+    std::deque<Request> m_queue;    // 按优先级从高到低，同优先级先进先出
+
+    bool m_playing;
+    Request m_current;
+    int m_remaining;                // 当前请求剩余的响声次数（含正在进行的一次）
+    bool m_outputOn;
+    qint64 m_nextEdgeNs;
+
+    Stats m_stats;
+};
+
+#endif // BEEPER_H
@@ -0,0 +1,214 @@
+#include "boardclock.h"
+#include <QCoreApplication>
+#include <limits>
+
+static BoardClock *s_clock = nullptr;
+
+BoardClock *BoardClock::instance()
+{
+    if (!s_clock) {
+        static SystemClock s_systemClock;
+        s_clock = &s_systemClock;
+    }
+    return s_clock;
+}
+
+void BoardClock::setInstance(BoardClock *clock)
+{
+    s_clock = clock;
+}
+
+// ====== SystemClock ======
+
+/**
+ * @brief 由 PeriodicScheduler 驱动的定时器
+ */
+class SchedulerTimer : public BoardTimer
+{
+public:
+    SchedulerTimer(const QString &name, QObject *parent)
+        : BoardTimer(parent)
+        , m_name(name)
+        , m_job(-1)
+        , m_intervalNs(0)
+    {
+    }
+
+    ~SchedulerTimer()
+    {
+        stop();
+    }
+
+    void start(qint64 intervalNs) override
+    {
+        stop();
+        m_intervalNs = intervalNs;
+        m_job = PeriodicScheduler::instance()->addJob(m_name, intervalNs,
+            [this](qint64 deadlineNs, quint64 missed) {
+                Q_UNUSED(missed);
+                emit timeout(deadlineNs);
+            });
+    }
+
+    void stop() override
+    {
+        // removeJob 返回后不会再发出 timeout
+        if (m_job >= 0) {
+            PeriodicScheduler::instance()->removeJob(m_job);
+            m_job = -1;
+        }
+    }
+
+    bool isActive() const override { return m_job >= 0; }
+    qint64 interval() const override { return m_intervalNs; }
+
+    PeriodicScheduler::JobStats stats() const override
+    {
+        return m_job >= 0 ? PeriodicScheduler::instance()->stats(m_job)
+                          : PeriodicScheduler::JobStats();
+    }
+
+private:
+    QString m_name;
+    int m_job;
+    qint64 m_intervalNs;
+};
+
+qint64 SystemClock::nowNs() const
+{
+    return PeriodicScheduler::nowNs();
+}
+
+BoardTimer *SystemClock::createTimer(const QString &name, QObject *parent)
+{
+    return new SchedulerTimer(name, parent);
+}
+
+// ====== SimulatedClock ======
+
+/**
+ * @brief 由 SimulatedClock::advance() 驱动的定时器
+ */
+class SimulatedTimer : public BoardTimer
+{
+public:
+    SimulatedTimer(SimulatedClock *clock, QObject *parent)
+        : BoardTimer(parent)
+        , m_clock(clock)
+        , m_active(false)
+        , m_intervalNs(0)
+        , m_nextDeadlineNs(0)
+    {
+    }
+
+    ~SimulatedTimer()
+    {
+        if (m_clock) {
+            m_clock->unregisterTimer(this);
+        }
+    }
+
+    void start(qint64 intervalNs) override
+    {
+        if (intervalNs <= 0) {
+            return;
+        }
+        m_active = true;
+        m_intervalNs = intervalNs;
+        m_nextDeadlineNs = m_clock->nowNs() + intervalNs;
+        m_stats = PeriodicScheduler::JobStats();
+        m_stats.periodNs = intervalNs;
+    }
+
+    void stop() override { m_active = false; }
+    bool isActive() const override { return m_active; }
+    qint64 interval() const override { return m_intervalNs; }
+    PeriodicScheduler::JobStats stats() const override { return m_stats; }
+
+    void fire()
+    {
+        qint64 deadline = m_nextDeadlineNs;
+        m_nextDeadlineNs += m_intervalNs;
+
+        // 仿真时间没有唤醒误差，实际周期恒等于设定周期
+        m_stats.runs++;
+        m_stats.meanPeriodNs = m_intervalNs;
+        m_stats.minPeriodNs = m_intervalNs;
+        m_stats.maxPeriodNs = m_intervalNs;
+
+        emit timeout(deadline);
+    }
+
+    SimulatedClock *m_clock;
+    bool m_active;
+    qint64 m_intervalNs;
+    qint64 m_nextDeadlineNs;
+    PeriodicScheduler::JobStats m_stats;
+};
+
+SimulatedClock::SimulatedClock(qint64 startNs)
+    : m_nowNs(startNs)
+{
+}
+
+SimulatedClock::~SimulatedClock()
+{
+    // 定时器可能比时钟活得久，断开它们的反向引用
+    for (SimulatedTimer *timer : m_timers) {
+        timer->m_clock = nullptr;
+        timer->m_active = false;
+    }
+}
+
+qint64 SimulatedClock::nowNs() const
+{
+    return m_nowNs;
+}
+
+BoardTimer *SimulatedClock::createTimer(const QString &name, QObject *parent)
+{
+    SimulatedTimer *timer = new SimulatedTimer(this, parent);
+    timer->setObjectName(name);
+    m_timers.append(timer);
+    return timer;
+}
+
+void SimulatedClock::unregisterTimer(SimulatedTimer *timer)
+{
+    m_timers.removeAll(timer);
+}
+
+quint64 SimulatedClock::advance(qint64 deltaNs)
+{
+    return advanceTo(m_nowNs + qMax<qint64>(deltaNs, 0));
+}
+
+quint64 SimulatedClock::advanceTo(qint64 targetNs)
+{
+    quint64 fired = 0;
+
+    for (;;) {
+        // 找到最早到期的定时器（定时器回调中可能创建/停止其他定时器，每次重新查找）
+        SimulatedTimer *next = nullptr;
+        qint64 earliest = std::numeric_limits<qint64>::max();
+        for (SimulatedTimer *timer : m_timers) {
+            if (timer->m_active && timer->m_nextDeadlineNs < earliest) {
+                earliest = timer->m_nextDeadlineNs;
+                next = timer;
+            }
+        }
+        if (!next || earliest > targetNs) {
+            break;
+        }
+
+        m_nowNs = earliest;
+        next->fire();
+        fired++;
+
+        // 让队列连接的接收者在同一仿真时刻处理完
+        QCoreApplication::sendPostedEvents();
+    }
+
+    m_nowNs = qMax(m_nowNs, targetNs);
+    return fired;
+}
@@ -0,0 +1,96 @@
+#ifndef BOARDCLOCK_H
+#define BOARDCLOCK_H
+
+#include <QObject>
+#include <QList>
+#include "periodicscheduler.h"
+
+/**
+ * @brief 周期定时器抽象
+ *
+ * timeout 携带本次触发的理论时刻（所属时钟的时间基准，纳秒）。
+ * SystemClock 的定时器在调度线程中发出 timeout：接收者在其他线程时按队列投递，
+ * 需要在调度线程中直接处理时用 Qt::DirectConnection 连接。
+ */
+class BoardTimer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BoardTimer(QObject *parent = nullptr) : QObject(parent) {}
+
+    virtual void start(qint64 intervalNs) = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+    virtual qint64 interval() const = 0;
+
+    // 实际触发周期与抖动统计
+    virtual PeriodicScheduler::JobStats stats() const = 0;
+
+signals:
+    void timeout(qint64 deadlineNs);
+};
+
+/**
+ * @brief 时钟抽象
+ *
+ * 传感器采样、音乐进度、动画与空闲检测都通过它读取时间和创建定时器，
+ * 测试时注入 SimulatedClock 即可瞬间推进时间。
+ */
+class BoardClock
+{
+public:
+    virtual ~BoardClock() {}
+
+    // 单调时间（纳秒）
+    virtual qint64 nowNs() const = 0;
+    virtual BoardTimer *createTimer(const QString &name, QObject *parent = nullptr) = 0;
+
+    qint64 nowMs() const { return nowNs() / 1000000LL; }
+
+    // 全局时钟，默认为 SystemClock；测试中在创建各子系统之前替换
+    static BoardClock *instance();
+    static void setInstance(BoardClock *clock);
+};
+
+/**
+ * @brief 真实时钟：CLOCK_MONOTONIC + PeriodicScheduler 定时器
+ */
+class SystemClock : public BoardClock
+{
+public:
+    qint64 nowNs() const override;
+    BoardTimer *createTimer(const QString &name, QObject *parent = nullptr) override;
+};
+
+class SimulatedTimer;
+
+/**
+ * @brief 仿真时钟：时间只在调用 advance() 时前进
+ *
+ * advance() 按截止时间顺序在调用线程中依次触发到期的定时器，
+ * 每次触发后处理已投递的事件，因此几小时的数据可以在几秒内跑完。
+ * 只能在单个线程中使用。
+ */
+class SimulatedClock : public BoardClock
+{
+public:
+    explicit SimulatedClock(qint64 startNs = 0);
+    ~SimulatedClock();
+
+    qint64 nowNs() const override;
+    BoardTimer *createTimer(const QString &name, QObject *parent = nullptr) override;
+
+    // 推进时间并触发期间到期的所有定时器，返回触发次数
+    quint64 advance(qint64 deltaNs);
+    quint64 advanceTo(qint64 targetNs);
+
+private:
+    friend class SimulatedTimer;
+    void unregisterTimer(SimulatedTimer *timer);
+
+    qint64 m_nowNs;
+    QList<SimulatedTimer*> m_timers;
+};
+
+#endif // BOARDCLOCK_H
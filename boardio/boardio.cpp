@@ -0,0 +1,544 @@
+#include "boardio.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char **environ;
+
+static inline qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+BoardIo *BoardIo::instance()
+{
+    // 第一次调用必须在主线程中（回调通过该对象投递回主线程）
+    static BoardIo *s_instance = nullptr;
+    if (!s_instance) {
+        s_instance = new BoardIo(QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+BoardIo::BoardIo(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_quit(false)
+    , m_nextId(1)
+{
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("BoardIo");
+    m_thread->start();
+}
+
+BoardIo::~BoardIo()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    // 退出前会先执行完队列中剩余的命令（例如关灯）
+    m_thread->wait();
+    delete m_thread;
+
+    qDeleteAll(m_nodes);
+    m_nodes.clear();
+}
+
+int BoardIo::registerNode(const QString &path, OpenMode mode)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, int>::const_iterator it = m_nodeIndex.constFind(path);
+    if (it != m_nodeIndex.constEnd()) {
+        return it.value();
+    }
+
+    Node *node = new Node;
+    node->path = path;
+    node->dir = path.left(path.lastIndexOf('/'));
+    node->mode = mode;
+    node->fd = -1;
+    node->hasLastWritten = false;
+
+    int handle = m_nodes.size();
+    m_nodes.append(node);
+    m_nodeIndex.insert(path, handle);
+    return handle;
+}
+
+QString BoardIo::nodePath(int handle) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (handle < 0 || handle >= m_nodes.size()) {
+        return QString();
+    }
+    return m_nodes[handle]->path;
+}
+
+quint64 BoardIo::read(int handle, QObject *context, ReadCallback done, int maxBytes)
+{
+    Command cmd;
+    cmd.type = ReadOp;
+    cmd.handle = handle;
+    cmd.maxBytes = maxBytes;
+    cmd.skipIfUnchanged = false;
+    return enqueue(cmd, context, done);
+}
+
+quint64 BoardIo::write(int handle, const QByteArray &data, QObject *context,
+                       WriteCallback done, bool skipIfUnchanged)
+{
+    Command cmd;
+    cmd.type = WriteOp;
+    cmd.handle = handle;
+    cmd.maxBytes = 0;
+    cmd.skipIfUnchanged = skipIfUnchanged;
+    cmd.data = data;
+
+    ReadCallback callback;
+    if (done) {
+        callback = [done](bool ok, const QByteArray &) { done(ok); };
+    }
+    return enqueue(cmd, context, callback);
+}
+
+quint64 BoardIo::exec(const QString &key, const QString &program, const QStringList &args,
+                      QObject *context, WriteCallback done)
+{
+    Command cmd;
+    cmd.type = ExecOp;
+    cmd.handle = -1;
+    cmd.maxBytes = 0;
+    cmd.skipIfUnchanged = false;
+    cmd.key = key;
+    cmd.program = program;
+    cmd.args = args;
+
+    ReadCallback callback;
+    if (done) {
+        callback = [done](bool ok, const QByteArray &) { done(ok); };
+    }
+    return enqueue(cmd, context, callback);
+}
+
+quint64 BoardIo::call(std::function<bool()> fn, QObject *context, WriteCallback done)
+{
+    Command cmd;
+    cmd.type = CallOp;
+    cmd.handle = -1;
+    cmd.maxBytes = 0;
+    cmd.skipIfUnchanged = false;
+    cmd.fn = fn;
+
+    ReadCallback callback;
+    if (done) {
+        callback = [done](bool ok, const QByteArray &) { done(ok); };
+    }
+    return enqueue(cmd, context, callback);
+}
+
+quint64 BoardIo::enqueue(Command &cmd, QObject *context, ReadCallback done)
+{
+    Completion completion;
+    completion.context = context;
+    completion.hasContext = (context != nullptr);
+    completion.callback = done;
+
+    QMutexLocker locker(&m_mutex);
+
+    bool hasNode = (cmd.type == ReadOp || cmd.type == WriteOp);
+    if (hasNode && (cmd.handle < 0 || cmd.handle >= m_nodes.size())) {
+        qDebug() << "BoardIo: invalid handle" << cmd.handle;
+        return 0;
+    }
+
+    // 合并只看队尾的那一条命令：越过其他节点、命令或 call 去合并会把新的写提前到
+    // 它们之前执行，打乱调用者发出的顺序。
+    // 写只与同一节点上的状态写（双方都 skipIfUnchanged）合并，设备命令每次都要执行；
+    // 读与同一节点上的读合并，命令按 key 合并，call 不合并
+    if (cmd.type != CallOp && !m_queue.empty()) {
+        Command &pending = m_queue.back();
+        bool merge = false;
+        if (cmd.type == ExecOp) {
+            if (pending.type == ExecOp && pending.key == cmd.key) {
+                pending.program = cmd.program;
+                pending.args = cmd.args;
+                merge = true;
+            }
+        } else if (pending.type == cmd.type && pending.handle == cmd.handle) {
+            if (cmd.type == WriteOp) {
+                if (pending.skipIfUnchanged && cmd.skipIfUnchanged) {
+                    pending.data = cmd.data;
+                    merge = true;
+                }
+            } else {
+                merge = (pending.maxBytes == cmd.maxBytes);
+            }
+        }
+
+        if (merge) {
+            if (done) {
+                pending.completions.append(completion);
+            }
+            m_stats[cmd.type].coalesced++;
+            if (hasNode) {
+                m_nodes[cmd.handle]->stats[cmd.type].coalesced++;
+            }
+            return pending.id;
+        }
+    }
+
+    cmd.id = m_nextId++;
+    cmd.node = nullptr;
+    cmd.enqueuedNs = monotonicNs();
+    if (done) {
+        cmd.completions.append(completion);
+    }
+    m_queue.push_back(std::move(cmd));
+    m_cond.wakeOne();
+    return m_queue.back().id;
+}
+
+void BoardIo::threadLoop()
+{
+    for (;;) {
+        Command cmd;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.empty() && !m_quit) {
+                m_cond.wait(&m_mutex);
+            }
+            if (m_queue.empty()) {
+                break;
+            }
+            cmd = std::move(m_queue.front());
+            m_queue.pop_front();
+            cmd.node = (cmd.handle >= 0) ? m_nodes[cmd.handle] : nullptr;
+        }
+        execute(cmd);
+    }
+
+    // 线程退出时关闭所有缓存的 fd
+    QMutexLocker locker(&m_mutex);
+    for (Node *node : m_nodes) {
+        closeNode(*node);
+    }
+}
+
+void BoardIo::execute(Command &cmd)
+{
+    qint64 start = monotonicNs();
+    bool ok = false;
+    bool skipped = false;
+    QByteArray data;
+
+    switch (cmd.type) {
+    case ReadOp:
+        ok = doRead(*cmd.node, cmd.maxBytes, data);
+        break;
+    case WriteOp:
+        if (cmd.skipIfUnchanged && cmd.node->hasLastWritten && cmd.node->lastWritten == cmd.data) {
+            ok = true;
+            skipped = true;
+        } else {
+            ok = doWrite(*cmd.node, cmd.data);
+            invalidateCache(cmd.node);
+            cmd.node->hasLastWritten = ok;
+            cmd.node->lastWritten = ok ? cmd.data : QByteArray();
+        }
+        break;
+    case ExecOp:
+        ok = doExec(cmd.program, cmd.args);
+        invalidateCache(nullptr);
+        break;
+    case CallOp:
+        ok = cmd.fn ? cmd.fn() : false;
+        invalidateCache(nullptr);
+        break;
+    default:
+        break;
+    }
+
+    recordStats(cmd, ok, skipped, start, monotonicNs());
+    complete(cmd, ok, data);
+
+    if (cmd.type == ReadOp) {
+        emit readFinished(cmd.handle, ok, data);
+    } else if (cmd.type == WriteOp) {
+        emit writeFinished(cmd.handle, ok);
+    }
+}
+
+int BoardIo::ensureOpen(Node &node)
+{
+    if (node.fd >= 0) {
+        return node.fd;
+    }
+
+    int flags = O_CLOEXEC;
+    switch (node.mode) {
+    case ReadOnly:  flags |= O_RDONLY; break;
+    case WriteOnly: flags |= O_WRONLY; break;
+    case ReadWrite: flags |= O_RDWR;   break;
+    }
+
+    do {
+        node.fd = ::open(node.path.toLocal8Bit().constData(), flags);
+    } while (node.fd < 0 && errno == EINTR);
+
+    if (node.fd < 0) {
+        qDebug() << "BoardIo: cannot open" << node.path << "errno" << errno;
+    }
+    return node.fd;
+}
+
+void BoardIo::closeNode(Node &node)
+{
+    if (node.fd >= 0) {
+        ::close(node.fd);
+        node.fd = -1;
+    }
+}
+
+void BoardIo::invalidateCache(const Node *writtenNode)
+{
+    // 写一个属性可能改变同一设备的其他属性（LED 的 trigger 会重置 brightness），
+    // 外部命令和 call 则可能改动任何节点；这些情况下不再信任缓存的上次写入值
+    QMutexLocker locker(&m_mutex);
+    for (Node *node : m_nodes) {
+        if (!writtenNode || (node != writtenNode && node->dir == writtenNode->dir)) {
+            node->hasLastWritten = false;
+            node->lastWritten.clear();
+        }
+    }
+}
+
+bool BoardIo::doRead(Node &node, int maxBytes, QByteArray &out)
+{
+    int fd = ensureOpen(node);
+    if (fd < 0) {
+        return false;
+    }
+
+    out.resize(maxBytes);
+    ssize_t n;
+    do {
+        // sysfs 属性必须从偏移 0 重新读取才能拿到最新值
+        n = ::pread(fd, out.data(), size_t(maxBytes), 0);
+        if (n < 0 && errno == ESPIPE) {
+            n = ::read(fd, out.data(), size_t(maxBytes));
+        }
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        // 设备可能被移除或重新加载，下次访问时重新打开
+        closeNode(node);
+        out.clear();
+        return false;
+    }
+    out.resize(int(n));
+    return true;
+}
+
+bool BoardIo::doWrite(Node &node, const QByteArray &data)
+{
+    int fd = ensureOpen(node);
+    if (fd < 0) {
+        return false;
+    }
+
+    ssize_t n;
+    do {
+        n = ::pwrite(fd, data.constData(), size_t(data.size()), 0);
+        if (n < 0 && errno == ESPIPE) {
+            n = ::write(fd, data.constData(), size_t(data.size()));
+        }
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        closeNode(node);
+        return false;
+    }
+    return n == data.size();
+}
+
+bool BoardIo::doExec(const QString &program, const QStringList &args)
+{
+    QList<QByteArray> storage;
+    storage.append(program.toLocal8Bit());
+    for (const QString &arg : args) {
+        storage.append(arg.toLocal8Bit());
+    }
+
+    QVector<char *> argv;
+    for (QByteArray &item : storage) {
+        argv.append(item.data());
+    }
+    argv.append(nullptr);
+
+    // 丢弃子进程输出，避免 amixer 之类的命令刷屏
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid = -1;
+    int ret = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (ret != 0) {
+        qDebug() << "BoardIo: failed to spawn" << program << "error" << ret;
+        return false;
+    }
+
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void BoardIo::recordStats(Command &cmd, bool ok, bool coalesced, qint64 startNs, qint64 endNs)
+{
+    qint64 elapsed = endNs - startNs;
+    qint64 waited = startNs - cmd.enqueuedNs;
+
+    QMutexLocker locker(&m_mutex);
+
+    OpStats *targets[2] = { &m_stats[cmd.type], cmd.node ? &cmd.node->stats[cmd.type] : nullptr };
+    for (OpStats *s : targets) {
+        if (!s) {
+            continue;
+        }
+        if (coalesced) {
+            s->coalesced++;
+            continue;
+        }
+        s->count++;
+        if (!ok) {
+            s->failures++;
+        }
+        s->totalNs += elapsed;
+        s->lastNs = elapsed;
+        s->maxNs = qMax(s->maxNs, elapsed);
+        s->maxQueueNs = qMax(s->maxQueueNs, waited);
+    }
+}
+
+void BoardIo::complete(Command &cmd, bool ok, const QByteArray &data)
+{
+    for (const Completion &completion : cmd.completions) {
+        if (!completion.callback) {
+            continue;
+        }
+        // 回调投递回 BoardIo 所在的主线程执行；context 已销毁则丢弃
+        Completion c = completion;
+        QMetaObject::invokeMethod(this, [c, ok, data]() {
+            if (c.hasContext && !c.context) {
+                return;
+            }
+            c.callback(ok, data);
+        }, Qt::QueuedConnection);
+    }
+}
+
+BoardIo::OpStats BoardIo::stats(OpType type) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats[type];
+}
+
+BoardIo::OpStats BoardIo::nodeStats(int handle, OpType type) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (handle < 0 || handle >= m_nodes.size()) {
+        return OpStats();
+    }
+    return m_nodes[handle]->stats[type];
+}
+
+int BoardIo::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_queue.size());
+}
+
+// ====== BoardAttr ======
+
+BoardAttr::BoardAttr(const QString &path, BoardIo::OpenMode mode, bool skipIfUnchanged)
+    : m_handle(BoardIo::instance()->registerNode(path, mode))
+    , m_skipIfUnchanged(skipIfUnchanged)
+{
+}
+
+QString BoardAttr::path() const
+{
+    return BoardIo::instance()->nodePath(m_handle);
+}
+
+void BoardAttr::write(int value, QObject *context, BoardIo::WriteCallback done) const
+{
+    BoardIo::instance()->write(m_handle, QByteArray::number(value), context, done, m_skipIfUnchanged);
+}
+
+void BoardAttr::write(const QByteArray &value, QObject *context, BoardIo::WriteCallback done) const
+{
+    BoardIo::instance()->write(m_handle, value, context, done, m_skipIfUnchanged);
+}
+
+void BoardAttr::readInt(QObject *context, std::function<void(bool, int)> done) const
+{
+    BoardIo::instance()->read(m_handle, context, [done](bool ok, const QByteArray &data) {
+        bool converted = false;
+        int value = data.trimmed().toInt(&converted);
+        done(ok && converted, value);
+    });
+}
+
+void BoardAttr::readFloat(QObject *context, std::function<void(bool, float)> done) const
+{
+    BoardIo::instance()->read(m_handle, context, [done](bool ok, const QByteArray &data) {
+        bool converted = false;
+        float value = data.trimmed().toFloat(&converted);
+        done(ok && converted, value);
+    });
+}
+
+void BoardAttr::readString(QObject *context, std::function<void(bool, const QString &)> done) const
+{
+    BoardIo::instance()->read(m_handle, context, [done](bool ok, const QByteArray &data) {
+        done(ok, QString::fromLocal8Bit(data).trimmed());
+    }, 256);
+}
+
+// ====== BoardDevice ======
+
+BoardDevice::BoardDevice(const QString &path, BoardIo::OpenMode mode)
+    : m_handle(BoardIo::instance()->registerNode(path, mode))
+{
+}
+
+void BoardDevice::write(const QByteArray &data, QObject *context, BoardIo::WriteCallback done) const
+{
+    // 设备节点的写通常是命令而不是状态，不做重复值跳过
+    BoardIo::instance()->write(m_handle, data, context, done, false);
+}
+
+void BoardDevice::read(int maxBytes, QObject *context, BoardIo::ReadCallback done) const
+{
+    BoardIo::instance()->read(m_handle, context, done, maxBytes);
+}
@@ -0,0 +1,212 @@
+#ifndef BOARDIO_H
+#define BOARDIO_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QPointer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QVector>
+#include <deque>
+#include <functional>
+
+class QThread;
+
+/**
+ * @brief 板级 I/O 服务
+ *
+ * 所有对 sysfs 属性、设备节点以及外部命令的访问都通过这里排队，
+ * 在唯一的 I/O 线程中执行，UI 线程不会因为硬件访问而阻塞。
+ *
+ * - 文件描述符在第一次访问时打开并缓存，之后用 pread/pwrite 访问
+ * - 新的状态写（skipIfUnchanged）只与队尾同一节点上尚未执行的状态写合并为最新值，
+ *   不会越过排在中间的其他命令；命令写（BoardDevice）逐个执行，不合并
+ * - 与上次写入相同的值直接跳过只对显式打开 skipIfUnchanged 的句柄生效；
+ *   同一设备目录下的其他属性被写入、或执行过命令/call 后缓存作废（例如改 trigger 会重置 brightness）
+ * - 每种操作都记录排队等待与执行耗时
+ * - call() 可把其他阻塞操作（打开/导出设备等）放到同一线程执行
+ * - 完成结果通过信号或回调（在 context 所在线程执行）返回
+ */
+class BoardIo : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum OpType {
+        ReadOp = 0,
+        WriteOp,
+        ExecOp,
+        CallOp,
+        OpTypeCount
+    };
+
+    enum OpenMode {
+        ReadOnly = 0,
+        WriteOnly,
+        ReadWrite
+    };
+
+    // 单项操作的延迟统计（单位：纳秒）
+    struct OpStats {
+        quint64 count = 0;          // 实际执行次数
+        quint64 failures = 0;       // 失败次数
+        quint64 coalesced = 0;      // 被合并/跳过的请求数
+        qint64 totalNs = 0;         // 执行耗时总和
+        qint64 maxNs = 0;           // 最大执行耗时
+        qint64 lastNs = 0;          // 最近一次执行耗时
+        qint64 maxQueueNs = 0;      // 最大排队等待时间
+
+        qint64 averageNs() const { return count ? totalNs / qint64(count) : 0; }
+    };
+
+    typedef std::function<void(bool ok, const QByteArray &data)> ReadCallback;
+    typedef std::function<void(bool ok)> WriteCallback;
+
+    static BoardIo *instance();
+
+    // 注册一个节点，返回句柄；相同路径返回同一个句柄
+    int registerNode(const QString &path, OpenMode mode = ReadWrite);
+    QString nodePath(int handle) const;
+
+    // 异步读取节点内容（从偏移 0 开始，最多 maxBytes 字节）
+    quint64 read(int handle, QObject *context, ReadCallback done, int maxBytes = 64);
+
+    // 异步写入；skipIfUnchanged 为 true 时与上次成功写入的值相同则不再访问硬件，
+    // 只适合除本进程外没人改动的属性（例如背光），默认每次都写
+    quint64 write(int handle, const QByteArray &data,
+                  QObject *context = nullptr, WriteCallback done = nullptr,
+                  bool skipIfUnchanged = false);
+
+    // 在 I/O 线程中执行外部命令；相同 key 的未执行命令只保留最新参数
+    quint64 exec(const QString &key, const QString &program, const QStringList &args,
+                 QObject *context = nullptr, WriteCallback done = nullptr);
+
+    // 在 I/O 线程中执行任意阻塞操作（例如导出 PWM 通道），返回值作为 ok
+    quint64 call(std::function<bool()> fn, QObject *context = nullptr, WriteCallback done = nullptr);
+
+    OpStats stats(OpType type) const;
+    OpStats nodeStats(int handle, OpType type) const;
+    int pendingCount() const;
+
+signals:
+    void readFinished(int handle, bool ok, const QByteArray &data);
+    void writeFinished(int handle, bool ok);
+
+private:
+    explicit BoardIo(QObject *parent = nullptr);
+    ~BoardIo();
+
+    struct Completion {
+        QPointer<QObject> context;
+        bool hasContext;
+        ReadCallback callback;
+    };
+
+    struct Node;
+
+    struct Command {
+        quint64 id;
+        OpType type;
+        int handle;
+        Node *node;
+        int maxBytes;
+        bool skipIfUnchanged;
+        QByteArray data;
+        QString key;
+        QString program;
+        QStringList args;
+        std::function<bool()> fn;
+        qint64 enqueuedNs;
+        QVector<Completion> completions;
+    };
+
+    struct Node {
+        QString path;
+        QString dir;
+        OpenMode mode;
+        int fd;
+        bool hasLastWritten;
+        QByteArray lastWritten;
+        OpStats stats[OpTypeCount];
+    };
+
+    quint64 enqueue(Command &cmd, QObject *context, ReadCallback done);
+    void threadLoop();
+    void execute(Command &cmd);
+    bool doRead(Node &node, int maxBytes, QByteArray &out);
+    bool doWrite(Node &node, const QByteArray &data);
+    bool doExec(const QString &program, const QStringList &args);
+    int ensureOpen(Node &node);
+    void closeNode(Node &node);
+    void invalidateCache(const Node *writtenNode);
+    void recordStats(Command &cmd, bool ok, bool coalesced, qint64 startNs, qint64 endNs);
+    void complete(Command &cmd, bool ok, const QByteArray &data);
+
+    QThread *m_thread;
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    std::deque<Command> m_queue;
+    bool m_quit;
+    quint64 m_nextId;
+
+    // 节点表只在注册时增长（受 m_mutex 保护），fd 与缓存值只在 I/O 线程中访问
+    QVector<Node*> m_nodes;
+    QHash<QString, int> m_nodeIndex;
+    OpStats m_stats[OpTypeCount];
+};
+
+/**
+ * @brief sysfs 属性句柄（文本读写）
+ *
+ * 轻量值类型，拷贝代价只有一个整数；真正的 fd 由 BoardIo 在 I/O 线程中缓存。
+ * skipIfUnchanged 为 true 时，这个句柄上的写与上次写入相同则跳过、连续的写合并为最新值。
+ */
+class BoardAttr
+{
+public:
+    BoardAttr() : m_handle(-1), m_skipIfUnchanged(false) {}
+    explicit BoardAttr(const QString &path, BoardIo::OpenMode mode = BoardIo::ReadWrite,
+                       bool skipIfUnchanged = false);
+
+    bool isValid() const { return m_handle >= 0; }
+    int handle() const { return m_handle; }
+    QString path() const;
+
+    void write(int value, QObject *context = nullptr,
+               BoardIo::WriteCallback done = nullptr) const;
+    void write(const QByteArray &value, QObject *context = nullptr,
+               BoardIo::WriteCallback done = nullptr) const;
+
+    void readInt(QObject *context, std::function<void(bool ok, int value)> done) const;
+    void readFloat(QObject *context, std::function<void(bool ok, float value)> done) const;
+    void readString(QObject *context, std::function<void(bool ok, const QString &value)> done) const;
+
+private:
+    int m_handle;
+    bool m_skipIfUnchanged;
+};
+
+/**
+ * @brief 字符设备节点句柄（二进制读写，例如 /dev/beep）
+ */
+class BoardDevice
+{
+public:
+    BoardDevice() : m_handle(-1) {}
+    explicit BoardDevice(const QString &path, BoardIo::OpenMode mode = BoardIo::ReadWrite);
+
+    bool isValid() const { return m_handle >= 0; }
+    int handle() const { return m_handle; }
+
+    void write(const QByteArray &data, QObject *context = nullptr,
+               BoardIo::WriteCallback done = nullptr) const;
+    void read(int maxBytes, QObject *context, BoardIo::ReadCallback done) const;
+
+private:
+    int m_handle;
+};
+
+#endif // BOARDIO_H
@@ -0,0 +1,21 @@
+# 板级 I/O 公共库
+# imx6ull_desktop 与 imx6ull_everything 共用，通过 include(../boardio/boardio.pri) 引入
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/boardio.cpp \
+    $$PWD/boardthread.cpp \
+    $$PWD/periodicscheduler.cpp \
+    $$PWD/boardclock.cpp \
+    $$PWD/pwmchannel.cpp \
+    $$PWD/beeper.cpp
+
+HEADERS += \
+    $$PWD/boardio.h \
+    $$PWD/boardthread.h \
+    $$PWD/periodicscheduler.h \
+    $$PWD/boardclock.h \
+    $$PWD/pwmchannel.h \
+    $$PWD/beeper.h
@@ -0,0 +1,12 @@
+#include "boardthread.h"
+
+BoardThread::BoardThread(std::function<void()> body, QObject *parent)
+    : QThread(parent)
+    , m_body(std::move(body))
+{
+}
+
+void BoardThread::run()
+{
+    m_body();
+}
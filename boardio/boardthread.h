@@ -0,0 +1,26 @@
+#ifndef BOARDTHREAD_H
+#define BOARDTHREAD_H
+
+#include <QThread>
+#include <functional>
+
+/**
+ * @brief 运行一个函数的线程
+ *
+ * 各服务的工作线程都只是在 run() 中调用自己的循环，用它代替逐个模块定义
+ * QThread 子类：new BoardThread([this] { threadLoop(); })。
+ * 函数返回即线程结束；停止循环、wait() 与 delete 仍由调用者负责。
+ */
+class BoardThread : public QThread
+{
+public:
+    explicit BoardThread(std::function<void()> body, QObject *parent = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    std::function<void()> m_body;
+};
+
+#endif // BOARDTHREAD_H
@@ -0,0 +1,314 @@
+#include "periodicscheduler.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QVarLengthArray>
+#include <QDebug>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <cmath>
+#include <limits>
+
+// SCHED_FIFO 优先级：高于普通线程，低于内核中断线程（50）
+static const int kSchedulerPriority = 40;
+
+PeriodicScheduler *PeriodicScheduler::instance()
+{
+    static PeriodicScheduler *s_instance = nullptr;
+    if (!s_instance) {
+        s_instance = new PeriodicScheduler(QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+qint64 PeriodicScheduler::nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+PeriodicScheduler::PeriodicScheduler(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_timerFd(-1)
+    , m_wakeFd(-1)
+    , m_quit(false)
+    , m_realtime(false)
+    , m_nextId(1)
+    , m_runningJob(0)
+{
+    m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_timerFd < 0 || m_wakeFd < 0) {
+        qDebug() << "PeriodicScheduler: failed to create timerfd/eventfd, errno" << errno;
+    }
+
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("PeriodicScheduler");
+    m_thread->start();
+}
+
+PeriodicScheduler::~PeriodicScheduler()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+    }
+    wakeThread();
+    m_thread->wait();
+    delete m_thread;
+
+    if (m_timerFd >= 0) {
+        ::close(m_timerFd);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+int PeriodicScheduler::addJob(const QString &name, qint64 periodNs, JobFunction fn, qint64 firstDelayNs)
+{
+    if (periodNs <= 0 || !fn) {
+        return -1;
+    }
+
+    Job job;
+    job.name = name;
+    job.periodNs = periodNs;
+    job.nextDeadlineNs = nowNs() + (firstDelayNs >= 0 ? firstDelayNs : periodNs);
+    job.lastStartNs = 0;
+    job.fn = fn;
+    job.stats.periodNs = periodNs;
+    job.periodMean = 0.0;
+    job.periodM2 = 0.0;
+
+    int id;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = m_nextId++;
+        m_jobs.insert(id, job);
+    }
+    wakeThread();
+    return id;
+}
+
+void PeriodicScheduler::removeJob(int id)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        // 任务正在执行时等它结束，之后才能销毁任务函数
+        while (m_runningJob == id && QThread::currentThread() != m_thread) {
+            m_jobDone.wait(&m_mutex);
+        }
+        m_jobs.remove(id);
+    }
+    wakeThread();
+}
+
+void PeriodicScheduler::setPeriod(int id, qint64 periodNs)
+{
+    if (periodNs <= 0) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        QMap<int, Job>::iterator it = m_jobs.find(id);
+        if (it == m_jobs.end()) {
+            return;
+        }
+        Job &job = it.value();
+        // 新周期从上一次截止时间起算，保持相位连续
+        job.nextDeadlineNs += periodNs - job.periodNs;
+        job.periodNs = periodNs;
+        job.stats = JobStats();
+        job.stats.periodNs = periodNs;
+        job.lastStartNs = 0;
+        job.periodMean = 0.0;
+        job.periodM2 = 0.0;
+    }
+    wakeThread();
+}
+
+PeriodicScheduler::JobStats PeriodicScheduler::stats(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    QMap<int, Job>::const_iterator it = m_jobs.constFind(id);
+    return it != m_jobs.constEnd() ? it.value().stats : JobStats();
+}
+
+QString PeriodicScheduler::jobName(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    QMap<int, Job>::const_iterator it = m_jobs.constFind(id);
+    return it != m_jobs.constEnd() ? it.value().name : QString();
+}
+
+bool PeriodicScheduler::isRealtime() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_realtime;
+}
+
+void PeriodicScheduler::wakeThread()
+{
+    if (m_wakeFd >= 0) {
+        quint64 one = 1;
+        ssize_t ret = ::write(m_wakeFd, &one, sizeof(one));
+        Q_UNUSED(ret);
+    }
+}
+
+void PeriodicScheduler::armTimer()
+{
+    // 调用方持有 m_mutex
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (QMap<int, Job>::const_iterator it = m_jobs.constBegin(); it != m_jobs.constEnd(); ++it) {
+        earliest = qMin(earliest, it.value().nextDeadlineNs);
+    }
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = 0;
+    spec.it_interval.tv_nsec = 0;
+    if (earliest == std::numeric_limits<qint64>::max()) {
+        // 没有任务时解除定时器
+        spec.it_value.tv_sec = 0;
+        spec.it_value.tv_nsec = 0;
+    } else {
+        // 绝对时间 0 会被解释为解除，至少设为 1ns
+        earliest = qMax<qint64>(earliest, 1);
+        spec.it_value.tv_sec = time_t(earliest / 1000000000LL);
+        spec.it_value.tv_nsec = long(earliest % 1000000000LL);
+    }
+    timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void PeriodicScheduler::threadLoop()
+{
+    // 尝试切换为实时调度；没有权限时保持普通调度，计时仍然基于绝对截止时间
+    struct sched_param param;
+    param.sched_priority = kSchedulerPriority;
+    bool realtime = (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_realtime = realtime;
+    }
+    qDebug() << "PeriodicScheduler started, SCHED_FIFO:" << realtime;
+
+    struct pollfd fds[2];
+    fds[0].fd = m_timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_quit) {
+                break;
+            }
+            armTimer();
+        }
+
+        int ret = ::poll(fds, 2, -1);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qDebug() << "PeriodicScheduler: poll failed, errno" << errno;
+            break;
+        }
+
+        quint64 value;
+        if (fds[1].revents & POLLIN) {
+            ssize_t n = ::read(m_wakeFd, &value, sizeof(value));
+            Q_UNUSED(n);
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t n = ::read(m_timerFd, &value, sizeof(value));
+            Q_UNUSED(n);
+        }
+
+        runDueJobs(nowNs());
+    }
+}
+
+void PeriodicScheduler::runDueJobs(qint64 now)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QVarLengthArray<int, 16> due;
+    for (QMap<int, Job>::const_iterator it = m_jobs.constBegin(); it != m_jobs.constEnd(); ++it) {
+        if (it.value().nextDeadlineNs <= now) {
+            due.append(it.key());
+        }
+    }
+
+    for (int id : due) {
+        // 前面的任务执行期间可能已被移除
+        QMap<int, Job>::iterator it = m_jobs.find(id);
+        if (it == m_jobs.end()) {
+            continue;
+        }
+        Job &job = it.value();
+
+        qint64 deadline = job.nextDeadlineNs;
+        qint64 period = job.periodNs;
+        qint64 start = nowNs();
+
+        // 错过的周期直接跳过并计入 overrun，保持绝对相位，不补发
+        quint64 missed = quint64((start - deadline) / period);
+        job.nextDeadlineNs = deadline + qint64(missed + 1) * period;
+
+        // 在锁外执行任务函数：removeJob 会等 m_runningJob 结束才移除任务，
+        // QMap 插入其他任务不移动已有节点，所以 fn 在执行期间一直有效
+        const JobFunction &fn = job.fn;
+        m_runningJob = id;
+        locker.unlock();
+        fn(deadline + qint64(missed) * period, missed);
+        qint64 end = nowNs();
+        locker.relock();
+        m_runningJob = 0;
+        m_jobDone.wakeAll();
+
+        it = m_jobs.find(id);
+        if (it == m_jobs.end()) {
+            continue;
+        }
+        Job &done = it.value();
+        done.stats.overruns += missed;
+        done.stats.lastLatencyNs = start - deadline - qint64(missed) * period;
+        done.stats.maxLatencyNs = qMax(done.stats.maxLatencyNs, done.stats.lastLatencyNs);
+        updateStats(done, start, end);
+    }
+}
+
+void PeriodicScheduler::updateStats(Job &job, qint64 start, qint64 end)
+{
+    JobStats &st = job.stats;
+    st.runs++;
+    st.maxRunNs = qMax(st.maxRunNs, end - start);
+
+    if (job.lastStartNs > 0) {
+        qint64 period = start - job.lastStartNs;
+        quint64 samples = st.runs - 1;
+
+        // Welford 在线算法计算实际周期的均值与标准差
+        double delta = double(period) - job.periodMean;
+        job.periodMean += delta / double(samples);
+        job.periodM2 += delta * (double(period) - job.periodMean);
+
+        st.meanPeriodNs = qint64(job.periodMean);
+        st.minPeriodNs = (samples == 1) ? period : qMin(st.minPeriodNs, period);
+        st.maxPeriodNs = qMax(st.maxPeriodNs, period);
+        st.jitterNs = samples > 1 ? qint64(std::sqrt(job.periodM2 / double(samples - 1))) : 0;
+    }
+    job.lastStartNs = start;
+}
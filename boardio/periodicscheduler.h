@@ -0,0 +1,97 @@
+#ifndef PERIODICSCHEDULER_H
+#define PERIODICSCHEDULER_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QMap>
+#include <functional>
+
+class QThread;
+
+/**
+ * @brief 基于 timerfd 的周期任务调度器
+ *
+ * 所有周期任务在同一个调度线程中执行，使用绝对截止时间（CLOCK_MONOTONIC），
+ * 周期不会因为 UI 线程繁忙而漂移。权限允许时调度线程切换到 SCHED_FIFO。
+ *
+ * 任务函数运行在调度线程中，必须短小且不能阻塞；需要更新界面时请投递回主线程。
+ * 任务函数执行时不持有调度器的锁，stats() 等查询不会被正在运行的任务挡住；
+ * 任务函数内部不能调用 removeJob 移除自己。
+ */
+class PeriodicScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // deadlineNs 为本次触发的理论时刻（CLOCK_MONOTONIC），missed 为之前错过的周期数
+    typedef std::function<void(qint64 deadlineNs, quint64 missed)> JobFunction;
+
+    // 单个任务的时序统计（单位：纳秒）
+    struct JobStats {
+        qint64 periodNs = 0;        // 设定周期
+        quint64 runs = 0;           // 执行次数
+        quint64 overruns = 0;       // 错过（被跳过）的周期数
+        qint64 meanPeriodNs = 0;    // 实际周期平均值
+        qint64 minPeriodNs = 0;     // 实际周期最小值
+        qint64 maxPeriodNs = 0;     // 实际周期最大值
+        qint64 jitterNs = 0;        // 实际周期的标准差
+        qint64 maxLatencyNs = 0;    // 相对截止时间的最大唤醒延迟
+        qint64 lastLatencyNs = 0;   // 最近一次唤醒延迟
+        qint64 maxRunNs = 0;        // 任务函数最长执行时间
+    };
+
+    static PeriodicScheduler *instance();
+    static qint64 nowNs();
+
+    // 注册周期任务，返回任务 id；firstDelayNs < 0 表示一个周期后首次触发
+    int addJob(const QString &name, qint64 periodNs, JobFunction fn, qint64 firstDelayNs = -1);
+
+    // 返回后保证任务不会再被执行（若任务正在执行则等待其结束）
+    void removeJob(int id);
+
+    // 修改周期，从下一次触发开始生效
+    void setPeriod(int id, qint64 periodNs);
+
+    JobStats stats(int id) const;
+    QString jobName(int id) const;
+    bool isRealtime() const;
+
+private:
+    explicit PeriodicScheduler(QObject *parent = nullptr);
+    ~PeriodicScheduler();
+
+    struct Job {
+        QString name;
+        qint64 periodNs;
+        qint64 nextDeadlineNs;
+        qint64 lastStartNs;
+        JobFunction fn;
+        JobStats stats;
+        double periodMean;
+        double periodM2;
+    };
+
+    void threadLoop();
+    void wakeThread();
+    void armTimer();
+    void runDueJobs(qint64 now);
+    void updateStats(Job &job, qint64 start, qint64 end);
+
+    QThread *m_thread;
+    int m_timerFd;
+    int m_wakeFd;
+    bool m_quit;
+    bool m_realtime;
+    int m_nextId;
+
+    // 保护任务表；任务函数在锁外执行，m_runningJob 记录正在执行的任务，
+    // removeJob 等它执行完再移除，因此返回后任务不再运行
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobDone;
+    int m_runningJob;
+    QMap<int, Job> m_jobs;
+};
+
+#endif // PERIODICSCHEDULER_H
@@ -0,0 +1,184 @@
+#include "pwmchannel.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+static int openAttr(const QString &path)
+{
+    int fd;
+    do {
+        fd = ::open(path.toLocal8Bit().constData(), O_WRONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+}
+
+PwmChannel::PwmChannel()
+    : m_periodFd(-1)
+    , m_dutyFd(-1)
+    , m_enableFd(-1)
+    , m_periodNs(-1)
+    , m_dutyNs(-1)
+    , m_enabled(false)
+    , m_writes(0)
+    , m_errors(0)
+{
+}
+
+PwmChannel::~PwmChannel()
+{
+    close();
+}
+
+int PwmChannel::findChip(const QString &deviceName)
+{
+    // /sys/class/pwm/pwmchipN 是指向 .../2088000.pwm/pwm/pwmchipN 的链接
+    QDir dir("/sys/class/pwm");
+    QStringList chips = dir.entryList(QStringList() << "pwmchip*", QDir::Dirs | QDir::System);
+    for (const QString &chip : chips) {
+        QString target = QFileInfo(dir.filePath(chip)).canonicalFilePath();
+        if (target.contains("/" + deviceName + "/")) {
+            return chip.mid(7).toInt();
+        }
+    }
+    return -1;
+}
+
+bool PwmChannel::open(int chip, int channel)
+{
+    close();
+
+    QString chipPath = QString("/sys/class/pwm/pwmchip%1").arg(chip);
+    m_basePath = QString("%1/pwm%2").arg(chipPath).arg(channel);
+
+    // 通道未导出时先导出
+    if (!QFileInfo::exists(m_basePath)) {
+        int exportFd = openAttr(chipPath + "/export");
+        if (exportFd < 0) {
+            qDebug() << "PwmChannel: cannot open" << chipPath + "/export";
+            return false;
+        }
+        QByteArray number = QByteArray::number(channel);
+        ssize_t ret = ::write(exportFd, number.constData(), size_t(number.size()));
+        ::close(exportFd);
+        if (ret < 0 && errno != EBUSY) {
+            qDebug() << "PwmChannel: export failed, errno" << errno;
+            return false;
+        }
+    }
+
+    // 导出后属性文件由 udev 调整权限，稍等片刻重试
+    for (int retry = 0; retry < 20; ++retry) {
+        m_periodFd = openAttr(m_basePath + "/period");
+        if (m_periodFd >= 0) {
+            break;
+        }
+        ::usleep(10000);
+    }
+    m_dutyFd = openAttr(m_basePath + "/duty_cycle");
+    m_enableFd = openAttr(m_basePath + "/enable");
+
+    if (m_periodFd < 0 || m_dutyFd < 0 || m_enableFd < 0) {
+        qDebug() << "PwmChannel: cannot open attributes under" << m_basePath;
+        close();
+        return false;
+    }
+
+    m_periodNs = -1;
+    m_dutyNs = -1;
+    m_enabled = false;
+    return true;
+}
+
+void PwmChannel::close()
+{
+    int *fds[3] = { &m_periodFd, &m_dutyFd, &m_enableFd };
+    for (int *fd : fds) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+bool PwmChannel::writeValue(int fd, qint64 value)
+{
+    // 栈上十进制格式化，避免 QString/QByteArray 分配
+    char buf[24];
+    int pos = int(sizeof(buf));
+    quint64 v = value < 0 ? 0 : quint64(value);
+    do {
+        buf[--pos] = char('0' + v % 10);
+        v /= 10;
+    } while (v && pos > 0);
+
+    ssize_t n;
+    do {
+        n = ::pwrite(fd, buf + pos, size_t(int(sizeof(buf)) - pos), 0);
+    } while (n < 0 && errno == EINTR);
+
+    m_writes++;
+    if (n < 0) {
+        m_errors++;
+        return false;
+    }
+    return true;
+}
+
+bool PwmChannel::setEnabled(bool enabled)
+{
+    if (m_enableFd < 0) {
+        return false;
+    }
+    if (enabled == m_enabled) {
+        return true;
+    }
+    if (!writeValue(m_enableFd, enabled ? 1 : 0)) {
+        return false;
+    }
+    m_enabled = enabled;
+    return true;
+}
+
+bool PwmChannel::apply(qint64 periodNs, qint64 dutyNs)
+{
+    if (!isOpen() || periodNs <= 0) {
+        return false;
+    }
+    dutyNs = qBound<qint64>(0, dutyNs, periodNs);
+
+    bool ok = true;
+    bool periodChanged = (periodNs != m_periodNs);
+    bool dutyChanged = (dutyNs != m_dutyNs);
+
+    // 内核要求任意时刻 duty_cycle <= period：
+    // 周期变大时先写周期，周期变小时先写占空比。
+    // 刚打开（或写失败）时不知道上次留下的占空比，可能大于新周期，先把占空比清零再写周期
+    if (m_periodNs < 0) {
+        ok = writeValue(m_dutyFd, 0) && ok;
+        ok = writeValue(m_periodFd, periodNs) && ok;
+        ok = writeValue(m_dutyFd, dutyNs) && ok;
+    } else if (periodChanged && dutyChanged && periodNs < m_periodNs) {
+        ok = writeValue(m_dutyFd, dutyNs) && ok;
+        ok = writeValue(m_periodFd, periodNs) && ok;
+    } else {
+        if (periodChanged) {
+            ok = writeValue(m_periodFd, periodNs) && ok;
+        }
+        if (dutyChanged) {
+            ok = writeValue(m_dutyFd, dutyNs) && ok;
+        }
+    }
+
+    if (ok) {
+        m_periodNs = periodNs;
+        m_dutyNs = dutyNs;
+    } else {
+        // 写失败后状态未知，下次全部重写
+        m_periodNs = -1;
+        m_dutyNs = -1;
+    }
+    return ok;
+}
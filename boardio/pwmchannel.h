@@ -0,0 +1,53 @@
+#ifndef PWMCHANNEL_H
+#define PWMCHANNEL_H
+
+#include <QString>
+
+/**
+ * @brief sysfs PWM 通道（/sys/class/pwm/pwmchipN/pwmM）
+ *
+ * 与 BoardIo 不同，这里是同步接口：open()/close() 放到 BoardIo::call() 中执行，
+ * apply() 由调度线程高频调用。period/duty_cycle/enable 的 fd 一直保持打开，
+ * 每次更新只有一到两次 pwrite，数值格式化在栈上完成，没有内存分配。
+ *
+ * 非线程安全：同一时刻只能有一个线程使用。
+ */
+class PwmChannel
+{
+public:
+    PwmChannel();
+    ~PwmChannel();
+
+    // 根据控制器的设备名（如 "2088000.pwm"）查找 pwmchip 编号，找不到返回 -1
+    static int findChip(const QString &deviceName);
+
+    bool open(int chip, int channel);
+    void close();
+    bool isOpen() const { return m_periodFd >= 0; }
+
+    bool setEnabled(bool enabled);
+
+    // 一次提交周期与占空比（纳秒），按内核要求的顺序写入并跳过未变化的值
+    bool apply(qint64 periodNs, qint64 dutyNs);
+
+    qint64 periodNs() const { return m_periodNs; }
+    qint64 dutyNs() const { return m_dutyNs; }
+    quint64 writeCount() const { return m_writes; }
+    quint64 errorCount() const { return m_errors; }
+
+private:
+    bool writeValue(int fd, qint64 value);
+
+private:
+    QString m_basePath;
+    int m_periodFd;
+    int m_dutyFd;
+    int m_enableFd;
+    qint64 m_periodNs;
+    qint64 m_dutyNs;
+    bool m_enabled;
+    quint64 m_writes;
+    quint64 m_errors;
+};
+
+#endif // PWMCHANNEL_H
@@ -1,11 +1,12 @@
 #include "appdialog.h"
 #include "musicplayer.h"
+#include "sensorsampler.h"
+#include "pwmgenerator.h"
+#include "beeper.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QDebug>
-#include <QFile>
-#include <QTextStream>
 #include <QMessageBox>
 #include <QFrame>
 #include <QScrollArea>
@@ -15,7 +16,8 @@
 AppDialog::AppDialog(const QString &appName, QWidget *parent)
     : QDialog(parent)
     , m_appName(appName)
-    , m_sensorTimer(nullptr)
+    , m_sensorSampler(nullptr)
+    , m_sensorInfoLabel(nullptr)
     , m_adcRawLabel(nullptr)
     , m_adcVoltageLabel(nullptr)
     , m_adcScaleLabel(nullptr)
@@ -31,6 +33,7 @@ AppDialog::AppDialog(const QString &appName, QWidget *parent)
     , m_axisY(nullptr)
     , m_startTime(0)
     , m_maxDataPoints(60)  // 保留最近60个数据点（30秒的数据）
+    , m_musicPlayer(nullptr)
 {
     setupUI(appName);
     
@@ -51,13 +54,22 @@ AppDialog::AppDialog(const QString &appName, QWidget *parent)
         createSystemApp();
     } else if (appName == "关于") {
         createAboutApp();
+    } else if (appName == "PWM发生器") {
+        createPwmApp();
     }
 }
 
 AppDialog::~AppDialog()
 {
-    if (m_sensorTimer) {
-        m_sensorTimer->stop();
+    // 停止采样；返回后定时器线程不会再访问采样器
+    if (m_sensorSampler) {
+        m_sensorSampler->stop();
+    }
+    
+    // 音乐播放器界面不随对话框销毁，隐藏后交还给主窗口，下次打开直接复用
+    if (m_musicPlayer) {
+        m_musicPlayer->hide();
+        m_musicPlayer->setParent(parentWidget());
     }
 }
 
@@ -123,8 +135,9 @@ void AppDialog::setupUI(const QString &appName)
 
 void AppDialog::createLEDApp()
 {
-    // 首先关闭心跳灯
-    system("echo none > /sys/class/leds/red/trigger");
+    // 首先关闭心跳灯（在 I/O 线程中执行，不阻塞界面）
+    BoardAttr("/sys/class/leds/red/trigger").write(QByteArray("none"));
+    BoardAttr ledBrightness("/sys/devices/platform/dtsleds/leds/red/brightness");
     
     m_contentLabel->setText("LED 控制应用\n\n控制板载 RED LED 灯的开关");
     
@@ -142,37 +155,33 @@ void AppDialog::createLEDApp()
         ledOnBtn->setStyleSheet("QPushButton { padding: 15px; font-size: 16px; background-color: #4CAF50; color: white; border: none; border-radius: 5px; }");
         ledOffBtn->setStyleSheet("QPushButton { padding: 15px; font-size: 16px; background-color: #f44336; color: white; border: none; border-radius: 5px; }");
         
-        // 连接按钮信号
-        connect(ledOnBtn, &QPushButton::clicked, this, [statusLabel]() {
-            QFile file("/sys/devices/platform/dtsleds/leds/red/brightness");
-            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                QTextStream out(&file);
-                out << "1";
-                file.close();
-                statusLabel->setText("LED 状态: 开启");
-                statusLabel->setStyleSheet("font-size: 16px; color: #4CAF50; padding: 10px; font-weight: bold;");
-                qDebug() << "LED turned ON";
-            } else {
-                statusLabel->setText("LED 状态: 操作失败");
-                statusLabel->setStyleSheet("font-size: 16px; color: #f44336; padding: 10px;");
-                qDebug() << "Failed to open LED device for writing";
-            }
+        // 连接按钮信号（写操作异步完成后再更新状态）
+        connect(ledOnBtn, &QPushButton::clicked, this, [this, ledBrightness, statusLabel]() {
+            ledBrightness.write(1, this, [statusLabel](bool ok) {
+                if (ok) {
+                    statusLabel->setText("LED 状态: 开启");
+                    statusLabel->setStyleSheet("font-size: 16px; color: #4CAF50; padding: 10px; font-weight: bold;");
+                    qDebug() << "LED turned ON";
+                } else {
+                    statusLabel->setText("LED 状态: 操作失败");
+                    statusLabel->setStyleSheet("font-size: 16px; color: #f44336; padding: 10px;");
+                    qDebug() << "Failed to write LED brightness";
+                }
+            });
         });
         
-        connect(ledOffBtn, &QPushButton::clicked, this, [statusLabel]() {
-            QFile file("/sys/devices/platform/dtsleds/leds/red/brightness");
-            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                QTextStream out(&file);
-                out << "0";
-                file.close();
-                statusLabel->setText("LED 状态: 关闭");
-                statusLabel->setStyleSheet("font-size: 16px; color: #666; padding: 10px;");
-                qDebug() << "LED turned OFF";
-            } else {
-                statusLabel->setText("LED 状态: 操作失败");
-                statusLabel->setStyleSheet("font-size: 16px; color: #f44336; padding: 10px;");
-                qDebug() << "Failed to open LED device for writing";
-            }
+        connect(ledOffBtn, &QPushButton::clicked, this, [this, ledBrightness, statusLabel]() {
+            ledBrightness.write(0, this, [statusLabel](bool ok) {
+                if (ok) {
+                    statusLabel->setText("LED 状态: 关闭");
+                    statusLabel->setStyleSheet("font-size: 16px; color: #666; padding: 10px;");
+                    qDebug() << "LED turned OFF";
+                } else {
+                    statusLabel->setText("LED 状态: 操作失败");
+                    statusLabel->setStyleSheet("font-size: 16px; color: #f44336; padding: 10px;");
+                    qDebug() << "Failed to write LED brightness";
+                }
+            });
         });
         
         layout->addWidget(statusLabel);
@@ -310,26 +319,25 @@ void AppDialog::createSensorApp()
         m_sensorStackedWidget->setCurrentIndex(0);
         m_sensorStackedWidget->setMinimumHeight(300);  // 设置最小高度确保内容完整显示
         
-        // 提示信息
-        QLabel *infoLabel = new QLabel("数据每500ms更新一次", this);
-        infoLabel->setAlignment(Qt::AlignCenter);
-        infoLabel->setStyleSheet("font-size: 12px; color: #999;");
-        infoLabel->setFixedHeight(25);
+        // 提示信息（附带实际采样周期与抖动）
+        m_sensorInfoLabel = new QLabel("数据每500ms更新一次", this);
+        m_sensorInfoLabel->setAlignment(Qt::AlignCenter);
+        m_sensorInfoLabel->setStyleSheet("font-size: 12px; color: #999;");
+        m_sensorInfoLabel->setFixedHeight(25);
         
         layout->addWidget(m_modeSwitchButton);
         layout->addWidget(m_sensorStackedWidget, 1);  // 添加拉伸因子，让它占据剩余空间
-        layout->addWidget(infoLabel);
-        
-        // 创建定时器更新传感器数据
-        m_sensorTimer = new QTimer(this);
-        connect(m_sensorTimer, &QTimer::timeout, this, &AppDialog::updateSensorData);
-        m_sensorTimer->start(500);  // 500ms 更新一次
+        layout->addWidget(m_sensorInfoLabel);
         
-        // 记录起始时间
-        m_startTime = QDateTime::currentMSecsSinceEpoch();
+        // 采样管线：按时钟定时器的绝对截止时间采样，500ms 一次，立即触发第一次；
+        // 采样时刻取截止时间，不受 UI 线程繁忙影响
+        m_sensorSampler = new SensorSampler(BoardClock::instance(), this);
+        connect(m_sensorSampler, &SensorSampler::sampleReady, this, &AppDialog::onSensorSample);
+        connect(m_sensorSampler, &SensorSampler::sampleFailed, this, &AppDialog::onSensorSampleFailed);
+        m_sensorSampler->start(500 * 1000000LL);
         
-        // 立即读取一次数据
-        updateSensorData();
+        // 记录起始时间（时钟时间基准）
+        m_startTime = m_sensorSampler->startTimeNs();
     }
 }
 
@@ -420,13 +428,12 @@ void AppDialog::switchSensorMode()
     }
 }
 
-void AppDialog::updateChartData(int rawValue)
+void AppDialog::updateChartData(int rawValue, qint64 sampleNs)
 {
     if (!m_series) return;
     
-    // 计算相对时间（秒）
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    double timeInSeconds = (currentTime - m_startTime) / 1000.0;
+    // 计算相对时间（秒），使用采样时刻而不是回调到达的时刻
+    double timeInSeconds = (sampleNs - m_startTime) / 1e9;
     
     // 添加新数据点
     m_dataPoints.append(QPointF(timeInSeconds, rawValue));
@@ -517,66 +524,46 @@ void AppDialog::toggleYAxisMode()
     }
 }
 
-void AppDialog::updateSensorData()
+void AppDialog::onSensorSample(qint64 sampleNs, int raw, float scale, float voltage)
 {
-    int raw = 0;
-    float scale = 0.0f;
-    float voltage = 0.0f;
+    // 更新数据模式的显示
+    m_adcRawLabel->setText(QString::number(raw));
+    m_adcVoltageLabel->setText(QString::number(voltage, 'f', 3) + " V");
+    m_adcScaleLabel->setText(QString::number(scale, 'f', 6));
     
-    int ret = readAdcData(raw, scale, voltage);
+    // 更新图表数据
+    updateChartData(raw, sampleNs);
     
-    if (ret == 0) {
-        // 更新数据模式的显示
-        m_adcRawLabel->setText(QString::number(raw));
-        m_adcVoltageLabel->setText(QString::number(voltage, 'f', 3) + " V");
-        m_adcScaleLabel->setText(QString::number(scale, 'f', 6));
-        
-        // 更新图表数据
-        updateChartData(raw);
-    } else {
-        m_adcRawLabel->setText("读取失败");
-        m_adcVoltageLabel->setText("-- V");
-        m_adcScaleLabel->setText("--");
-    }
+    updateSensorTiming();
 }
 
-int AppDialog::readAdcData(int &raw, float &scale, float &voltage)
+void AppDialog::onSensorSampleFailed(qint64 sampleNs)
 {
-    // 读取 scale 值
-    QString scaleStr = readFileContent("/sys/bus/iio/devices/iio:device0/in_voltage_scale");
-    if (scaleStr.isEmpty()) {
-        qDebug() << "Failed to read ADC scale";
-        return -1;
-    }
-    scale = scaleStr.toFloat();
-    
-    // 读取原始值
-    QString rawStr = readFileContent("/sys/bus/iio/devices/iio:device0/in_voltage1_raw");
-    if (rawStr.isEmpty()) {
-        qDebug() << "Failed to read ADC raw value";
-        return -1;
-    }
-    raw = rawStr.toInt();
+    Q_UNUSED(sampleNs);
     
-    // 计算实际电压值（mV 转 V）
-    voltage = (scale * raw) / 1000.0f;
+    m_adcRawLabel->setText("读取失败");
+    m_adcVoltageLabel->setText("-- V");
+    m_adcScaleLabel->setText("--");
     
-    return 0;
+    updateSensorTiming();
 }
 
-QString AppDialog::readFileContent(const QString &filePath)
+void AppDialog::updateSensorTiming()
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Cannot open file:" << filePath;
-        return QString();
+    if (!m_sensorSampler || !m_sensorInfoLabel) {
+        return;
     }
     
-    QTextStream in(&file);
-    QString content = in.readLine().trimmed();
-    file.close();
+    PeriodicScheduler::JobStats st = m_sensorSampler->timingStats();
+    if (st.runs < 2) {
+        return;
+    }
     
-    return content;
+    m_sensorInfoLabel->setText(QString("数据每500ms更新一次  实际周期 %1ms  抖动 %2ms  丢失 %3%4")
+                               .arg(st.meanPeriodNs / 1e6, 0, 'f', 2)
+                               .arg(st.jitterNs / 1e6, 0, 'f', 3)
+                               .arg(st.overruns)
+                               .arg(PeriodicScheduler::instance()->isRealtime() ? "  [RT]" : ""));
 }
 
 void AppDialog::createNetworkApp()
@@ -713,6 +700,10 @@ QString AppDialog::getNetworkInfo()
 
 void AppDialog::createSettingsApp()
 {
+    // 背光只由本程序调节，拖动滑块时重复的档位不必再写
+    m_backlightAttr = BoardAttr("/sys/devices/platform/backlight/backlight/backlight/brightness",
+                                BoardIo::ReadWrite, true);
+    
     m_contentLabel->setText("系统设置");
     m_contentLabel->setStyleSheet("font-size: 18px; color: #333; font-weight: bold;");
     
@@ -735,11 +726,8 @@ void AppDialog::createSettingsApp()
         infoLabel->setStyleSheet("font-size: 12px; color: #999;");
         brightnessLayout->addWidget(infoLabel);
         
-        // 当前亮度显示
-        int currentLevel = getCurrentBrightness();  // 读取的是档位编号 1-7
-        if (currentLevel < 1 || currentLevel > 7) {
-            currentLevel = 4;  // 默认档位4
-        }
+        // 当前亮度显示：先按默认档位4显示，实际档位异步读回后再刷新
+        int currentLevel = 4;
         const int brightnessValues[] = {0, 4, 8, 16, 32, 64, 128, 255};  // 索引0不用，1-7对应档位1-7
         
         QString currentBrightnessText = QString("当前档位: <b>%1</b> (亮度值: %2)").arg(currentLevel).arg(brightnessValues[currentLevel]);
@@ -821,6 +809,20 @@ void AppDialog::createSettingsApp()
         // 保存最后一次实际设置的值，防止重复设置
         int *lastSetValue = new int(currentLevel);
         
+        // 读取当前档位（档位编号 1-7），不触发写入
+        m_backlightAttr.readInt(this, [brightnessValues, currentLabel, brightnessSlider, lastSetValue](bool ok, int level) {
+            if (!ok || level < 1 || level > 7) {
+                qDebug() << "Failed to read brightness level";
+                return;
+            }
+            qDebug() << "Current brightness level:" << level;
+            *lastSetValue = level;
+            brightnessSlider->blockSignals(true);
+            brightnessSlider->setValue(level);
+            brightnessSlider->blockSignals(false);
+            currentLabel->setText(QString("当前档位: <b>%1</b> (亮度值: %2)").arg(level).arg(brightnessValues[level]));
+        });
+        
         // 连接滑动条的 valueChanged 信号
         // 但使用 QTimer 防抖，避免拖动时频繁写入文件
         QTimer *debounceTimer = new QTimer(this);
@@ -879,48 +881,6 @@ void AppDialog::createSettingsApp()
     }
 }
 
-int AppDialog::getCurrentBrightness()
-{
-    QString filePath = "/sys/devices/platform/backlight/backlight/backlight/brightness";
-    QFile file(filePath);
-    
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Failed to open brightness file:" << filePath;
-        return -1;
-    }
-    
-    QTextStream in(&file);
-    QString line = in.readLine().trimmed();
-    file.close();
-    
-    bool ok;
-    int level = line.toInt(&ok);  // 读取的是档位编号 1-7
-    if (ok && level >= 1 && level <= 7) {
-        qDebug() << "Current brightness level:" << level;
-        return level;
-    }
-    
-    return -1;
-}
-
-bool AppDialog::writeBrightness(int value)
-{
-    QString filePath = "/sys/devices/platform/backlight/backlight/backlight/brightness";
-    QFile file(filePath);
-    
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qDebug() << "Failed to open brightness file for writing:" << filePath;
-        return false;
-    }
-    
-    QTextStream out(&file);
-    out << value;  // 写入档位编号 1-7
-    file.close();
-    
-    qDebug() << "Brightness level set to:" << value;
-    return true;
-}
-
 void AppDialog::setBrightness(int level)
 {
     // level 是档位编号 1-7
@@ -929,14 +889,18 @@ void AppDialog::setBrightness(int level)
         return;
     }
     
-    if (writeBrightness(level)) {
-        qDebug() << "Successfully set brightness to level:" << level;
-    } else {
-        qDebug() << "Failed to set brightness to level:" << level;
-        QMessageBox::warning(this, "错误", 
-            QString("设置亮度失败！\n请确保有足够的权限访问:\n%1")
-            .arg("/sys/devices/platform/backlight/backlight/backlight/brightness"));
-    }
+    // 写入档位编号 1-7，失败时再提示（回调在主线程执行）
+    m_backlightAttr.write(level, this, [this, level](bool ok) {
+        if (ok) {
+            qDebug() << "Successfully set brightness to level:" << level;
+        } else {
+            qDebug() << "Failed to set brightness to level:" << level;
+            Beeper::instance()->alarm();
+            QMessageBox::warning(this, "错误", 
+                QString("设置亮度失败！\n请确保有足够的权限访问:\n%1")
+                .arg(m_backlightAttr.path()));
+        }
+    });
 }
 
 void AppDialog::createMediaApp()
@@ -946,13 +910,35 @@ void AppDialog::createMediaApp()
         m_contentLabel->hide();
     }
     
-    // 创建音乐播放器（完整版，使用图片资源）
-    MusicPlayer *musicPlayer = new MusicPlayer(this);
+    // 音乐播放器界面（完整版，使用图片资源）只在第一次打开时创建；播放在 PlayerService 中进行，
+    // 关闭对话框时界面隐藏后留在主窗口下，再次打开时移入本对话框，不重建界面也不重新加载样式
+    if (parentWidget()) {
+        m_musicPlayer = parentWidget()->findChild<MusicPlayer*>(QString(), Qt::FindDirectChildrenOnly);
+    }
+    if (!m_musicPlayer) {
+        m_musicPlayer = new MusicPlayer(this);
+    }
     
     // 获取主布局并添加音乐播放器
     QVBoxLayout *mainLayout = qobject_cast<QVBoxLayout*>(layout());
     if (mainLayout) {
-        mainLayout->addWidget(musicPlayer);
+        mainLayout->addWidget(m_musicPlayer);
+    }
+    m_musicPlayer->show();
+}
+
+void AppDialog::createPwmApp()
+{
+    // 隐藏默认的内容标签
+    if (m_contentLabel) {
+        m_contentLabel->hide();
+    }
+
+    PwmGenerator *generator = new PwmGenerator(this);
+
+    QVBoxLayout *mainLayout = qobject_cast<QVBoxLayout*>(layout());
+    if (mainLayout) {
+        mainLayout->addWidget(generator);
     }
 }
 
@@ -963,7 +949,36 @@ void AppDialog::createFileApp()
 
 void AppDialog::createSystemApp()
 {
-    m_contentLabel->setText("系统信息\n\nCPU：NXP i.MX6ULL\n内存：512MB\n存储：8GB eMMC");
+    QString info = "系统信息\n\nCPU：NXP i.MX6ULL\n内存：512MB\n存储：8GB eMMC";
+    
+    // 板级 I/O 延迟统计（平均/最大执行耗时，单位 us）
+    static const char *opNames[BoardIo::OpTypeCount] = { "读", "写", "命令", "调用" };
+    info += "\n\n硬件 I/O 统计";
+    for (int type = 0; type < BoardIo::OpTypeCount; ++type) {
+        BoardIo::OpStats st = BoardIo::instance()->stats(static_cast<BoardIo::OpType>(type));
+        info += QString("\n%1: %2 次  平均 %3us  最大 %4us  合并 %5 次  失败 %6 次")
+                .arg(opNames[type])
+                .arg(st.count)
+                .arg(st.averageNs() / 1000)
+                .arg(st.maxNs / 1000)
+                .arg(st.coalesced)
+                .arg(st.failures);
+    }
+
+    // 蜂鸣器队列统计
+    Beeper::Stats beep = Beeper::instance()->stats();
+    info += QString("\n蜂鸣器: 请求 %1  播放 %2  合并 %3  丢弃 %4  打断 %5  最大启动延迟 %6us")
+            .arg(beep.requests)
+            .arg(beep.played)
+            .arg(beep.coalesced)
+            .arg(beep.dropped)
+            .arg(beep.preempted)
+            .arg(beep.maxStartDelayNs / 1000);
+    if (!Beeper::instance()->isAvailable()) {
+        info += "（/dev/beep 不可用）";
+    }
+
+    m_contentLabel->setText(info);
 }
 
 void AppDialog::createAboutApp()
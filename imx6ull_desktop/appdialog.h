@@ -12,6 +12,10 @@
 #include <QVector>
 #include <QDateTime>
 #include <QNetworkInterface>
+#include "boardio.h"
+
+class SensorSampler;
+class MusicPlayer;
 
 QT_CHARTS_USE_NAMESPACE
 
@@ -24,10 +28,11 @@ public:
     ~AppDialog();
 
 private slots:
-    void updateSensorData();
     void switchSensorMode();
     void toggleYAxisMode();
     void setBrightness(int level);
+    void onSensorSample(qint64 sampleNs, int raw, float scale, float voltage);
+    void onSensorSampleFailed(qint64 sampleNs);
 
 private:
     void setupUI(const QString &appName);
@@ -39,21 +44,16 @@ private:
     void createFileApp();
     void createSystemApp();
     void createAboutApp();
-    
-    // ADC 读取相关
-    int readAdcData(int &raw, float &scale, float &voltage);
-    QString readFileContent(const QString &filePath);
+    void createPwmApp();
     
     // 传感器图表相关
     void setupSensorChart();
-    void updateChartData(int rawValue);
+    void updateChartData(int rawValue, qint64 sampleNs);
+    void updateSensorTiming();
     
     // 网络信息相关
     QString getNetworkInfo();
     
-    // 系统设置相关
-    int getCurrentBrightness();
-    bool writeBrightness(int value);
 
 private:
     QString m_appName;
@@ -62,7 +62,8 @@ private:
     QPushButton *m_closeButton;
     
     // 传感器相关
-    QTimer *m_sensorTimer;
+    SensorSampler *m_sensorSampler;
+    QLabel *m_sensorInfoLabel;
     QLabel *m_adcRawLabel;
     QLabel *m_adcVoltageLabel;
     QLabel *m_adcScaleLabel;
@@ -81,8 +82,14 @@ private:
     QValueAxis *m_axisX;
     QValueAxis *m_axisY;
     QVector<QPointF> m_dataPoints;
-    qint64 m_startTime;
+    qint64 m_startTime;         // 采样起点（CLOCK_MONOTONIC，纳秒）
     int m_maxDataPoints;
+    
+    // 系统设置相关
+    BoardAttr m_backlightAttr;
+    
+    // 多媒体：进程内唯一的播放器界面，对话框关闭时交还给主窗口
+    MusicPlayer *m_musicPlayer;
 };
 
 #endif // APPDIALOG_H
@@ -0,0 +1,92 @@
+# 进程内音频播放引擎（ALSA），网络流的接收使用 QtNetwork
+# 由 imx6ull_desktop.pro 通过 include(audio/audio.pri) 引入
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+LIBS += -lasound
+
+SOURCES += \
+    $$PWD/audiodecoder.cpp \
+    $$PWD/wavdecoder.cpp \
+    $$PWD/flacdecoder.cpp \
+    $$PWD/mp3seektable.cpp \
+    $$PWD/jitterbuffer.cpp \
+    $$PWD/httpstream.cpp \
+    $$PWD/streamdecoder.cpp \
+    $$PWD/pcmringbuffer.cpp \
+    $$PWD/playbackclock.cpp \
+    $$PWD/audiodiagnostics.cpp \
+    $$PWD/pcmwriter.cpp \
+    $$PWD/resampler.cpp \
+    $$PWD/softwaregain.cpp \
+    $$PWD/equalizer.cpp \
+    $$PWD/loudnessmeter.cpp \
+    $$PWD/waveformoverview.cpp \
+    $$PWD/volumecontrol.cpp \
+    $$PWD/pcmtap.cpp \
+    $$PWD/spectrumanalyzer.cpp \
+    $$PWD/audioengine.cpp \
+    $$PWD/audiobenchmark.cpp
+
+HEADERS += \
+    $$PWD/audiodecoder.h \
+    $$PWD/wavdecoder.h \
+    $$PWD/flacdecoder.h \
+    $$PWD/mp3seektable.h \
+    $$PWD/jitterbuffer.h \
+    $$PWD/httpstream.h \
+    $$PWD/streamdecoder.h \
+    $$PWD/pcmringbuffer.h \
+    $$PWD/playbackclock.h \
+    $$PWD/audiodiagnostics.h \
+    $$PWD/pcmwriter.h \
+    $$PWD/resampler.h \
+    $$PWD/softwaregain.h \
+    $$PWD/equalizer.h \
+    $$PWD/loudnessmeter.h \
+    $$PWD/waveformoverview.h \
+    $$PWD/volumecontrol.h \
+    $$PWD/pcmtap.h \
+    $$PWD/spectrumanalyzer.h \
+    $$PWD/audioengine.h \
+    $$PWD/audiobenchmark.h
+
+# 解码器插件：sysroot 中能用 pkg-config 找到库（mad.pc、vorbisidec.pc）时自动启用（交叉编译时
+# qmake 只在设置了 PKG_CONFIG_SYSROOT_DIR 或 PKG_CONFIG_LIBDIR 时才调用 pkg-config）；库没有
+# .pc 文件时用 CONFIG+=libmad / CONFIG+=tremor 手动启用。确实不需要 MP3 或 Ogg Vorbis 时
+# 用 CONFIG+=no_libmad / CONFIG+=no_tremor 明确关闭，音乐库也不再列出这些格式的文件；
+# 两者都没给出时 qmake 报错，而不是悄悄编出一个不能播放 MP3 的播放器
+packagesExist(mad) {
+    CONFIG += libmad link_pkgconfig
+    PKGCONFIG += mad
+} else:libmad {
+    LIBS += -lmad
+} else:!no_libmad {
+    error("找不到 libmad（mad.pc）：安装 libmad 并设置 PKG_CONFIG_SYSROOT_DIR/PKG_CONFIG_LIBDIR，或用 CONFIG+=libmad 手动启用；不需要 MP3 时用 CONFIG+=no_libmad")
+}
+
+libmad {
+    DEFINES += HAVE_LIBMAD
+    SOURCES += $$PWD/mp3decoder.cpp
+    HEADERS += $$PWD/mp3decoder.h
+} else {
+    warning("未启用 libmad：不能播放 MP3，音乐库中不列出 .mp3 文件")
+}
+
+packagesExist(vorbisidec) {
+    CONFIG += tremor link_pkgconfig
+    PKGCONFIG += vorbisidec
+} else:tremor {
+    LIBS += -lvorbisidec
+} else:!no_tremor {
+    error("找不到 Tremor（vorbisidec.pc）：安装 libvorbisidec 并设置 PKG_CONFIG_SYSROOT_DIR/PKG_CONFIG_LIBDIR，或用 CONFIG+=tremor 手动启用；不需要 Ogg Vorbis 时用 CONFIG+=no_tremor")
+}
+
+tremor {
+    DEFINES += HAVE_TREMOR
+    SOURCES += $$PWD/vorbisdecoder.cpp
+    HEADERS += $$PWD/vorbisdecoder.h
+} else {
+    warning("未启用 Tremor：不能播放 Ogg Vorbis，音乐库中不列出 .ogg 文件")
+}
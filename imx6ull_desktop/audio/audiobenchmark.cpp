@@ -0,0 +1,789 @@
+#include "audiobenchmark.h"
+#include "wavdecoder.h"
+#include "equalizer.h"
+#include "pcmringbuffer.h"
+#include "pcmwriter.h"
+#include "playbackclock.h"
+#include "resampler.h"
+#include "streamdecoder.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <time.h>
+#include <sys/resource.h>
+#include <alsa/asoundlib.h>
+#include <cmath>
+#include <cstring>
+
+// 与 AudioEngine 一致的缓冲区与解码块大小
+static const int kRingSamples = 1 << 17;
+static const int kDecodeFrames = 2048;
+static const unsigned int kPcmLatencyUs = 100000;
+
+// 播放路径测试默认直接写 wm8960 的硬件设备（只有这样 mmap 才是写 DMA 缓冲区），按实时速度播放这么多秒
+static const char *kBenchDevice = "hw:0,0";
+static const int kBenchSeconds = 10;
+
+// 重采样测试的音频长度（秒）
+static const int kResamplerSeconds = 20;
+
+// 解码测试中均匀分布的定位次数
+static const int kDecoderSeeks = 20;
+
+// 均衡器测试每次处理的帧数（与输出周期相当）与折算可用频段数的 CPU 预算（单核千分比）
+static const int kEqualizerFrames = 1024;
+static const int kEqualizerBudget = 100;
+
+// 网络流测试：模拟的声卡最多领先消耗这么多音频，回环服务器每次发送的时间片，
+// 直播模式插入元数据的间隔
+static const int kStreamLeadMs = 200;
+static const int kServerSliceMs = 20;
+static const int kServerMetaInterval = 8192;
+
+struct BenchResult {
+    bool ok = false;
+    QString error;
+    bool mapped = false;
+    PcmWriter::Access access = PcmWriter::CopyAccess;
+    qint64 frames = 0;
+    int sampleRate = 0;
+    qint64 wallNs = 0;
+    qint64 cpuNs = 0;
+    long minorFaults = 0;
+    long majorFaults = 0;
+};
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static void threadFaults(long &minor, long &major)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    minor = usage.ru_minflt;
+    major = usage.ru_majflt;
+}
+
+// 把整个文件读一遍，两条路径都在页缓存已热的条件下比较
+static void warmPageCache(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QByteArray block(1 << 20, Qt::Uninitialized);
+    while (file.read(block.data(), block.size()) > 0) {
+    }
+}
+
+static BenchResult runPath(const QString &path, const QString &device, bool zeroCopy, int seconds)
+{
+    BenchResult result;
+
+    WavDecoder decoder;
+    decoder.setMemoryMapEnabled(zeroCopy);
+    if (!decoder.open(path)) {
+        result.error = decoder.errorString();
+        return result;
+    }
+    AudioFormat format = decoder.format();
+    int channels = format.channels;
+
+    PcmWriter writer;
+    if (!writer.open(device, zeroCopy ? device : QString(), format, kPcmLatencyUs, result.error)) {
+        return result;
+    }
+    result.mapped = decoder.isMemoryMapped();
+    result.access = writer.access();
+    result.sampleRate = format.sampleRate;
+
+    qint64 limit = seconds > 0 ? qint64(seconds) * format.sampleRate : decoder.totalFrames();
+    PcmRingBuffer ring(kRingSamples);
+    QVector<qint16> chunk(kDecodeFrames * channels);
+    bool eof = false;
+
+    long minorBefore = 0;
+    long majorBefore = 0;
+    threadFaults(minorBefore, majorBefore);
+    qint64 cpuBefore = threadCpuNs();
+    qint64 wallBefore = PlaybackClock::nowNs();
+
+    while (result.frames < limit) {
+        // 解码线程的工作：填满环形缓冲区
+        while (!eof && ring.freeSpace() >= kDecodeFrames * channels) {
+            const qint16 *data = nullptr;
+            int frames = decoder.readDirect(&data, kDecodeFrames);
+            if (frames < 0) {
+                frames = decoder.read(chunk.data(), kDecodeFrames);
+                data = chunk.constData();
+            }
+            if (frames <= 0) {
+                eof = true;
+                break;
+            }
+            ring.write(data, frames * channels);
+        }
+
+        // 输出线程的工作：每次写一个周期
+        int frames = int(qMin<qint64>(qMin(ring.available() / channels, writer.periodFrames()),
+                                      limit - result.frames));
+        if (frames <= 0) {
+            break;
+        }
+        writer.write(frames, [&](qint16 *dst, int count) {
+            ring.read(dst, count * channels);
+        });
+        result.frames += frames;
+    }
+
+    result.wallNs = PlaybackClock::nowNs() - wallBefore;
+    result.cpuNs = threadCpuNs() - cpuBefore;
+    long minorAfter = 0;
+    long majorAfter = 0;
+    threadFaults(minorAfter, majorAfter);
+    result.minorFaults = minorAfter - minorBefore;
+    result.majorFaults = majorAfter - majorBefore;
+    result.ok = true;
+    return result;
+}
+
+int AudioBenchmark::run(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    if (arguments.isEmpty()) {
+        out << QString("用法: --bench-audio <file.wav> [设备，默认 %1] [秒数，默认 %2]\n")
+               .arg(kBenchDevice).arg(kBenchSeconds);
+        return 2;
+    }
+
+    QString path = arguments.value(0);
+    QString device = arguments.value(1, kBenchDevice);
+    int seconds = arguments.size() > 2 ? arguments.value(2).toInt() : kBenchSeconds;
+
+    warmPageCache(path);
+
+    const bool modes[2] = { false, true };
+    for (bool zeroCopy : modes) {
+        BenchResult r = runPath(path, device, zeroCopy, seconds);
+        QString name = zeroCopy ? "零拷贝" : "复制";
+        if (!r.ok) {
+            out << QString("%1: 失败，%2\n").arg(name, r.error);
+            return 1;
+        }
+
+        double audioSeconds = double(r.frames) / r.sampleRate;
+        double cpuMs = r.cpuNs / 1e6;
+        out << QString("%1（%2 + %3）\n").arg(name)
+               .arg(r.mapped ? "mmap 文件" : "read 文件")
+               .arg(r.access == PcmWriter::MmapAccess ? "mmap 写入" : "writei 写入")
+            << QString("  音频 %1 秒，墙钟 %2 ms，CPU %3 ms（每秒音频 %4 ms）\n")
+               .arg(audioSeconds, 0, 'f', 1).arg(r.wallNs / 1e6, 0, 'f', 1)
+               .arg(cpuMs, 0, 'f', 1).arg(audioSeconds > 0 ? cpuMs / audioSeconds : 0.0, 0, 'f', 3)
+            << QString("  缺页 %1 次（其中需读盘 %2 次）\n").arg(r.minorFaults + r.majorFaults).arg(r.majorFaults);
+        out.flush();
+    }
+    return 0;
+}
+
+// 立体声测试信号：两个正弦叠加少量噪声，避免全零数据走捷径
+static QVector<qint16> testSignal(int sampleRate, int seconds)
+{
+    int frames = sampleRate * seconds;
+    QVector<qint16> samples(frames * 2);
+    quint32 noise = 12345;
+    for (int i = 0; i < frames; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        double t = double(i) / sampleRate;
+        double n = (int(noise >> 16) - 32768) / 32768.0 * 0.02;
+        samples[i * 2] = qint16(12000 * std::sin(2 * M_PI * 440 * t) + 3000 * n);
+        samples[i * 2 + 1] = qint16(12000 * std::sin(2 * M_PI * 5000 * t) + 3000 * n);
+    }
+    return samples;
+}
+
+// 打开内联定义的 plug → null 设备；rate 与输入不同时 plug 自动插入 rate 插件
+static snd_pcm_t *openPlugNull(int inputRate, int slaveRate, const QString &converter,
+                               snd_config_t **config, QString &error)
+{
+    QString text = QString("pcm.bench { type plug slave { pcm { type null } rate %1 } %2 }")
+            .arg(slaveRate)
+            .arg(converter.isEmpty() ? QString() : QString("rate_converter \"%1\"").arg(converter));
+    QByteArray bytes = text.toLatin1();
+
+    snd_input_t *input = nullptr;
+    *config = nullptr;
+    int err = snd_input_buffer_open(&input, bytes.constData(), bytes.size());
+    if (err == 0) {
+        err = snd_config_top(config);
+        if (err == 0) {
+            err = snd_config_load(*config, input);
+        }
+        snd_input_close(input);
+    }
+
+    snd_pcm_t *pcm = nullptr;
+    if (err == 0) {
+        err = snd_pcm_open_lconf(&pcm, "bench", SND_PCM_STREAM_PLAYBACK, 0, *config);
+    }
+    if (err == 0) {
+        err = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+                                 2, unsigned(inputRate), 1, kPcmLatencyUs);
+        if (err < 0) {
+            snd_pcm_close(pcm);
+            pcm = nullptr;
+        }
+    }
+    if (err < 0) {
+        error = snd_strerror(err);
+        if (*config) {
+            snd_config_delete(*config);
+            *config = nullptr;
+        }
+        return nullptr;
+    }
+    return pcm;
+}
+
+// 把测试信号写入 plug → null，返回线程 CPU 时间（纳秒），失败返回 -1
+static qint64 measurePlug(const QVector<qint16> &signal, int inputRate, int slaveRate,
+                          const QString &converter, QString &error)
+{
+    snd_config_t *config = nullptr;
+    snd_pcm_t *pcm = openPlugNull(inputRate, slaveRate, converter, &config, error);
+    if (!pcm) {
+        return -1;
+    }
+
+    int frames = signal.size() / 2;
+    qint64 cpuBefore = threadCpuNs();
+    for (int offset = 0; offset < frames; ) {
+        int count = qMin(kDecodeFrames, frames - offset);
+        snd_pcm_sframes_t n = snd_pcm_writei(pcm, signal.constData() + offset * 2, snd_pcm_uframes_t(count));
+        if (n < 0) {
+            if (snd_pcm_recover(pcm, int(n), 1) < 0) {
+                error = snd_strerror(int(n));
+                break;
+            }
+            continue;
+        }
+        offset += int(n);
+    }
+    qint64 cpuNs = threadCpuNs() - cpuBefore;
+
+    snd_pcm_close(pcm);
+    snd_config_delete(config);
+    return error.isEmpty() ? cpuNs : -1;
+}
+
+int AudioBenchmark::runResampler(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    int inputRate = arguments.value(0, "44100").toInt();
+    int outputRate = arguments.value(1, "48000").toInt();
+    QString converter = arguments.value(2);
+    if (!Resampler::isSupported(inputRate, outputRate)) {
+        out << QString("不支持 %1 -> %2 Hz\n").arg(inputRate).arg(outputRate);
+        return 2;
+    }
+
+    QVector<qint16> signal = testSignal(inputRate, kResamplerSeconds);
+    int frames = signal.size() / 2;
+    double seconds = double(kResamplerSeconds);
+    out << QString("单路立体声 %1 -> %2 Hz，%3 秒音频，数值为每秒音频的 CPU 毫秒数（即单核占用的千分比）\n")
+           .arg(inputRate).arg(outputRate).arg(kResamplerSeconds);
+
+    const Resampler::Quality qualities[3] = {
+        Resampler::LowQuality, Resampler::MediumQuality, Resampler::HighQuality
+    };
+    for (Resampler::Quality quality : qualities) {
+        Resampler resampler(inputRate, outputRate, 2, quality);
+        QVector<qint16> output(resampler.maxOutputFrames(kDecodeFrames) * 2);
+        qint64 cpuBefore = threadCpuNs();
+        for (int offset = 0; offset < frames; offset += kDecodeFrames) {
+            int count = qMin(kDecodeFrames, frames - offset);
+            resampler.process(signal.constData() + offset * 2, count, output.data());
+        }
+        qint64 cpuNs = threadCpuNs() - cpuBefore;
+        out << QString("  Resampler %1（%2 抽头）: %3 ms\n")
+               .arg(Resampler::qualityName(quality)).arg(resampler.taps())
+               .arg(cpuNs / 1e6 / seconds, 0, 'f', 2);
+        out.flush();
+    }
+
+    // plug 本身和 null 设备也有开销：不转换时的结果作为基线一并给出
+    QString error;
+    qint64 baseline = measurePlug(signal, inputRate, inputRate, QString(), error);
+    qint64 converted = measurePlug(signal, inputRate, outputRate, converter, error);
+    if (baseline < 0 || converted < 0) {
+        out << QString("  ALSA plug: 失败，%1\n").arg(error);
+        return 1;
+    }
+    out << QString("  ALSA plug rate（%1）: %2 ms，其中不转换时的 plug + null 开销 %3 ms\n")
+           .arg(converter.isEmpty() ? QString("默认") : converter)
+           .arg(converted / 1e6 / seconds, 0, 'f', 2)
+           .arg(baseline / 1e6 / seconds, 0, 'f', 2);
+    return 0;
+}
+
+int AudioBenchmark::runDecoders(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    if (arguments.isEmpty()) {
+        out << QString("用法: --bench-decoders <文件> [文件...]\n");
+        return 2;
+    }
+    out << QString("实时倍数 = 音频时长 / 解码线程 CPU 时间，页缓存已预热\n");
+
+    struct Total {
+        int files = 0;
+        double audioSeconds = 0;
+        double cpuSeconds = 0;
+    };
+    QMap<QString, Total> totals;
+    QVector<qint16> buffer;
+    int failures = 0;
+
+    for (const QString &path : arguments) {
+        QString name = QFileInfo(path).fileName();
+        const AudioDecoderPlugin *plugin = AudioDecoder::plugin(path);
+        if (!plugin) {
+            out << QString("%1: 没有对应的解码器\n").arg(name);
+            ++failures;
+            continue;
+        }
+        warmPageCache(path);
+
+        // 打开也计入：MP3 要读定位表缓存或首帧，FLAC 要解析元数据
+        QScopedPointer<AudioDecoder> decoder(plugin->create());
+        qint64 wallStart = PlaybackClock::nowNs();
+        qint64 cpuStart = threadCpuNs();
+        if (!decoder->open(path)) {
+            out << QString("%1: 打开失败，%2\n").arg(name, decoder->errorString());
+            ++failures;
+            continue;
+        }
+        AudioFormat format = decoder->format();
+        buffer.resize(kDecodeFrames * format.channels);
+        qint64 frames = 0;
+        int count;
+        while ((count = decoder->read(buffer.data(), kDecodeFrames)) > 0) {
+            frames += count;
+        }
+        qint64 cpuNs = threadCpuNs() - cpuStart;
+        qint64 wallNs = PlaybackClock::nowNs() - wallStart;
+        if (count < 0 || frames == 0) {
+            out << QString("%1: 解码失败，%2\n").arg(name, decoder->errorString());
+            ++failures;
+            continue;
+        }
+
+        // 定位后解出第一块才算完成
+        qint64 length = decoder->totalFrames() > 0 ? decoder->totalFrames() : frames;
+        qint64 seekStart = threadCpuNs();
+        for (int i = 0; i < kDecoderSeeks; ++i) {
+            decoder->seek(length * i / kDecoderSeeks);
+            decoder->read(buffer.data(), kDecodeFrames);
+        }
+        qint64 seekNs = (threadCpuNs() - seekStart) / kDecoderSeeks;
+
+        double audioSeconds = double(frames) / format.sampleRate;
+        double cpuSeconds = cpuNs / 1e9;
+        out << QString("%1 [%2] %3 Hz %4 声道 %5 秒\n").arg(name, QString::fromLatin1(plugin->name))
+               .arg(format.sampleRate).arg(format.channels).arg(audioSeconds, 0, 'f', 1)
+            << QString("  CPU %1 ms，墙钟 %2 ms，实时倍数 %3，定位平均 %4 ms\n")
+               .arg(cpuSeconds * 1e3, 0, 'f', 1).arg(wallNs / 1e6, 0, 'f', 1)
+               .arg(cpuSeconds > 0 ? audioSeconds / cpuSeconds : 0.0, 0, 'f', 1)
+               .arg(seekNs / 1e6, 0, 'f', 2);
+        out.flush();
+
+        Total &total = totals[QString::fromLatin1(plugin->name)];
+        ++total.files;
+        total.audioSeconds += audioSeconds;
+        total.cpuSeconds += cpuSeconds;
+    }
+
+    if (!totals.isEmpty()) {
+        out << QString("按解码器汇总:\n");
+        for (auto it = totals.constBegin(); it != totals.constEnd(); ++it) {
+            const Total &total = it.value();
+            out << QString("  %1: %2 个文件，%3 秒音频，实时倍数 %4\n").arg(it.key()).arg(total.files)
+                   .arg(total.audioSeconds, 0, 'f', 1)
+                   .arg(total.cpuSeconds > 0 ? total.audioSeconds / total.cpuSeconds : 0.0, 0, 'f', 1);
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+int AudioBenchmark::runEqualizer(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    int sampleRate = arguments.value(0, "48000").toInt();
+    if (sampleRate <= 0) {
+        out << QString("用法: --bench-eq [采样率，默认 48000]\n");
+        return 2;
+    }
+
+    QVector<qint16> signal = testSignal(sampleRate, kResamplerSeconds);
+    int frames = signal.size() / 2;
+    double seconds = double(kResamplerSeconds);
+    out << QString("立体声 %1 Hz，%2 秒音频，数值为每秒音频的 CPU 毫秒数（即单核占用的千分比）\n")
+           .arg(sampleRate).arg(kResamplerSeconds);
+
+    // 0 个频段只有前级增益与格式转换，作为固定开销
+    QVector<qint16> work(kEqualizerFrames * 2);
+    double baseline = 0;
+    double perBand = 0;
+    for (int bands = 0; bands <= Equalizer::kMaxBands; ++bands) {
+        Equalizer::Parameters parameters;
+        parameters.preampDb = -3.0f;
+        parameters.bandCount = bands;
+        for (int i = 0; i < bands; ++i) {
+            // 31Hz ~ 16kHz 按倍频程分布
+            parameters.bands[i].frequency = 31.25f * float(1 << i);
+            parameters.bands[i].gainDb = 3.0f;
+            parameters.bands[i].q = 1.0f;
+        }
+        Equalizer equalizer;
+        equalizer.setParameters(parameters);
+        equalizer.prepare(sampleRate, 2);
+
+        qint64 cpuBefore = threadCpuNs();
+        for (int offset = 0; offset < frames; offset += kEqualizerFrames) {
+            int count = qMin(kEqualizerFrames, frames - offset);
+            memcpy(work.data(), signal.constData() + offset * 2, size_t(count) * 2 * sizeof(qint16));
+            equalizer.process(work.data(), count);
+        }
+        double ms = (threadCpuNs() - cpuBefore) / 1e6 / seconds;
+        if (bands == 0) {
+            baseline = ms;
+            out << QString("  固定开销（格式转换与前级增益）: %1 ms\n").arg(ms, 0, 'f', 2);
+        } else {
+            perBand = (ms - baseline) / bands;
+            out << QString("  %1 个频段: %2 ms，平均每频段 %3 ms\n").arg(bands).arg(ms, 0, 'f', 2)
+                   .arg(perBand, 0, 'f', 3);
+        }
+        out.flush();
+    }
+
+    if (perBand > 0) {
+        int affordable = int((kEqualizerBudget - baseline) / perBand);
+        out << QString("按单核 %1% 的预算最多可用 %2 个频段\n").arg(kEqualizerBudget / 10).arg(affordable);
+    }
+    return 0;
+}
+
+/**
+ * @brief 回环 HTTP 服务器：按指定码率（可选突发、定时断开）发送一个文件
+ *
+ * 文件模式带 Content-Length 并支持 Range；直播模式模拟 Icecast：ICY 状态行、
+ * 没有长度、循环发送，客户端请求时插入 icy-metaint 元数据，重连后从上次断开处继续。
+ */
+class LoopbackStreamServer : public QThread
+{
+public:
+    LoopbackStreamServer(const QByteArray &data, const QByteArray &contentType, int kbps,
+                         int burstSeconds, int dropSeconds, bool live)
+        : m_data(data), m_contentType(contentType), m_byteRate(kbps * 125)
+        , m_burstSeconds(burstSeconds), m_dropSeconds(dropSeconds), m_live(live)
+        , m_port(0), m_stop(0), m_livePos(0), m_metaCount(0)
+    {
+    }
+
+    // 开始监听后返回端口，失败返回 0
+    quint16 waitForPort()
+    {
+        m_ready.acquire();
+        return m_port;
+    }
+
+    void stop()
+    {
+        m_stop.storeRelease(1);
+        wait();
+    }
+
+protected:
+    void run() override
+    {
+        QTcpServer server;
+        if (server.listen(QHostAddress::LocalHost, 0)) {
+            m_port = server.serverPort();
+        }
+        m_ready.release();
+        while (m_port && !m_stop.loadAcquire()) {
+            if (!server.waitForNewConnection(100)) {
+                continue;
+            }
+            QScopedPointer<QTcpSocket> socket(server.nextPendingConnection());
+            serve(*socket);
+        }
+    }
+
+private:
+    void serve(QTcpSocket &socket)
+    {
+        // 请求头：只关心 Range 与 Icy-MetaData
+        QByteArray request;
+        while (!request.contains("\r\n\r\n") && request.size() < 16384) {
+            if (!socket.waitForReadyRead(5000)) {
+                return;
+            }
+            request += socket.readAll();
+        }
+        qint64 offset = 0;
+        bool metadata = false;
+        for (const QByteArray &line : request.split('\n')) {
+            QByteArray lower = line.trimmed().toLower();
+            if (lower.startsWith("range: bytes=")) {
+                offset = qBound<qint64>(0, lower.mid(13).split('-').first().toLongLong(), m_data.size());
+            } else if (lower == "icy-metadata: 1") {
+                metadata = m_live;
+            }
+        }
+
+        QByteArray header;
+        qint64 length = m_data.size();
+        if (m_live) {
+            header = "ICY 200 OK\r\nicy-name: loopback\r\nicy-br: " + QByteArray::number(m_byteRate / 125)
+                   + "\r\nContent-Type: " + m_contentType + "\r\n";
+            if (metadata) {
+                header += "icy-metaint: " + QByteArray::number(kServerMetaInterval) + "\r\n";
+            }
+            offset = m_livePos;
+        } else if (offset > 0) {
+            header = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + QByteArray::number(offset) + "-"
+                   + QByteArray::number(length - 1) + "/" + QByteArray::number(length)
+                   + "\r\nContent-Length: " + QByteArray::number(length - offset)
+                   + "\r\nContent-Type: " + m_contentType + "\r\n";
+        } else {
+            header = "HTTP/1.1 200 OK\r\nAccept-Ranges: bytes\r\nContent-Length: " + QByteArray::number(length)
+                   + "\r\nContent-Type: " + m_contentType + "\r\n";
+        }
+        socket.write(header + "Connection: close\r\n\r\n");
+
+        // 按时间表发送：匀速时每个时间片补足到 码率×时间，突发时每 burst 秒一次发完
+        QElapsedTimer timer;
+        timer.start();
+        qint64 sent = 0;
+        qint64 pos = offset;
+        int untilMeta = kServerMetaInterval;
+        while (!m_stop.loadAcquire() && (m_live || pos < length)
+               && socket.state() == QAbstractSocket::ConnectedState) {
+            qint64 elapsed = timer.elapsed();
+            if (m_dropSeconds > 0 && elapsed >= m_dropSeconds * 1000LL) {
+                break;      // 模拟断线
+            }
+            qint64 due = sent + 64 * 1024;
+            if (m_byteRate > 0) {
+                due = m_burstSeconds > 0
+                        ? (elapsed / (m_burstSeconds * 1000LL) + 1) * m_burstSeconds * m_byteRate
+                        : elapsed * m_byteRate / 1000 + m_byteRate * kServerSliceMs / 1000;
+            }
+            qint64 count = qMin<qint64>(due - sent, 64 * 1024);
+            if (!m_live) {
+                count = qMin(count, length - pos);
+            }
+            if (count <= 0 || socket.bytesToWrite() > 256 * 1024) {
+                // 客户端不读（缓冲区满）时写不出去，等它消化
+                socket.waitForBytesWritten(kServerSliceMs);
+                QThread::msleep(kServerSliceMs);
+                continue;
+            }
+            while (count > 0) {
+                int chunk = int(qMin<qint64>(count, length - pos));
+                if (metadata) {
+                    chunk = qMin(chunk, untilMeta);
+                }
+                socket.write(m_data.constData() + pos, chunk);
+                pos += chunk;
+                sent += chunk;
+                count -= chunk;
+                if (m_live && pos == length) {
+                    pos = 0;
+                }
+                if (metadata && (untilMeta -= chunk) == 0) {
+                    QByteArray meta = "StreamTitle='loopback #" + QByteArray::number(++m_metaCount) + "';";
+                    int blocks = (meta.size() + 15) / 16;
+                    meta.append(QByteArray(blocks * 16 - meta.size(), '\0'));
+                    socket.write(QByteArray(1, char(blocks)) + meta);
+                    untilMeta = kServerMetaInterval;
+                }
+            }
+            socket.waitForBytesWritten(kServerSliceMs);
+        }
+        m_livePos = pos;
+        if (socket.state() == QAbstractSocket::ConnectedState) {
+            socket.waitForBytesWritten(1000);
+        }
+        socket.abort();
+    }
+
+    QByteArray m_data;
+    QByteArray m_contentType;
+    int m_byteRate;                 // 0 为不限速
+    int m_burstSeconds;
+    int m_dropSeconds;
+    bool m_live;
+    quint16 m_port;
+    QSemaphore m_ready;
+    QAtomicInt m_stop;
+    qint64 m_livePos;
+    int m_metaCount;
+};
+
+int AudioBenchmark::runStream(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    QStringList args = arguments;
+    bool live = args.removeAll("--live") > 0;
+    if (args.isEmpty()) {
+        out << QString("用法: --bench-stream <文件|http://地址> [秒数，默认 60] [码率 kbps，默认不限]"
+                       " [突发间隔秒数] [断开间隔秒数] [--live]\n");
+        return 2;
+    }
+    QString source = args.value(0);
+    int seconds = qMax(1, args.value(1, "60").toInt());
+    int kbps = args.value(2, "0").toInt();
+    int burstSeconds = args.value(3, "0").toInt();
+    int dropSeconds = args.value(4, "0").toInt();
+
+    // 本地文件由回环服务器按指定的节奏提供
+    QScopedPointer<LoopbackStreamServer> server;
+    QString url = source;
+    if (!HttpStream::handles(source)) {
+        QFile file(source);
+        if (!file.open(QIODevice::ReadOnly)) {
+            out << QString("无法打开 %1\n").arg(source);
+            return 1;
+        }
+        QString suffix = QFileInfo(source).suffix().toLower();
+        QByteArray type = suffix == "mp3" ? "audio/mpeg" : (suffix == "ogg" || suffix == "oga")
+                ? "application/ogg" : "application/octet-stream";
+        server.reset(new LoopbackStreamServer(file.readAll(), type, kbps, burstSeconds, dropSeconds, live));
+        server->start();
+        quint16 port = server->waitForPort();
+        if (!port) {
+            out << QString("回环服务器无法监听\n");
+            return 1;
+        }
+        url = QString("http://127.0.0.1:%1/%2").arg(port).arg(QFileInfo(source).fileName());
+        out << QString("回环服务器 %1：%2，%3%4%5\n").arg(url, live ? "直播" : "文件")
+               .arg(kbps > 0 ? QString("%1 kbps").arg(kbps) : QString("不限速"))
+               .arg(burstSeconds > 0 ? QString("，每 %1 秒突发一次").arg(burstSeconds) : QString())
+               .arg(dropSeconds > 0 ? QString("，每 %1 秒断开").arg(dropSeconds) : QString());
+    }
+
+    QElapsedTimer wall;
+    wall.start();
+    StreamDecoder decoder;
+    if (!decoder.open(url)) {
+        out << QString("打开失败，%1\n").arg(decoder.errorString());
+        return 1;
+    }
+    AudioFormat format = decoder.format();
+    out << QString("%1 Hz %2 声道，打开 %3 ms；模拟声卡按实时速度消耗，数据不够时记为中断\n")
+           .arg(format.sampleRate).arg(format.channels).arg(wall.elapsed());
+    out.flush();
+
+    QSharedPointer<HttpStream> stream = decoder.networkStream();
+    QVector<qint16> buffer(kDecodeFrames * format.channels);
+    qint64 frames = 0;
+    qint64 startMs = -1;            // 第一块解码出来即开始"播放"
+    qint64 playedMs = 0;
+    qint64 stallMs = 0;
+    int stalls = 0;
+    bool stalled = false;
+    qint64 lastMs = 0;
+    qint64 nextReportMs = 1000;
+    qint64 cpuStart = threadCpuNs();
+    bool ended = false;
+
+    while (wall.elapsed() < seconds * 1000LL) {
+        // 模拟声卡：有数据时播放位置随墙钟前进，没有数据的时间记为中断
+        qint64 now = wall.elapsed();
+        qint64 audioMs = frames * 1000 / format.sampleRate;
+        if (startMs >= 0) {
+            qint64 advance = qMin(now - lastMs, audioMs - playedMs);
+            playedMs += advance;
+            stallMs += now - lastMs - advance;
+            bool starved = playedMs >= audioMs;
+            if (starved && !stalled && !ended) {
+                ++stalls;
+            }
+            stalled = starved;
+        }
+        lastMs = now;
+
+        if (now >= nextReportMs) {
+            HttpStream::Status status = stream->status();
+            const char *state = status.buffer.state == JitterBuffer::Buffering ? "缓冲"
+                              : status.buffer.state == JitterBuffer::Playing ? "播放" : "结束";
+            out << QString("%1 s  %2  缓冲 %3/%4 ms  欠载 %5  重连 %6  接收 %7 kbps  中断 %8 次 %9 ms%10\n")
+                   .arg(now / 1000, 3).arg(QString::fromUtf8(state))
+                   .arg(status.buffer.levelMs, 5).arg(status.buffer.targetMs, 5)
+                   .arg(status.buffer.underruns).arg(status.reconnects).arg(status.receiveKbps, 4)
+                   .arg(stalls).arg(stallMs)
+                   .arg(status.title.isEmpty() ? QString() : QString("  [%1]").arg(status.title));
+            out.flush();
+            nextReportMs += 1000;
+        }
+
+        if (ended) {
+            if (playedMs >= audioMs) {
+                break;
+            }
+            QThread::msleep(10);
+            continue;
+        }
+        if (audioMs > playedMs + kStreamLeadMs) {
+            QThread::msleep(10);
+            continue;
+        }
+        int count = decoder.read(buffer.data(), kDecodeFrames);
+        if (count == AudioDecoder::kPending) {
+            QThread::msleep(20);
+            continue;
+        }
+        if (count <= 0) {
+            if (count < 0) {
+                out << QString("解码出错，%1\n").arg(decoder.errorString());
+            }
+            ended = true;
+            continue;
+        }
+        if (startMs < 0) {
+            startMs = now;
+            out << QString("首块音频 %1 ms\n").arg(now);
+        }
+        frames += count;
+    }
+
+    HttpStream::Status status = stream->status();
+    double audioSeconds = double(frames) / format.sampleRate;
+    qint64 cpuNs = threadCpuNs() - cpuStart;
+    out << QString("解码 %1 秒音频，中断 %2 次共 %3 ms，欠载 %4 次，重连 %5 次，最终目标 %6 ms，"
+                   "接收 %7 KB，解码 CPU %8 ms/秒音频%9\n")
+           .arg(audioSeconds, 0, 'f', 1).arg(stalls).arg(stallMs)
+           .arg(status.buffer.underruns).arg(status.reconnects).arg(status.buffer.targetMs)
+           .arg(status.buffer.bytesIn / 1024)
+           .arg(audioSeconds > 0 ? cpuNs / 1e6 / audioSeconds : 0.0, 0, 'f', 2)
+           .arg(status.error.isEmpty() ? QString() : QString("，%1").arg(status.error));
+
+    stream->stop();
+    if (server) {
+        server->stop();
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef AUDIOBENCHMARK_H
+#define AUDIOBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @brief 播放路径基准测试（命令行，不启动界面）
+ *
+ *   imx6ull_desktop --bench-audio <file.wav> [设备] [秒数]
+ *
+ * 用与 AudioEngine 相同的结构（解码 → 环形缓冲区 → 设备）在同一个设备上分别跑两条路径，
+ * 输出墙钟时间、线程 CPU 时间（折算为每秒音频的 CPU 毫秒数）和缺页次数：
+ * - 复制路径：QFile 按块读取并转换，snd_pcm_writei 写入
+ * - 零拷贝路径：文件内存映射，16 位 PCM 直接进缓冲区，snd_pcm_mmap_begin/commit 写入
+ *
+ * 设备默认为 wm8960 的硬件设备 hw:0,0，按实时速度播放 10 秒（秒数为 0 时播放整个文件），
+ * 文件格式须被硬件原样支持，否则零拷贝路径会退回 writei（输出中会标明）。
+ * 也可以指定 null 等设备只比较 CPU 开销，但那时 mmap 写入的是插件自己的缓冲区，
+ * 不代表声卡上的情况。每条路径先预热一次页缓存。
+ *
+ *   imx6ull_desktop --bench-resampler [输入采样率] [输出采样率] [ALSA 转换器名]
+ *
+ * 单路立体声重采样的 CPU 开销：Resampler 的各个质量等级，对比同样的数据经
+ * ALSA plug 的 rate 插件（默认 linear，可指定如 samplerate、speexrate）写入 null 设备。
+ *
+ *   imx6ull_desktop --bench-decoders <文件> [文件...]
+ *
+ * 各解码器插件的速度：整个文件解码到同一块缓冲区，输出实时倍数（音频时长 / CPU 时间）
+ * 与均匀分布的 20 次定位的平均耗时，最后按解码器汇总。不依赖声卡，PC 与开发板上都能运行。
+ *
+ *   imx6ull_desktop --bench-eq [采样率]
+ *
+ * 参数均衡器在 0 ~ 10 个频段时处理立体声的 CPU 开销，给出每个频段的平均开销
+ * 以及单核 10% 预算下可用的频段数。
+ *
+ *   imx6ull_desktop --bench-stream <文件|http://地址> [秒数] [码率kbps] [突发间隔秒数] [断开间隔秒数] [--live]
+ *
+ * 网络流播放：给出本地文件时在回环地址上起一个 HTTP 服务器，按码率限速发送，可以
+ * 每隔几秒突发一次或定时断开连接（--live 模拟 Icecast 直播流与 ICY 元数据）。
+ * StreamDecoder 按实时速度消耗，每秒输出抖动缓冲区的水位、目标、欠载与重连次数，
+ * 以及模拟声卡拿不到数据的中断次数与时长。
+class AudioBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+    static int runResampler(const QStringList &arguments);
+    static int runDecoders(const QStringList &arguments);
+    static int runEqualizer(const QStringList &arguments);
+    static int runStream(const QStringList &arguments);
+};
+
+#endif // AUDIOBENCHMARK_H
@@ -0,0 +1,58 @@
+#include "audiodecoder.h"
+#include "wavdecoder.h"
+#include "flacdecoder.h"
+#include "streamdecoder.h"
+#ifdef HAVE_LIBMAD
+#include "mp3decoder.h"
+#endif
+#ifdef HAVE_TREMOR
+#include "vorbisdecoder.h"
+#endif
+#include <QFileInfo>
+#include <QStringList>
+
+template<typename T>
+static AudioDecoder *createDecoder()
+{
+    return new T();
+}
+
+// 已编入的解码器，同一扩展名以先登记者为准
+static const AudioDecoderPlugin kPlugins[] = {
+    { "wav", "wav", &createDecoder<WavDecoder> },
+    { "flac", "flac", &createDecoder<FlacDecoder> },
+#ifdef HAVE_LIBMAD
+    { "libmad", "mp3", &createDecoder<Mp3Decoder> },
+#endif
+#ifdef HAVE_TREMOR
+    { "tremor", "ogg oga", &createDecoder<VorbisDecoder> },
+#endif
+};
+
+// 网络流按协议识别，不看扩展名（地址中的 .mp3 不代表本地文件）
+static const AudioDecoderPlugin kStreamPlugin = { "http", "", &createDecoder<StreamDecoder> };
+
+const AudioDecoderPlugin *AudioDecoder::plugin(const QString &path)
+{
+    if (HttpStream::handles(path)) {
+        return &kStreamPlugin;
+    }
+
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix.isEmpty()) {
+        return nullptr;
+    }
+
+    for (const AudioDecoderPlugin &plugin : kPlugins) {
+        if (QString::fromLatin1(plugin.suffixes).split(' ').contains(suffix)) {
+            return &plugin;
+        }
+    }
+    return nullptr;
+}
+
+AudioDecoder *AudioDecoder::create(const QString &path)
+{
+    const AudioDecoderPlugin *decoder = plugin(path);
+    return decoder ? decoder->create() : nullptr;
+}
@@ -0,0 +1,87 @@
+#ifndef AUDIODECODER_H
+#define AUDIODECODER_H
+
+#include <QString>
+#include <QSharedPointer>
+
+class HttpStream;
+
+/**
+ * @brief 解码输出的 PCM 格式，样本固定为交错的 16 位有符号整数
+ */
+struct AudioFormat {
+    int sampleRate = 0;
+    int channels = 0;
+
+    bool isValid() const { return sampleRate > 0 && channels > 0; }
+    bool operator==(const AudioFormat &other) const {
+        return sampleRate == other.sampleRate && channels == other.channels;
+    }
+    bool operator!=(const AudioFormat &other) const { return !(*this == other); }
+};
+
+class AudioDecoder;
+
+/**
+ * @brief 解码器插件：名称、处理的扩展名与构造函数
+ *
+ * 插件在编译时登记到 audiodecoder.cpp 的表中，依赖第三方库的插件由 audio.pri 中的开关
+ * 决定是否编入；不在运行时加载动态库。
+ */
+struct AudioDecoderPlugin {
+    const char *name;
+    const char *suffixes;           // 小写扩展名，以空格分隔
+    AudioDecoder *(*create)();
+};
+
+/**
+ * @brief 音频解码器接口
+ *
+ * 解码器只在 AudioEngine 的解码线程中使用，不需要线程安全。
+ */
+class AudioDecoder
+{
+public:
+    // read() 的返回值：暂时没有数据（网络流正在缓冲），稍后重试，不是结束
+    static const int kPending = -2;
+
+    virtual ~AudioDecoder() {}
+
+    virtual bool open(const QString &path) = 0;
+    virtual AudioFormat format() const = 0;
+
+    // 总帧数，未知时返回 -1
+    virtual qint64 totalFrames() const = 0;
+
+    // 解码最多 maxFrames 帧到 buffer（交错 S16），返回帧数；0 表示结束，-1 表示出错，
+    // kPending 表示暂时没有数据
+    virtual int read(qint16 *buffer, int maxFrames) = 0;
+
+    // 不经转换直接取得最多 maxFrames 帧 S16 数据的地址（例如内存映射的 16 位 WAV），
+    // 指针在下一次调用解码器之前有效；返回帧数，0 表示结束，-1 表示不支持，改用 read()
+    virtual int readDirect(const qint16 **data, int maxFrames)
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(maxFrames);
+        return -1;
+    }
+
+    // 定位到指定帧
+    virtual bool seek(qint64 frame) = 0;
+
+    // 网络流的接收端，供界面读取缓冲状态；本地文件返回空指针
+    virtual QSharedPointer<HttpStream> networkStream() const { return QSharedPointer<HttpStream>(); }
+
+    QString errorString() const { return m_errorString; }
+
+    // 按扩展名（网络流按协议）创建解码器，不支持的格式返回 nullptr
+    static AudioDecoder *create(const QString &path);
+
+    // 处理该路径的插件：http:// 地址为网络流，其余按扩展名；没有时返回 nullptr
+    static const AudioDecoderPlugin *plugin(const QString &path);
+
+protected:
+    QString m_errorString;
+};
+
+#endif // AUDIODECODER_H
@@ -0,0 +1,328 @@
+#include "audiodiagnostics.h"
+#include "playbackclock.h"
+#include <QMutexLocker>
+#include <QTextStream>
+#include <cstdio>
+#include <cstdlib>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// 故障列表保留的条数
+static const int kMaxGlitches = 32;
+
+struct HistogramSpec {
+    const char *name;
+    const char *label;
+    qint64 bounds[AudioDiagnostics::kBuckets - 1];
+};
+
+// 解码块约 46ms（2048 帧 @44.1kHz），设备缓冲 100ms，上界按此选取
+static const HistogramSpec kHistograms[AudioDiagnostics::HistogramCount] = {
+    { "audio_ring_fill_percent", "缓冲区填充 (%)",
+      { 10, 20, 30, 40, 50, 60, 70, 80, 90 } },
+    { "audio_decode_chunk_us", "解码耗时/块 (us)",
+      { 250, 500, 1000, 2000, 4000, 8000, 16000, 32000, 64000 } },
+    { "audio_wakeup_late_us", "输出唤醒迟到 (us)",
+      { 100, 250, 500, 1000, 2000, 5000, 10000, 20000, 50000 } },
+};
+
+static const char *const kCounterNames[AudioDiagnostics::CounterCount] = {
+    "audio_frames_written_total",
+    "audio_periods_written_total",
+    "audio_device_underruns_total",
+    "audio_device_suspends_total",
+    "audio_device_timeouts_total",
+    "audio_ring_starvations_total",
+    "audio_glitches_decode_total",
+    "audio_glitches_io_total",
+    "audio_glitches_scheduling_total",
+    "audio_decode_chunks_total",
+    "audio_decoded_frames_total",
+    "audio_decode_wall_ns_total",
+    "audio_decode_cpu_ns_total",
+    "audio_decode_runqueue_ns_total",
+    "audio_equalizer_ns_total",
+    "audio_equalizer_band_frames_total",
+};
+
+static void atomicMax(QAtomicInteger<qint64> &target, qint64 value)
+{
+    qint64 current = target.loadAcquire();
+    while (value > current && !target.testAndSetOrdered(current, value, current)) {
+    }
+}
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+AudioDiagnostics::DecodeProbe::DecodeProbe(AudioDiagnostics *diagnostics)
+    : m_diagnostics(diagnostics)
+    , m_schedFd(-1)
+    , m_startNs(0)
+    , m_startCpuNs(0)
+    , m_startWaitNs(0)
+{
+    // 在解码线程中构造：第一个字段为运行时间，第二个为在运行队列中等待的时间（纳秒）
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%ld/schedstat", long(syscall(SYS_gettid)));
+    m_schedFd = ::open(path, O_RDONLY | O_CLOEXEC);
+}
+
+AudioDiagnostics::DecodeProbe::~DecodeProbe()
+{
+    if (m_schedFd >= 0) {
+        ::close(m_schedFd);
+    }
+}
+
+bool AudioDiagnostics::DecodeProbe::sample(qint64 &cpuNs, qint64 &waitNs) const
+{
+    if (m_schedFd >= 0) {
+        char text[96];
+        ssize_t n = ::pread(m_schedFd, text, sizeof(text) - 1, 0);
+        if (n > 0) {
+            text[n] = '\0';
+            char *end = nullptr;
+            cpuNs = qint64(strtoll(text, &end, 10));
+            waitNs = qint64(strtoll(end, nullptr, 10));
+            return true;
+        }
+    }
+    cpuNs = threadCpuNs();
+    waitNs = -1;
+    return false;
+}
+
+void AudioDiagnostics::DecodeProbe::begin()
+{
+    m_startNs = PlaybackClock::nowNs();
+    sample(m_startCpuNs, m_startWaitNs);
+}
+
+void AudioDiagnostics::DecodeProbe::end(int frames)
+{
+    qint64 cpuNs, waitNs;
+    bool haveWait = sample(cpuNs, waitNs);
+    qint64 wallNs = PlaybackClock::nowNs() - m_startNs;
+    m_diagnostics->recordDecode(wallNs, cpuNs - m_startCpuNs,
+                                haveWait ? waitNs - m_startWaitNs : -1, frames);
+}
+
+AudioDiagnostics::AudioDiagnostics()
+{
+    reset();
+}
+
+void AudioDiagnostics::record(Histogram histogram, qint64 value)
+{
+    const HistogramSpec &spec = kHistograms[histogram];
+    int bucket = 0;
+    while (bucket < kBuckets - 1 && value > spec.bounds[bucket]) {
+        ++bucket;
+    }
+    m_buckets[histogram][bucket].fetchAndAddRelaxed(1);
+    atomicMax(m_maxValue[histogram], value);
+}
+
+void AudioDiagnostics::recordDecode(qint64 wallNs, qint64 cpuNs, qint64 waitNs, int frames)
+{
+    add(DecodeChunks);
+    add(DecodedFrames, quint64(qMax(0, frames)));
+    add(DecodeWallNs, quint64(qMax<qint64>(0, wallNs)));
+    add(DecodeCpuNs, quint64(qMax<qint64>(0, cpuNs)));
+    if (waitNs > 0) {
+        add(DecodeRunqueueNs, quint64(waitNs));
+    }
+    record(DecodeTimeHistogram, wallNs / 1000);
+
+    // 只有解码线程写这三个值
+    if (wallNs > m_worstWallNs.loadAcquire()) {
+        m_worstCpuNs.storeRelease(cpuNs);
+        m_worstWaitNs.storeRelease(waitNs);
+        m_worstWallNs.storeRelease(wallNs);
+    }
+}
+
+void AudioDiagnostics::recordUnderrun(bool ringStarved, int ringFillPercent, qint64 outputLateUs)
+{
+    Glitch glitch;
+    glitch.timestampNs = PlaybackClock::nowNs();
+    glitch.ringStarved = ringStarved;
+    glitch.ringFillPercent = ringFillPercent;
+    glitch.outputLateUs = outputLateUs;
+    glitch.decodeWallUs = m_worstWallNs.loadAcquire() / 1000;
+    glitch.decodeCpuUs = m_worstCpuNs.loadAcquire() / 1000;
+    qint64 waitNs = m_worstWaitNs.loadAcquire();
+    glitch.decodeWaitUs = waitNs >= 0 ? waitNs / 1000 : -1;
+
+    if (!ringStarved) {
+        // 缓冲区里有数据，设备却播空了：输出线程没有按时醒来
+        glitch.cause = SchedulingCause;
+    } else if (glitch.decodeWallUs > 0) {
+        qint64 wait = qMax<qint64>(0, glitch.decodeWaitUs);
+        qint64 blocked = qMax<qint64>(0, glitch.decodeWallUs - glitch.decodeCpuUs - wait);
+        if (wait >= blocked && wait >= glitch.decodeCpuUs) {
+            glitch.cause = SchedulingCause;
+        } else if (blocked >= glitch.decodeCpuUs) {
+            glitch.cause = IoCause;
+        } else {
+            glitch.cause = DecodeCause;
+        }
+    }
+
+    switch (glitch.cause) {
+    case DecodeCause:
+        add(DecodeGlitches);
+        break;
+    case IoCause:
+        add(IoGlitches);
+        break;
+    case SchedulingCause:
+        add(SchedulingGlitches);
+        break;
+    case UnknownCause:
+        break;
+    }
+
+    // 下一次欠载只看这之后的解码
+    m_worstWallNs.storeRelease(0);
+
+    // 欠载已经发生，这里加锁不会再影响本次播放
+    QMutexLocker locker(&m_glitchMutex);
+    if (m_glitches.size() >= kMaxGlitches) {
+        m_glitches.removeFirst();
+    }
+    m_glitches.append(glitch);
+}
+
+AudioDiagnostics::Snapshot AudioDiagnostics::snapshot() const
+{
+    Snapshot snapshot;
+    for (int i = 0; i < CounterCount; ++i) {
+        snapshot.counters[i] = m_counters[i].loadAcquire();
+    }
+    for (int h = 0; h < HistogramCount; ++h) {
+        for (int b = 0; b < kBuckets; ++b) {
+            snapshot.buckets[h][b] = m_buckets[h][b].loadAcquire();
+        }
+        snapshot.maxValue[h] = m_maxValue[h].loadAcquire();
+    }
+    snapshot.elapsedNs = PlaybackClock::nowNs() - m_resetNs.loadAcquire();
+
+    QMutexLocker locker(&m_glitchMutex);
+    snapshot.glitches = m_glitches;
+    return snapshot;
+}
+
+void AudioDiagnostics::reset()
+{
+    // 与各线程的累加并发执行时个别计数可能漏掉一次，不影响统计用途
+    for (int i = 0; i < CounterCount; ++i) {
+        m_counters[i].storeRelease(0);
+    }
+    for (int h = 0; h < HistogramCount; ++h) {
+        for (int b = 0; b < kBuckets; ++b) {
+            m_buckets[h][b].storeRelease(0);
+        }
+        m_maxValue[h].storeRelease(0);
+    }
+    m_worstWallNs.storeRelease(0);
+    m_resetNs.storeRelease(PlaybackClock::nowNs());
+
+    QMutexLocker locker(&m_glitchMutex);
+    m_glitches.clear();
+}
+
+QString AudioDiagnostics::exportText() const
+{
+    Snapshot s = snapshot();
+    QString text;
+    QTextStream out(&text);
+
+    // QTextStream 按 Latin-1 解释 const char*，这里只输出 ASCII
+    out << "# audio pipeline diagnostics\n";
+    out << "audio_elapsed_ms " << s.elapsedNs / 1000000 << "\n";
+    for (int i = 0; i < CounterCount; ++i) {
+        out << "# TYPE " << kCounterNames[i] << " counter\n";
+        out << kCounterNames[i] << " " << s.counters[i] << "\n";
+    }
+
+    // 分布按 Prometheus 的累积桶输出
+    for (int h = 0; h < HistogramCount; ++h) {
+        const char *name = kHistograms[h].name;
+        out << "# TYPE " << name << " histogram\n";
+        quint64 cumulative = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            cumulative += s.buckets[h][b];
+            if (b < kBuckets - 1) {
+                out << name << "_bucket{le=\"" << kHistograms[h].bounds[b] << "\"} " << cumulative << "\n";
+            } else {
+                out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+            }
+        }
+        out << name << "_count " << cumulative << "\n";
+        out << name << "_max " << s.maxValue[h] << "\n";
+    }
+
+    for (const Glitch &glitch : s.glitches) {
+        out << "# glitch t=" << glitch.timestampNs / 1000000 << "ms cause=" << causeName(glitch.cause)
+            << " starved=" << (glitch.ringStarved ? 1 : 0) << " fill=" << glitch.ringFillPercent
+            << "% late=" << glitch.outputLateUs << "us decode_wall=" << glitch.decodeWallUs
+            << "us decode_cpu=" << glitch.decodeCpuUs << "us decode_wait=" << glitch.decodeWaitUs << "us\n";
+    }
+    out.flush();
+    return text;
+}
+
+QString AudioDiagnostics::summary() const
+{
+    Snapshot s = snapshot();
+    return QString("underruns %1 (decode %2, io %3, sched %4), starved %5, suspends %6, timeouts %7, "
+                   "max decode %8 us, max late %9 us")
+            .arg(s.counters[DeviceUnderruns]).arg(s.counters[DecodeGlitches])
+            .arg(s.counters[IoGlitches]).arg(s.counters[SchedulingGlitches])
+            .arg(s.counters[RingStarvations]).arg(s.counters[DeviceSuspends])
+            .arg(s.counters[DeviceTimeouts]).arg(s.maxValue[DecodeTimeHistogram])
+            .arg(s.maxValue[WakeupLateHistogram]);
+}
+
+const char *AudioDiagnostics::counterName(Counter counter)
+{
+    return kCounterNames[counter];
+}
+
+const char *AudioDiagnostics::histogramName(Histogram histogram)
+{
+    return kHistograms[histogram].name;
+}
+
+const char *AudioDiagnostics::histogramLabel(Histogram histogram)
+{
+    return kHistograms[histogram].label;
+}
+
+const char *AudioDiagnostics::causeName(Cause cause)
+{
+    switch (cause) {
+    case DecodeCause:
+        return "decode";
+    case IoCause:
+        return "io";
+    case SchedulingCause:
+        return "scheduling";
+    case UnknownCause:
+        break;
+    }
+    return "unknown";
+}
+
+qint64 AudioDiagnostics::bucketBound(Histogram histogram, int bucket)
+{
+    return bucket >= 0 && bucket < kBuckets - 1 ? kHistograms[histogram].bounds[bucket] : -1;
+}
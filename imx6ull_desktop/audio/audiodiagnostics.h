@@ -0,0 +1,146 @@
+#ifndef AUDIODIAGNOSTICS_H
+#define AUDIODIAGNOSTICS_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 播放路径的欠载统计与延迟分布
+ *
+ * 解码线程与输出线程只做原子加法，不加锁、不分配内存；界面按需取快照。
+ *
+ * - 计数：设备欠载/挂起/超时、环形缓冲区取空、写入的帧与周期、解码与均衡耗时累计
+ * - 分布：每个输出周期的缓冲区填充率、每块解码耗时、输出线程唤醒迟到时间
+ * - 每次设备欠载归入一个原因并记入最近的故障列表：
+ *   缓冲区没有取空 → 输出线程唤醒太晚（调度）；
+ *   缓冲区取空 → 看此前最慢的一块解码：等待 CPU 的时间最多为调度，
+ *   阻塞（读文件、缺页）最多为 I/O，否则为解码本身太慢
+ *
+ * 解码线程的运行/等待时间来自 /proc/self/task/<tid>/schedstat，
+ * 内核没有该文件时只能区分 CPU 时间与其他等待（调度与 I/O 不再细分）。
+ */
+class AudioDiagnostics
+{
+public:
+    enum Counter {
+        FramesWritten = 0,
+        PeriodsWritten,
+        DeviceUnderruns,        // snd_pcm 返回 -EPIPE
+        DeviceSuspends,         // -ESTRPIPE
+        DeviceTimeouts,         // 等待设备超过 1 秒
+        RingStarvations,        // 播放中缓冲区取空（解码跟不上）
+        DecodeGlitches,         // 欠载原因：解码
+        IoGlitches,             // 欠载原因：I/O
+        SchedulingGlitches,     // 欠载原因：调度
+        DecodeChunks,
+        DecodedFrames,          // 解码（重采样后）的帧数
+        DecodeWallNs,
+        DecodeCpuNs,
+        DecodeRunqueueNs,       // 可以运行但在等待 CPU
+        EqualizerNs,            // 输出线程均衡处理耗时
+        EqualizerBandFrames,    // 均衡处理的帧数 × 频段数
+        CounterCount
+    };
+
+    enum Histogram {
+        RingFillHistogram = 0,  // 百分比
+        DecodeTimeHistogram,    // 微秒/块
+        WakeupLateHistogram,    // 微秒
+        HistogramCount
+    };
+
+    enum Cause {
+        UnknownCause = 0,
+        DecodeCause,
+        IoCause,
+        SchedulingCause
+    };
+
+    // 每个分布 10 个桶，最后一个桶收集超过所有上界的值
+    static const int kBuckets = 10;
+
+    struct Glitch {
+        qint64 timestampNs = 0;     // CLOCK_MONOTONIC
+        Cause cause = UnknownCause;
+        bool ringStarved = false;
+        int ringFillPercent = 0;
+        qint64 outputLateUs = 0;    // 输出线程最近一次唤醒迟到
+        qint64 decodeWallUs = 0;    // 此前最慢一块解码：总耗时
+        qint64 decodeCpuUs = 0;     // 其中运行时间
+        qint64 decodeWaitUs = 0;    // 其中等待 CPU 的时间（-1 表示无法测量）
+    };
+
+    struct Snapshot {
+        quint64 counters[CounterCount];
+        quint32 buckets[HistogramCount][kBuckets];
+        qint64 maxValue[HistogramCount];
+        qint64 elapsedNs = 0;       // 自上次清零
+        QVector<Glitch> glitches;   // 最近的在后
+    };
+
+    /**
+     * @brief 解码线程测量一块解码的耗时
+     */
+    class DecodeProbe
+    {
+    public:
+        explicit DecodeProbe(AudioDiagnostics *diagnostics);
+        ~DecodeProbe();
+
+        void begin();
+        void end(int frames);
+
+    private:
+        bool sample(qint64 &cpuNs, qint64 &waitNs) const;
+
+        AudioDiagnostics *m_diagnostics;
+        int m_schedFd;
+        qint64 m_startNs;
+        qint64 m_startCpuNs;
+        qint64 m_startWaitNs;
+    };
+
+    AudioDiagnostics();
+
+    void add(Counter counter, quint64 value = 1) { m_counters[counter].fetchAndAddRelaxed(value); }
+    void record(Histogram histogram, qint64 value);
+
+    // 输出线程：设备欠载后调用，归因并记入故障列表
+    void recordUnderrun(bool ringStarved, int ringFillPercent, qint64 outputLateUs);
+
+    Snapshot snapshot() const;
+    void reset();
+
+    // Prometheus 文本格式的计数与分布
+    QString exportText() const;
+    // 单行摘要，用于日志
+    QString summary() const;
+
+    static const char *counterName(Counter counter);
+    static const char *histogramName(Histogram histogram);
+    static const char *histogramLabel(Histogram histogram);
+    static const char *causeName(Cause cause);
+    // 第 bucket 个桶的上界，最后一个桶返回 -1
+    static qint64 bucketBound(Histogram histogram, int bucket);
+
+private:
+    void recordDecode(qint64 wallNs, qint64 cpuNs, qint64 waitNs, int frames);
+
+    QAtomicInteger<quint64> m_counters[CounterCount];
+    QAtomicInteger<quint32> m_buckets[HistogramCount][kBuckets];
+    QAtomicInteger<qint64> m_maxValue[HistogramCount];
+    QAtomicInteger<qint64> m_resetNs;
+
+    // 上次欠载以来最慢的一块解码，解码线程写、输出线程读；
+    // 三个值之间可能不是同一块的（只用于归因，允许偶尔不一致）
+    QAtomicInteger<qint64> m_worstWallNs;
+    QAtomicInteger<qint64> m_worstCpuNs;
+    QAtomicInteger<qint64> m_worstWaitNs;
+
+    mutable QMutex m_glitchMutex;
+    QVector<Glitch> m_glitches;
+};
+
+#endif // AUDIODIAGNOSTICS_H
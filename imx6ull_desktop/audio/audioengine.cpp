@@ -0,0 +1,986 @@
+#include "audioengine.h"
+#include "boardthread.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QVector>
+#include <QDebug>
+#include <alsa/asoundlib.h>
+#include <cstring>
+#include <cmath>
+#include <pthread.h>
+#include <sched.h>
+
+// 开发板上 default 即 wm8960，经 plug 层做采样率/声道转换
+static const char *kDefaultDevice = "default";
+
+// wm8960 本身（0 号声卡）：格式被硬件原样支持时直接在其 DMA 缓冲区上 mmap 写入
+static const char *kDefaultHardwareDevice = "hw:0,0";
+
+// PCM 缓冲时长（微秒），决定暂停/切歌时丢弃的数据量
+static const unsigned int kPcmLatencyUs = 100000;
+
+// 环形缓冲区容量（样本），44.1kHz 立体声约 1.5 秒
+static const int kRingSamples = 1 << 17;
+
+// 旁路容量（帧），需容纳设备延迟加上最大的分析窗口
+static const int kTapFrames = 8192;
+
+// 解码线程每次解码的帧数
+static const int kDecodeFrames = 2048;
+
+// 网络流缓冲期间解码线程重试的间隔
+static const unsigned long kPendingRetryMs = 20;
+
+// 输出线程 SCHED_FIFO 优先级：高于 PeriodicScheduler（40），避免界面负载导致欠载
+static const int kOutputPriority = 45;
+
+AudioEngine::AudioEngine(QObject *parent)
+    : QObject(parent)
+    , m_decodeThread(nullptr)
+    , m_outputThread(nullptr)
+    , m_ring(kRingSamples)
+    , m_tap(kTapFrames)
+    , m_pcm(nullptr)
+    , m_periodFrames(0)
+    , m_canPause(false)
+    , m_baseFrame(0)
+    , m_framesWritten(0)
+    , m_samplesConsumed(0)
+    , m_boundaryFrame(-1)
+    , m_historyFrames(0)
+    , m_historyPos(0)
+    , m_historyFilled(0)
+    , m_replayFrames(0)
+    , m_device(kDefaultDevice)
+    , m_hardwareDevice(kDefaultHardwareDevice)
+    , m_outputRate(0)
+    , m_resamplerQuality(Resampler::MediumQuality)
+    , m_quit(false)
+    , m_paused(false)
+    , m_flushRequest(0)
+    , m_flushAck(0)
+    , m_generation(0)
+    , m_decoderEof(false)
+    , m_finishedPosted(false)
+    , m_outputFailed(false)
+    , m_flushBaseFrame(0)
+    , m_nextGainDb(0)
+    , m_nextTaken(false)
+    , m_boundaryPending(false)
+    , m_boundarySample(0)
+    , m_boundaryDurationMs(0)
+    , m_state(StoppedState)
+    , m_requestGeneration(0)
+    , m_durationMs(0)
+{
+    qRegisterMetaType<AudioEngine::State>("AudioEngine::State");
+
+    m_decodeThread = new BoardThread([this] { decodeLoop(); });
+    m_decodeThread->setObjectName("AudioDecode");
+    m_decodeThread->start();
+
+    m_outputThread = new BoardThread([this] { outputLoop(); });
+    m_outputThread->setObjectName("AudioOutput");
+    m_outputThread->start();
+}
+
+AudioEngine::~AudioEngine()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_decodeCond.wakeAll();
+        m_outputCond.wakeAll();
+        m_flushCond.wakeAll();
+    }
+    m_decodeThread->wait();
+    m_outputThread->wait();
+    delete m_decodeThread;
+    delete m_outputThread;
+}
+
+bool AudioEngine::streamStatus(HttpStream::Status &status) const
+{
+    QSharedPointer<HttpStream> stream;
+    {
+        QMutexLocker locker(&m_mutex);
+        stream = m_stream;
+    }
+    if (!stream) {
+        return false;
+    }
+    status = stream->status();
+    return true;
+}
+
+void AudioEngine::setDevice(const QString &device)
+{
+    QMutexLocker locker(&m_mutex);
+    m_device = device;
+}
+
+void AudioEngine::setHardwareDevice(const QString &device)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hardwareDevice = device;
+}
+
+void AudioEngine::setOutputRate(int rate)
+{
+    QMutexLocker locker(&m_mutex);
+    m_outputRate = rate;
+}
+
+void AudioEngine::setResamplerQuality(Resampler::Quality quality)
+{
+    QMutexLocker locker(&m_mutex);
+    m_resamplerQuality = quality;
+}
+
+void AudioEngine::play(const QString &path, float gainDb)
+{
+    Command command;
+    command.type = OpenCommand;
+    command.path = path;
+    command.gainDb = gainDb;
+    command.positionMs = 0;
+    command.generation = ++m_requestGeneration;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        // 新曲目取代所有尚未执行的请求
+        m_commands.clear();
+        m_commands.push_back(command);
+        m_nextPath.clear();
+        m_paused = false;
+        m_decodeCond.wakeAll();
+        m_outputCond.wakeAll();
+    }
+
+    m_durationMs = 0;
+    setState(PlayingState);
+}
+
+void AudioEngine::pause()
+{
+    if (m_state != PlayingState) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_paused = true;
+        m_outputCond.wakeAll();
+    }
+    setState(PausedState);
+}
+
+void AudioEngine::resume()
+{
+    if (m_state != PausedState) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_paused = false;
+        m_outputCond.wakeAll();
+    }
+    setState(PlayingState);
+}
+
+void AudioEngine::stop()
+{
+    Command command;
+    command.type = StopCommand;
+    command.gainDb = 0;
+    command.positionMs = 0;
+    command.generation = ++m_requestGeneration;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_commands.clear();
+        m_commands.push_back(command);
+        m_nextPath.clear();
+        m_paused = false;
+        m_decodeCond.wakeAll();
+        m_outputCond.wakeAll();
+    }
+
+    setState(StoppedState);
+}
+
+void AudioEngine::seek(qint64 positionMs)
+{
+    if (m_state == StoppedState) {
+        return;
+    }
+
+    Command command;
+    command.type = SeekCommand;
+    command.gainDb = 0;
+    command.positionMs = qMax<qint64>(0, positionMs);
+    command.generation = m_requestGeneration;
+
+    QMutexLocker locker(&m_mutex);
+    // 连续拖动时只保留最后一次定位
+    if (!m_commands.empty() && m_commands.back().type == SeekCommand) {
+        m_commands.back() = command;
+    } else {
+        m_commands.push_back(command);
+    }
+    m_decodeCond.wakeAll();
+}
+
+void AudioEngine::setNext(const QString &path, float gainDb)
+{
+    QMutexLocker locker(&m_mutex);
+    // 同一曲目的增益可能在分析完成后更新，衔接时取最新值
+    m_nextGainDb = gainDb;
+    if (m_nextPath != path) {
+        m_nextPath = path;
+        m_decodeCond.wakeAll();
+    }
+}
+
+void AudioEngine::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        emit stateChanged(state);
+    }
+}
+
+void AudioEngine::postFinished(quint64 generation)
+{
+    QMetaObject::invokeMethod(this, [this, generation]() {
+        if (generation == m_requestGeneration && m_state != StoppedState) {
+            setState(StoppedState);
+            emit finished();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::postError(quint64 generation, const QString &message)
+{
+    QMetaObject::invokeMethod(this, [this, generation, message]() {
+        if (generation == m_requestGeneration) {
+            setState(StoppedState);
+            emit errorOccurred(message);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::postDuration(quint64 generation, qint64 durationMs)
+{
+    QMetaObject::invokeMethod(this, [this, generation, durationMs]() {
+        if (generation == m_requestGeneration) {
+            m_durationMs = durationMs;
+            emit durationChanged(durationMs);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::postTrackAdvanced(quint64 generation, const QString &path, qint64 durationMs)
+{
+    QMetaObject::invokeMethod(this, [this, generation, path, durationMs]() {
+        if (generation == m_requestGeneration && m_state != StoppedState) {
+            m_durationMs = durationMs;
+            emit trackAdvanced(path);
+            emit durationChanged(durationMs);
+        }
+    }, Qt::QueuedConnection);
+}
+
+void AudioEngine::flushOutput()
+{
+    // 调用方持有 m_mutex；等待期间不写环形缓冲区，输出线程可以安全地丢弃数据
+    m_flushRequest++;
+    m_outputCond.wakeAll();
+    while (m_flushAck != m_flushRequest && !m_quit) {
+        m_flushCond.wait(&m_mutex);
+    }
+}
+
+AudioFormat AudioEngine::outputFormatFor(const AudioFormat &source) const
+{
+    AudioFormat format = source;
+    int rate = m_outputRate;
+    if (rate <= 0 && !m_hardwareRates.isEmpty() && !m_hardwareRates.contains(source.sampleRate)) {
+        // 硬件不支持曲目采样率：取不低于它且能重采样过去的最低硬件采样率，
+        // 硬件采样率都比它低时取最高的
+        for (int candidate : m_hardwareRates) {
+            if (Resampler::isSupported(source.sampleRate, candidate)) {
+                rate = candidate;
+                if (candidate >= source.sampleRate) {
+                    break;
+                }
+            }
+        }
+    }
+    if (rate > 0 && source.sampleRate != rate && Resampler::isSupported(source.sampleRate, rate)) {
+        format.sampleRate = rate;
+    }
+    return format;
+}
+
+static float dbToGain(float db)
+{
+    return std::pow(10.0f, db / 20.0f);
+}
+
+// 解码线程调用：按曲目格式准备重采样器。参数不变时保留原实例和滤波器历史，
+// 相同采样率的曲目无缝衔接时不会在边界处产生瞬态
+static Resampler *resamplerFor(Resampler *current, const AudioFormat &source, const AudioFormat &output,
+                               Resampler::Quality quality)
+{
+    if (source.sampleRate == output.sampleRate) {
+        delete current;
+        return nullptr;
+    }
+    if (current && current->inputRate() == source.sampleRate && current->outputRate() == output.sampleRate
+            && current->channels() == source.channels && current->quality() == quality) {
+        return current;
+    }
+    delete current;
+    qDebug() << "AudioEngine: resampling" << source.sampleRate << "->" << output.sampleRate
+             << "quality" << Resampler::qualityName(quality);
+    return new Resampler(source.sampleRate, output.sampleRate, source.channels, quality);
+}
+
+void AudioEngine::decodeLoop()
+{
+    AudioDecoder *decoder = nullptr;
+    AudioDecoder *nextDecoder = nullptr;        // 预先打开的下一首
+    AudioDecoder *previousDecoder = nullptr;    // 已解码完、衔接点尚未播放到的上一首
+    QString currentPath;
+    QString nextDecoderPath;
+    QString previousPath;
+    qint64 samplesQueued = 0;                   // 清空后写入缓冲区的样本数
+    QVector<qint16> chunk(kDecodeFrames * 8);
+    Resampler *resampler = nullptr;             // 曲目采样率与设备不同时使用
+    QVector<qint16> resampled;
+    SoftwareGain trackGain;                     // 响度校正，按曲目切换
+    float currentGainDb = 0;
+    float previousGainDb = 0;
+    AudioDiagnostics::DecodeProbe probe(&m_diagnostics);
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        // 衔接点已播放（或已被清空），上一首不再需要
+        if (previousDecoder && !m_boundaryPending) {
+            AudioDecoder *old = previousDecoder;
+            previousDecoder = nullptr;
+            locker.unlock();
+            delete old;
+            locker.relock();
+            continue;
+        }
+
+        if (!m_commands.empty()) {
+            Command command = m_commands.front();
+            m_commands.pop_front();
+
+            // 定位目标在清空前算好，输出线程清空时据此发布新位置
+            qint64 targetFrame = 0;             // 设备采样率下的帧
+            qint64 sourceFrame = 0;             // 曲目采样率下的帧
+            bool rewindNext = false;
+            if (command.type == SeekCommand) {
+                if (!decoder || command.generation != m_generation) {
+                    continue;
+                }
+                // 下一首已开始写入缓冲区但还没播放到：定位仍作用于正在播放的曲目，
+                // 下一首退回预先打开的状态
+                if (m_boundaryPending && previousDecoder && !nextDecoder) {
+                    nextDecoder = decoder;
+                    nextDecoderPath = currentPath;
+                    decoder = previousDecoder;
+                    currentPath = previousPath;
+                    currentGainDb = previousGainDb;
+                    previousDecoder = nullptr;
+                    rewindNext = true;
+                    m_stream = decoder->networkStream();
+                }
+                int sourceRate = decoder->format().sampleRate;
+                sourceFrame = command.positionMs * sourceRate / 1000;
+                qint64 total = decoder->totalFrames();
+                if (total > 0) {
+                    sourceFrame = qMin(sourceFrame, total);
+                }
+                m_format = outputFormatFor(decoder->format());
+                targetFrame = sourceFrame * m_format.sampleRate / sourceRate;
+            }
+
+            m_flushBaseFrame = targetFrame;
+            m_boundaryPending = false;
+            m_nextTaken = false;
+            flushOutput();
+            samplesQueued = 0;
+            m_decoderEof = false;
+            m_finishedPosted = false;
+
+            if (command.type == OpenCommand) {
+                m_generation = command.generation;
+                m_format = AudioFormat();
+
+                // 要播放的正是预先打开的曲目时直接复用
+                AudioDecoder *reuse = nullptr;
+                if (nextDecoder && nextDecoderPath == command.path) {
+                    reuse = nextDecoder;
+                    nextDecoder = nullptr;
+                    nextDecoderPath.clear();
+                }
+
+                // 还不知道硬件支持哪些采样率（或换了硬件设备）时顺便查询，设备正被占用就下次再查
+                QString probeDevice;
+                if (!m_hardwareDevice.isEmpty()
+                        && (m_hardwareRates.isEmpty() || m_ratesDevice != m_hardwareDevice)) {
+                    probeDevice = m_hardwareDevice;
+                }
+
+                // 打开文件、解析文件头与查询设备不持有锁
+                locker.unlock();
+                QVector<int> rates;
+                if (!probeDevice.isEmpty()) {
+                    QString probeError;
+                    rates = PcmWriter::supportedRates(probeDevice, probeError);
+                    if (rates.isEmpty()) {
+                        qDebug() << "AudioEngine:" << probeError;
+                    } else {
+                        qDebug() << "AudioEngine:" << probeDevice << "supports" << rates << "Hz";
+                    }
+                }
+                delete decoder;
+                decoder = nullptr;
+                QString error;
+                if (reuse && reuse->seek(0)) {
+                    decoder = reuse;
+                } else {
+                    delete reuse;
+                    decoder = AudioDecoder::create(command.path);
+                    if (!decoder) {
+                        error = QString("不支持的文件格式: %1").arg(command.path);
+                    } else if (!decoder->open(command.path)) {
+                        error = decoder->errorString();
+                        delete decoder;
+                        decoder = nullptr;
+                    }
+                }
+                locker.relock();
+                if (!rates.isEmpty()) {
+                    m_hardwareRates = rates;
+                    m_ratesDevice = probeDevice;
+                }
+
+                m_stream = decoder ? decoder->networkStream() : QSharedPointer<HttpStream>();
+                if (!decoder) {
+                    qDebug() << "AudioEngine:" << error;
+                    postError(command.generation, error);
+                    continue;
+                }
+
+                currentPath = command.path;
+                currentGainDb = command.gainDb;
+                trackGain.reset(dbToGain(currentGainDb));
+                AudioFormat source = decoder->format();
+                m_format = outputFormatFor(source);
+                qint64 total = decoder->totalFrames();
+                postDuration(command.generation, total > 0 ? total * 1000 / source.sampleRate : 0);
+                qDebug() << "AudioEngine: playing" << command.path
+                         << source.sampleRate << "Hz" << source.channels << "ch"
+                         << (reuse ? "(preopened)" : "");
+
+                // 新曲目从静音的滤波器历史开始
+                resampler = resamplerFor(resampler, source, m_format, m_resamplerQuality);
+                if (resampler) {
+                    resampler->reset();
+                }
+            } else if (command.type == SeekCommand) {
+                resampler = resamplerFor(resampler, decoder->format(), m_format, m_resamplerQuality);
+                locker.unlock();
+                bool ok = decoder->seek(sourceFrame);
+                if (rewindNext) {
+                    nextDecoder->seek(0);
+                }
+                if (resampler) {
+                    resampler->reset();
+                }
+                trackGain.reset(dbToGain(currentGainDb));
+                locker.relock();
+
+                if (!ok) {
+                    qDebug() << "AudioEngine: seek failed," << decoder->errorString();
+                }
+            } else {
+                locker.unlock();
+                delete decoder;
+                decoder = nullptr;
+                delete resampler;
+                resampler = nullptr;
+                locker.relock();
+                currentPath.clear();
+                m_format = AudioFormat();
+                m_stream.reset();
+            }
+            continue;
+        }
+
+        if (!decoder) {
+            m_decodeCond.wait(&m_mutex);
+            continue;
+        }
+
+        int channels = m_format.channels;
+        int maxFrames = resampler ? resampler->maxOutputFrames(kDecodeFrames) : kDecodeFrames;
+        bool ringFull = m_ring.freeSpace() < maxFrames * channels;
+
+        // 缓冲区已满或已解码完时才预先打开下一首（只解析文件头），
+        // 不与刚开始播放的曲目争抢填充缓冲区的时间
+        if ((ringFull || m_decoderEof) && !m_nextTaken && nextDecoderPath != m_nextPath) {
+            QString path = m_nextPath;
+            AudioDecoder *stale = nextDecoder;
+            nextDecoder = nullptr;
+            nextDecoderPath = path;
+            locker.unlock();
+            delete stale;
+            AudioDecoder *opened = nullptr;
+            if (!path.isEmpty()) {
+                opened = AudioDecoder::create(path);
+                if (opened && !opened->open(path)) {
+                    qDebug() << "AudioEngine: cannot preopen" << path << opened->errorString();
+                    delete opened;
+                    opened = nullptr;
+                }
+            }
+            locker.relock();
+            nextDecoder = opened;
+            continue;
+        }
+
+        // 当前曲目解码完、下一首已就绪且格式相同：接着写入缓冲区，在样本边界衔接。
+        // 一次只允许一个未播放的衔接点；格式不同需要重新配置设备，按普通结束处理
+        if (m_decoderEof && !m_finishedPosted && !m_nextTaken && !m_boundaryPending
+                && nextDecoder && !m_nextPath.isEmpty() && nextDecoderPath == m_nextPath
+                && outputFormatFor(nextDecoder->format()) == m_format) {
+            previousDecoder = decoder;
+            previousPath = currentPath;
+            previousGainDb = currentGainDb;
+            decoder = nextDecoder;
+            currentPath = nextDecoderPath;
+            currentGainDb = m_nextGainDb;
+            trackGain.reset(dbToGain(currentGainDb));
+            nextDecoder = nullptr;
+            nextDecoderPath.clear();
+            m_stream = decoder->networkStream();
+
+            qint64 total = decoder->totalFrames();
+            m_nextTaken = true;
+            m_boundaryPending = true;
+            m_boundarySample = samplesQueued;
+            m_boundaryPath = currentPath;
+            m_boundaryDurationMs = total > 0 ? total * 1000 / decoder->format().sampleRate : 0;
+            m_decoderEof = false;
+            resampler = resamplerFor(resampler, decoder->format(), m_format, m_resamplerQuality);
+            qDebug() << "AudioEngine: gapless transition to" << currentPath;
+            continue;
+        }
+
+        if (m_decoderEof || ringFull) {
+            m_decodeCond.wait(&m_mutex);
+            continue;
+        }
+
+        // 解码、重采样与写入缓冲区不持有锁；无需转换的数据（内存映射的 16 位 WAV）
+        // 直接从映射区写入缓冲区，不经过 chunk
+        locker.unlock();
+        probe.begin();
+        const qint16 *data = nullptr;
+        qint16 *writable = nullptr;             // data 可以原地修改时指向同一块内存
+        int decoded = decoder->readDirect(&data, kDecodeFrames);
+        if (decoded < 0) {
+            decoded = decoder->read(chunk.data(), kDecodeFrames);
+            data = writable = chunk.data();
+        }
+        int frames = decoded;
+        if (frames > 0 && resampler) {
+            int needed = resampler->maxOutputFrames(frames) * channels;
+            if (resampled.size() < needed) {
+                resampled.resize(needed);
+            }
+            frames = resampler->process(data, frames, resampled.data());
+            data = writable = resampled.data();
+        }
+        if (frames > 0 && !trackGain.isUnity()) {
+            // 映射区只读，先复制出来
+            if (!writable) {
+                memcpy(chunk.data(), data, size_t(frames) * channels * sizeof(qint16));
+                data = writable = chunk.data();
+            }
+            trackGain.process(writable, frames, channels);
+        }
+        if (frames > 0) {
+            m_ring.write(data, frames * channels);
+            samplesQueued += frames * channels;
+        }
+        if (decoded != AudioDecoder::kPending) {
+            probe.end(frames);
+        }
+        locker.relock();
+
+        if (decoded == AudioDecoder::kPending) {
+            // 网络流正在缓冲：等一会儿再试，期间照常处理命令
+            m_decodeCond.wait(&m_mutex, kPendingRetryMs);
+            continue;
+        }
+        if (decoded <= 0) {
+            if (decoded < 0) {
+                qDebug() << "AudioEngine: decode error," << decoder->errorString();
+            }
+            m_decoderEof = true;
+        }
+        m_outputCond.wakeAll();
+    }
+
+    m_stream.reset();
+    locker.unlock();
+    delete decoder;
+    delete nextDecoder;
+    delete resampler;
+    delete previousDecoder;
+}
+
+bool AudioEngine::configurePcm(const AudioFormat &format, QString &error)
+{
+    closePcm();
+
+    QString device;
+    QString hardwareDevice;
+    {
+        QMutexLocker locker(&m_mutex);
+        device = m_device;
+        hardwareDevice = m_hardwareDevice;
+    }
+
+    if (!m_writer.open(device, hardwareDevice, format, kPcmLatencyUs, error)) {
+        return false;
+    }
+
+    m_pcm = m_writer.handle();
+    m_pcmFormat = format;
+    m_periodFrames = m_writer.periodFrames();
+    m_canPause = m_writer.canPause();
+    m_historyFrames = m_canPause ? 0 : m_writer.bufferFrames();
+    m_history.resize(m_historyFrames * format.channels);
+    m_historyPos = 0;
+    m_historyFilled = 0;
+    m_replayFrames = 0;
+    m_equalizer.prepare(format.sampleRate, format.channels);
+    return true;
+}
+
+void AudioEngine::closePcm()
+{
+    m_writer.close();
+    m_pcm = nullptr;
+    m_pcmFormat = AudioFormat();
+}
+
+qint64 AudioEngine::playedFrames() const
+{
+    // 输出线程调用；已写入的帧减去仍在设备缓冲区中的帧即为已经播放的帧
+    snd_pcm_sframes_t delay = 0;
+    if (m_pcm && snd_pcm_delay(m_pcm, &delay) < 0) {
+        delay = 0;
+    }
+    return m_framesWritten - qBound<qint64>(0, delay, m_framesWritten);
+}
+
+void AudioEngine::keepHistory(const qint16 *data, int frames)
+{
+    int channels = m_pcmFormat.channels;
+    m_historyFilled = qMin<qint64>(m_historyFilled + frames, m_historyFrames);
+    // 只需要最后 m_historyFrames 帧
+    if (frames > m_historyFrames) {
+        data += (frames - m_historyFrames) * channels;
+        frames = m_historyFrames;
+    }
+    while (frames > 0) {
+        int count = qMin(frames, m_historyFrames - m_historyPos);
+        memcpy(m_history.data() + m_historyPos * channels, data, size_t(count) * channels * sizeof(qint16));
+        m_historyPos = (m_historyPos + count) % m_historyFrames;
+        data += count * channels;
+        frames -= count;
+    }
+}
+
+void AudioEngine::copyHistory(qint16 *dst, qint64 fromEnd, int frames) const
+{
+    // 从倒数第 fromEnd 帧开始取 frames 帧
+    int channels = m_pcmFormat.channels;
+    int pos = int((m_historyPos - fromEnd % m_historyFrames + m_historyFrames) % m_historyFrames);
+    while (frames > 0) {
+        int count = qMin(frames, m_historyFrames - pos);
+        memcpy(dst, m_history.constData() + pos * channels, size_t(count) * channels * sizeof(qint16));
+        pos = (pos + count) % m_historyFrames;
+        dst += count * channels;
+        frames -= count;
+    }
+}
+
+void AudioEngine::publishPosition(bool running)
+{
+    // 输出线程调用；设备里还有上一首的尾部时，位置不超过上一首的结尾
+    bool deviceRunning = m_pcm && snd_pcm_state(m_pcm) == SND_PCM_STATE_RUNNING;
+    qint64 written = m_boundaryFrame >= 0 ? m_boundaryFrame : m_framesWritten;
+
+    PlaybackClock::Snapshot snapshot;
+    snapshot.frame = m_baseFrame + qMin(playedFrames(), written);
+    snapshot.maxFrame = m_baseFrame + written;
+    snapshot.timestampNs = PlaybackClock::nowNs();
+    snapshot.sampleRate = m_pcmFormat.sampleRate;
+    snapshot.running = running && deviceRunning;
+    m_playbackClock.publish(snapshot);
+}
+
+void AudioEngine::outputLoop()
+{
+    struct sched_param param;
+    param.sched_priority = kOutputPriority;
+    bool realtime = (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0);
+    qDebug() << "AudioEngine output thread started, SCHED_FIFO:" << realtime;
+
+    QVector<qint16> buffer;
+    bool pcmPaused = false;
+    bool starved = false;       // 播放中缓冲区取空过，尚未写入新数据
+    qint64 lateUs = 0;          // 最近一次等待设备后唤醒的迟到时间
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        // 切歌/定位：丢弃设备与缓冲区中的旧数据
+        if (m_flushAck != m_flushRequest) {
+            quint64 request = m_flushRequest;
+            locker.unlock();
+            if (m_pcm) {
+                snd_pcm_drop(m_pcm);
+                snd_pcm_prepare(m_pcm);
+            }
+            m_ring.discard();
+            locker.relock();
+
+            pcmPaused = false;
+            starved = false;
+            m_baseFrame = m_flushBaseFrame;
+            m_framesWritten = 0;
+            m_samplesConsumed = 0;
+            m_boundaryFrame = -1;
+            m_historyFilled = 0;
+            m_replayFrames = 0;
+            m_outputFailed = false;
+            m_flushAck = request;
+            m_flushCond.wakeAll();
+
+            // 定位后立即发布新位置，不等第一次写入
+            publishPosition(false);
+            continue;
+        }
+
+        if (m_paused) {
+            if (m_pcm && !pcmPaused && snd_pcm_state(m_pcm) == SND_PCM_STATE_RUNNING) {
+                locker.unlock();
+                if (m_canPause) {
+                    snd_pcm_pause(m_pcm, 1);
+                    publishPosition(false);
+                } else {
+                    // 不支持硬件暂停：记下设备中尚未播放的帧数再 drop（最多 kPcmLatencyUs 的数据），
+                    // 位置退回实际播放处，恢复后先把这些帧从保留的副本重新写入
+                    snd_pcm_sframes_t delay = 0;
+                    if (snd_pcm_delay(m_pcm, &delay) < 0) {
+                        delay = 0;
+                    }
+                    snd_pcm_drop(m_pcm);
+                    snd_pcm_prepare(m_pcm);
+                    qint64 dropped = qBound<qint64>(0, delay, qMin(m_framesWritten, m_historyFilled - m_replayFrames));
+                    m_framesWritten -= dropped;
+                    m_replayFrames += dropped;
+                    publishPosition(false);
+                }
+                locker.relock();
+                pcmPaused = m_canPause;
+            }
+            m_outputCond.wait(&m_mutex);
+            continue;
+        }
+
+        if (pcmPaused) {
+            locker.unlock();
+            if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PAUSED) {
+                snd_pcm_pause(m_pcm, 0);
+            }
+            publishPosition(true);
+            locker.relock();
+            pcmPaused = false;
+            continue;
+        }
+
+        if (!m_format.isValid() || m_outputFailed) {
+            m_outputCond.wait(&m_mutex);
+            continue;
+        }
+
+        // 格式变化时重新配置设备，格式相同则直接复用
+        if (m_format != m_pcmFormat) {
+            AudioFormat format = m_format;
+            quint64 generation = m_generation;
+            locker.unlock();
+            QString error;
+            bool ok = configurePcm(format, error);
+            locker.relock();
+            if (!ok) {
+                qDebug() << "AudioEngine:" << error;
+                m_outputFailed = true;
+                postError(generation, error);
+            }
+            continue;
+        }
+
+        // 衔接点离开缓冲区时只记下它在设备中的位置，下一首接着写入；
+        // 等声卡真正播放到下一首的第一个样本，再从 0 重新计算位置并通知界面
+        if (m_boundaryPending && m_boundaryFrame < 0 && m_samplesConsumed >= m_boundarySample) {
+            m_boundaryFrame = m_framesWritten;
+        }
+        if (m_boundaryFrame >= 0 && playedFrames() >= m_boundaryFrame) {
+            m_boundaryPending = false;
+            m_nextTaken = false;
+            if (m_nextPath == m_boundaryPath) {
+                m_nextPath.clear();
+            }
+            m_baseFrame = 0;
+            m_framesWritten -= m_boundaryFrame;
+            m_boundaryFrame = -1;
+            publishPosition(true);
+            postTrackAdvanced(m_generation, m_boundaryPath, m_boundaryDurationMs);
+            m_decodeCond.wakeAll();
+            continue;
+        }
+
+        int channels = m_pcmFormat.channels;
+
+        // 暂停时被 drop 的数据先重新写入；这些帧已经过均衡、旁路与增益，也还在副本里
+        if (m_replayFrames > 0) {
+            int frames = int(qMin<qint64>(m_replayFrames, m_periodFrames));
+            qint64 fromEnd = m_replayFrames;
+            locker.unlock();
+            int written = m_writer.write(frames, [&](qint16 *dst, int count) {
+                copyHistory(dst, fromEnd, count);
+                fromEnd -= count;
+            });
+            m_replayFrames -= frames;
+            m_framesWritten += written;
+            publishPosition(true);
+            locker.relock();
+            continue;
+        }
+
+        int availableFrames = m_ring.available() / channels;
+        if (availableFrames == 0) {
+            if (m_decoderEof && !m_finishedPosted) {
+                // 数据已全部写入，等设备播放完再通知结束
+                locker.unlock();
+                snd_pcm_sframes_t delay = 0;
+                int err = snd_pcm_delay(m_pcm, &delay);
+                snd_pcm_state_t state = snd_pcm_state(m_pcm);
+                if (err == 0 && delay > 0 && state == SND_PCM_STATE_PREPARED) {
+                    // 曲目短于启动阈值时设备还没开始播放
+                    snd_pcm_start(m_pcm);
+                    state = SND_PCM_STATE_RUNNING;
+                }
+                publishPosition(true);
+                locker.relock();
+
+                if (err < 0 || delay <= 0 || state != SND_PCM_STATE_RUNNING) {
+                    m_finishedPosted = true;
+                    postFinished(m_generation);
+                } else {
+                    m_outputCond.wait(&m_mutex, 10);
+                }
+                continue;
+            }
+            // 设备开始播放后缓冲区被取空：解码跟不上，设备随后可能欠载
+            if (!starved && m_framesWritten > 0) {
+                starved = true;
+                m_diagnostics.add(AudioDiagnostics::RingStarvations);
+            }
+            // 设备里还有上一首的尾部时定时醒来检查衔接点是否已播放
+            if (m_boundaryFrame >= 0) {
+                m_outputCond.wait(&m_mutex, 10);
+            } else {
+                m_outputCond.wait(&m_mutex);
+            }
+            continue;
+        }
+
+        int frames = qMin(availableFrames, m_periodFrames);
+        if (m_boundaryPending && m_boundaryFrame < 0) {
+            // 写到衔接点为止，下一次循环记下它在设备中的位置
+            frames = int(qMin<qint64>(frames, (m_boundarySample - m_samplesConsumed) / channels));
+        }
+        if (buffer.size() < frames * channels) {
+            buffer.resize(frames * channels);
+        }
+
+        // 从缓冲区取数据并写入设备，阻塞写期间不持有锁。
+        // mmap 方式下（直接打开硬件设备时）从缓冲区复制到声卡的 DMA 缓冲区；那块内存可能不带缓存，
+        // 需要旁路或增益时先在 buffer 中处理好再整段复制过去
+        locker.unlock();
+        int fillPercent = int(qint64(availableFrames) * channels * 100 / m_ring.capacity());
+        m_diagnostics.record(AudioDiagnostics::RingFillHistogram, fillPercent);
+        PcmWriter::Stats before = m_writer.stats();
+
+        m_samplesConsumed += frames * channels;
+        bool equalize = !m_equalizer.isBypassed();
+        bool keep = m_historyFrames > 0;
+        bool staged = (m_writer.access() == PcmWriter::MmapAccess)
+                && (m_tap.isEnabled() || !m_gain.isUnity() || equalize || keep);
+        int written = m_writer.write(frames, [&](qint16 *dst, int count) {
+            int samples = count * channels;
+            qint16 *work = staged ? buffer.data() : dst;
+            m_ring.read(work, samples);
+            if (equalize) {
+                qint64 startNs = PlaybackClock::nowNs();
+                m_equalizer.process(work, count);
+                m_diagnostics.add(AudioDiagnostics::EqualizerNs, quint64(PlaybackClock::nowNs() - startNs));
+                m_diagnostics.add(AudioDiagnostics::EqualizerBandFrames, quint64(count) * m_equalizer.activeBands());
+            }
+            m_tap.write(work, count, channels);
+            m_gain.process(work, count, channels);
+            if (keep) {
+                keepHistory(work, count);
+            }
+            if (staged) {
+                memcpy(dst, work, samples * sizeof(qint16));
+            }
+        });
+        m_framesWritten += written;
+        publishPosition(true);
+
+        // 写入过程中发生的欠载按此前的状态归因
+        const PcmWriter::Stats &after = m_writer.stats();
+        if (after.lastWakeLateUs >= 0) {
+            lateUs = after.lastWakeLateUs;
+            m_diagnostics.record(AudioDiagnostics::WakeupLateHistogram, lateUs);
+        }
+        for (quint64 i = before.underruns; i < after.underruns; ++i) {
+            m_diagnostics.add(AudioDiagnostics::DeviceUnderruns);
+            m_diagnostics.recordUnderrun(starved, fillPercent, lateUs);
+        }
+        m_diagnostics.add(AudioDiagnostics::DeviceSuspends, after.suspends - before.suspends);
+        m_diagnostics.add(AudioDiagnostics::DeviceTimeouts, after.timeouts - before.timeouts);
+        m_diagnostics.add(AudioDiagnostics::FramesWritten, quint64(written));
+        m_diagnostics.add(AudioDiagnostics::PeriodsWritten);
+        starved = false;
+        locker.relock();
+
+        m_decodeCond.wakeAll();
+    }
+
+    locker.unlock();
+    closePcm();
+}
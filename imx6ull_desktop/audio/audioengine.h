@@ -0,0 +1,223 @@
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <deque>
+#include "audiodecoder.h"
+#include "audiodiagnostics.h"
+#include "equalizer.h"
+#include "httpstream.h"
+#include "pcmringbuffer.h"
+#include "pcmtap.h"
+#include "pcmwriter.h"
+#include "playbackclock.h"
+#include "resampler.h"
+#include "softwaregain.h"
+
+class QThread;
+struct _snd_pcm;
+
+/**
+ * @brief 进程内音频播放引擎
+ *
+ * 解码线程把文件解码为 S16 写入无锁环形缓冲区，输出线程从缓冲区取数据写入
+ * ALSA PCM 设备（开发板上为 wm8960）。所有控制接口只是投递请求，立即返回，
+ * 界面线程不会等待文件打开、解码或设备操作。
+ *
+ * - 切歌/定位时清空缓冲区并 drop PCM，格式不变时复用已打开的 PCM 设备
+ * - 暂停优先使用硬件暂停（snd_pcm_pause），不支持时 drop 后重新 prepare，
+ *   被丢弃的设备缓冲区数据从保留的副本重新写入，位置与声音都不跳
+ * - 状态与结果通过信号返回；过期的结果（已被新的 play/stop 取代）会被丢弃
+ * - 播放位置来自声卡实际消耗的帧数（已写入 - snd_pcm_delay），无锁读取
+ * - 第一次播放时向硬件设备查询它原样支持的采样率，硬件不支持曲目采样率时在解码线程
+ *   用多相滤波器重采样；设备打开时关闭 ALSA 的软件重采样，采样率不符直接报错
+ * - 硬件原样支持输出格式时直接打开硬件设备以 mmap 方式写入，数据从缓冲区直接复制到
+ *   声卡的 DMA 缓冲区；否则经 ALSA 设备（plug）以 writei 写入
+ * - 可选的软件增益在写入设备前作用于 PCM（没有硬件音量控件时使用）
+ * - play()/setNext() 可附带曲目增益（响度校正），由解码线程作用于该曲目的 PCM，
+ *   无缝衔接时在样本边界切换
+ * - 输出线程在写入设备前经过参数均衡器，参数由界面线程无锁发布，下一个周期生效
+ * - 送往设备的数据（均衡之后、音量增益之前）同时写入无锁旁路 PcmTap，供可视化读取
+ * - setNext() 指定的下一首在缓冲区空闲时预先打开；当前曲目解码完且格式相同时
+ *   直接接着写入缓冲区，在样本边界切换，不重新打开设备，也不产生间隙
+ * - 两个线程把欠载、缓冲区填充、解码耗时与唤醒迟到记入 AudioDiagnostics
+ * - play() 也接受 http:// 地址：网络线程把数据收进抖动缓冲区，解码器在缓冲期间
+ *   返回 kPending，解码线程稍后重试而不是结束曲目；缓冲状态由 streamStatus() 读取
+ */
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        StoppedState = 0,
+        PlayingState,
+        PausedState
+    };
+
+    explicit AudioEngine(QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // ALSA 设备名，在第一次播放之前设置
+    void setDevice(const QString &device);
+
+    // 对应的硬件设备（hw:），空字符串表示不使用 mmap，在第一次播放之前设置
+    void setHardwareDevice(const QString &device);
+
+    // 强制的设备采样率；0（默认）表示按硬件设备查询到的采样率自动选择：硬件支持曲目
+    // 采样率时原样输出，否则重采样到硬件支持的采样率。与重采样质量一起从下一次
+    // play()/定位开始生效
+    void setOutputRate(int rate);
+    void setResamplerQuality(Resampler::Quality quality);
+
+    State state() const { return m_state; }
+
+    // 当前位置与总时长（毫秒）；position() 不加锁，可以每帧调用
+    qint64 position() const { return m_playbackClock.positionMs(); }
+    qint64 duration() const { return m_durationMs; }
+
+    // 音频时钟，供画面/歌词与声音同步
+    const PlaybackClock &playbackClock() const { return m_playbackClock; }
+
+    // 输出 PCM 旁路，启用后输出线程才会写入
+    PcmTap *pcmTap() { return &m_tap; }
+
+    // 软件增益（线性 0.0 ~ 1.0），任意线程可调用，变化时平滑过渡
+    void setGain(float gain) { m_gain.setGain(gain); }
+    float gain() const { return m_gain.gain(); }
+
+    // 参数均衡器，setParameters() 只在界面线程调用
+    Equalizer *equalizer() { return &m_equalizer; }
+
+    // 播放路径诊断，任意线程可读取快照
+    AudioDiagnostics *diagnostics() { return &m_diagnostics; }
+
+    // 当前曲目为网络流时取得其接收与缓冲状态，否则返回 false
+    bool streamStatus(HttpStream::Status &status) const;
+
+public slots:
+    // gainDb 为该曲目的增益（dB，最大 +12），用于响度校正
+    void play(const QString &path, float gainDb = 0.0f);
+    void pause();
+    void resume();
+    void stop();
+    void seek(qint64 positionMs);
+
+    // 当前曲目结束后无缝接着播放的曲目，空字符串表示没有；play()/stop() 会清除
+    void setNext(const QString &path, float gainDb = 0.0f);
+
+signals:
+    void stateChanged(AudioEngine::State state);
+    void durationChanged(qint64 durationMs);
+    void finished();
+    void errorOccurred(const QString &message);
+    // 无缝切换到了 setNext() 指定的曲目（声卡开始播放其第一个样本时）
+    void trackAdvanced(const QString &path);
+
+private:
+    enum CommandType {
+        OpenCommand,
+        SeekCommand,
+        StopCommand
+    };
+
+    struct Command {
+        CommandType type;
+        QString path;
+        float gainDb;
+        qint64 positionMs;
+        quint64 generation;
+    };
+
+    void decodeLoop();
+    void outputLoop();
+
+    // 解码线程调用（持有 m_mutex）：请求输出线程清空并等待完成
+    void flushOutput();
+    // 持有 m_mutex：曲目格式对应的缓冲区/设备格式
+    AudioFormat outputFormatFor(const AudioFormat &source) const;
+
+    // 输出线程调用（不持有 m_mutex）
+    bool configurePcm(const AudioFormat &format, QString &error);
+    void closePcm();
+    void publishPosition(bool running);
+    qint64 playedFrames() const;
+    void keepHistory(const qint16 *data, int frames);
+    void copyHistory(qint16 *dst, qint64 fromEnd, int frames) const;
+
+    // 主线程
+    void setState(State state);
+    void postFinished(quint64 generation);
+    void postError(quint64 generation, const QString &message);
+    void postDuration(quint64 generation, qint64 durationMs);
+    void postTrackAdvanced(quint64 generation, const QString &path, qint64 durationMs);
+
+    QThread *m_decodeThread;
+    QThread *m_outputThread;
+    PcmRingBuffer m_ring;
+    PlaybackClock m_playbackClock;
+    PcmTap m_tap;
+    SoftwareGain m_gain;
+    Equalizer m_equalizer;
+    AudioDiagnostics m_diagnostics;
+
+    // 输出线程独占
+    PcmWriter m_writer;
+    _snd_pcm *m_pcm;                // m_writer 打开的设备
+    AudioFormat m_pcmFormat;
+    int m_periodFrames;
+    bool m_canPause;
+    qint64 m_baseFrame;             // 清空后第一帧在曲目中的位置
+    qint64 m_framesWritten;         // 清空后写入 PCM 的帧数
+    qint64 m_samplesConsumed;       // 清空后从缓冲区取出的样本数
+    qint64 m_boundaryFrame;         // 衔接点对应的 m_framesWritten，尚未写到衔接点时为 -1
+    // 设备不支持硬件暂停时保留最近写入设备的一个缓冲区的数据（已处理好），
+    // 暂停时被 drop 的部分在恢复后重新写入
+    QVector<qint16> m_history;
+    int m_historyFrames;            // m_history 的容量（帧）
+    int m_historyPos;               // 下一帧写入的位置
+    qint64 m_historyFilled;         // 已保留的帧数，不超过容量
+    qint64 m_replayFrames;          // 恢复后需要重新写入的帧数
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_decodeCond;    // 有新命令，或缓冲区腾出了空间
+    QWaitCondition m_outputCond;    // 有新数据、暂停状态变化或清空请求
+    QWaitCondition m_flushCond;     // 输出线程完成清空
+    std::deque<Command> m_commands;
+    QString m_device;
+    QString m_hardwareDevice;
+    int m_outputRate;
+    QVector<int> m_hardwareRates;   // m_ratesDevice 原样支持的采样率，从低到高
+    QString m_ratesDevice;
+    Resampler::Quality m_resamplerQuality;
+    bool m_quit;
+    bool m_paused;
+    quint64 m_flushRequest;
+    quint64 m_flushAck;
+    quint64 m_generation;           // 解码线程当前处理的曲目
+    AudioFormat m_format;           // 缓冲区与设备的格式（重采样之后），无曲目时无效
+    bool m_decoderEof;
+    bool m_finishedPosted;
+    bool m_outputFailed;
+    qint64 m_flushBaseFrame;        // 清空后的起始位置，由输出线程在清空时取走
+    QString m_nextPath;             // setNext() 指定的下一首
+    float m_nextGainDb;
+    bool m_nextTaken;               // 解码线程已切换到下一首，衔接点尚未播放
+    bool m_boundaryPending;         // 缓冲区或设备中有尚未播放到的衔接点
+    qint64 m_boundarySample;        // 衔接点：清空后写入缓冲区的第几个样本
+    QString m_boundaryPath;
+    qint64 m_boundaryDurationMs;
+    QSharedPointer<HttpStream> m_stream;    // 当前曲目的网络接收端，本地文件为空
+
+    // 主线程独占
+    State m_state;
+    quint64 m_requestGeneration;
+    qint64 m_durationMs;
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,403 @@
+#include "equalizer.h"
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// 交换槽下标的低位与“有新参数”标志
+static const int kSlotMask = 0x3;
+static const int kFreshFlag = 0x4;
+
+// 参数范围
+static const float kMinFrequency = 10.0f;
+static const float kMaxGainDb = 15.0f;
+static const float kMinQ = 0.1f;
+static const float kMaxQ = 10.0f;
+
+// 输入加上极小的直流，静音后滤波器状态不会衰减成非规格化数（标量 VFP/x86 上很慢）
+static const float kAntiDenormal = 1e-15f;
+
+namespace {
+
+struct PresetBand {
+    Equalizer::BandType type;
+    float frequency;
+    float gainDb;
+    float q;
+};
+
+struct Preset {
+    const char *name;
+    float preampDb;
+    int bandCount;
+    PresetBand bands[Equalizer::kMaxBands];
+};
+
+const Preset kPresets[] = {
+    { "关闭", 0.0f, 0, {} },
+    // 小腔体扬声器：切掉推不动的低频，压低箱体共振，提升临场感
+    { "小音箱", -4.0f, 6, {
+        { Equalizer::HighPass, 90.0f, 0.0f, 0.707f },
+        { Equalizer::Peaking, 180.0f, -2.0f, 1.0f },
+        { Equalizer::Peaking, 450.0f, -1.5f, 1.2f },
+        { Equalizer::Peaking, 2500.0f, 3.0f, 1.0f },
+        { Equalizer::Peaking, 5000.0f, 2.0f, 1.4f },
+        { Equalizer::HighShelf, 10000.0f, 1.5f, 0.707f } } },
+    { "人声", -4.0f, 5, {
+        { Equalizer::HighPass, 100.0f, 0.0f, 0.707f },
+        { Equalizer::Peaking, 250.0f, -2.0f, 1.0f },
+        { Equalizer::Peaking, 1200.0f, 1.5f, 1.0f },
+        { Equalizer::Peaking, 3000.0f, 4.0f, 1.2f },
+        { Equalizer::HighShelf, 8000.0f, -1.0f, 0.707f } } },
+    { "低音增强", -6.0f, 3, {
+        { Equalizer::HighPass, 30.0f, 0.0f, 0.707f },
+        { Equalizer::LowShelf, 100.0f, 6.0f, 0.707f },
+        { Equalizer::Peaking, 400.0f, -2.0f, 1.0f } } },
+    { "明亮", -5.0f, 3, {
+        { Equalizer::Peaking, 300.0f, -1.0f, 1.0f },
+        { Equalizer::Peaking, 3000.0f, 2.0f, 1.0f },
+        { Equalizer::HighShelf, 6000.0f, 5.0f, 0.707f } } },
+    // 小音量收听：补偿人耳对高低频的不敏感
+    { "夜间", -4.0f, 3, {
+        { Equalizer::LowShelf, 120.0f, 4.0f, 0.707f },
+        { Equalizer::Peaking, 2500.0f, -2.0f, 1.0f },
+        { Equalizer::HighShelf, 8000.0f, 3.0f, 0.707f } } },
+};
+
+const int kPresetCount = int(sizeof(kPresets) / sizeof(kPresets[0]));
+
+void toFloat(const qint16 *in, float *out, int count)
+{
+    int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t bias = vdupq_n_f32(kAntiDenormal);
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t s = vld1q_s16(in + i);
+        vst1q_f32(out + i, vaddq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), bias));
+        vst1q_f32(out + i + 4, vaddq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), bias));
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = float(in[i]) + kAntiDenormal;
+    }
+}
+
+void toS16(const float *in, qint16 *out, int count)
+{
+    int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // vcvt 向零取整：先加上与样本同号的 0.5 实现四舍五入，vqmovn 饱和收窄
+    const uint32x4_t sign = vdupq_n_u32(0x80000000u);
+    const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t a = vld1q_f32(in + i);
+        float32x4_t b = vld1q_f32(in + i + 4);
+        a = vaddq_f32(a, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(a), sign), half)));
+        b = vaddq_f32(b, vreinterpretq_f32_u32(vorrq_u32(vandq_u32(vreinterpretq_u32_f32(b), sign), half)));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(a)), vqmovn_s32(vcvtq_s32_f32(b))));
+    }
+#endif
+    for (; i < count; ++i) {
+        float x = qBound(-32768.0f, in[i], 32767.0f);
+        out[i] = qint16(qRound(x));
+    }
+}
+
+} // namespace
+
+Equalizer::Equalizer()
+    : m_shared(2)
+    , m_writeSlot(1)
+    , m_readSlot(0)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_bandCount(0)
+    , m_preamp(1.0f)
+    , m_fading(false)
+    , m_oldBandCount(0)
+    , m_oldPreamp(1.0f)
+{
+    memset(m_coefs, 0, sizeof(m_coefs));
+    memset(m_state, 0, sizeof(m_state));
+    memset(m_oldCoefs, 0, sizeof(m_oldCoefs));
+    memset(m_oldState, 0, sizeof(m_oldState));
+}
+
+void Equalizer::setParameters(const Parameters &parameters)
+{
+    m_published = parameters;
+    m_published.bandCount = qBound(0, parameters.bandCount, kMaxBands);
+
+    // 写入自己的槽后与交换槽互换，处理线程下次取走
+    m_slots[m_writeSlot] = m_published;
+    int previous = m_shared.fetchAndStoreAcquireRelease(m_writeSlot | kFreshFlag);
+    m_writeSlot = previous & kSlotMask;
+}
+
+bool Equalizer::isBypassed() const
+{
+    if (m_sampleRate <= 0) {
+        return true;
+    }
+    return m_bandCount == 0 && m_preamp == 1.0f && !m_fading && !(m_shared.loadAcquire() & kFreshFlag);
+}
+
+void Equalizer::prepare(int sampleRate, int channels)
+{
+    if (m_shared.loadAcquire() & kFreshFlag) {
+        m_readSlot = m_shared.fetchAndStoreAcquireRelease(m_readSlot) & kSlotMask;
+    }
+    if (sampleRate <= 0 || channels < 1 || channels > kMaxChannels) {
+        m_sampleRate = 0;
+        return;
+    }
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    design(m_slots[m_readSlot], m_coefs, m_bandCount, m_preamp);
+    memset(m_state, 0, sizeof(m_state));
+    m_fading = false;
+}
+
+void Equalizer::pickUp()
+{
+    if (!(m_shared.loadAcquire() & kFreshFlag)) {
+        return;
+    }
+    m_readSlot = m_shared.fetchAndStoreAcquireRelease(m_readSlot) & kSlotMask;
+
+    // 旧滤波器再处理一块用于淡出
+    memcpy(m_oldCoefs, m_coefs, sizeof(m_coefs));
+    memcpy(m_oldState, m_state, sizeof(m_state));
+    m_oldBandCount = m_bandCount;
+    m_oldPreamp = m_preamp;
+    design(m_slots[m_readSlot], m_coefs, m_bandCount, m_preamp);
+
+    // 状态是按各自的系数积累的，只交给类型与频率都相同的新频段（拖动增益或 Q）；
+    // 0dB 的峰值频段不占位置，下标会错开，所以按类型与频率查找而不是按下标对应
+    bool taken[kMaxBands] = {};
+    for (int band = 0; band < m_bandCount; ++band) {
+        int match = -1;
+        for (int old = 0; old < m_oldBandCount; ++old) {
+            if (!taken[old] && m_oldCoefs[old].type == m_coefs[band].type
+                    && m_oldCoefs[old].frequency == m_coefs[band].frequency) {
+                match = old;
+                break;
+            }
+        }
+        if (match >= 0) {
+            taken[match] = true;
+            memcpy(m_state[band], m_oldState[match], sizeof(m_state[band]));
+        } else {
+            memset(m_state[band], 0, sizeof(m_state[band]));
+        }
+    }
+    m_fading = true;
+}
+
+void Equalizer::design(const Parameters &parameters, Coefficients *coefs, int &bandCount, float &preamp) const
+{
+    // RBJ Audio EQ Cookbook，以双精度计算后归一化
+    bandCount = 0;
+    for (int i = 0; i < parameters.bandCount && i < kMaxBands; ++i) {
+        const Band &band = parameters.bands[i];
+        double frequency = qBound(double(kMinFrequency), double(band.frequency), 0.45 * m_sampleRate);
+        double gainDb = qBound(-double(kMaxGainDb), double(band.gainDb), double(kMaxGainDb));
+        double q = qBound(double(kMinQ), double(band.q), double(kMaxQ));
+
+        double a = std::pow(10.0, gainDb / 40.0);
+        double w0 = 2.0 * M_PI * frequency / m_sampleRate;
+        double cosW = std::cos(w0);
+        double alpha = std::sin(w0) / (2.0 * q);
+        double shelf = 2.0 * std::sqrt(a) * alpha;
+        double b0, b1, b2, a0, a1, a2;
+        switch (band.type) {
+        case LowShelf:
+            b0 = a * ((a + 1) - (a - 1) * cosW + shelf);
+            b1 = 2 * a * ((a - 1) - (a + 1) * cosW);
+            b2 = a * ((a + 1) - (a - 1) * cosW - shelf);
+            a0 = (a + 1) + (a - 1) * cosW + shelf;
+            a1 = -2 * ((a - 1) + (a + 1) * cosW);
+            a2 = (a + 1) + (a - 1) * cosW - shelf;
+            break;
+        case HighShelf:
+            b0 = a * ((a + 1) + (a - 1) * cosW + shelf);
+            b1 = -2 * a * ((a - 1) + (a + 1) * cosW);
+            b2 = a * ((a + 1) + (a - 1) * cosW - shelf);
+            a0 = (a + 1) - (a - 1) * cosW + shelf;
+            a1 = 2 * ((a - 1) - (a + 1) * cosW);
+            a2 = (a + 1) - (a - 1) * cosW - shelf;
+            break;
+        case HighPass:
+            b0 = (1 + cosW) / 2;
+            b1 = -(1 + cosW);
+            b2 = (1 + cosW) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha;
+            break;
+        case LowPass:
+            b0 = (1 - cosW) / 2;
+            b1 = 1 - cosW;
+            b2 = (1 - cosW) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha;
+            break;
+        case Peaking:
+        default:
+            if (gainDb == 0.0) {
+                continue;   // 0dB 的峰值滤波器是直通，不占用计算
+            }
+            b0 = 1 + alpha * a;
+            b1 = -2 * cosW;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cosW;
+            a2 = 1 - alpha / a;
+            break;
+        }
+        Coefficients &c = coefs[bandCount++];
+        c.type = band.type;
+        c.frequency = float(frequency);
+        c.b0 = float(b0 / a0);
+        c.b1 = float(b1 / a0);
+        c.b2 = float(b2 / a0);
+        c.a1 = float(a1 / a0);
+        c.a2 = float(a2 / a0);
+    }
+    preamp = float(std::pow(10.0, qBound(-24.0, double(parameters.preampDb), 12.0) / 20.0));
+}
+
+void Equalizer::runChain(float *work, int frames, const Coefficients *coefs, int bandCount,
+                         float (*state)[kMaxChannels][2], float preamp) const
+{
+    int channels = m_channels;
+
+    // 转置直接 II 型：y = b0·x + s1，s1 = b1·x − a1·y + s2，s2 = b2·x − a2·y
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    if (channels == 2) {
+        // 左右声道占一个 float32x2_t 的两条通道，交错数据可以直接按帧载入
+        for (int band = 0; band < bandCount; ++band) {
+            const Coefficients &c = coefs[band];
+            float32x2_t b0 = vdup_n_f32(c.b0);
+            float32x2_t b1 = vdup_n_f32(c.b1);
+            float32x2_t b2 = vdup_n_f32(c.b2);
+            float32x2_t a1 = vdup_n_f32(c.a1);
+            float32x2_t a2 = vdup_n_f32(c.a2);
+            float32x2_t s1 = vset_lane_f32(state[band][1][0], vdup_n_f32(state[band][0][0]), 1);
+            float32x2_t s2 = vset_lane_f32(state[band][1][1], vdup_n_f32(state[band][0][1]), 1);
+            for (int i = 0; i < frames; ++i) {
+                float32x2_t x = vld1_f32(work + i * 2);
+                float32x2_t y = vmla_f32(s1, b0, x);
+                s1 = vmls_f32(vmla_f32(s2, b1, x), a1, y);
+                s2 = vmls_f32(vmul_f32(b2, x), a2, y);
+                vst1_f32(work + i * 2, y);
+            }
+            state[band][0][0] = vget_lane_f32(s1, 0);
+            state[band][1][0] = vget_lane_f32(s1, 1);
+            state[band][0][1] = vget_lane_f32(s2, 0);
+            state[band][1][1] = vget_lane_f32(s2, 1);
+        }
+    } else
+#endif
+    {
+        for (int band = 0; band < bandCount; ++band) {
+            const Coefficients &c = coefs[band];
+            for (int ch = 0; ch < channels; ++ch) {
+                float s1 = state[band][ch][0];
+                float s2 = state[band][ch][1];
+                float *p = work + ch;
+                for (int i = 0; i < frames; ++i) {
+                    float x = p[i * channels];
+                    float y = c.b0 * x + s1;
+                    s1 = c.b1 * x - c.a1 * y + s2;
+                    s2 = c.b2 * x - c.a2 * y;
+                    p[i * channels] = y;
+                }
+                state[band][ch][0] = s1;
+                state[band][ch][1] = s2;
+            }
+        }
+    }
+
+    if (preamp != 1.0f) {
+        int count = frames * channels;
+        for (int i = 0; i < count; ++i) {
+            work[i] *= preamp;
+        }
+    }
+}
+
+void Equalizer::process(qint16 *samples, int frames)
+{
+    if (m_sampleRate <= 0) {
+        return;
+    }
+    pickUp();
+    if (m_bandCount == 0 && m_preamp == 1.0f && !m_fading) {
+        return;
+    }
+
+    int channels = m_channels;
+    while (frames > 0) {
+        int n = qMin(frames, kBlockFrames);
+        int count = n * channels;
+        toFloat(samples, m_work, count);
+        if (m_fading) {
+            memcpy(m_fadeWork, m_work, size_t(count) * sizeof(float));
+        }
+        runChain(m_work, n, m_coefs, m_bandCount, m_state, m_preamp);
+
+        if (m_fading) {
+            // 旧参数的输出线性过渡到新参数的输出
+            runChain(m_fadeWork, n, m_oldCoefs, m_oldBandCount, m_oldState, m_oldPreamp);
+            float step = 1.0f / n;
+            for (int i = 0; i < n; ++i) {
+                float t = (i + 1) * step;
+                for (int ch = 0; ch < channels; ++ch) {
+                    float &y = m_work[i * channels + ch];
+                    float old = m_fadeWork[i * channels + ch];
+                    y = old + (y - old) * t;
+                }
+            }
+            m_fading = false;
+        }
+
+        toS16(m_work, samples, count);
+        samples += count;
+        frames -= n;
+    }
+}
+
+int Equalizer::presetCount()
+{
+    return kPresetCount;
+}
+
+QString Equalizer::presetName(int preset)
+{
+    if (preset < 0 || preset >= kPresetCount) {
+        return QString();
+    }
+    return QString::fromUtf8(kPresets[preset].name);
+}
+
+Equalizer::Parameters Equalizer::preset(int preset)
+{
+    Parameters parameters;
+    if (preset < 0 || preset >= kPresetCount) {
+        return parameters;
+    }
+    const Preset &p = kPresets[preset];
+    parameters.preampDb = p.preampDb;
+    parameters.bandCount = p.bandCount;
+    for (int i = 0; i < p.bandCount; ++i) {
+        parameters.bands[i].type = p.bands[i].type;
+        parameters.bands[i].frequency = p.bands[i].frequency;
+        parameters.bands[i].gainDb = p.bands[i].gainDb;
+        parameters.bands[i].q = p.bands[i].q;
+    }
+    return parameters;
+}
@@ -0,0 +1,113 @@
+#ifndef EQUALIZER_H
+#define EQUALIZER_H
+
+#include <QAtomicInt>
+#include <QString>
+
+/**
+ * @brief 参数均衡器：最多 kMaxBands 个级联双二阶滤波器（S16 交错）
+ *
+ * 每个频段为 RBJ 公式设计的峰值、低架、高架、高通或低通滤波器，按转置直接 II 型
+ * 以单精度浮点计算。立体声在 ARM 上用 NEON 把左右声道放在同一个向量中并行处理，
+ * 其他声道数逐声道计算。
+ *
+ * 参数由界面线程通过三缓冲无锁交换发布，处理线程在下一块开始时取走，不会阻塞也
+ * 不会读到写了一半的参数。换参数时新旧两组滤波器并行处理一小块并线性交叉淡化；
+ * 类型与频率不变的频段沿用旧滤波器的状态，拖动增益或 Q 不产生咔哒声，其余从零开始。
+ *
+ * setParameters() 只能由一个线程调用；prepare()/process() 只在处理数据的线程调用。
+ */
+class Equalizer
+{
+public:
+    static const int kMaxBands = 10;
+    static const int kMaxChannels = 8;
+
+    enum BandType {
+        Peaking = 0,
+        LowShelf,
+        HighShelf,
+        HighPass,           // 增益不起作用
+        LowPass
+    };
+
+    struct Band {
+        BandType type = Peaking;
+        float frequency = 1000.0f;  // Hz
+        float gainDb = 0.0f;        // ±15dB
+        float q = 0.707f;
+    };
+
+    // 固定大小，可以在线程之间按值复制而不分配内存
+    struct Parameters {
+        float preampDb = 0.0f;      // 有频段提升时用负值留出余量，避免削波
+        int bandCount = 0;
+        Band bands[kMaxBands];
+    };
+
+    Equalizer();
+
+    // 写入线程：发布新参数；没有频段且前级增益为 0dB 时为直通
+    void setParameters(const Parameters &parameters);
+    // 写入线程：最近一次发布的参数
+    Parameters parameters() const { return m_published; }
+
+    // 处理线程：格式变化时调用，按采样率重新计算系数并清空滤波器状态
+    void prepare(int sampleRate, int channels);
+
+    // 处理线程：当前为直通且没有待取走的参数，process() 不会改动数据
+    bool isBypassed() const;
+
+    // 处理线程：当前生效的频段数
+    int activeBands() const { return m_bandCount; }
+
+    // 处理线程：原地处理交错样本
+    void process(qint16 *samples, int frames);
+
+    // 预设，第 0 个为关闭
+    static int presetCount();
+    static QString presetName(int preset);
+    static Parameters preset(int preset);
+
+private:
+    struct Coefficients {
+        float b0, b1, b2, a1, a2;   // 已除以 a0
+        BandType type;              // 以下两项用于换参数时判断能否沿用状态
+        float frequency;            // 限定范围之后的频率
+    };
+
+    // 每次处理的帧数，也是交叉淡化的长度
+    static const int kBlockFrames = 256;
+
+    void pickUp();
+    void design(const Parameters &parameters, Coefficients *coefs, int &bandCount, float &preamp) const;
+    void runChain(float *work, int frames, const Coefficients *coefs, int bandCount,
+                  float (*state)[kMaxChannels][2], float preamp) const;
+
+    // 三缓冲：写入线程与处理线程各占一个槽，第三个为交换槽
+    Parameters m_slots[3];
+    QAtomicInt m_shared;            // 交换槽下标，kFreshFlag 表示有新参数
+    int m_writeSlot;                // 写入线程独占
+    Parameters m_published;
+
+    // 以下只由处理线程访问
+    int m_readSlot;
+    int m_sampleRate;
+    int m_channels;
+    Coefficients m_coefs[kMaxBands];
+    int m_bandCount;
+    float m_preamp;
+    float m_state[kMaxBands][kMaxChannels][2];
+
+    // 交叉淡化中的旧滤波器
+    bool m_fading;
+    Coefficients m_oldCoefs[kMaxBands];
+    int m_oldBandCount;
+    float m_oldPreamp;
+    float m_oldState[kMaxBands][kMaxChannels][2];
+
+    float m_work[kBlockFrames * kMaxChannels];
+    float m_fadeWork[kBlockFrames * kMaxChannels];
+};
+
+#endif // EQUALIZER_H
@@ -0,0 +1,736 @@
+#include "flacdecoder.h"
+#include <QtEndian>
+#include <cstring>
+#include <sys/mman.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// 元数据块类型
+static const int kStreamInfo = 0;
+static const int kSeekTable = 3;
+
+// 预测阶数上限与 NEON 读取越过当前样本的余量
+static const int kMaxLpcOrder = 32;
+static const int kSamplePad = 4;
+
+// 没有定位点时，目标与起点相距超过这么多秒就先按字节二分
+static const int kBisectSeconds = 10;
+
+// 二分查找缩小到这个范围后改为逐帧跳跃
+static const qint64 kBisectBytes = 64 * 1024;
+
+namespace {
+
+/**
+ * @brief 高位在前的位读取器，64 位缓存
+ *
+ * 越过数据末尾时返回 0 并置 overrun，调用者在帧末统一检查。
+ */
+class BitReader
+{
+public:
+    BitReader(const uchar *data, qint64 size)
+        : m_start(data), m_p(data), m_end(data + size), m_cache(0), m_bits(0), m_overrun(false)
+    {
+    }
+
+    quint32 read(int n)
+    {
+        if (n == 0) {
+            return 0;
+        }
+        if (m_bits < n) {
+            refill();
+            if (m_bits < n) {
+                m_overrun = true;
+                m_cache = 0;
+                m_bits = 0;
+                return 0;
+            }
+        }
+        quint32 value = quint32(m_cache >> (64 - n));
+        m_cache <<= n;
+        m_bits -= n;
+        return value;
+    }
+
+    qint32 readSigned(int n)
+    {
+        if (n == 0) {
+            return 0;
+        }
+        return qint32(read(n) << (32 - n)) >> (32 - n);
+    }
+
+    // 连续的 0 的个数，并消耗其后的 1
+    quint32 readUnary()
+    {
+        quint32 count = 0;
+        for (;;) {
+            if (m_cache == 0) {
+                // 缓存中有效位全为 0（有效位之后也总是 0）
+                count += quint32(m_bits);
+                m_bits = 0;
+                refill();
+                if (m_bits == 0) {
+                    m_overrun = true;
+                    return count;
+                }
+                continue;
+            }
+            int zeros = __builtin_clzll(m_cache);
+            count += quint32(zeros);
+            m_cache = zeros == 63 ? 0 : m_cache << (zeros + 1);
+            m_bits -= zeros + 1;
+            return count;
+        }
+    }
+
+    // Rice 编码：商为一元码，余数为 param 位，再把无符号值映射回有符号
+    qint32 readRice(int param)
+    {
+        quint32 value = (readUnary() << param) | read(param);
+        return qint32(value >> 1) ^ -qint32(value & 1);
+    }
+
+    void alignToByte()
+    {
+        int drop = m_bits & 7;
+        m_cache <<= drop;
+        m_bits -= drop;
+    }
+
+    // 已消耗的字节数（对齐之后调用）
+    qint64 bytesConsumed() const { return (m_p - m_start) - m_bits / 8; }
+
+    bool overrun() const { return m_overrun; }
+
+private:
+    void refill()
+    {
+        while (m_bits <= 56 && m_p < m_end) {
+            m_cache |= quint64(*m_p++) << (56 - m_bits);
+            m_bits += 8;
+        }
+    }
+
+    const uchar *m_start;
+    const uchar *m_p;
+    const uchar *m_end;
+    quint64 m_cache;
+    int m_bits;
+    bool m_overrun;
+};
+
+quint8 crc8(const uchar *data, int length)
+{
+    quint8 crc = 0;
+    for (int i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? quint8((crc << 1) ^ 0x07) : quint8(crc << 1);
+        }
+    }
+    return crc;
+}
+
+int floorLog2(int value)
+{
+    int log = 0;
+    while (value >>= 1) {
+        ++log;
+    }
+    return log;
+}
+
+bool decodeResidual(BitReader &reader, qint32 *out, int blockSize, int order)
+{
+    int method = int(reader.read(2));
+    if (method > 1) {
+        return false;
+    }
+    int paramBits = method == 0 ? 4 : 5;
+    int escape = method == 0 ? 15 : 31;
+    int partitionOrder = int(reader.read(4));
+    int partitionSamples = blockSize >> partitionOrder;
+    if ((blockSize & ((1 << partitionOrder) - 1)) != 0 || partitionSamples < order) {
+        return false;
+    }
+
+    qint32 *r = out + order;
+    for (int partition = 0; partition < (1 << partitionOrder); ++partition) {
+        int param = int(reader.read(paramBits));
+        int count = partition == 0 ? partitionSamples - order : partitionSamples;
+        if (param == escape) {
+            // 转义：该分区直接以固定位数保存
+            int bits = int(reader.read(5));
+            for (int i = 0; i < count; ++i) {
+                r[i] = reader.readSigned(bits);
+            }
+        } else {
+            for (int i = 0; i < count; ++i) {
+                r[i] = reader.readRice(param);
+            }
+        }
+        r += count;
+    }
+    return !reader.overrun();
+}
+
+// 固定多项式预测：残差已在 x[order..] 中，原地恢复
+void restoreFixed(qint32 *x, int n, int order)
+{
+    switch (order) {
+    case 1:
+        for (int i = 1; i < n; ++i) {
+            x[i] += x[i - 1];
+        }
+        break;
+    case 2:
+        for (int i = 2; i < n; ++i) {
+            x[i] += 2 * x[i - 1] - x[i - 2];
+        }
+        break;
+    case 3:
+        for (int i = 3; i < n; ++i) {
+            x[i] += 3 * x[i - 1] - 3 * x[i - 2] + x[i - 3];
+        }
+        break;
+    case 4:
+        for (int i = 4; i < n; ++i) {
+            x[i] += 4 * x[i - 1] - 6 * x[i - 2] + 4 * x[i - 3] - x[i - 4];
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void restoreLpcWide(qint32 *x, int n, const qint32 *coefs, int order, int shift)
+{
+    for (int i = order; i < n; ++i) {
+        qint64 sum = 0;
+        for (int j = 0; j < order; ++j) {
+            sum += qint64(coefs[j]) * x[i - 1 - j];
+        }
+        x[i] += qint32(sum >> shift);
+    }
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+// 系数倒序并在末尾补零到 4 的倍数，与 x[i - order ..] 做点积；
+// 补零的系数对应当前及之后尚未恢复的样本（乘 0），缓冲区末尾留有 kSamplePad 的余量
+void restoreLpcNarrow(qint32 *x, int n, const qint32 *coefs, int order, int shift)
+{
+    qint32 reversed[kMaxLpcOrder + 4];
+    int padded = (order + 3) & ~3;
+    for (int k = 0; k < padded; ++k) {
+        reversed[k] = k < order ? coefs[order - 1 - k] : 0;
+    }
+
+    for (int i = order; i < n; ++i) {
+        const qint32 *history = x + i - order;
+        int32x4_t acc = vmulq_s32(vld1q_s32(history), vld1q_s32(reversed));
+        for (int k = 4; k < padded; k += 4) {
+            acc = vmlaq_s32(acc, vld1q_s32(history + k), vld1q_s32(reversed + k));
+        }
+        int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+        x[i] += vget_lane_s32(vpadd_s32(sum, sum), 0) >> shift;
+    }
+}
+#else
+void restoreLpcNarrow(qint32 *x, int n, const qint32 *coefs, int order, int shift)
+{
+    for (int i = order; i < n; ++i) {
+        qint32 sum = 0;
+        for (int j = 0; j < order; ++j) {
+            sum += coefs[j] * x[i - 1 - j];
+        }
+        x[i] += sum >> shift;
+    }
+}
+#endif
+
+bool decodeSubframe(BitReader &reader, qint32 *out, int blockSize, int bitsPerSample)
+{
+    if (reader.read(1) != 0) {
+        return false;
+    }
+    int type = int(reader.read(6));
+    int wasted = 0;
+    if (reader.read(1)) {
+        wasted = int(reader.readUnary()) + 1;
+        bitsPerSample -= wasted;
+        if (bitsPerSample <= 0) {
+            return false;
+        }
+    }
+
+    if (type == 0) {
+        // CONSTANT
+        qint32 value = reader.readSigned(bitsPerSample);
+        for (int i = 0; i < blockSize; ++i) {
+            out[i] = value;
+        }
+    } else if (type == 1) {
+        // VERBATIM
+        for (int i = 0; i < blockSize; ++i) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+    } else if (type >= 8 && type <= 12) {
+        // FIXED，阶数 0~4
+        int order = type - 8;
+        if (order > blockSize) {
+            return false;
+        }
+        for (int i = 0; i < order; ++i) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+        if (!decodeResidual(reader, out, blockSize, order)) {
+            return false;
+        }
+        restoreFixed(out, blockSize, order);
+    } else if (type >= 32) {
+        // LPC，阶数 1~32
+        int order = type - 31;
+        if (order > blockSize) {
+            return false;
+        }
+        for (int i = 0; i < order; ++i) {
+            out[i] = reader.readSigned(bitsPerSample);
+        }
+        int precision = int(reader.read(4)) + 1;
+        int shift = reader.readSigned(5);
+        if (precision == 16 || shift < 0) {
+            return false;
+        }
+        qint32 coefs[kMaxLpcOrder];
+        for (int i = 0; i < order; ++i) {
+            coefs[i] = reader.readSigned(precision);
+        }
+        if (!decodeResidual(reader, out, blockSize, order)) {
+            return false;
+        }
+        if (bitsPerSample + precision + floorLog2(order) <= 32) {
+            restoreLpcNarrow(out, blockSize, coefs, order, shift);
+        } else {
+            restoreLpcWide(out, blockSize, coefs, order, shift);
+        }
+    } else {
+        return false;   // 保留类型
+    }
+
+    if (wasted > 0) {
+        for (int i = 0; i < blockSize; ++i) {
+            out[i] = qint32(quint32(out[i]) << wasted);
+        }
+    }
+    return !reader.overrun();
+}
+
+} // namespace
+
+FlacDecoder::FlacDecoder()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_bitsPerSample(0)
+    , m_maxBlockSize(0)
+    , m_fixedBlockSize(0)
+    , m_totalSamples(0)
+    , m_firstFrame(0)
+    , m_offset(0)
+    , m_stride(0)
+    , m_blockSize(0)
+    , m_blockPos(0)
+{
+}
+
+FlacDecoder::~FlacDecoder()
+{
+    unmap();
+    m_file.close();
+}
+
+void FlacDecoder::unmap()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+}
+
+bool FlacDecoder::open(const QString &path)
+{
+    unmap();
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开文件: %1").arg(m_file.errorString());
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        m_errorString = "无法映射 FLAC 文件";
+        return false;
+    }
+    madvise(const_cast<uchar *>(m_data), size_t(m_size), MADV_SEQUENTIAL);
+
+    if (!parseMetadata()) {
+        unmap();
+        return false;
+    }
+
+    // 每声道的缓冲区一次分配到最大块长
+    m_stride = m_maxBlockSize + kSamplePad;
+    m_samples.fill(0, m_stride * m_format.channels);
+
+    // 可变块长的 STREAMINFO 中 min ≠ max，帧头里直接是样本号
+    FrameHeader first;
+    if (m_fixedBlockSize == 0 && parseFrameHeader(m_firstFrame, first)) {
+        m_fixedBlockSize = first.blockSize;
+    }
+    return seek(0);
+}
+
+bool FlacDecoder::parseMetadata()
+{
+    // 前面可能有 ID3v2
+    qint64 pos = 0;
+    if (m_size >= 10 && memcmp(m_data, "ID3", 3) == 0) {
+        pos = 10 + ((qint64(m_data[6] & 0x7F) << 21) | ((m_data[7] & 0x7F) << 14)
+                    | ((m_data[8] & 0x7F) << 7) | (m_data[9] & 0x7F));
+    }
+    if (pos + 4 > m_size || memcmp(m_data + pos, "fLaC", 4) != 0) {
+        m_errorString = "不是有效的 FLAC 文件";
+        return false;
+    }
+    pos += 4;
+
+    bool haveInfo = false;
+    bool last = false;
+    m_seekPoints.clear();
+    while (!last) {
+        if (pos + 4 > m_size) {
+            m_errorString = "FLAC 元数据已截断";
+            return false;
+        }
+        last = (m_data[pos] & 0x80) != 0;
+        int type = m_data[pos] & 0x7F;
+        qint64 length = (qint64(m_data[pos + 1]) << 16) | (m_data[pos + 2] << 8) | m_data[pos + 3];
+        const uchar *p = m_data + pos + 4;
+        pos += 4 + length;
+        if (pos > m_size) {
+            m_errorString = "FLAC 元数据已截断";
+            return false;
+        }
+
+        if (type == kStreamInfo && length >= 34) {
+            int minBlock = qFromBigEndian<quint16>(p);
+            m_maxBlockSize = qFromBigEndian<quint16>(p + 2);
+            m_format.sampleRate = int((quint32(p[10]) << 12) | (p[11] << 4) | (p[12] >> 4));
+            m_format.channels = ((p[12] >> 1) & 0x07) + 1;
+            m_bitsPerSample = (((p[12] & 0x01) << 4) | (p[13] >> 4)) + 1;
+            m_totalSamples = (qint64(p[13] & 0x0F) << 32) | qFromBigEndian<quint32>(p + 14);
+            m_fixedBlockSize = minBlock == m_maxBlockSize ? m_maxBlockSize : 0;
+            haveInfo = true;
+        } else if (type == kSeekTable) {
+            // 每个定位点 18 字节：样本号、相对第一帧的偏移、帧内样本数；全 1 的样本号为占位
+            for (qint64 i = 0; i + 18 <= length; i += 18) {
+                quint64 sample = qFromBigEndian<quint64>(p + i);
+                if (sample == ~quint64(0)) {
+                    continue;
+                }
+                SeekPoint point;
+                point.sample = qint64(sample);
+                point.offset = qint64(qFromBigEndian<quint64>(p + i + 8));
+                m_seekPoints.append(point);
+            }
+        }
+    }
+    m_firstFrame = pos;
+
+    if (!haveInfo || !m_format.isValid() || m_maxBlockSize < 16) {
+        m_errorString = "FLAC 缺少 STREAMINFO";
+        return false;
+    }
+    if (m_bitsPerSample < 4 || m_bitsPerSample > 24) {
+        m_errorString = QString("不支持 %1 位 FLAC").arg(m_bitsPerSample);
+        return false;
+    }
+    return true;
+}
+
+bool FlacDecoder::parseFrameHeader(qint64 offset, FrameHeader &header) const
+{
+    static const int kSampleSizes[8] = { 0, 8, 12, 0, 16, 20, 24, 0 };
+
+    if (offset + 6 > m_size) {
+        return false;
+    }
+    const uchar *p = m_data + offset;
+    if (p[0] != 0xFF || (p[1] & 0xFE) != 0xF8) {
+        return false;
+    }
+    bool variable = p[1] & 0x01;
+    int blockCode = p[2] >> 4;
+    int rateCode = p[2] & 0x0F;
+    int assignment = p[3] >> 4;
+    int sizeCode = (p[3] >> 1) & 0x07;
+    if (blockCode == 0 || rateCode == 15 || assignment > 10 || sizeCode == 3 || sizeCode == 7 || (p[3] & 0x01)) {
+        return false;
+    }
+
+    // 帧号或样本号，UTF-8 式变长编码，最长 7 字节
+    int pos = 4;
+    quint64 number = p[pos];
+    int extra = 0;
+    if (number >= 0x80) {
+        if (number >= 0xFE) {
+            extra = 6;
+            number = 0;
+        } else {
+            int leading = __builtin_clz(quint32(~number & 0xFF) << 24);
+            if (leading < 2) {
+                return false;
+            }
+            extra = leading - 1;
+            number &= 0x7F >> leading;
+        }
+    }
+    if (offset + pos + 1 + extra + 5 > m_size) {   // 块长、采样率各最多 2 字节与 CRC-8
+        return false;
+    }
+    for (int i = 1; i <= extra; ++i) {
+        if ((p[pos + i] & 0xC0) != 0x80) {
+            return false;
+        }
+        number = (number << 6) | (p[pos + i] & 0x3F);
+    }
+    pos += 1 + extra;
+
+    int blockSize;
+    if (blockCode == 1) {
+        blockSize = 192;
+    } else if (blockCode <= 5) {
+        blockSize = 576 << (blockCode - 2);
+    } else if (blockCode == 6) {
+        blockSize = p[pos++] + 1;
+    } else if (blockCode == 7) {
+        blockSize = ((p[pos] << 8) | p[pos + 1]) + 1;
+        pos += 2;
+    } else {
+        blockSize = 256 << (blockCode - 8);
+    }
+    // 采样率只用于校验：与 STREAMINFO 不同的帧不属于这个流
+    static const int kSampleRates[12] = { 0, 88200, 176400, 192000, 8000, 16000, 22050,
+                                          24000, 32000, 44100, 48000, 96000 };
+    int sampleRate = rateCode < 12 ? kSampleRates[rateCode] : 0;
+    if (rateCode == 12) {
+        sampleRate = p[pos++] * 1000;
+    } else if (rateCode == 13) {
+        sampleRate = (p[pos] << 8) | p[pos + 1];
+        pos += 2;
+    } else if (rateCode == 14) {
+        sampleRate = ((p[pos] << 8) | p[pos + 1]) * 10;
+        pos += 2;
+    }
+    if (offset + pos + 1 > m_size || crc8(p, pos) != p[pos]) {
+        return false;
+    }
+
+    int channels = assignment < 8 ? assignment + 1 : 2;
+    int bitsPerSample = sizeCode == 0 ? m_bitsPerSample : kSampleSizes[sizeCode];
+    if (blockSize > m_maxBlockSize || channels != m_format.channels || bitsPerSample != m_bitsPerSample
+            || (sampleRate != 0 && sampleRate != m_format.sampleRate)) {
+        return false;
+    }
+
+    header.blockSize = blockSize;
+    header.assignment = assignment;
+    header.bitsPerSample = bitsPerSample;
+    header.headerBytes = pos + 1;
+    header.firstSample = variable ? qint64(number) : qint64(number) * m_fixedBlockSize;
+    return true;
+}
+
+qint64 FlacDecoder::findFrame(qint64 from, FrameHeader &header) const
+{
+    for (qint64 i = qMax(from, m_firstFrame); i + 2 <= m_size; ++i) {
+        const uchar *hit = static_cast<const uchar *>(memchr(m_data + i, 0xFF, size_t(m_size - i)));
+        if (!hit) {
+            break;
+        }
+        i = hit - m_data;
+        if (parseFrameHeader(i, header)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int FlacDecoder::decodeFrame()
+{
+    FrameHeader header;
+    if (!parseFrameHeader(m_offset, header)) {
+        // 帧间的垃圾数据或文件末尾的标签
+        m_offset = findFrame(m_offset + 1, header);
+        if (m_offset < 0) {
+            m_offset = m_size;
+            return 0;
+        }
+    }
+
+    BitReader reader(m_data + m_offset + header.headerBytes, m_size - m_offset - header.headerBytes);
+    int channels = m_format.channels;
+    int blockSize = header.blockSize;
+    for (int ch = 0; ch < channels; ++ch) {
+        // 侧声道多一位
+        int bits = header.bitsPerSample;
+        if ((header.assignment == 8 && ch == 1) || (header.assignment == 9 && ch == 0)
+                || (header.assignment == 10 && ch == 1)) {
+            ++bits;
+        }
+        if (!decodeSubframe(reader, m_samples.data() + ch * m_stride, blockSize, bits)) {
+            m_errorString = "FLAC 帧数据损坏";
+            return -1;
+        }
+    }
+    reader.alignToByte();
+    m_offset += header.headerBytes + reader.bytesConsumed() + 2;   // 帧尾 CRC-16
+
+    // 声道去相关
+    qint32 *a = m_samples.data();
+    qint32 *b = a + m_stride;
+    switch (header.assignment) {
+    case 8:     // 左、侧：右 = 左 - 侧
+        for (int i = 0; i < blockSize; ++i) {
+            b[i] = a[i] - b[i];
+        }
+        break;
+    case 9:     // 侧、右：左 = 侧 + 右
+        for (int i = 0; i < blockSize; ++i) {
+            a[i] += b[i];
+        }
+        break;
+    case 10:    // 中、侧
+        for (int i = 0; i < blockSize; ++i) {
+            qint32 side = b[i];
+            qint32 mid = qint32(quint32(a[i]) << 1) | (side & 1);
+            a[i] = (mid + side) >> 1;
+            b[i] = (mid - side) >> 1;
+        }
+        break;
+    default:
+        break;
+    }
+
+    m_blockSize = blockSize;
+    m_blockPos = 0;
+    return 1;
+}
+
+int FlacDecoder::read(qint16 *buffer, int maxFrames)
+{
+    int channels = m_format.channels;
+    int shift = m_bitsPerSample - 16;
+    int done = 0;
+    while (done < maxFrames) {
+        if (m_blockPos >= m_blockSize) {
+            int result = decodeFrame();
+            if (result == 0) {
+                break;
+            }
+            if (result < 0) {
+                return done > 0 ? done : -1;
+            }
+            continue;
+        }
+
+        // 交错并转换为 16 位，直接写入调用者的缓冲区
+        int frames = qMin(maxFrames - done, m_blockSize - m_blockPos);
+        qint16 *out = buffer + done * channels;
+        for (int ch = 0; ch < channels; ++ch) {
+            const qint32 *src = m_samples.constData() + ch * m_stride + m_blockPos;
+            qint16 *dst = out + ch;
+            if (shift >= 0) {
+                for (int i = 0; i < frames; ++i) {
+                    dst[i * channels] = qint16(src[i] >> shift);
+                }
+            } else {
+                for (int i = 0; i < frames; ++i) {
+                    dst[i * channels] = qint16(quint32(src[i]) << -shift);
+                }
+            }
+        }
+        m_blockPos += frames;
+        done += frames;
+    }
+    return done;
+}
+
+bool FlacDecoder::seek(qint64 frame)
+{
+    if (m_totalSamples > 0) {
+        frame = qBound<qint64>(0, frame, m_totalSamples);
+    }
+
+    // 不晚于目标的最后一个定位点
+    qint64 offset = m_firstFrame;
+    qint64 start = 0;
+    for (const SeekPoint &point : m_seekPoints) {
+        if (point.sample > frame || m_firstFrame + point.offset >= m_size) {
+            break;
+        }
+        offset = m_firstFrame + point.offset;
+        start = point.sample;
+    }
+
+    // 离定位点太远时按字节位置二分：[low, high) 中找到的帧头样本号不晚于目标则收紧下界
+    FrameHeader header;
+    if (frame - start > qint64(m_format.sampleRate) * kBisectSeconds) {
+        qint64 low = offset;
+        qint64 high = m_size;
+        while (high - low > kBisectBytes) {
+            qint64 mid = low + (high - low) / 2;
+            qint64 found = findFrame(mid, header);
+            if (found < 0 || found >= high || header.firstSample > frame) {
+                high = mid;
+            } else {
+                low = found;
+            }
+        }
+        offset = low;
+    }
+
+    // 逐帧跳跃：只解析帧头，按同步字找下一帧，并要求样本号连续以排除误同步
+    if (!parseFrameHeader(offset, header)) {
+        offset = findFrame(offset, header);
+        if (offset < 0) {
+            m_errorString = "FLAC 定位失败";
+            return false;
+        }
+    }
+    while (header.firstSample + header.blockSize <= frame) {
+        qint64 expected = header.firstSample + header.blockSize;
+        FrameHeader next;
+        qint64 found = offset;
+        do {
+            found = findFrame(found + header.headerBytes, next);
+        } while (found >= 0 && next.firstSample != expected);
+        if (found < 0) {
+            break;      // 目标在最后一帧之后
+        }
+        offset = found;
+        header = next;
+    }
+
+    m_offset = offset;
+    m_blockSize = 0;
+    m_blockPos = 0;
+    if (frame > header.firstSample && decodeFrame() > 0) {
+        m_blockPos = int(qMin<qint64>(frame - header.firstSample, m_blockSize));
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef FLACDECODER_H
+#define FLACDECODER_H
+
+#include "audiodecoder.h"
+#include <QFile>
+#include <QVector>
+
+/**
+ * @brief FLAC 解码器（自带实现，不依赖 libFLAC）
+ *
+ * 整个文件只读映射，按帧解码到预先分配的每声道 32 位缓冲区，再交错转换写入调用者的
+ * S16 缓冲区；打开之后解码过程中不再分配内存。支持 4~24 位、最多 8 声道，
+ * 不校验帧尾的 CRC-16（帧头的 CRC-8 用于定位时确认同步）。
+ *
+ * LPC 预测恢复是逐样本的递推，每个样本要与前 order 个样本做点积：在 ARM 上用 NEON
+ * 一次乘加 4 个系数，32 位累加不会溢出时（位深 + 系数精度 + log2(阶数) ≤ 32，
+ * 16 位音频总是满足）走这条路径，否则用 64 位标量累加。
+ *
+ * 定位：有 SEEKTABLE 时从不晚于目标的定位点开始，否则按字节位置二分查找帧头；
+ * 之后只解析帧头、按同步字跳到目标所在的帧，不解码中间的帧。
+ */
+class FlacDecoder : public AudioDecoder
+{
+public:
+    FlacDecoder();
+    ~FlacDecoder() override;
+
+    bool open(const QString &path) override;
+    AudioFormat format() const override { return m_format; }
+    qint64 totalFrames() const override { return m_totalSamples > 0 ? m_totalSamples : -1; }
+    int read(qint16 *buffer, int maxFrames) override;
+    bool seek(qint64 frame) override;
+
+private:
+    struct FrameHeader {
+        int blockSize = 0;
+        int assignment = 0;         // 0~7 为独立声道，8~10 为左/侧、右/侧、中/侧
+        int bitsPerSample = 0;
+        int headerBytes = 0;
+        qint64 firstSample = 0;
+    };
+
+    struct SeekPoint {
+        qint64 sample;
+        qint64 offset;              // 相对第一帧
+    };
+
+    bool parseMetadata();
+    bool parseFrameHeader(qint64 offset, FrameHeader &header) const;
+    qint64 findFrame(qint64 from, FrameHeader &header) const;
+    int decodeFrame();
+    void unmap();
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    AudioFormat m_format;
+    int m_bitsPerSample;
+    int m_maxBlockSize;
+    int m_fixedBlockSize;           // 固定块长的流中帧号换算样本号，可变块长为 0
+    qint64 m_totalSamples;
+    qint64 m_firstFrame;            // 第一帧在文件中的偏移
+    QVector<SeekPoint> m_seekPoints;
+
+    qint64 m_offset;                // 下一帧的偏移
+    QVector<qint32> m_samples;      // 每声道 m_stride 个样本
+    int m_stride;
+    int m_blockSize;                // 当前帧的样本数
+    int m_blockPos;                 // 当前帧中已输出的样本
+};
+
+#endif // FLACDECODER_H
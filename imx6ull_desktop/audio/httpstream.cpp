@@ -0,0 +1,452 @@
+#include "httpstream.h"
+#include "boardthread.h"
+#include <QThread>
+#include <QTcpSocket>
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+// 缓冲区容量：320kbps 时约 26 秒，足够容纳最大的预缓冲目标
+static const int kBufferBytes = 1024 * 1024;
+
+// 每次从套接字读取的字节数
+static const int kReadBytes = 16 * 1024;
+
+// 阻塞等待的间隔，期间检查是否要停止
+static const int kPollMs = 200;
+
+// 响应头的长度上限
+static const int kMaxHeaderBytes = 16 * 1024;
+
+HttpStream::HttpStream(const QString &url)
+    : m_url(url)
+    , m_buffer(kBufferBytes)
+    , m_thread(nullptr)
+    , m_stop(false)
+    , m_headersReceived(false)
+    , m_connected(false)
+    , m_bitrateKbps(0)
+    , m_receiveKbps(0)
+    , m_reconnects(0)
+{
+}
+
+HttpStream::~HttpStream()
+{
+    stop();
+}
+
+void HttpStream::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_cond.wakeAll();
+    }
+    m_buffer.abort();
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+bool HttpStream::handles(const QString &url)
+{
+    return url.startsWith("http://", Qt::CaseInsensitive);
+}
+
+void HttpStream::start()
+{
+    if (m_thread || stopping()) {
+        return;
+    }
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("HttpStream");
+    m_thread->start();
+}
+
+bool HttpStream::waitForHeaders(int timeoutMs, QString &error)
+{
+    QMutexLocker locker(&m_mutex);
+    QElapsedTimer timer;
+    timer.start();
+    while (!m_headersReceived && m_error.isEmpty() && !m_stop) {
+        qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            break;
+        }
+        m_cond.wait(&m_mutex, quint64(remaining));
+    }
+    if (m_headersReceived) {
+        return true;
+    }
+    error = m_error.isEmpty() ? QString("连接超时: %1").arg(m_url.host()) : m_error;
+    return false;
+}
+
+HttpStream::Status HttpStream::status() const
+{
+    Status status;
+    status.buffer = m_buffer.stats();
+    QMutexLocker locker(&m_mutex);
+    status.connected = m_connected;
+    status.contentType = m_contentType;
+    status.name = m_name;
+    status.title = m_title;
+    status.bitrateKbps = m_bitrateKbps;
+    status.receiveKbps = m_receiveKbps;
+    status.reconnects = m_reconnects;
+    status.error = m_error;
+    return status;
+}
+
+bool HttpStream::stopping() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stop;
+}
+
+void HttpStream::sleep(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_stop) {
+        m_cond.wait(&m_mutex, quint64(ms));
+    }
+}
+
+void HttpStream::threadLoop()
+{
+    qint64 received = 0;            // 已写入缓冲区的正文字节
+    qint64 contentLength = -1;      // 普通文件的总长度，直播流为 -1
+    bool connectedOnce = false;
+    int failures = 0;
+
+    while (!stopping()) {
+        QTcpSocket socket;
+        Response response;
+        QString error;
+        // 普通文件从断点续传；直播流重连后从服务器的当前位置继续
+        qint64 offset = contentLength > 0 ? received : 0;
+        if (request(socket, offset, response, error)) {
+            if (!connectedOnce) {
+                contentLength = response.contentLength;
+                connectedOnce = true;
+            }
+            if (response.bitrateKbps > 0) {
+                m_buffer.setByteRate(response.bitrateKbps * 1000 / 8);
+            }
+            {
+                QMutexLocker locker(&m_mutex);
+                m_headersReceived = true;
+                m_connected = true;
+                m_contentType = response.contentType;
+                if (!response.name.isEmpty()) {
+                    m_name = response.name;
+                }
+                m_bitrateKbps = response.bitrateKbps;
+                m_cond.wakeAll();
+            }
+
+            // 服务器忽略了 Range，从头发送：跳过已收到的部分
+            qint64 skip = (offset > 0 && response.code == 200) ? offset : 0;
+            qint64 got = receive(socket, response, skip);
+            received += got;
+            {
+                QMutexLocker locker(&m_mutex);
+                m_connected = false;
+                m_receiveKbps = 0;
+            }
+            if (contentLength >= 0 && received >= contentLength) {
+                qDebug() << "HttpStream: completed," << received << "bytes";
+                break;
+            }
+            if (got > 0) {
+                failures = 0;
+            }
+        } else {
+            qDebug() << "HttpStream:" << error;
+            if (!connectedOnce) {
+                QMutexLocker locker(&m_mutex);
+                m_error = error;
+                m_cond.wakeAll();
+                break;
+            }
+        }
+
+        if (stopping()) {
+            break;
+        }
+        if (++failures > kMaxRetries) {
+            QMutexLocker locker(&m_mutex);
+            m_error = QString("网络流中断，已重试 %1 次").arg(kMaxRetries);
+            qDebug() << "HttpStream: giving up";
+            break;
+        }
+        int delay = qMin(kReconnectBaseMs << (failures - 1), int(kReconnectMaxMs));
+        qDebug() << "HttpStream: reconnecting in" << delay << "ms";
+        sleep(delay);
+        QMutexLocker locker(&m_mutex);
+        ++m_reconnects;
+    }
+    m_buffer.finish();
+}
+
+bool HttpStream::request(QTcpSocket &socket, qint64 offset, Response &response, QString &error)
+{
+    QUrl url = m_url;
+    for (int redirect = 0; redirect <= kMaxRedirects; ++redirect) {
+        if (url.scheme().toLower() != "http") {
+            error = QString("不支持的协议: %1").arg(url.scheme());
+            return false;
+        }
+        socket.abort();
+        socket.connectToHost(url.host(), quint16(url.port(80)));
+        if (!socket.waitForConnected(kConnectTimeoutMs)) {
+            error = QString("无法连接 %1: %2").arg(url.host(), socket.errorString());
+            return false;
+        }
+
+        QByteArray path = url.path(QUrl::FullyEncoded).toLatin1();
+        if (path.isEmpty()) {
+            path = "/";
+        }
+        if (url.hasQuery()) {
+            path += '?' + url.query(QUrl::FullyEncoded).toLatin1();
+        }
+        QByteArray host = url.host(QUrl::FullyEncoded).toLatin1();
+        if (url.port() > 0 && url.port() != 80) {
+            host += ':' + QByteArray::number(url.port());
+        }
+        QByteArray header = "GET " + path + " HTTP/1.0\r\n"
+                            "Host: " + host + "\r\n"
+                            "User-Agent: imx6ull_desktop\r\n"
+                            "Accept: */*\r\n"
+                            "Icy-MetaData: 1\r\n";
+        if (offset > 0) {
+            header += "Range: bytes=" + QByteArray::number(offset) + "-\r\n";
+        }
+        header += "\r\n";
+        socket.write(header);
+        if (!socket.waitForBytesWritten(kConnectTimeoutMs)) {
+            error = QString("发送请求失败: %1").arg(socket.errorString());
+            return false;
+        }
+
+        response = Response();
+        if (!readHeaders(socket, response, error)) {
+            return false;
+        }
+        if (response.code >= 300 && response.code < 400 && response.location.isValid()) {
+            url = url.resolved(response.location);
+            qDebug() << "HttpStream: redirected to" << url.toString();
+            continue;
+        }
+        if (response.code != 200 && response.code != 206) {
+            error = QString("服务器返回 %1").arg(response.code);
+            return false;
+        }
+        return true;
+    }
+    error = "重定向次数过多";
+    return false;
+}
+
+bool HttpStream::readHeaders(QTcpSocket &socket, Response &response, QString &error)
+{
+    QElapsedTimer timer;
+    timer.start();
+    bool statusLine = true;
+    int headerBytes = 0;
+    for (;;) {
+        if (!socket.canReadLine()) {
+            if (stopping()) {
+                error = "已停止";
+                return false;
+            }
+            if (socket.bytesAvailable() > kMaxHeaderBytes) {
+                error = "响应头过长";
+                return false;
+            }
+            if (timer.elapsed() > kConnectTimeoutMs) {
+                error = "等待响应超时";
+                return false;
+            }
+            if (!socket.waitForReadyRead(kPollMs) && socket.state() != QAbstractSocket::ConnectedState
+                    && !socket.canReadLine()) {
+                error = "连接在响应头之前断开";
+                return false;
+            }
+            continue;
+        }
+
+        QByteArray line = socket.readLine(kMaxHeaderBytes).trimmed();
+        headerBytes += line.size();
+        if (headerBytes > kMaxHeaderBytes) {
+            error = "响应头过长";
+            return false;
+        }
+        if (statusLine) {
+            // "HTTP/1.1 200 OK"，SHOUTcast 为 "ICY 200 OK"
+            QList<QByteArray> parts = line.split(' ');
+            if (parts.size() < 2 || !(parts[0].startsWith("HTTP/") || parts[0] == "ICY")) {
+                error = "不是 HTTP 响应";
+                return false;
+            }
+            response.code = parts[1].toInt();
+            statusLine = false;
+            continue;
+        }
+        if (line.isEmpty()) {
+            return true;
+        }
+
+        int colon = line.indexOf(':');
+        if (colon <= 0) {
+            continue;
+        }
+        QByteArray key = line.left(colon).trimmed().toLower();
+        QByteArray value = line.mid(colon + 1).trimmed();
+        if (key == "content-type") {
+            response.contentType = QString::fromLatin1(value.split(';').first().trimmed().toLower());
+        } else if (key == "content-length") {
+            if (response.contentLength < 0) {
+                response.contentLength = value.toLongLong();
+            }
+        } else if (key == "content-range") {
+            // "bytes 100-999/1000"：取整个文件的长度
+            int slash = value.indexOf('/');
+            bool ok = false;
+            qint64 total = slash > 0 ? value.mid(slash + 1).toLongLong(&ok) : 0;
+            if (ok) {
+                response.contentLength = total;
+            }
+        } else if (key == "icy-metaint") {
+            response.metaInterval = qMax(0, value.toInt());
+        } else if (key == "icy-name") {
+            response.name = QString::fromUtf8(value);
+        } else if (key == "icy-br") {
+            response.bitrateKbps = value.split(',').first().toInt();
+        } else if (key == "location") {
+            response.location = QUrl(QString::fromUtf8(value));
+        }
+    }
+}
+
+qint64 HttpStream::receive(QTcpSocket &socket, const Response &response, qint64 skip)
+{
+    const int interval = response.metaInterval;
+    int untilMeta = interval;           // 下一段元数据之前的音频字节
+    int metaLength = -1;                // 正在接收的元数据长度，-1 表示下一个字节是长度
+    QByteArray metadata;
+    qint64 delivered = 0;
+    bool aborted = false;
+
+    QElapsedTimer idle;
+    idle.start();
+    QElapsedTimer rateTimer;
+    rateTimer.start();
+    qint64 rateBytes = 0;
+
+    // 正文中的音频数据写入缓冲区；续传时先丢掉服务器重发的部分
+    auto deliver = [&](const char *data, int size) {
+        if (skip > 0) {
+            int drop = int(qMin<qint64>(skip, size));
+            skip -= drop;
+            data += drop;
+            size -= drop;
+        }
+        if (size > 0) {
+            if (!m_buffer.write(data, size)) {
+                aborted = true;
+            }
+            delivered += size;
+        }
+    };
+
+    while (!aborted && !stopping()) {
+        if (socket.bytesAvailable() == 0) {
+            bool ready = socket.waitForReadyRead(kPollMs);
+            if (rateTimer.elapsed() >= 1000) {
+                QMutexLocker locker(&m_mutex);
+                m_receiveKbps = int(rateBytes * 8 / rateTimer.elapsed());
+                rateBytes = 0;
+                rateTimer.restart();
+            }
+            if (!ready) {
+                if (socket.state() != QAbstractSocket::ConnectedState) {
+                    qDebug() << "HttpStream: connection closed," << socket.errorString();
+                    break;
+                }
+                if (idle.elapsed() > kStallTimeoutMs) {
+                    qDebug() << "HttpStream: no data for" << kStallTimeoutMs << "ms";
+                    break;
+                }
+                continue;
+            }
+        }
+        QByteArray data = socket.read(kReadBytes);
+        rateBytes += data.size();
+        const char *p = data.constData();
+        int n = data.size();
+        while (n > 0 && !aborted) {
+            if (interval <= 0 || untilMeta > 0) {
+                int count = interval > 0 ? qMin(n, untilMeta) : n;
+                deliver(p, count);
+                if (interval > 0) {
+                    untilMeta -= count;
+                }
+                p += count;
+                n -= count;
+            } else if (metaLength < 0) {
+                // 长度字节以 16 字节为单位，0 表示这次没有元数据
+                metaLength = uchar(*p) * 16;
+                ++p;
+                --n;
+                metadata.clear();
+                if (metaLength == 0) {
+                    metaLength = -1;
+                    untilMeta = interval;
+                }
+            } else {
+                int count = qMin(n, metaLength - metadata.size());
+                metadata.append(p, count);
+                p += count;
+                n -= count;
+                if (metadata.size() == metaLength) {
+                    parseMetadata(metadata);
+                    metaLength = -1;
+                    untilMeta = interval;
+                }
+            }
+        }
+        // 缓冲区满时 write() 会阻塞，空闲时间从写完之后算起
+        idle.restart();
+    }
+    return delivered;
+}
+
+void HttpStream::parseMetadata(const QByteArray &metadata)
+{
+    // StreamTitle='歌手 - 曲名';StreamUrl='...';，末尾用 0 填充
+    static const QByteArray kKey = "StreamTitle='";
+    int start = metadata.indexOf(kKey);
+    if (start < 0) {
+        return;
+    }
+    start += kKey.size();
+    int end = metadata.indexOf("';", start);
+    if (end < 0) {
+        end = metadata.indexOf('\0', start);
+    }
+    if (end < 0) {
+        end = metadata.size();
+    }
+    QString title = QString::fromUtf8(metadata.mid(start, end - start)).trimmed();
+
+    QMutexLocker locker(&m_mutex);
+    if (title != m_title) {
+        m_title = title;
+        qDebug() << "HttpStream: title" << title;
+    }
+}
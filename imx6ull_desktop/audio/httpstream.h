@@ -0,0 +1,111 @@
+#ifndef HTTPSTREAM_H
+#define HTTPSTREAM_H
+
+#include "jitterbuffer.h"
+#include <QMutex>
+#include <QString>
+#include <QUrl>
+#include <QWaitCondition>
+
+class QThread;
+class QTcpSocket;
+
+/**
+ * @brief HTTP/Icecast 音频流的接收端
+ *
+ * 在自己的线程里用阻塞的 QTcpSocket 接收响应正文写入 JitterBuffer，解码线程
+ * 只从缓冲区取数据，不碰网络。请求使用 HTTP/1.0（服务器不会用分块编码），
+ * 跟随最多 kMaxRedirects 次重定向，接受 Icecast/SHOUTcast 的 "ICY 200" 状态行。
+ *
+ * 请求头带 Icy-MetaData: 1，服务器按 icy-metaint 间隔插入的元数据从正文中去掉，
+ * 其中的 StreamTitle 作为当前曲名。
+ *
+ * 重连：连接断开或超过 kStallTimeoutMs 收不到数据时重新请求，间隔从
+ * kReconnectBaseMs 起每次失败翻倍，最长 kReconnectMaxMs；连续 kMaxRetries 次
+ * 收不到数据后放弃，缓冲区中剩下的数据播完即结束。响应带 Content-Length 的
+ * （普通文件）重连时用 Range 从断点续传，服务器不支持时跳过已收到的部分。
+ * 第一次连接失败不重试，直接报告错误。
+ */
+class HttpStream
+{
+public:
+    static const int kMaxRedirects = 5;
+    static const int kConnectTimeoutMs = 5000;
+    static const int kStallTimeoutMs = 10000;
+    static const int kReconnectBaseMs = 500;
+    static const int kReconnectMaxMs = 16000;
+    static const int kMaxRetries = 6;
+
+    struct Status {
+        JitterBuffer::Stats buffer;
+        bool connected = false;
+        QString contentType;
+        QString name;                   // icy-name
+        QString title;                  // 元数据中的 StreamTitle
+        int bitrateKbps = 0;            // icy-br，没有时为 0
+        int receiveKbps = 0;            // 最近一秒的接收速率
+        quint64 reconnects = 0;
+        QString error;                  // 放弃时的原因
+    };
+
+    explicit HttpStream(const QString &url);
+    ~HttpStream();
+
+    // 只按 URL 前缀判断（http://）
+    static bool handles(const QString &url);
+
+    // 启动网络线程
+    void start();
+    // 停止并等待网络线程退出，之后 status() 仍然可用
+    void stop();
+
+    // 等待收到第一个响应头；连接失败或超时返回 false
+    bool waitForHeaders(int timeoutMs, QString &error);
+
+    JitterBuffer *buffer() { return &m_buffer; }
+
+    // 任意线程可调用
+    Status status() const;
+
+private:
+    struct Response {
+        int code = 0;
+        QString contentType;
+        qint64 contentLength = -1;      // 206 时为整个文件的长度
+        int metaInterval = 0;
+        QString name;
+        int bitrateKbps = 0;
+        QUrl location;
+    };
+
+    void threadLoop();
+    // 建立连接并读完响应头（含重定向）；offset > 0 时请求从该处续传
+    bool request(QTcpSocket &socket, qint64 offset, Response &response, QString &error);
+    bool readHeaders(QTcpSocket &socket, Response &response, QString &error);
+    // 接收正文直到断开或停止；返回写入缓冲区的字节数
+    qint64 receive(QTcpSocket &socket, const Response &response, qint64 skip);
+    void parseMetadata(const QByteArray &metadata);
+    bool stopping() const;
+    // 最多等待 ms 毫秒，停止时提前返回
+    void sleep(int ms);
+
+    QUrl m_url;
+    JitterBuffer m_buffer;
+    QThread *m_thread;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;          // 收到响应头、出错或停止
+    bool m_stop;
+    bool m_headersReceived;
+    bool m_connected;
+    QString m_contentType;
+    QString m_name;
+    QString m_title;
+    int m_bitrateKbps;
+    int m_receiveKbps;
+    quint64 m_reconnects;
+    QString m_error;
+};
+
+#endif // HTTPSTREAM_H
@@ -0,0 +1,190 @@
+#include "jitterbuffer.h"
+#include <QMutexLocker>
+#include <cstring>
+
+// 字节率未知时按 128kbps 估算
+static const int kDefaultByteRate = 128000 / 8;
+
+JitterBuffer::JitterBuffer(int capacity)
+    : m_buffer(capacity, '\0')
+    , m_readPos(0)
+    , m_level(0)
+    , m_state(Buffering)
+    , m_ended(false)
+    , m_aborted(false)
+    , m_byteRate(0)
+    , m_targetMs(kInitialTargetMs)
+    , m_underruns(0)
+    , m_bytesIn(0)
+    , m_bytesOut(0)
+{
+    m_stableTimer.start();
+}
+
+int JitterBuffer::levelMs() const
+{
+    int rate = m_byteRate > 0 ? m_byteRate : kDefaultByteRate;
+    return int(qint64(m_level) * 1000 / rate);
+}
+
+int JitterBuffer::targetBytes() const
+{
+    int rate = m_byteRate > 0 ? m_byteRate : kDefaultByteRate;
+    // 高码率时目标可能超过容量，留出余量，避免缓冲区满了仍在缓冲
+    return int(qMin<qint64>(qint64(rate) * m_targetMs / 1000, m_buffer.size() * 3 / 4));
+}
+
+void JitterBuffer::updateState()
+{
+    if (m_state == Buffering && (m_level >= targetBytes() || m_ended)) {
+        m_state = Playing;
+        m_stableTimer.restart();
+    }
+    if (m_ended && m_level == 0) {
+        m_state = Finished;
+    }
+}
+
+void JitterBuffer::copyOut(char *data, int size) const
+{
+    int first = qMin(size, m_buffer.size() - m_readPos);
+    memcpy(data, m_buffer.constData() + m_readPos, size_t(first));
+    memcpy(data + first, m_buffer.constData(), size_t(size - first));
+}
+
+bool JitterBuffer::write(const char *data, int size)
+{
+    QMutexLocker locker(&m_mutex);
+    while (size > 0) {
+        while (m_level == m_buffer.size() && !m_aborted) {
+            m_writable.wait(&m_mutex);
+        }
+        if (m_aborted) {
+            return false;
+        }
+        int capacity = m_buffer.size();
+        int writePos = (m_readPos + m_level) % capacity;
+        int count = qMin(size, capacity - m_level);
+        int first = qMin(count, capacity - writePos);
+        memcpy(m_buffer.data() + writePos, data, size_t(first));
+        memcpy(m_buffer.data(), data + first, size_t(count - first));
+        m_level += count;
+        m_bytesIn += quint64(count);
+        data += count;
+        size -= count;
+        updateState();
+        m_readable.wakeAll();
+    }
+    return true;
+}
+
+void JitterBuffer::finish()
+{
+    QMutexLocker locker(&m_mutex);
+    m_ended = true;
+    updateState();
+    m_readable.wakeAll();
+}
+
+void JitterBuffer::abort()
+{
+    QMutexLocker locker(&m_mutex);
+    m_aborted = true;
+    m_readable.wakeAll();
+    m_writable.wakeAll();
+}
+
+bool JitterBuffer::ready(int minBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    updateState();
+    if (m_ended) {
+        return true;
+    }
+    if (m_state != Playing) {
+        return false;
+    }
+    if (m_level < minBytes) {
+        // 播放中取空：网络跟不上，下次多缓冲一些
+        ++m_underruns;
+        m_targetMs = qMin(m_targetMs * 3 / 2, int(kMaxTargetMs));
+        m_state = Buffering;
+        return false;
+    }
+    if (m_stableTimer.elapsed() >= kShrinkAfterMs) {
+        m_targetMs = qMax(m_targetMs * 4 / 5, int(kMinTargetMs));
+        m_stableTimer.restart();
+    }
+    return true;
+}
+
+bool JitterBuffer::waitReady(int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    updateState();
+    if (m_state == Buffering && !m_aborted) {
+        m_readable.wait(&m_mutex, timeoutMs);
+        updateState();
+    }
+    return m_state != Buffering;
+}
+
+int JitterBuffer::read(char *data, int maxSize, int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_level == 0 && !m_ended && !m_aborted && timeoutMs > 0) {
+        m_readable.wait(&m_mutex, timeoutMs);
+    }
+    if (m_level == 0) {
+        updateState();
+        return m_ended ? -1 : 0;
+    }
+    int count = qMin(maxSize, m_level);
+    copyOut(data, count);
+    m_readPos = (m_readPos + count) % m_buffer.size();
+    m_level -= count;
+    m_bytesOut += quint64(count);
+    updateState();
+    m_writable.wakeAll();
+    return count;
+}
+
+int JitterBuffer::peek(char *data, int size, int timeoutMs)
+{
+    QMutexLocker locker(&m_mutex);
+    size = qMin(size, m_buffer.size());
+    QElapsedTimer timer;
+    timer.start();
+    while (m_level < size && !m_ended && !m_aborted) {
+        qint64 remaining = timeoutMs - timer.elapsed();
+        if (remaining <= 0) {
+            break;
+        }
+        m_readable.wait(&m_mutex, quint64(remaining));
+    }
+    int count = qMin(size, m_level);
+    copyOut(data, count);
+    return count;
+}
+
+void JitterBuffer::setByteRate(int bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    m_byteRate = qMax(0, bytesPerSecond);
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats;
+    stats.state = m_state;
+    stats.levelBytes = m_level;
+    stats.levelMs = levelMs();
+    stats.targetMs = m_targetMs;
+    stats.byteRate = m_byteRate;
+    stats.underruns = m_underruns;
+    stats.bytesIn = m_bytesIn;
+    stats.bytesOut = m_bytesOut;
+    stats.ended = m_ended;
+    return stats;
+}
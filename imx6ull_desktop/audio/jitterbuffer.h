@@ -0,0 +1,100 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+
+/**
+ * @brief 网络流的抖动缓冲区：压缩数据的字节环，带自适应预缓冲
+ *
+ * 网络线程写入、解码线程读取。缓冲区满时 write() 阻塞，不再从套接字读取，
+ * 由 TCP 的流量控制让服务器放慢发送，不会无限占用内存。
+ *
+ * 开始播放前和每次取空之后处于缓冲状态，数据达到目标时长才允许解码线程读取。
+ * 目标时长自适应：每次取空（欠载）放大到 1.5 倍，上限 kMaxTargetMs；连续
+ * kShrinkAfterMs 没有欠载则缩小 20%，下限 kMinTargetMs。网络稳定时起播与
+ * 恢复更快，网络抖动大时多缓冲一些，不反复卡顿。
+ *
+ * 时长按字节率换算，字节率由解码器从码流（MP3 帧头、Vorbis 标称码率）或
+ * icy-br 响应头得到，未知时按 128kbps 估算。
+ */
+class JitterBuffer
+{
+public:
+    static const int kInitialTargetMs = 2000;
+    static const int kMinTargetMs = 1000;
+    static const int kMaxTargetMs = 20000;
+    static const int kShrinkAfterMs = 60000;
+
+    enum State {
+        Buffering = 0,
+        Playing,
+        Finished            // 网络端已结束且数据已取完
+    };
+
+    struct Stats {
+        State state = Buffering;
+        int levelBytes = 0;
+        int levelMs = 0;
+        int targetMs = kInitialTargetMs;
+        int byteRate = 0;
+        quint64 underruns = 0;
+        quint64 bytesIn = 0;
+        quint64 bytesOut = 0;
+        bool ended = false;             // 网络端不会再写入
+    };
+
+    explicit JitterBuffer(int capacity);
+
+    // 网络线程：写入全部数据，缓冲区满时等待；abort() 后返回 false
+    bool write(const char *data, int size);
+    // 网络线程：不会再有数据，剩余数据不再受预缓冲限制
+    void finish();
+
+    // 任意线程：唤醒并放弃所有等待，之后的 write() 立即返回 false
+    void abort();
+
+    // 解码线程：至少有 minBytes 可读（或已结束）时返回 true。播放中数据不足
+    // minBytes 记为一次欠载并回到缓冲状态
+    bool ready(int minBytes);
+    // 解码线程：等待进入可读状态（或结束、中止），最多 timeoutMs
+    bool waitReady(int timeoutMs);
+    // 解码线程：读取最多 maxSize 字节，不受缓冲状态限制；没有数据时最多等待
+    // timeoutMs。返回字节数，0 表示暂时没有，-1 表示已结束且取完
+    int read(char *data, int maxSize, int timeoutMs = 0);
+    // 解码线程：等待至少 size 字节（或结束），复制但不取走；返回复制的字节数
+    int peek(char *data, int size, int timeoutMs);
+
+    // 任意线程：码流的字节率（字节/秒），用于把字节数换算为时长
+    void setByteRate(int bytesPerSecond);
+
+    int capacity() const { return m_buffer.size(); }
+    Stats stats() const;
+
+private:
+    // 持有 m_mutex
+    int levelMs() const;
+    int targetBytes() const;
+    void copyOut(char *data, int size) const;
+    void updateState();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_readable;      // 有新数据或结束
+    QWaitCondition m_writable;      // 腾出了空间或中止
+    QByteArray m_buffer;
+    int m_readPos;
+    int m_level;
+    State m_state;
+    bool m_ended;
+    bool m_aborted;
+    int m_byteRate;
+    int m_targetMs;
+    quint64 m_underruns;
+    quint64 m_bytesIn;
+    quint64 m_bytesOut;
+    QElapsedTimer m_stableTimer;    // 上一次欠载（或开始播放）以来的时间
+};
+
+#endif // JITTERBUFFER_H
@@ -0,0 +1,233 @@
+#include "loudnessmeter.h"
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// BS.1770 的块长 400ms，每 100ms 一个块
+static const int kHopsPerBlock = 4;
+
+// 块响度 = -0.691 + 10·log10(加权均方)
+static const double kLoudnessOffset = -0.691;
+static const double kAbsoluteGateLufs = -70.0;
+static const double kRelativeGateLu = -10.0;
+
+static const float kSampleScale = 1.0f / 32768.0f;
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(channels)
+    , m_usedChannels(qBound(1, channels, 2))
+    , m_hopFrames(qMax(1, (sampleRate + 5) / 10))
+    , m_hopPosition(0)
+    , m_hopEnergy(0)
+    , m_hopCount(0)
+    , m_peak(0)
+    , m_frames(0)
+{
+    // 按采样率计算 BS.1770 的两级滤波器（48kHz 时与标准给出的系数一致）
+    double fs = qMax(1, sampleRate);
+
+    // 高架：约 1.68kHz 以上 +4dB，模拟头部的声学效应
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / fs);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_pre.b0 = float((vh + vb * k / q + k * k) / a0);
+    m_pre.b1 = float(2.0 * (k * k - vh) / a0);
+    m_pre.b2 = float((vh - vb * k / q + k * k) / a0);
+    m_pre.a1 = float(2.0 * (k * k - 1.0) / a0);
+    m_pre.a2 = float((1.0 - k / q + k * k) / a0);
+
+    // RLB 高通：约 38Hz
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / fs);
+    a0 = 1.0 + k / q + k * k;
+    m_rlb.b0 = 1.0f;
+    m_rlb.b1 = -2.0f;
+    m_rlb.b2 = 1.0f;
+    m_rlb.a1 = float(2.0 * (k * k - 1.0) / a0);
+    m_rlb.a2 = float((1.0 - k / q + k * k) / a0);
+
+    memset(m_state, 0, sizeof(m_state));
+    memset(m_recentHops, 0, sizeof(m_recentHops));
+}
+
+void LoudnessMeter::process(const qint16 *samples, int frames)
+{
+    // 按 100ms 的边界分段，每段结束时累加到当前块
+    while (frames > 0) {
+        int n = qMin(frames, m_hopFrames - m_hopPosition);
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        if (m_channels == 2) {
+            processStereo(samples, n);
+        } else {
+            processScalar(samples, n);
+        }
+#else
+        processScalar(samples, n);
+#endif
+        samples += n * m_channels;
+        frames -= n;
+        m_frames += n;
+        m_hopPosition += n;
+        if (m_hopPosition == m_hopFrames) {
+            finishHop();
+        }
+    }
+}
+
+void LoudnessMeter::processScalar(const qint16 *samples, int frames)
+{
+    const Biquad pre = m_pre;
+    const Biquad rlb = m_rlb;
+    int peak = 0;
+
+    for (int c = 0; c < m_usedChannels; ++c) {
+        float s1 = m_state[0][c];
+        float s2 = m_state[1][c];
+        float s3 = m_state[2][c];
+        float s4 = m_state[3][c];
+        float sum = 0.0f;
+        const qint16 *p = samples + c;
+        for (int i = 0; i < frames; ++i, p += m_channels) {
+            int v = *p;
+            peak = qMax(peak, qAbs(v));
+            float x = float(v) * kSampleScale;
+            float y = pre.b0 * x + s1;
+            s1 = pre.b1 * x - pre.a1 * y + s2;
+            s2 = pre.b2 * x - pre.a2 * y;
+            float z = rlb.b0 * y + s3;
+            s3 = rlb.b1 * y - rlb.a1 * z + s4;
+            s4 = rlb.b2 * y - rlb.a2 * z;
+            sum += z * z;
+        }
+        m_state[0][c] = s1;
+        m_state[1][c] = s2;
+        m_state[2][c] = s3;
+        m_state[3][c] = s4;
+        m_hopEnergy += sum;
+    }
+    m_peak = qMax(m_peak, float(peak) * kSampleScale);
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void LoudnessMeter::processStereo(const qint16 *samples, int frames)
+{
+    // 左右声道各占一个通道：滤波器是递归的，时间方向不能并行，声道方向可以
+    const float32x2_t pb0 = vdup_n_f32(m_pre.b0), pb1 = vdup_n_f32(m_pre.b1), pb2 = vdup_n_f32(m_pre.b2);
+    const float32x2_t pa1 = vdup_n_f32(m_pre.a1), pa2 = vdup_n_f32(m_pre.a2);
+    const float32x2_t rb0 = vdup_n_f32(m_rlb.b0), rb1 = vdup_n_f32(m_rlb.b1), rb2 = vdup_n_f32(m_rlb.b2);
+    const float32x2_t ra1 = vdup_n_f32(m_rlb.a1), ra2 = vdup_n_f32(m_rlb.a2);
+    float32x2_t s1 = vld1_f32(m_state[0]);
+    float32x2_t s2 = vld1_f32(m_state[1]);
+    float32x2_t s3 = vld1_f32(m_state[2]);
+    float32x2_t s4 = vld1_f32(m_state[3]);
+    float32x2_t sum = vdup_n_f32(0.0f);
+    int16x4_t peak = vdup_n_s16(0);
+
+    auto step = [&](float32x2_t x) {
+        float32x2_t y = vmla_f32(s1, pb0, x);
+        s1 = vmls_f32(vmla_f32(s2, pb1, x), pa1, y);
+        s2 = vmls_f32(vmul_f32(pb2, x), pa2, y);
+        float32x2_t z = vmla_f32(s3, rb0, y);
+        s3 = vmls_f32(vmla_f32(s4, rb1, y), ra1, z);
+        s4 = vmls_f32(vmul_f32(rb2, y), ra2, z);
+        sum = vmla_f32(sum, z, z);
+    };
+
+    // 每次载入两帧（4 个样本）一起转换为浮点，再逐帧滤波
+    int i = 0;
+    for (; i + 2 <= frames; i += 2) {
+        int16x4_t in = vld1_s16(samples + i * 2);
+        peak = vmax_s16(peak, vqabs_s16(in));
+        float32x4_t x = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(in)), kSampleScale);
+        step(vget_low_f32(x));
+        step(vget_high_f32(x));
+    }
+    if (i < frames) {
+        int16x4_t in = vdup_n_s16(0);
+        in = vset_lane_s16(samples[i * 2], in, 0);
+        in = vset_lane_s16(samples[i * 2 + 1], in, 1);
+        peak = vmax_s16(peak, vqabs_s16(in));
+        step(vget_low_f32(vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(in)), kSampleScale)));
+    }
+
+    vst1_f32(m_state[0], s1);
+    vst1_f32(m_state[1], s2);
+    vst1_f32(m_state[2], s3);
+    vst1_f32(m_state[3], s4);
+    m_hopEnergy += vget_lane_f32(sum, 0) + vget_lane_f32(sum, 1);
+
+    int16x4_t pmax = vpmax_s16(peak, peak);
+    pmax = vpmax_s16(pmax, pmax);
+    m_peak = qMax(m_peak, float(vget_lane_s16(pmax, 0)) * kSampleScale);
+}
+#endif
+
+void LoudnessMeter::finishHop()
+{
+    m_recentHops[m_hopCount % kHopsPerBlock] = m_hopEnergy;
+    ++m_hopCount;
+    m_hopEnergy = 0;
+    m_hopPosition = 0;
+
+    if (m_hopCount >= kHopsPerBlock) {
+        double energy = 0;
+        for (int i = 0; i < kHopsPerBlock; ++i) {
+            energy += m_recentHops[i];
+        }
+        m_blocks.append(float(energy / (double(kHopsPerBlock) * m_hopFrames)));
+    }
+}
+
+static double energyToLufs(double energy)
+{
+    return kLoudnessOffset + 10.0 * std::log10(energy);
+}
+
+static double lufsToEnergy(double lufs)
+{
+    return std::pow(10.0, (lufs - kLoudnessOffset) / 10.0);
+}
+
+bool LoudnessMeter::hasLoudness() const
+{
+    const float gate = float(lufsToEnergy(kAbsoluteGateLufs));
+    for (float energy : m_blocks) {
+        if (energy > gate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double LoudnessMeter::integratedLufs() const
+{
+    // 先去掉静音（绝对门限），再去掉比平均响度低 10 LU 以上的安静段落
+    double gate = lufsToEnergy(kAbsoluteGateLufs);
+    for (int pass = 0; pass < 2; ++pass) {
+        double sum = 0;
+        int count = 0;
+        for (float energy : m_blocks) {
+            if (energy > gate) {
+                sum += energy;
+                ++count;
+            }
+        }
+        if (count == 0) {
+            return kAbsoluteGateLufs;
+        }
+        if (pass == 1) {
+            return energyToLufs(sum / count);
+        }
+        gate = qMax(gate, sum / count * std::pow(10.0, kRelativeGateLu / 10.0));
+    }
+    return kAbsoluteGateLufs;
+}
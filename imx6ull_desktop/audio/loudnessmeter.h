@@ -0,0 +1,65 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+
+/**
+ * @brief EBU R128 / ITU-R BS.1770 积分响度（S16 交错）
+ *
+ * 每个声道先经过 K 计权（高架预滤波 + RLB 高通，两级双二阶），按 100ms 累加均方，
+ * 每 400ms（75% 重叠）得到一个块；积分响度对块做 -70 LUFS 绝对门限与
+ * 相对 -10 LU 门限后取平均。同时记录样本峰值，用于限制增益不致削波。
+ *
+ * 滤波器为单精度，双声道时左右声道放在 NEON 向量的两个通道里同时计算；
+ * 只支持单声道与立体声的权重（各声道权重均为 1），多于两个声道时只计前两个。
+ *
+ * 只在一个线程中使用，不是线程安全的。
+ */
+class LoudnessMeter
+{
+public:
+    LoudnessMeter(int sampleRate, int channels);
+
+    // 处理 frames 帧交错样本，可多次调用
+    void process(const qint16 *samples, int frames);
+
+    // 至少有一个块高于绝对门限
+    bool hasLoudness() const;
+
+    // 积分响度（LUFS），hasLoudness() 为 false 时返回 -70
+    double integratedLufs() const;
+
+    // 样本峰值，满幅为 1.0
+    float peak() const { return m_peak; }
+
+    // 已处理的帧数
+    qint64 frames() const { return m_frames; }
+
+private:
+    struct Biquad {
+        float b0, b1, b2, a1, a2;
+    };
+
+    void processScalar(const qint16 *samples, int frames);
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    void processStereo(const qint16 *samples, int frames);
+#endif
+    void finishHop();
+
+    int m_sampleRate;
+    int m_channels;
+    int m_usedChannels;             // 参与计算的声道数，最多 2
+    Biquad m_pre;                   // 高架预滤波
+    Biquad m_rlb;                   // RLB 高通
+    float m_state[4][2];            // 两级滤波器的 DF2T 状态，[状态][声道]
+    int m_hopFrames;                // 100ms
+    int m_hopPosition;
+    double m_hopEnergy;             // 当前 100ms 内各声道平方和
+    double m_recentHops[4];         // 最近 4 个 100ms 的能量，组成一个 400ms 块
+    int m_hopCount;
+    QVector<float> m_blocks;        // 每个块的均方（已按声道权重相加）
+    float m_peak;
+    qint64 m_frames;
+};
+
+#endif // LOUDNESSMETER_H
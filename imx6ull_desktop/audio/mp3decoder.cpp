@@ -0,0 +1,280 @@
+#include "mp3decoder.h"
+#include <QDebug>
+#include <cstring>
+#include <sys/mman.h>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// 定位时在目标帧之前多解码的帧数（主数据最多回溯 511 字节，3 帧足够覆盖）
+static const int kPrerollFrames = 3;
+
+// 解码器固有延迟，LAME 标签中的延迟不含这部分
+static const int kDecoderDelay = 529;
+
+// 最后不足一帧的数据最多这么长（最大帧长 1441 字节的两倍以内）
+static const int kTailBytes = 4096;
+
+// mad_fixed_t 转 S16：加 0.5 LSB 舍入，饱和到 ±1.0 后右移
+static inline qint16 toS16(mad_fixed_t sample)
+{
+    sample += 1L << (MAD_F_FRACBITS - 16);
+    if (sample >= MAD_F_ONE) {
+        sample = MAD_F_ONE - 1;
+    } else if (sample < -MAD_F_ONE) {
+        sample = -MAD_F_ONE;
+    }
+    return qint16(sample >> (MAD_F_FRACBITS + 1 - 16));
+}
+
+Mp3Decoder::Mp3Decoder()
+    : m_data(nullptr)
+    , m_inTail(false)
+    , m_skip(0)
+    , m_total(-1)
+    , m_frameIndex(0)
+    , m_position(0)
+    , m_synthPos(0)
+    , m_discard(0)
+{
+    mad_stream_init(&m_stream);
+    mad_frame_init(&m_frame);
+    mad_synth_init(&m_synth);
+    m_tail.resize(kTailBytes + MAD_BUFFER_GUARD);
+}
+
+Mp3Decoder::~Mp3Decoder()
+{
+    mad_synth_finish(&m_synth);
+    mad_frame_finish(&m_frame);
+    mad_stream_finish(&m_stream);
+    unmap();
+    m_file.close();
+}
+
+void Mp3Decoder::unmap()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+}
+
+bool Mp3Decoder::open(const QString &path)
+{
+    unmap();
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开文件: %1").arg(m_file.errorString());
+        return false;
+    }
+
+    // 优先用缓存的精确表；还没扫描过的文件只读首帧建立近似表，不在打开时读完整个文件
+    if (!m_table.load(path) && !m_table.probe(path)) {
+        m_errorString = "不是有效的 MP3 文件";
+        return false;
+    }
+    m_format.sampleRate = m_table.sampleRate();
+    m_format.channels = m_table.channels();
+
+    qint64 size = m_file.size();
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        m_errorString = "无法映射 MP3 文件";
+        return false;
+    }
+    madvise(const_cast<uchar *>(m_data), size_t(size), MADV_SEQUENTIAL);
+
+    bool gapless = m_table.encoderDelay() > 0 || m_table.encoderPadding() > 0;
+    m_skip = gapless ? m_table.encoderDelay() + kDecoderDelay : 0;
+    m_total = gapless ? m_table.totalSamples() : -1;
+    return seek(0);
+}
+
+qint64 Mp3Decoder::totalFrames() const
+{
+    qint64 total = m_table.totalSamples();
+    return total > 0 ? total : -1;
+}
+
+void Mp3Decoder::startStream(qint64 offset)
+{
+    mad_stream_buffer(&m_stream, m_data + offset, static_cast<unsigned long>(m_table.audioEnd() - offset));
+    m_stream.md_len = 0;            // 丢弃上一位置残留的主数据
+    mad_frame_mute(&m_frame);
+    mad_synth_mute(&m_synth);
+    m_synth.pcm.length = 0;
+    m_inTail = false;
+    m_synthPos = 0;
+}
+
+int Mp3Decoder::decodeFrame()
+{
+    for (;;) {
+        if (mad_frame_decode(&m_frame, &m_stream) == 0) {
+            break;
+        }
+        if (m_stream.error == MAD_ERROR_BUFLEN) {
+            if (m_inTail || !m_stream.next_frame) {
+                return 0;
+            }
+            // 剩余数据复制到尾缓冲区并补零，再解码最后一帧
+            size_t remaining = qMin<size_t>(m_stream.bufend - m_stream.next_frame, kTailBytes);
+            memcpy(m_tail.data(), m_stream.next_frame, remaining);
+            memset(m_tail.data() + remaining, 0, MAD_BUFFER_GUARD);
+            mad_stream_buffer(&m_stream, m_tail.constData(), remaining + MAD_BUFFER_GUARD);
+            m_inTail = true;
+            continue;
+        }
+        if (!MAD_RECOVERABLE(m_stream.error)) {
+            m_errorString = QString("MP3 解码失败: %1").arg(mad_stream_errorstr(&m_stream));
+            return -1;
+        }
+        if (m_stream.error >= MAD_ERROR_BADCRC) {
+            // 帧头有效但帧数据不可用（定位后缺少主数据或 CRC 错误）：输出一帧静音，时长不变
+            mad_frame_mute(&m_frame);
+            break;
+        }
+    }
+    mad_synth_frame(&m_synth, &m_frame);
+    ++m_frameIndex;
+    m_synthPos = 0;
+    return 1;
+}
+
+void Mp3Decoder::convert(const mad_synth &synth, int offset, int channels, qint16 *out, int frames)
+{
+    const mad_fixed_t *left = synth.pcm.samples[0] + offset;
+    // 单声道帧出现在立体声流中时复制到两个声道；反之只取左声道
+    const mad_fixed_t *right = synth.pcm.channels > 1 ? synth.pcm.samples[1] + offset : left;
+
+    if (channels == 1) {
+        for (int i = 0; i < frames; ++i) {
+            out[i] = toS16(left[i]);
+        }
+        return;
+    }
+
+    int i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    // 舍入右移并饱和到 16 位（vqrshrn），vst2 交错写出
+    const int shift = MAD_F_FRACBITS + 1 - 16;
+    for (; i + 8 <= frames; i += 8) {
+        const int32_t *l = reinterpret_cast<const int32_t *>(left + i);
+        const int32_t *r = reinterpret_cast<const int32_t *>(right + i);
+        int16x8x2_t pcm;
+        pcm.val[0] = vcombine_s16(vqrshrn_n_s32(vld1q_s32(l), shift), vqrshrn_n_s32(vld1q_s32(l + 4), shift));
+        pcm.val[1] = vcombine_s16(vqrshrn_n_s32(vld1q_s32(r), shift), vqrshrn_n_s32(vld1q_s32(r + 4), shift));
+        vst2q_s16(out + i * 2, pcm);
+    }
+#endif
+    for (; i < frames; ++i) {
+        out[i * 2] = toS16(left[i]);
+        out[i * 2 + 1] = toS16(right[i]);
+    }
+}
+
+int Mp3Decoder::read(qint16 *buffer, int maxFrames)
+{
+    int channels = m_format.channels;
+    int done = 0;
+    while (done < maxFrames) {
+        if (m_total >= 0 && m_position >= m_total) {
+            break;
+        }
+        int available = m_synth.pcm.length - m_synthPos;
+        if (available <= 0) {
+            int result = decodeFrame();
+            if (result == 0) {
+                break;
+            }
+            if (result < 0) {
+                return done > 0 ? done : -1;
+            }
+            continue;
+        }
+        if (m_discard > 0) {
+            int drop = qMin(available, m_discard);
+            m_synthPos += drop;
+            m_discard -= drop;
+            continue;
+        }
+
+        int frames = qMin(available, maxFrames - done);
+        if (m_total >= 0) {
+            frames = int(qMin<qint64>(frames, m_total - m_position));
+        }
+        convert(m_synth, m_synthPos, channels, buffer + done * channels, frames);
+        m_synthPos += frames;
+        m_position += frames;
+        done += frames;
+    }
+    return done;
+}
+
+bool Mp3Decoder::seek(qint64 frame)
+{
+    if (m_total >= 0) {
+        frame = qBound<qint64>(0, frame, m_total);
+    }
+    frame = qMax<qint64>(0, frame);
+
+    int samplesPerFrame = m_table.samplesPerFrame();
+    qint64 sample = frame + m_skip;
+    qint64 target = sample / samplesPerFrame;
+    qint64 start = qMax<qint64>(0, target - kPrerollFrames);
+
+    // 近似表只能落到目标附近的某一帧，报告的位置与无缝裁剪都会偏；第一次定位到开头以外时
+    // 扫描全部帧头建立精确表（写入缓存，之后打开直接使用）。失败时仍按近似表定位
+    if (start > 0 && !m_table.isExact()) {
+        Mp3SeekTable exact;
+        if (exact.build(m_file.fileName())) {
+            m_table = exact;
+            if (m_total >= 0) {
+                m_total = m_table.totalSamples();
+            }
+            qDebug() << "Mp3Decoder: built seek table for" << m_file.fileName() << m_table.frameCount() << "frames";
+        }
+    }
+
+    const qint64 end = m_table.audioEnd();
+    Mp3SeekTable::SeekPoint point = m_table.locate(start);
+    qint64 offset = point.offset;
+    if (m_table.isExact()) {
+        // 从表项向后按帧长跳过不超过 kFramesPerEntry - 1 个帧头
+        qint64 index = point.frame;
+        while (index < start && offset + 4 <= end) {
+            Mp3SeekTable::FrameHeader header;
+            if (!Mp3SeekTable::parseHeader(m_data + offset, header) || header.sampleRate != m_format.sampleRate) {
+                offset = Mp3SeekTable::findFrame(m_data, offset + 1, end, m_format.sampleRate);
+                if (offset < 0) {
+                    offset = end;
+                }
+                continue;
+            }
+            offset += header.length;
+            ++index;
+        }
+        start = index;
+    } else {
+        // 近似表给出的偏移多半落在帧中间，向后重新同步
+        offset = Mp3SeekTable::findFrame(m_data, qMax(offset, m_table.audioStart()), end, m_format.sampleRate);
+        if (offset < 0) {
+            offset = end;
+        }
+    }
+
+    startStream(qMin(offset, end));
+    m_frameIndex = start;
+    while (m_frameIndex < target) {
+        if (decodeFrame() <= 0) {
+            break;
+        }
+    }
+    // 预解码的输出全部丢弃，目标帧中再丢掉目标之前的样本
+    m_synthPos = m_synth.pcm.length;
+    m_discard = int(qBound<qint64>(0, sample - m_frameIndex * samplesPerFrame, samplesPerFrame));
+    m_position = frame;
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef MP3DECODER_H
+#define MP3DECODER_H
+
+#include "audiodecoder.h"
+#include "mp3seektable.h"
+#include <QFile>
+#include <QVector>
+#include <mad.h>
+
+/**
+ * @brief MP3 解码器（libmad，定点运算）
+ *
+ * i.MX6ULL 的 Cortex-A7 浮点单元较弱，libmad 全程使用 28 位小数的定点数，解码一帧的
+ * 耗时远低于浮点实现。整个文件只读映射后直接交给 libmad，合成后的定点样本舍入、饱和为
+ * S16 写入调用者的缓冲区（ARM 上用 NEON 一次转换 8 个样本），不经过中间缓冲区。
+ *
+ * 定位依赖 Mp3SeekTable：有缓存的精确表时从表项按帧头跳到目标帧。打开时只有近似表的文件
+ * 在第一次定位到开头以外时扫描全部帧头建立精确表，之后的定位都落在准确的帧上；建表失败时
+ * 才按 Xing/VBRI 目录插值后重新同步。Layer III 的主数据可能在前几帧中（bit reservoir），合成滤波器也有
+ * 重叠状态，所以从目标前 kPrerollFrames 帧开始解码并丢弃这些输出。
+ *
+ * 有 LAME 标签时去掉编码器延迟、解码器固有的 529 样本延迟与末尾填充，曲目之间无缝衔接。
+ */
+class Mp3Decoder : public AudioDecoder
+{
+public:
+    Mp3Decoder();
+    ~Mp3Decoder() override;
+
+    bool open(const QString &path) override;
+    AudioFormat format() const override { return m_format; }
+    qint64 totalFrames() const override;
+    int read(qint16 *buffer, int maxFrames) override;
+    bool seek(qint64 frame) override;
+
+    // 合成结果从第 offset 个样本起的 frames 帧转为交错 S16，声道数不同时复制或只取左声道
+    static void convert(const mad_synth &synth, int offset, int channels, qint16 *out, int frames);
+
+private:
+    int decodeFrame();
+    void startStream(qint64 offset);
+    void unmap();
+
+    QFile m_file;
+    const uchar *m_data;
+    Mp3SeekTable m_table;
+    AudioFormat m_format;
+
+    mad_stream m_stream;
+    mad_frame m_frame;
+    mad_synth m_synth;
+
+    // 最后一帧之后要补 MAD_BUFFER_GUARD 个 0 才能解码，把剩余数据复制到这里
+    QVector<uchar> m_tail;
+    bool m_inTail;
+
+    qint64 m_skip;                  // 开头丢弃的样本：编码器延迟 + 529，没有 LAME 标签时为 0
+    qint64 m_total;                 // 有 LAME 标签时的样本帧数，否则 -1（解码到文件末尾）
+    qint64 m_frameIndex;            // 下一个要解码的 MPEG 帧
+    qint64 m_position;              // 已输出的样本帧
+    int m_synthPos;                 // 当前帧中已取走的样本
+    int m_discard;                  // 定位后当前帧中还要丢弃的样本
+};
+
+#endif // MP3DECODER_H
@@ -0,0 +1,413 @@
+#include "mp3seektable.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <cstring>
+#include <cmath>
+#include <sys/mman.h>
+
+// 缓存文件格式
+static const quint32 kCacheMagic = 0x4D50534B;     // "MPSK"
+static const quint32 kCacheVersion = 1;
+
+// 近似表只读文件开头这么多字节找首帧与 Xing/VBRI 头
+static const int kProbeBytes = 64 * 1024;
+
+// 偏移以 32 位保存
+static const qint64 kMaxFileSize = 0xFFFFFFFFLL;
+
+static quint32 be32(const uchar *p)
+{
+    return qFromBigEndian<quint32>(p);
+}
+
+static quint16 be16(const uchar *p)
+{
+    return qFromBigEndian<quint16>(p);
+}
+
+// ID3v2 标签长度（含头与页脚），没有时返回 0
+static qint64 id3v2Size(const uchar *data, qint64 size)
+{
+    if (size < 10 || memcmp(data, "ID3", 3) != 0) {
+        return 0;
+    }
+    qint64 length = (qint64(data[6] & 0x7F) << 21) | ((data[7] & 0x7F) << 14)
+                    | ((data[8] & 0x7F) << 7) | (data[9] & 0x7F);
+    return 10 + length + ((data[5] & 0x10) ? 10 : 0);
+}
+
+Mp3SeekTable::Mp3SeekTable()
+{
+    clear();
+}
+
+void Mp3SeekTable::clear()
+{
+    m_sampleRate = 0;
+    m_channels = 0;
+    m_samplesPerFrame = 0;
+    m_frameCount = 0;
+    m_encoderDelay = 0;
+    m_encoderPadding = 0;
+    m_audioStart = 0;
+    m_audioEnd = 0;
+    m_exact = false;
+    m_framesPerEntry = kFramesPerEntry;
+    m_offsets.clear();
+}
+
+bool Mp3SeekTable::handles(const QString &path)
+{
+    return QFileInfo(path).suffix().compare("mp3", Qt::CaseInsensitive) == 0;
+}
+
+bool Mp3SeekTable::parseHeader(const uchar *p, FrameHeader &header)
+{
+    static const short kBitrates[2][15] = {
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },     // MPEG-1
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },          // MPEG-2/2.5
+    };
+    static const int kSampleRates[3] = { 44100, 48000, 32000 };
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+    int versionBits = (p[1] >> 3) & 0x03;
+    int layerBits = (p[1] >> 1) & 0x03;
+    int bitrateIndex = p[2] >> 4;
+    int rateIndex = (p[2] >> 2) & 0x03;
+    if (versionBits == 1 || layerBits != 1 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+        return false;   // 保留值、非 Layer III 或自由码率
+    }
+
+    // versionBits：3 为 MPEG-1，2 为 MPEG-2，0 为 MPEG-2.5
+    bool mpeg1 = versionBits == 3;
+    int shift = mpeg1 ? 0 : (versionBits == 2 ? 1 : 2);
+    bool mono = (p[3] >> 6) == 3;
+    int padding = (p[2] >> 1) & 0x01;
+
+    header.sampleRate = kSampleRates[rateIndex] >> shift;
+    header.channels = mono ? 1 : 2;
+    header.samplesPerFrame = mpeg1 ? 1152 : 576;
+    header.bitrate = kBitrates[mpeg1 ? 0 : 1][bitrateIndex] * 1000;
+    header.length = header.samplesPerFrame / 8 * header.bitrate / header.sampleRate + padding;
+    header.sideInfoBytes = mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17);
+    return header.length > 4;
+}
+
+qint64 Mp3SeekTable::findFrame(const uchar *data, qint64 from, qint64 end, int sampleRate)
+{
+    // 下一帧头也要合法且采样率相同，避免把数据中的 0xFF 误认为同步字
+    for (qint64 i = from; i + 4 <= end; ++i) {
+        if (data[i] != 0xFF) {
+            continue;
+        }
+        FrameHeader h;
+        if (!parseHeader(data + i, h) || (sampleRate > 0 && h.sampleRate != sampleRate)) {
+            continue;
+        }
+        qint64 next = i + h.length;
+        FrameHeader n;
+        if (next == end || (next + 4 <= end && parseHeader(data + next, n) && n.sampleRate == h.sampleRate)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool Mp3SeekTable::parseStart(const uchar *data, qint64 size, qint64 base)
+{
+    // data[0] 为文件偏移 base 处的字节（ID3v2 已跳过），以下偏移都相对于 data
+    qint64 first = findFrame(data, 0, size, 0);
+    FrameHeader h;
+    if (first < 0 || !parseHeader(data + first, h)) {
+        return false;
+    }
+    m_sampleRate = h.sampleRate;
+    m_channels = h.channels;
+    m_samplesPerFrame = h.samplesPerFrame;
+    m_audioStart = base + first;
+    m_offsets.clear();
+    qint64 frameEnd = qMin(size, first + h.length);
+
+    // Xing/Info：标志、帧数、字节数、100 项目录、质量，之后可能跟着 LAME 标签
+    qint64 xing = first + 4 + h.sideInfoBytes;
+    const uchar *vbri = data + first + 4 + 32;
+    if (xing + 8 <= frameEnd && (memcmp(data + xing, "Xing", 4) == 0 || memcmp(data + xing, "Info", 4) == 0)) {
+        quint32 flags = be32(data + xing + 4);
+        qint64 pos = xing + 8;
+        qint64 bytes = 0;
+        const uchar *toc = nullptr;
+        if ((flags & 0x01) && pos + 4 <= frameEnd) {
+            m_frameCount = be32(data + pos);
+            pos += 4;
+        }
+        if ((flags & 0x02) && pos + 4 <= frameEnd) {
+            bytes = be32(data + pos);
+            pos += 4;
+        }
+        if ((flags & 0x04) && pos + 100 <= frameEnd) {
+            toc = data + pos;
+            pos += 100;
+        }
+        if (flags & 0x08) {
+            pos += 4;
+        }
+        // LAME 标签：9 字节编码器名起第 21 字节开始为 12 位延迟与 12 位填充
+        if (pos + 24 <= frameEnd && (memcmp(data + pos, "LAME", 4) == 0
+                                     || memcmp(data + pos, "Lavf", 4) == 0 || memcmp(data + pos, "Lavc", 4) == 0)) {
+            const uchar *p = data + pos + 21;
+            m_encoderDelay = (p[0] << 4) | (p[1] >> 4);
+            m_encoderPadding = ((p[1] & 0x0F) << 8) | p[2];
+        }
+
+        // 信息帧本身不含音频
+        qint64 frameStart = m_audioStart;
+        m_audioStart += h.length;
+        if (bytes <= 0 || frameStart + bytes > m_audioEnd) {
+            bytes = m_audioEnd - frameStart;
+        }
+        if (toc && m_frameCount > 0) {
+            // 第 i 项为 i% 时长处的字节位置，以总字节数的 1/256 为单位
+            m_offsets.reserve(101);
+            m_offsets.append(quint32(m_audioStart));
+            for (int i = 1; i < 100; ++i) {
+                m_offsets.append(quint32(frameStart + toc[i] * bytes / 256));
+            }
+            m_framesPerEntry = m_frameCount / 100.0;
+        }
+    } else if (first + 4 + 32 + 26 <= frameEnd && memcmp(vbri, "VBRI", 4) == 0) {
+        // VBRI：版本、延迟、质量、字节数、帧数、目录项数、缩放、项宽、每项帧数，之后为各段字节数
+        m_frameCount = be32(vbri + 14);
+        int entries = be16(vbri + 18);
+        int scale = be16(vbri + 20);
+        int entryBytes = be16(vbri + 22);
+        int framesPerEntry = be16(vbri + 24);
+        m_audioStart += h.length;
+        if (entries > 0 && entryBytes >= 1 && entryBytes <= 4 && framesPerEntry > 0
+                && first + 4 + 32 + 26 + qint64(entries) * entryBytes <= frameEnd) {
+            const uchar *p = vbri + 26;
+            qint64 offset = m_audioStart;
+            m_offsets.reserve(entries + 1);
+            for (int i = 0; i < entries; ++i) {
+                m_offsets.append(quint32(qMin(offset, m_audioEnd)));
+                qint64 segment = 0;
+                for (int b = 0; b < entryBytes; ++b) {
+                    segment = (segment << 8) | *p++;
+                }
+                offset += segment * scale;
+            }
+            m_framesPerEntry = framesPerEntry;
+        }
+    } else {
+        // 没有信息帧：按首帧码率估算（CBR 时准确）
+        m_frameCount = qint64(double(m_audioEnd - m_audioStart) * 8 * h.sampleRate
+                              / (double(h.bitrate) * h.samplesPerFrame));
+    }
+
+    if (m_offsets.isEmpty()) {
+        // 没有目录：整段线性插值
+        m_offsets.append(quint32(m_audioStart));
+        m_framesPerEntry = qMax<qint64>(m_frameCount, 1);
+    }
+    m_offsets.append(quint32(m_audioEnd));
+    return m_frameCount > 0;
+}
+
+bool Mp3SeekTable::probe(const QString &path)
+{
+    clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() > kMaxFileSize) {
+        return false;
+    }
+    qint64 fileSize = file.size();
+
+    // 末尾的 ID3v1 不属于音频数据
+    m_audioEnd = fileSize;
+    if (fileSize >= 128 && file.seek(fileSize - 128) && file.read(3) == "TAG") {
+        m_audioEnd = fileSize - 128;
+    }
+
+    // ID3v2 可能很大（内嵌封面），按头部给出的长度跳过后再读首帧附近
+    file.seek(0);
+    QByteArray tagHeader = file.read(10);
+    qint64 base = id3v2Size(reinterpret_cast<const uchar *>(tagHeader.constData()), tagHeader.size());
+    if (!file.seek(base)) {
+        return false;
+    }
+    QByteArray head = file.read(kProbeBytes);
+    if (!parseStart(reinterpret_cast<const uchar *>(head.constData()), head.size(), base)) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool Mp3SeekTable::build(const QString &path)
+{
+    clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() <= 0 || file.size() > kMaxFileSize) {
+        return false;
+    }
+    qint64 fileSize = file.size();
+    uchar *data = file.map(0, fileSize);
+    if (!data) {
+        return false;
+    }
+    // 只顺序读一遍，内核加大预读
+    madvise(data, size_t(fileSize), MADV_SEQUENTIAL);
+
+    m_audioEnd = fileSize;
+    if (fileSize >= 128 && memcmp(data + fileSize - 128, "TAG", 3) == 0) {
+        m_audioEnd = fileSize - 128;
+    }
+
+    qint64 base = qMin(id3v2Size(data, fileSize), m_audioEnd);
+    bool ok = parseStart(data + base, m_audioEnd - base, base);
+    if (ok) {
+        // 从第一个音频帧开始按帧长跳跃，每 kFramesPerEntry 帧记一次偏移；
+        // 帧头损坏或帧间有垃圾数据时重新同步
+        qint64 estimated = m_frameCount;
+        m_offsets.clear();
+        m_offsets.reserve(int(estimated / kFramesPerEntry + 16));
+        qint64 frames = 0;
+        qint64 pos = m_audioStart;
+        while (pos + 4 <= m_audioEnd) {
+            FrameHeader h;
+            if (!parseHeader(data + pos, h) || h.sampleRate != m_sampleRate) {
+                pos = findFrame(data, pos + 1, m_audioEnd, m_sampleRate);
+                if (pos < 0) {
+                    break;
+                }
+                continue;
+            }
+            if (pos + h.length > m_audioEnd) {
+                break;      // 截断的最后一帧
+            }
+            if (frames % kFramesPerEntry == 0) {
+                m_offsets.append(quint32(pos));
+            }
+            ++frames;
+            pos += h.length;
+        }
+        m_frameCount = frames;
+        m_framesPerEntry = kFramesPerEntry;
+        m_exact = true;
+        ok = frames > 0;
+    }
+    file.unmap(data);
+
+    if (!ok) {
+        clear();
+        return false;
+    }
+    saveCache(path);
+    return true;
+}
+
+qint64 Mp3SeekTable::totalSamples() const
+{
+    return qMax<qint64>(0, m_frameCount * m_samplesPerFrame - m_encoderDelay - m_encoderPadding);
+}
+
+Mp3SeekTable::SeekPoint Mp3SeekTable::locate(qint64 frame) const
+{
+    SeekPoint point;
+    if (m_offsets.isEmpty()) {
+        return point;
+    }
+    frame = qBound<qint64>(0, frame, qMax<qint64>(0, m_frameCount - 1));
+
+    if (m_exact) {
+        int index = int(qMin<qint64>(frame / kFramesPerEntry, m_offsets.size() - 1));
+        point.offset = m_offsets[index];
+        point.frame = qint64(index) * kFramesPerEntry;
+        return point;
+    }
+
+    // 近似表：在相邻两个目录项之间按帧数线性插值
+    double position = frame / m_framesPerEntry;
+    int index = qMin(int(position), m_offsets.size() - 2);
+    double fraction = qMin(position - index, 1.0);
+    qint64 from = m_offsets[index];
+    qint64 to = m_offsets[index + 1];
+    point.offset = from + qint64(std::floor((to - from) * fraction));
+    point.frame = frame;
+    return point;
+}
+
+QString Mp3SeekTable::cacheFile(const QString &path)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/seek";
+    QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir + "/" + QString::fromLatin1(hash) + ".idx";
+}
+
+bool Mp3SeekTable::load(const QString &path)
+{
+    clear();
+    QFileInfo info(path);
+    QFile file(cacheFile(path));
+    if (!info.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version;
+    qint64 mtime, size;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion) {
+        return false;
+    }
+    in >> mtime >> size;
+    if (mtime != info.lastModified().toSecsSinceEpoch() || size != info.size()) {
+        return false;   // 文件已修改，需要重新扫描
+    }
+
+    qint32 sampleRate, channels, samplesPerFrame, delay, padding;
+    in >> sampleRate >> channels >> samplesPerFrame >> m_frameCount >> delay >> padding
+       >> m_audioStart >> m_audioEnd >> m_offsets;
+    if (in.status() != QDataStream::Ok || m_frameCount <= 0
+            || m_offsets.size() != int((m_frameCount + kFramesPerEntry - 1) / kFramesPerEntry)) {
+        clear();
+        return false;
+    }
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_samplesPerFrame = samplesPerFrame;
+    m_encoderDelay = delay;
+    m_encoderPadding = padding;
+    m_framesPerEntry = kFramesPerEntry;
+    m_exact = true;
+    return true;
+}
+
+bool Mp3SeekTable::saveCache(const QString &path) const
+{
+    QFileInfo info(path);
+    QString file = cacheFile(path);
+    QDir().mkpath(QFileInfo(file).path());
+
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << kCacheMagic << kCacheVersion
+           << qint64(info.lastModified().toSecsSinceEpoch()) << qint64(info.size())
+           << qint32(m_sampleRate) << qint32(m_channels) << qint32(m_samplesPerFrame)
+           << m_frameCount << qint32(m_encoderDelay) << qint32(m_encoderPadding)
+           << m_audioStart << m_audioEnd << m_offsets;
+    return stream.status() == QDataStream::Ok && out.commit();
+}
@@ -0,0 +1,111 @@
+#ifndef MP3SEEKTABLE_H
+#define MP3SEEKTABLE_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief MP3 定位表：MPEG 帧序号 → 帧头在文件中的偏移
+ *
+ * VBR 文件每帧长度不同，没有表时定位到某个时间只能从头逐帧累加帧长。这里每
+ * kFramesPerEntry 帧记录一次帧头偏移，定位时按下标直接取表项，再最多向后跳过
+ * kFramesPerEntry - 1 个帧头即到达目标帧，耗时与文件长度无关。
+ *
+ * 精确的表来自一次性扫描全部帧头（只读 4 字节帧头，按帧长跳跃），按路径的 SHA-1
+ * 保存在缓存目录下，文件修改时间或大小变化后失效。扫描要读完整个文件，不在打开时进行：
+ * LoudnessAnalyzer 分析曲目时顺便建立，或者由 Mp3Decoder 在第一次定位时建立。尚未扫描的
+ * 文件用首帧中的 Xing/VBRI 目录建立近似表，按目录插值得到字节偏移，解码器从该处重新同步
+ * 帧头；没有目录时按首帧码率估算。
+ *
+ * 同时记录 LAME 标签中的编码器延迟与填充（不含解码器固有的 529 样本延迟）。
+ *
+ * 只在一个线程中使用，不是线程安全的。
+ */
+class Mp3SeekTable
+{
+public:
+    // 精确表每个表项覆盖的帧数
+    static const int kFramesPerEntry = 8;
+
+    /**
+     * @brief MPEG-1/2/2.5 Layer III 帧头
+     */
+    struct FrameHeader {
+        int sampleRate = 0;
+        int channels = 0;
+        int samplesPerFrame = 0;
+        int bitrate = 0;            // bit/s
+        int length = 0;             // 整帧字节数（含帧头）
+        int sideInfoBytes = 0;      // 帧头之后的 side info 长度
+    };
+
+    /**
+     * @brief 定位点
+     */
+    struct SeekPoint {
+        qint64 offset = 0;          // 帧头在文件中的偏移
+        qint64 frame = 0;           // 该帧的序号；近似表中即请求的帧
+    };
+
+    Mp3SeekTable();
+
+    // 只按扩展名判断
+    static bool handles(const QString &path);
+
+    // 解析 4 字节帧头，不是合法的 Layer III 帧头时返回 false
+    static bool parseHeader(const uchar *p, FrameHeader &header);
+
+    // 在 [from, end) 中查找帧头，要求其后紧跟同采样率的帧头；sampleRate 为 0 时不限，找不到返回 -1
+    static qint64 findFrame(const uchar *data, qint64 from, qint64 end, int sampleRate);
+
+    // 读取缓存中的精确表，没有缓存或文件已变化时返回 false
+    bool load(const QString &path);
+
+    // 扫描全部帧头建立精确表并写入缓存；会读完整个文件
+    bool build(const QString &path);
+
+    // 只读文件首尾，按 Xing/VBRI 目录或首帧码率建立近似表
+    bool probe(const QString &path);
+
+    bool isValid() const { return m_frameCount > 0; }
+    bool isExact() const { return m_exact; }
+
+    int sampleRate() const { return m_sampleRate; }
+    int channels() const { return m_channels; }
+    int samplesPerFrame() const { return m_samplesPerFrame; }
+
+    // 音频帧数，不含 Xing/VBRI 所在的信息帧
+    qint64 frameCount() const { return m_frameCount; }
+    int encoderDelay() const { return m_encoderDelay; }
+    int encoderPadding() const { return m_encoderPadding; }
+
+    // 第一个音频帧的偏移与音频数据的结束位置（ID3v1 之前）
+    qint64 audioStart() const { return m_audioStart; }
+    qint64 audioEnd() const { return m_audioEnd; }
+
+    // 去掉编码器延迟与填充后的样本帧数
+    qint64 totalSamples() const;
+
+    // 不晚于 frame 的定位点；精确表中 frame - point.frame < kFramesPerEntry
+    SeekPoint locate(qint64 frame) const;
+
+private:
+    void clear();
+    bool parseStart(const uchar *data, qint64 size, qint64 base);
+    bool saveCache(const QString &path) const;
+    static QString cacheFile(const QString &path);
+
+    int m_sampleRate;
+    int m_channels;
+    int m_samplesPerFrame;
+    qint64 m_frameCount;
+    int m_encoderDelay;
+    int m_encoderPadding;
+    qint64 m_audioStart;
+    qint64 m_audioEnd;
+    bool m_exact;
+    double m_framesPerEntry;        // 近似表为目录一格对应的帧数
+    QVector<quint32> m_offsets;     // 近似表最后多一项 m_audioEnd，便于插值
+};
+
+#endif // MP3SEEKTABLE_H
@@ -0,0 +1,68 @@
+#include "pcmringbuffer.h"
+#include <cstring>
+
+PcmRingBuffer::PcmRingBuffer(int capacity)
+    : m_mask(0)
+    , m_readPos(0)
+    , m_writePos(0)
+{
+    quint32 size = 1;
+    while (size < quint32(qMax(capacity, 2))) {
+        size <<= 1;
+    }
+    m_buffer.resize(int(size));
+    m_mask = size - 1;
+}
+
+int PcmRingBuffer::available() const
+{
+    // 位置是自由递增的计数器，差值在回绕后依然正确
+    return int(m_writePos.loadAcquire() - m_readPos.loadAcquire());
+}
+
+int PcmRingBuffer::write(const qint16 *data, int count)
+{
+    quint32 write = m_writePos.load();
+    quint32 read = m_readPos.loadAcquire();
+    int space = capacity() - int(write - read);
+    count = qMin(count, space);
+    if (count <= 0) {
+        return 0;
+    }
+
+    quint32 index = write & m_mask;
+    int first = qMin(count, int(m_mask + 1 - index));
+    memcpy(m_buffer.data() + index, data, size_t(first) * sizeof(qint16));
+    if (count > first) {
+        memcpy(m_buffer.data(), data + first, size_t(count - first) * sizeof(qint16));
+    }
+
+    // 数据写完后再发布新的写位置
+    m_writePos.storeRelease(write + quint32(count));
+    return count;
+}
+
+int PcmRingBuffer::read(qint16 *data, int count)
+{
+    quint32 read = m_readPos.load();
+    quint32 write = m_writePos.loadAcquire();
+    count = qMin(count, int(write - read));
+    if (count <= 0) {
+        return 0;
+    }
+
+    quint32 index = read & m_mask;
+    int first = qMin(count, int(m_mask + 1 - index));
+    memcpy(data, m_buffer.constData() + index, size_t(first) * sizeof(qint16));
+    if (count > first) {
+        memcpy(data + first, m_buffer.constData(), size_t(count - first) * sizeof(qint16));
+    }
+
+    m_readPos.storeRelease(read + quint32(count));
+    return count;
+}
+
+void PcmRingBuffer::discard()
+{
+    m_readPos.storeRelease(m_writePos.loadAcquire());
+}
@@ -0,0 +1,40 @@
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include <QVector>
+#include <QAtomicInteger>
+
+/**
+ * @brief 单生产者/单消费者 PCM 环形缓冲区（无锁）
+ *
+ * 解码线程写入、输出线程读取，读写位置各自只由一方修改。
+ * 容量向上取整为 2 的幂，单位为样本（qint16）。
+ */
+class PcmRingBuffer
+{
+public:
+    explicit PcmRingBuffer(int capacity);
+
+    int capacity() const { return int(m_mask + 1); }
+
+    // 可读样本数（任意线程可调用，结果是近似值）
+    int available() const;
+    int freeSpace() const { return capacity() - available(); }
+
+    // 生产者调用，返回实际写入的样本数
+    int write(const qint16 *data, int count);
+
+    // 消费者调用，返回实际读出的样本数
+    int read(qint16 *data, int count);
+
+    // 消费者调用：丢弃全部未读数据（调用期间生产者必须停止写入）
+    void discard();
+
+private:
+    QVector<qint16> m_buffer;
+    quint32 m_mask;
+    QAtomicInteger<quint32> m_readPos;
+    QAtomicInteger<quint32> m_writePos;
+};
+
+#endif // PCMRINGBUFFER_H
@@ -0,0 +1,58 @@
+#include "pcmtap.h"
+#include <cstring>
+
+PcmTap::PcmTap(int capacityFrames)
+    : m_mask(0)
+    , m_writePos(0)
+    , m_enabled(0)
+{
+    quint32 size = 1;
+    while (size < quint32(qMax(capacityFrames, 2))) {
+        size <<= 1;
+    }
+    m_buffer.resize(int(size) * 2);
+    m_mask = size - 1;
+}
+
+void PcmTap::write(const qint16 *samples, int frames, int channels)
+{
+    if (!isEnabled() || frames <= 0 || channels <= 0) {
+        return;
+    }
+
+    quint32 write = m_writePos.load();
+    qint16 *buffer = m_buffer.data();
+    for (int i = 0; i < frames; ++i) {
+        quint32 index = ((write + quint32(i)) & m_mask) * 2;
+        const qint16 *frame = samples + i * channels;
+        buffer[index] = frame[0];
+        buffer[index + 1] = channels > 1 ? frame[1] : frame[0];
+    }
+
+    // 数据写完后再发布新的写位置
+    m_writePos.storeRelease(write + quint32(frames));
+}
+
+bool PcmTap::read(qint16 *stereo, int frames, int lagFrames) const
+{
+    if (frames <= 0 || lagFrames < 0 || frames + lagFrames > capacity()) {
+        return false;
+    }
+
+    quint32 write = m_writePos.loadAcquire();
+    if (write < quint32(frames + lagFrames)) {
+        return false;   // 启用后写入的数据还不够
+    }
+    quint32 start = write - quint32(lagFrames) - quint32(frames);
+
+    quint32 index = start & m_mask;
+    int first = qMin(frames, int(m_mask + 1 - index));
+    memcpy(stereo, m_buffer.constData() + index * 2, size_t(first) * 2 * sizeof(qint16));
+    if (frames > first) {
+        memcpy(stereo + first * 2, m_buffer.constData(), size_t(frames - first) * 2 * sizeof(qint16));
+    }
+
+    // 复制期间写入方绕过了起点：数据已被覆盖
+    quint32 after = m_writePos.loadAcquire();
+    return after - start <= quint32(capacity());
+}
@@ -0,0 +1,40 @@
+#ifndef PCMTAP_H
+#define PCMTAP_H
+
+#include <QVector>
+#include <QAtomicInteger>
+
+/**
+ * @brief 输出 PCM 的无锁旁路（供可视化等只读消费者使用）
+ *
+ * 输出线程把送往设备的数据（增益之前）按立体声复制一份，写入时从不等待读取方，
+ * 旧数据直接被覆盖。读取方复制后再检查写位置，复制期间被覆盖的结果会被丢弃。
+ * 未启用时 write() 立即返回，播放时没有额外开销。
+ *
+ * 只允许一个线程调用 write()，读取方可以有多个。
+ */
+class PcmTap
+{
+public:
+    explicit PcmTap(int capacityFrames);
+
+    int capacity() const { return int(m_mask + 1); }
+
+    void setEnabled(bool enabled) { m_enabled.storeRelease(enabled ? 1 : 0); }
+    bool isEnabled() const { return m_enabled.loadAcquire() != 0; }
+
+    // 输出线程调用：单声道复制到两个声道，多于两个声道时只取前两个
+    void write(const qint16 *samples, int frames, int channels);
+
+    // 复制最新写入位置往前 lagFrames 帧为止的 frames 帧（交错立体声）
+    // 数据不足或复制期间被覆盖时返回 false
+    bool read(qint16 *stereo, int frames, int lagFrames) const;
+
+private:
+    QVector<qint16> m_buffer;       // 交错立体声
+    quint32 m_mask;                 // 以帧为单位
+    QAtomicInteger<quint32> m_writePos;
+    QAtomicInteger<int> m_enabled;
+};
+
+#endif // PCMTAP_H
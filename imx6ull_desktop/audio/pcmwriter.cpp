@@ -0,0 +1,312 @@
+#include "pcmwriter.h"
+#include "playbackclock.h"
+#include <QDebug>
+#include <alsa/asoundlib.h>
+
+// 等待设备腾出空间的超时（毫秒），超时说明设备已停止工作
+static const int kWaitTimeoutMs = 1000;
+
+// supportedRates() 逐个测试的标准采样率
+static const unsigned int kStandardRates[] = { 8000, 11025, 16000, 22050, 32000, 44100, 48000, 88200, 96000 };
+
+PcmWriter::PcmWriter()
+    : m_pcm(nullptr)
+    , m_access(CopyAccess)
+    , m_channels(0)
+    , m_rate(0)
+    , m_periodFrames(0)
+    , m_bufferFrames(0)
+    , m_startThreshold(0)
+    , m_canPause(false)
+{
+}
+
+PcmWriter::~PcmWriter()
+{
+    close();
+}
+
+bool PcmWriter::open(const QString &device, const QString &mmapDevice, const AudioFormat &format,
+                     unsigned int latencyUs, QString &error)
+{
+    close();
+
+    // 硬件设备上 mmap_begin 给出的才是 DMA 缓冲区，格式必须原样被支持，不经任何转换
+    snd_pcm_t *pcm = nullptr;
+    QString opened = device;
+    bool mmap = false;
+    if (!mmapDevice.isEmpty()) {
+        QString mmapError;
+        int err = snd_pcm_open(&pcm, mmapDevice.toLocal8Bit().constData(), SND_PCM_STREAM_PLAYBACK, 0);
+        if (err < 0) {
+            mmapError = snd_strerror(err);
+            pcm = nullptr;
+        } else if (configure(pcm, format, latencyUs, true, mmapError)) {
+            opened = mmapDevice;
+            mmap = true;
+        } else {
+            snd_pcm_close(pcm);
+            pcm = nullptr;
+        }
+        if (!mmap) {
+            qDebug() << "PcmWriter: mmap on" << mmapDevice << "unavailable:" << mmapError;
+        }
+    }
+
+    if (!pcm) {
+        int err = snd_pcm_open(&pcm, device.toLocal8Bit().constData(), SND_PCM_STREAM_PLAYBACK, 0);
+        if (err < 0) {
+            error = QString("无法打开音频设备 %1: %2").arg(device).arg(snd_strerror(err));
+            return false;
+        }
+        if (!configure(pcm, format, latencyUs, false, error)) {
+            snd_pcm_close(pcm);
+            return false;
+        }
+    }
+
+    m_pcm = pcm;
+    m_access = mmap ? MmapAccess : CopyAccess;
+    m_channels = format.channels;
+    m_rate = format.sampleRate;
+
+    qDebug() << "PcmWriter:" << opened << (mmap ? "mmap" : "rw") << "buffer" << m_bufferFrames
+             << "period" << m_periodFrames << "start" << m_startThreshold << "can pause:" << m_canPause;
+    return true;
+}
+
+bool PcmWriter::configure(snd_pcm_t *pcm, const AudioFormat &format, unsigned int latencyUs,
+                          bool mmap, QString &error)
+{
+    // soft_resample = 0：plug 只做格式与声道转换，采样率不符时在这里失败
+    int err = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S16_LE,
+                                 mmap ? SND_PCM_ACCESS_MMAP_INTERLEAVED : SND_PCM_ACCESS_RW_INTERLEAVED,
+                                 unsigned(format.channels), unsigned(format.sampleRate),
+                                 0, latencyUs);
+    if (err < 0) {
+        error = QString("音频设备不支持 %1Hz/%2 声道: %3")
+                .arg(format.sampleRate).arg(format.channels).arg(snd_strerror(err));
+        return false;
+    }
+
+    snd_pcm_uframes_t bufferSize = 0;
+    snd_pcm_uframes_t periodSize = 0;
+    snd_pcm_get_params(pcm, &bufferSize, &periodSize);
+    m_bufferFrames = int(bufferSize);
+    m_periodFrames = periodSize > 0 ? int(periodSize) : 1024;
+
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_hw_params_alloca(&hw);
+    m_canPause = (snd_pcm_hw_params_current(pcm, hw) == 0 && snd_pcm_hw_params_can_pause(hw));
+
+    // mmap 方式下提交数据不会自动启动设备，按同样的启动阈值手动启动
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_uframes_t threshold = bufferSize;
+    if (snd_pcm_sw_params_current(pcm, sw) == 0) {
+        snd_pcm_sw_params_get_start_threshold(sw, &threshold);
+    }
+    m_startThreshold = int(qMin<snd_pcm_uframes_t>(threshold, bufferSize));
+    return true;
+}
+
+QVector<int> PcmWriter::supportedRates(const QString &device, QString &error)
+{
+    QVector<int> rates;
+
+    // 非阻塞打开：设备正被占用时立即返回，而不是等到对方关闭
+    snd_pcm_t *pcm = nullptr;
+    int err = snd_pcm_open(&pcm, device.toLocal8Bit().constData(), SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        error = QString("无法打开音频设备 %1: %2").arg(device).arg(snd_strerror(err));
+        return rates;
+    }
+
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_hw_params_alloca(&hw);
+    err = snd_pcm_hw_params_any(pcm, hw);
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_rate_resample(pcm, hw, 0);
+    }
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16_LE);
+    }
+    if (err < 0) {
+        error = QString("无法读取音频设备 %1 的参数: %2").arg(device).arg(snd_strerror(err));
+    } else {
+        for (unsigned int rate : kStandardRates) {
+            if (snd_pcm_hw_params_test_rate(pcm, hw, rate, 0) == 0) {
+                rates.append(int(rate));
+            }
+        }
+        if (rates.isEmpty()) {
+            error = QString("音频设备 %1 不支持任何标准采样率").arg(device);
+        }
+    }
+    snd_pcm_close(pcm);
+    return rates;
+}
+
+void PcmWriter::close()
+{
+    if (m_pcm) {
+        snd_pcm_drop(m_pcm);
+        snd_pcm_close(m_pcm);
+        m_pcm = nullptr;
+    }
+    m_access = CopyAccess;
+    m_channels = 0;
+}
+
+bool PcmWriter::recover(int err)
+{
+    // 欠载（-EPIPE）或挂起（-ESTRPIPE）后恢复
+    if (err == -EPIPE) {
+        m_stats.underruns++;
+    } else if (err == -ESTRPIPE) {
+        m_stats.suspends++;
+    }
+    int result = snd_pcm_recover(m_pcm, err, 1);
+    if (result < 0) {
+        qDebug() << "PcmWriter: write failed," << snd_strerror(result);
+        return false;
+    }
+    return true;
+}
+
+int PcmWriter::write(int frames, const FillFunction &fill)
+{
+    m_stats.lastWakeLateUs = -1;
+    if (!m_pcm || frames <= 0) {
+        return 0;
+    }
+    return m_access == MmapAccess ? writeMmap(frames, fill) : writeCopy(frames, fill);
+}
+
+int PcmWriter::writeCopy(int frames, const FillFunction &fill)
+{
+    if (m_scratch.size() < frames * m_channels) {
+        m_scratch.resize(frames * m_channels);
+    }
+    fill(m_scratch.data(), frames);
+
+    const qint16 *data = m_scratch.constData();
+    int remaining = frames;
+    int written = 0;
+    while (remaining > 0) {
+        // 空间不够时 writei 会阻塞到设备腾出足够空间，比预期多等的时间即唤醒迟到
+        snd_pcm_sframes_t space = snd_pcm_avail_update(m_pcm);
+        qint64 startNs = PlaybackClock::nowNs();
+        snd_pcm_sframes_t n = snd_pcm_writei(m_pcm, data, snd_pcm_uframes_t(remaining));
+        if (n > 0 && space >= 0 && space < n && snd_pcm_state(m_pcm) == SND_PCM_STATE_RUNNING) {
+            qint64 expectedNs = qint64(n - space) * 1000000000LL / m_rate;
+            qint64 lateUs = qMax<qint64>(0, PlaybackClock::nowNs() - startNs - expectedNs) / 1000;
+            m_stats.lastWakeLateUs = qMax(m_stats.lastWakeLateUs, lateUs);
+        }
+        if (n == -EAGAIN) {
+            continue;
+        }
+        if (n < 0) {
+            // 仍无法恢复则丢弃本段
+            if (!recover(int(n))) {
+                break;
+            }
+            continue;
+        }
+        data += n * m_channels;
+        remaining -= int(n);
+        written += int(n);
+    }
+    return written;
+}
+
+int PcmWriter::writeMmap(int frames, const FillFunction &fill)
+{
+    int consumed = 0;   // 已从调用方取走的帧
+    int written = 0;    // 其中成功提交给设备的帧
+    bool woke = false;  // 刚从 snd_pcm_wait 返回
+    while (consumed < frames) {
+        int wanted = frames - consumed;
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm);
+        if (avail < 0) {
+            woke = false;
+            if (!recover(int(avail))) {
+                break;
+            }
+            continue;
+        }
+        if (woke) {
+            // avail_min 为一个周期，醒来时多空出的帧是迟到期间设备播放掉的
+            qint64 lateUs = qint64(qMax<snd_pcm_sframes_t>(0, avail - m_periodFrames)) * 1000000 / m_rate;
+            m_stats.lastWakeLateUs = qMax(m_stats.lastWakeLateUs, lateUs);
+            woke = false;
+        }
+
+        // 空间不足一个周期：设备还没启动时启动它，否则等待设备消耗数据
+        if (avail < qMin(wanted, m_periodFrames)) {
+            int err = 0;
+            if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED) {
+                err = snd_pcm_start(m_pcm);
+            } else {
+                err = snd_pcm_wait(m_pcm, kWaitTimeoutMs);
+                if (err == 0) {
+                    m_stats.timeouts++;
+                    qDebug() << "PcmWriter: device timeout";
+                    break;
+                }
+                woke = (err > 0);
+            }
+            if (err < 0 && !recover(err)) {
+                break;
+            }
+            continue;
+        }
+
+        const snd_pcm_channel_area_t *areas = nullptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t count = snd_pcm_uframes_t(qMin<snd_pcm_sframes_t>(wanted, avail));
+        int err = snd_pcm_mmap_begin(m_pcm, &areas, &offset, &count);
+        if (err < 0) {
+            if (!recover(err)) {
+                break;
+            }
+            continue;
+        }
+
+        // 交错访问时所有声道共用一块区域，步长为一帧；到达缓冲区末尾时 count 会变小
+        qint16 *dst = reinterpret_cast<qint16 *>(static_cast<char *>(areas[0].addr)
+                                                 + (areas[0].first + offset * areas[0].step) / 8);
+        fill(dst, int(count));
+        consumed += int(count);
+
+        snd_pcm_sframes_t committed = snd_pcm_mmap_commit(m_pcm, offset, count);
+        if (committed < 0 || snd_pcm_uframes_t(committed) != count) {
+            // 提交失败（通常是欠载），这段数据已经取走，恢复后继续写后面的
+            if (!recover(committed < 0 ? int(committed) : -EPIPE)) {
+                break;
+            }
+            continue;
+        }
+        written += int(count);
+
+        if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED) {
+            snd_pcm_sframes_t space = snd_pcm_avail_update(m_pcm);
+            if (space >= 0 && m_bufferFrames - space >= m_startThreshold) {
+                snd_pcm_start(m_pcm);
+            }
+        }
+    }
+
+    if (consumed < frames) {
+        discard(frames - consumed, fill);
+    }
+    return written;
+}
+
+void PcmWriter::discard(int frames, const FillFunction &fill)
+{
+    if (m_scratch.size() < frames * m_channels) {
+        m_scratch.resize(frames * m_channels);
+    }
+    fill(m_scratch.data(), frames);
+}
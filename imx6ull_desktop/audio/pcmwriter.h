@@ -0,0 +1,88 @@
+#ifndef PCMWRITER_H
+#define PCMWRITER_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "audiodecoder.h"
+
+struct _snd_pcm;
+
+/**
+ * @brief ALSA 播放设备的打开与写入
+ *
+ * 给出硬件设备（hw:）且硬件原样支持该格式时使用 mmap 访问（snd_pcm_mmap_begin/commit）：
+ * 数据直接填入声卡的 DMA 缓冲区，省去 snd_pcm_writei 的一次内核复制和中间缓冲区。
+ * 经过 plug 等插件时 mmap 拿到的只是插件的中间缓冲区，插件转换时还要再复制一次，
+ * 并不比 writei 省，所以其他情况一律以 RW 交错访问打开普通设备。
+ * 两种方式对调用方一致：write() 通过回调让调用方把数据填到目标地址。
+ *
+ * 设备一律关闭 ALSA 的软件重采样打开：采样率不被硬件支持时 open() 直接失败，
+ * 而不是由 plug 悄悄做线性插值。重采样由调用方按 supportedRates() 自己完成。
+ *
+ * 只在一个线程中使用，不是线程安全的。
+ */
+class PcmWriter
+{
+public:
+    enum Access {
+        CopyAccess = 0,     // snd_pcm_writei
+        MmapAccess          // snd_pcm_mmap_begin/commit
+    };
+
+    // 把 frames 帧交错 S16 填入 dst；mmap 时 dst 是设备缓冲区（可能不带缓存，只写不读）
+    typedef std::function<void(qint16 *dst, int frames)> FillFunction;
+
+    // 累计次数（重新打开设备不清零），调用方比较写入前后的差得知其间发生了什么
+    struct Stats {
+        quint64 underruns = 0;      // -EPIPE
+        quint64 suspends = 0;       // -ESTRPIPE
+        quint64 timeouts = 0;       // 等待设备超时
+        // 最近一次 write() 中等待设备后唤醒的迟到时间（微秒）：设备空出一个周期时
+        // 就应唤醒，多空出的部分即迟到；该次写入没有等待时为 -1
+        qint64 lastWakeLateUs = -1;
+    };
+
+    PcmWriter();
+    ~PcmWriter();
+
+    // latencyUs 为设备缓冲时长。mmapDevice 非空时先以 mmap 方式直接打开这个硬件设备，
+    // 格式不被硬件支持（或打不开）时改用 device 以 writei 写入；mmapDevice 为空时只用 device
+    bool open(const QString &device, const QString &mmapDevice, const AudioFormat &format,
+              unsigned int latencyUs, QString &error);
+    void close();
+
+    // 硬件设备（hw:）原样支持的 S16 采样率，从低到高；打不开（如正被占用）时返回空并给出原因
+    static QVector<int> supportedRates(const QString &device, QString &error);
+
+    _snd_pcm *handle() const { return m_pcm; }
+    Access access() const { return m_access; }
+    int periodFrames() const { return m_periodFrames; }
+    int bufferFrames() const { return m_bufferFrames; }
+    bool canPause() const { return m_canPause; }
+    const Stats &stats() const { return m_stats; }
+
+    // 写入 frames 帧，必要时阻塞等待设备腾出空间，返回实际写入的帧数。
+    // 无论成败，fill 都会被要求提供全部 frames 帧，写不进去的部分被丢弃
+    int write(int frames, const FillFunction &fill);
+
+private:
+    bool configure(_snd_pcm *pcm, const AudioFormat &format, unsigned int latencyUs, bool mmap, QString &error);
+    bool recover(int err);
+    int writeCopy(int frames, const FillFunction &fill);
+    int writeMmap(int frames, const FillFunction &fill);
+    void discard(int frames, const FillFunction &fill);
+
+    _snd_pcm *m_pcm;
+    Access m_access;
+    int m_channels;
+    int m_rate;
+    int m_periodFrames;
+    int m_bufferFrames;
+    int m_startThreshold;
+    bool m_canPause;
+    Stats m_stats;
+    QVector<qint16> m_scratch;      // 复制方式的中间缓冲区，以及丢弃数据时使用
+};
+
+#endif // PCMWRITER_H
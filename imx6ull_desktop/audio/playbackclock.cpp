@@ -0,0 +1,77 @@
+#include "playbackclock.h"
+#include <atomic>
+#include <time.h>
+
+PlaybackClock::PlaybackClock()
+    : m_sequence(0)
+    , m_frame(0)
+    , m_maxFrame(0)
+    , m_timestampNs(0)
+    , m_sampleRate(0)
+    , m_running(0)
+{
+}
+
+qint64 PlaybackClock::nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void PlaybackClock::publish(const Snapshot &snapshot)
+{
+    // 序列号为奇数表示正在写入
+    quint32 sequence = m_sequence.load();
+    m_sequence.store(sequence + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_frame.store(snapshot.frame);
+    m_maxFrame.store(snapshot.maxFrame);
+    m_timestampNs.store(snapshot.timestampNs);
+    m_sampleRate.store(snapshot.sampleRate);
+    m_running.store(snapshot.running ? 1 : 0);
+
+    m_sequence.storeRelease(sequence + 2);
+}
+
+PlaybackClock::Snapshot PlaybackClock::snapshot() const
+{
+    Snapshot snapshot;
+    quint32 before, after;
+    do {
+        before = m_sequence.loadAcquire();
+        snapshot.frame = m_frame.load();
+        snapshot.maxFrame = m_maxFrame.load();
+        snapshot.timestampNs = m_timestampNs.load();
+        snapshot.sampleRate = m_sampleRate.load();
+        snapshot.running = m_running.load() != 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = m_sequence.load();
+    } while ((before & 1) || before != after);
+    return snapshot;
+}
+
+qint64 PlaybackClock::Snapshot::frameAt(qint64 nowNs) const
+{
+    const Snapshot &s = *this;
+    if (!s.running || s.sampleRate <= 0 || nowNs <= s.timestampNs) {
+        return s.frame;
+    }
+    qint64 elapsed = (nowNs - s.timestampNs) * s.sampleRate / 1000000000LL;
+    return qMin(s.frame + elapsed, s.maxFrame);
+}
+
+qint64 PlaybackClock::frameAt(qint64 nowNs) const
+{
+    return snapshot().frameAt(nowNs);
+}
+
+qint64 PlaybackClock::positionMs() const
+{
+    Snapshot s = snapshot();
+    if (s.sampleRate <= 0) {
+        return 0;
+    }
+    return s.frameAt(nowNs()) * 1000 / s.sampleRate;
+}
@@ -0,0 +1,51 @@
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <QAtomicInteger>
+
+/**
+ * @brief 由声卡实际消耗的帧数驱动的播放时钟
+ *
+ * 输出线程每写完一个周期后用 snd_pcm_delay 得到“已写入 - 仍在设备中”的帧数，
+ * 连同采样时刻（CLOCK_MONOTONIC）一起发布；读取方按经过的时间外推到当前时刻。
+ * 发布与读取使用序列锁，读取方不加锁、不阻塞输出线程，适合界面每帧读取一次。
+ *
+ * 只允许一个线程调用 publish()。
+ */
+class PlaybackClock
+{
+public:
+    struct Snapshot {
+        qint64 frame = 0;           // 采样时刻正在播放的帧（曲目内位置）
+        qint64 maxFrame = 0;        // 已写入设备的最后一帧，外推不会超过这里
+        qint64 timestampNs = 0;     // 采样时刻
+        int sampleRate = 0;
+        bool running = false;       // 设备正在播放（暂停、欠载、停止时为 false）
+
+        // 按经过的时间外推到 nowNs 时刻
+        qint64 frameAt(qint64 nowNs) const;
+    };
+
+    PlaybackClock();
+
+    void publish(const Snapshot &snapshot);
+    Snapshot snapshot() const;
+
+    // 外推到 nowNs 时刻的播放位置（帧）
+    qint64 frameAt(qint64 nowNs) const;
+
+    // 当前播放位置（毫秒）
+    qint64 positionMs() const;
+
+    static qint64 nowNs();
+
+private:
+    QAtomicInteger<quint32> m_sequence;
+    QAtomicInteger<qint64> m_frame;
+    QAtomicInteger<qint64> m_maxFrame;
+    QAtomicInteger<qint64> m_timestampNs;
+    QAtomicInteger<int> m_sampleRate;
+    QAtomicInteger<int> m_running;
+};
+
+#endif // PLAYBACKCLOCK_H
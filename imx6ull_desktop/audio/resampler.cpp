@@ -0,0 +1,217 @@
+#include "resampler.h"
+#include <QtGlobal>
+#include <cmath>
+#include <cstring>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+// 相位数上限：比例约分后 L 过大（例如非标准采样率）时滤波器组占用内存过多
+static const int kMaxPhases = 4096;
+
+struct QualityParams {
+    int taps;
+    double passband;    // 通带边缘占较低奈奎斯特频率的比例
+    double beta;        // Kaiser 窗参数
+};
+
+static const QualityParams kQualityParams[] = {
+    { 8, 0.85, 5.0 },
+    { 16, 0.90, 7.0 },
+    { 32, 0.94, 9.0 },
+};
+
+static int gcd(int a, int b)
+{
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// 第一类零阶修正贝塞尔函数，级数展开
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static inline int dot(const qint16 *coeffs, const qint16 *samples, int taps)
+{
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int i = 0; i < taps; i += 8) {
+        int16x8_t c = vld1q_s16(coeffs + i);
+        int16x8_t x = vld1q_s16(samples + i);
+        acc = vmlal_s16(acc, vget_low_s16(c), vget_low_s16(x));
+        acc = vmlal_s16(acc, vget_high_s16(c), vget_high_s16(x));
+    }
+    int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    sum = vpadd_s32(sum, sum);
+    return vget_lane_s32(sum, 0);
+#else
+    int acc = 0;
+    for (int i = 0; i < taps; ++i) {
+        acc += int(coeffs[i]) * samples[i];
+    }
+    return acc;
+#endif
+}
+
+Resampler::Resampler(int inputRate, int outputRate, int channels, Quality quality)
+    : m_inputRate(inputRate)
+    , m_outputRate(outputRate)
+    , m_channels(channels)
+    , m_quality(quality)
+    , m_up(0)
+    , m_down(0)
+    , m_taps(0)
+    , m_phase(0)
+    , m_position(0)
+{
+    if (channels <= 0 || !isSupported(inputRate, outputRate)) {
+        return;
+    }
+    int divisor = gcd(inputRate, outputRate);
+    m_up = outputRate / divisor;
+    m_down = inputRate / divisor;
+    design();
+    reset();
+}
+
+bool Resampler::isSupported(int inputRate, int outputRate)
+{
+    if (inputRate <= 0 || outputRate <= 0) {
+        return false;
+    }
+    return outputRate / gcd(inputRate, outputRate) <= kMaxPhases;
+}
+
+const char *Resampler::qualityName(Quality quality)
+{
+    switch (quality) {
+    case LowQuality:
+        return "low";
+    case MediumQuality:
+        return "medium";
+    case HighQuality:
+        return "high";
+    }
+    return "";
+}
+
+void Resampler::design()
+{
+    const QualityParams &params = kQualityParams[m_quality];
+    int taps = params.taps;
+    int length = taps * m_up;
+
+    // 原型滤波器工作在 L 倍输入采样率上，截止于输入、输出中较低的奈奎斯特频率以内
+    double cutoff = params.passband * 0.5 * qMin(1.0, double(m_up) / m_down) / m_up;
+    double center = (length - 1) / 2.0;
+    double norm = besselI0(params.beta);
+
+    QVector<double> prototype(length);
+    for (int i = 0; i < length; ++i) {
+        double t = i - center;
+        double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        double r = t / center;
+        double window = besselI0(params.beta * std::sqrt(qMax(0.0, 1.0 - r * r))) / norm;
+        prototype[i] = sinc * window;
+    }
+
+    // 相位 p 的第 j 个系数作用于往前第 j 个输入：h[p + j*L]。
+    // 每组单独归一化为单位直流增益，各相位之间没有增益起伏
+    m_taps = taps;
+    m_coeffs.resize(m_up * taps);
+    for (int p = 0; p < m_up; ++p) {
+        double sum = 0;
+        for (int j = 0; j < taps; ++j) {
+            sum += prototype[p + j * m_up];
+        }
+        qint16 *group = m_coeffs.data() + p * taps;
+        for (int j = 0; j < taps; ++j) {
+            double value = prototype[p + j * m_up] / sum * 32768.0;
+            group[taps - 1 - j] = qint16(qBound(-32768.0, std::round(value), 32767.0));
+        }
+    }
+}
+
+void Resampler::reset()
+{
+    m_phase = 0;
+    m_position = m_taps - 1;
+    m_work.fill(0);
+}
+
+int Resampler::maxOutputFrames(int inputFrames) const
+{
+    if (!isValid()) {
+        return 0;
+    }
+    return int((qint64(inputFrames) * m_up + m_down - 1) / m_down) + 1;
+}
+
+int Resampler::process(const qint16 *input, int frames, qint16 *output)
+{
+    if (!isValid() || frames <= 0) {
+        return 0;
+    }
+
+    int history = m_taps - 1;
+    int length = history + frames;
+    int stride = qMax(length, m_work.size() / m_channels);
+    if (m_work.size() < stride * m_channels) {
+        // 扩容时保留各声道的历史样本
+        QVector<qint16> grown(stride * m_channels, 0);
+        int oldStride = m_work.size() / m_channels;
+        for (int ch = 0; ch < m_channels && oldStride > 0; ++ch) {
+            memcpy(grown.data() + ch * stride, m_work.constData() + ch * oldStride, history * sizeof(qint16));
+        }
+        m_work.swap(grown);
+    }
+
+    // 解交错到各声道的历史之后
+    for (int ch = 0; ch < m_channels; ++ch) {
+        qint16 *dst = m_work.data() + ch * stride + history;
+        const qint16 *src = input + ch;
+        for (int i = 0; i < frames; ++i) {
+            dst[i] = src[i * m_channels];
+        }
+    }
+
+    int produced = 0;
+    int position = m_position;
+    int phase = m_phase;
+    while (position < length) {
+        const qint16 *coeffs = m_coeffs.constData() + phase * m_taps;
+        for (int ch = 0; ch < m_channels; ++ch) {
+            const qint16 *samples = m_work.constData() + ch * stride + position - history;
+            int value = (dot(coeffs, samples, m_taps) + (1 << 14)) >> 15;
+            output[produced * m_channels + ch] = qint16(qBound(-32768, value, 32767));
+        }
+        ++produced;
+        phase += m_down;
+        position += phase / m_up;
+        phase %= m_up;
+    }
+
+    // 最后 taps - 1 个输入留作下一次的历史
+    for (int ch = 0; ch < m_channels; ++ch) {
+        qint16 *base = m_work.data() + ch * stride;
+        memmove(base, base + frames, history * sizeof(qint16));
+    }
+    m_position = position - frames;
+    m_phase = phase;
+    return produced;
+}
@@ -0,0 +1,66 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QVector>
+
+/**
+ * @brief 多相 FIR 采样率转换（S16 交错）
+ *
+ * 输入输出采样率之比约分为 L/M，原型低通滤波器（Kaiser 窗 sinc）拆成 L 组相位，
+ * 每个输出样本只与一组 taps 个系数做点积。系数为 Q15，点积用 NEON 的
+ * vmlal_s16 每次处理 8 个样本，32 位累加。
+ *
+ * 质量等级决定每相位的抽头数、通带宽度和阻带衰减；抽头数越多 CPU 开销越大。
+ * 流式处理：滤波器历史在调用之间保留，连续的曲目可以共用同一个实例。
+ *
+ * 只在一个线程中使用，不是线程安全的。
+ */
+class Resampler
+{
+public:
+    enum Quality {
+        LowQuality = 0,     // 8 抽头，通带 0.85，约 50dB
+        MediumQuality,      // 16 抽头，通带 0.90，约 70dB
+        HighQuality         // 32 抽头，通带 0.94，约 90dB
+    };
+
+    Resampler(int inputRate, int outputRate, int channels, Quality quality);
+
+    // 采样率比例无法用合理大小的滤波器组实现时无效
+    bool isValid() const { return m_taps > 0; }
+    static bool isSupported(int inputRate, int outputRate);
+
+    int inputRate() const { return m_inputRate; }
+    int outputRate() const { return m_outputRate; }
+    int channels() const { return m_channels; }
+    Quality quality() const { return m_quality; }
+    int taps() const { return m_taps; }
+
+    // inputFrames 帧输入最多产生的输出帧数
+    int maxOutputFrames(int inputFrames) const;
+
+    // 处理 frames 帧交错输入，结果写入 output（至少 maxOutputFrames(frames) 帧），返回输出帧数
+    int process(const qint16 *input, int frames, qint16 *output);
+
+    // 清空滤波器历史（定位后调用）
+    void reset();
+
+    static const char *qualityName(Quality quality);
+
+private:
+    void design();
+
+    int m_inputRate;
+    int m_outputRate;
+    int m_channels;
+    Quality m_quality;
+    int m_up;                       // L
+    int m_down;                     // M
+    int m_taps;                     // 每相位抽头数，8 的倍数
+    QVector<qint16> m_coeffs;       // L 组，每组逆序排列，可直接与时间顺序的输入做点积
+    QVector<qint16> m_work;         // 各声道分开存放：taps - 1 个历史样本 + 本次输入
+    int m_phase;
+    int m_position;                 // 下一个输出对应的最新输入样本在 m_work 中的下标
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,119 @@
+#include "softwaregain.h"
+#include <QtGlobal>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+static const int kUnityQ15 = 32768;
+
+// 最大增益 +12dB，Q15 下为 131072，放大时按 Q12 计算仍在 16 位以内
+static const float kMaxGain = 4.0f;
+
+// 增益过渡时长（帧），44.1kHz 下约 23ms
+static const int kRampFrames = 1024;
+
+SoftwareGain::SoftwareGain()
+    : m_targetQ15(kUnityQ15)
+    , m_currentQ15(kUnityQ15)
+    , m_rampStep(0)
+    , m_rampTarget(kUnityQ15)
+{
+}
+
+void SoftwareGain::setGain(float gain)
+{
+    gain = qBound(0.0f, gain, kMaxGain);
+    m_targetQ15.storeRelease(qRound(gain * kUnityQ15));
+}
+
+void SoftwareGain::reset(float gain)
+{
+    setGain(gain);
+    m_currentQ15 = m_targetQ15.loadAcquire();
+    m_rampTarget = m_currentQ15;
+    m_rampStep = 0;
+}
+
+float SoftwareGain::gain() const
+{
+    return float(m_targetQ15.loadAcquire()) / kUnityQ15;
+}
+
+bool SoftwareGain::isUnity() const
+{
+    return m_currentQ15 == kUnityQ15 && m_targetQ15.loadAcquire() == kUnityQ15;
+}
+
+static inline void applyScalar(qint16 *samples, int count, int gainQ15)
+{
+    if (gainQ15 <= kUnityQ15) {
+        for (int i = 0; i < count; ++i) {
+            samples[i] = qint16((int(samples[i]) * gainQ15) >> 15);
+        }
+        return;
+    }
+    // 放大：降为 Q12 以免 32 位乘积溢出，结果饱和到 16 位
+    int gainQ12 = gainQ15 >> 3;
+    for (int i = 0; i < count; ++i) {
+        samples[i] = qint16(qBound(-32768, (int(samples[i]) * gainQ12 + (1 << 11)) >> 12, 32767));
+    }
+}
+
+void SoftwareGain::process(qint16 *samples, int frames, int channels)
+{
+    int target = m_targetQ15.loadAcquire();
+    if (target != m_rampTarget) {
+        // 新目标：从当前增益开始重新计算斜率
+        m_rampTarget = target;
+        m_rampStep = (target - m_currentQ15) / kRampFrames;
+        if (m_rampStep == 0) {
+            m_rampStep = (target > m_currentQ15) ? 1 : -1;
+        }
+    }
+
+    // 过渡阶段逐帧改变增益
+    int frame = 0;
+    while (frame < frames && m_currentQ15 != target) {
+        m_currentQ15 += m_rampStep;
+        if ((m_rampStep > 0 && m_currentQ15 > target) || (m_rampStep < 0 && m_currentQ15 < target)) {
+            m_currentQ15 = target;
+        }
+        applyScalar(samples + frame * channels, channels, m_currentQ15);
+        ++frame;
+    }
+
+    if (frame >= frames || m_currentQ15 == kUnityQ15) {
+        return;
+    }
+
+    // 稳定阶段：增益恒定，批量处理
+    qint16 *p = samples + frame * channels;
+    int count = (frames - frame) * channels;
+    int gain = m_currentQ15;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    int i = 0;
+    if (gain < kUnityQ15) {
+        // vqrdmulh: (2*a*b + 0x8000) >> 16，即带舍入的 Q15 乘法；gain < 32768，不会溢出
+        int16x8_t g = vdupq_n_s16(qint16(gain));
+        for (; i + 16 <= count; i += 16) {
+            int16x8_t a = vld1q_s16(p + i);
+            int16x8_t b = vld1q_s16(p + i + 8);
+            vst1q_s16(p + i, vqrdmulhq_s16(a, g));
+            vst1q_s16(p + i + 8, vqrdmulhq_s16(b, g));
+        }
+    } else {
+        // 放大：Q12 增益扩展乘到 32 位，vqrshrn 带舍入右移并饱和收窄
+        int16x4_t g = vdup_n_s16(qint16(gain >> 3));
+        for (; i + 8 <= count; i += 8) {
+            int16x8_t a = vld1q_s16(p + i);
+            int32x4_t lo = vmull_s16(vget_low_s16(a), g);
+            int32x4_t hi = vmull_s16(vget_high_s16(a), g);
+            vst1q_s16(p + i, vcombine_s16(vqrshrn_n_s32(lo, 12), vqrshrn_n_s32(hi, 12)));
+        }
+    }
+    applyScalar(p + i, count - i, gain);
+#else
+    applyScalar(p, count, gain);
+#endif
+}
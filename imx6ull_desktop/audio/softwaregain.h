@@ -0,0 +1,42 @@
+#ifndef SOFTWAREGAIN_H
+#define SOFTWAREGAIN_H
+
+#include <QAtomicInt>
+
+/**
+ * @brief 作用在 S16 PCM 上的软件增益
+ *
+ * 声卡没有可用的硬件音量控件时作为音量使用（输出线程），也用于按曲目响度
+ * 校正的增益（解码线程）。目标增益可在任意线程设置，process() 只在处理数据的
+ * 线程调用：增益变化时在 kRampFrames 帧内线性过渡，避免咔哒声；增益稳定后用
+ * NEON 饱和乘法批量处理，单位增益时直接跳过。增益大于 1 时结果饱和，不会回绕。
+ */
+class SoftwareGain
+{
+public:
+    SoftwareGain();
+
+    // 线性增益 0.0 ~ 4.0（+12dB）
+    void setGain(float gain);
+    float gain() const;
+
+    // 处理数据的线程调用：立即切换到该增益，不经过渡（用于新曲目的开头）
+    void reset(float gain);
+
+    // 处理数据的线程调用：当前与目标增益都是单位增益，process() 不会改动数据
+    bool isUnity() const;
+
+    // 原地处理交错样本
+    void process(qint16 *samples, int frames, int channels);
+
+private:
+    // Q15 定点增益，32768 表示单位增益，最大 4 倍
+    QAtomicInt m_targetQ15;
+
+    // 以下只由输出线程访问
+    int m_currentQ15;
+    int m_rampStep;
+    int m_rampTarget;
+};
+
+#endif // SOFTWAREGAIN_H
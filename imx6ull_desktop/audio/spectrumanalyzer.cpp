@@ -0,0 +1,364 @@
+#include "spectrumanalyzer.h"
+#include "pcmtap.h"
+#include "playbackclock.h"
+#include "boardthread.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cmath>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 质量等级：FFT 点数、频段数、帧率，CPU 紧张时逐级下降
+static const int kLevelCount = 4;
+
+// 每帧 CPU 时间预算（30fps 时约占单核 12%）
+static const qint64 kFrameBudgetNs = 4000000;
+
+// 1 秒窗口内迟到/跳帧达到该次数即降级
+static const int kMaxMissedPerWindow = 3;
+
+// 连续空闲这么多个窗口后升级
+static const int kCalmWindowsToUpgrade = 3;
+
+static const int kAnalyzerNice = 5;
+static const int kScopePoints = 128;
+
+// 频谱显示范围
+static const float kFloorDb = -60.0f;
+static const float kLowHz = 40.0f;
+static const float kHighHz = 16000.0f;
+
+// 下落速度（满量程/秒）
+static const float kBandFall = 1.5f;
+static const float kBandPeakFall = 0.4f;
+static const float kMeterPeakFall = 1.5f;
+static const float kMeterHoldFall = 0.3f;
+static const float kRmsIntegrationS = 0.3f;
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+static inline float toLevel(float amplitude)
+{
+    float db = 20.0f * std::log10(amplitude + 1e-9f);
+    return qBound(0.0f, (db - kFloorDb) / -kFloorDb, 1.0f);
+}
+
+static inline float fall(float current, float target, float rate, float dt)
+{
+    return qMax(target, current - rate * dt);
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(PcmTap *tap, const PlaybackClock *clock, QObject *parent)
+    : QObject(parent)
+    , m_tap(tap)
+    , m_clock(clock)
+    , m_thread(nullptr)
+    , m_tableSize(0)
+    , m_quit(false)
+    , m_running(false)
+    , m_level(0)
+    , m_windowFrames(0)
+    , m_windowMissed(0)
+    , m_calmWindows(0)
+{
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("Spectrum");
+    m_thread->start();
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stop();
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+SpectrumAnalyzer::Level SpectrumAnalyzer::levelAt(int index)
+{
+    static const Level kLevels[kLevelCount] = {
+        { 1024, 32, 30 },
+        { 512, 24, 20 },
+        { 256, 16, 15 },
+        { 256, 8, 10 },
+    };
+    return kLevels[qBound(0, index, kLevelCount - 1)];
+}
+
+void SpectrumAnalyzer::start()
+{
+    m_tap->setEnabled(true);
+    QMutexLocker locker(&m_mutex);
+    m_running = true;
+    m_cond.wakeAll();
+}
+
+void SpectrumAnalyzer::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        m_cond.wakeAll();
+        qDebug() << "SpectrumAnalyzer: frames" << m_stats.frames << "skipped" << m_stats.skipped
+                 << "late" << m_stats.late << "avg" << m_stats.avgCostNs / 1000 << "us"
+                 << "max" << m_stats.maxCostNs / 1000 << "us" << "level" << m_level;
+    }
+    m_tap->setEnabled(false);
+}
+
+bool SpectrumAnalyzer::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running;
+}
+
+SpectrumAnalyzer::Frame SpectrumAnalyzer::frame() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frame;
+}
+
+SpectrumAnalyzer::Stats SpectrumAnalyzer::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    Level level = levelAt(m_level);
+    stats.level = m_level;
+    stats.bands = level.bands;
+    stats.fps = level.fps;
+    return stats;
+}
+
+void SpectrumAnalyzer::prepareTables(int fftSize)
+{
+    if (m_tableSize == fftSize) {
+        return;
+    }
+    m_tableSize = fftSize;
+    m_re.resize(fftSize);
+    m_im.resize(fftSize);
+    m_window.resize(fftSize);
+    m_cos.resize(fftSize / 2);
+    m_sin.resize(fftSize / 2);
+    m_bitReverse.resize(fftSize);
+
+    int bits = 0;
+    while ((1 << bits) < fftSize) {
+        ++bits;
+    }
+    for (int i = 0; i < fftSize; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+        m_window[i] = 0.5f - 0.5f * std::cos(2.0f * float(M_PI) * i / (fftSize - 1));
+    }
+    for (int k = 0; k < fftSize / 2; ++k) {
+        m_cos[k] = std::cos(2.0f * float(M_PI) * k / fftSize);
+        m_sin[k] = std::sin(2.0f * float(M_PI) * k / fftSize);
+    }
+}
+
+void SpectrumAnalyzer::analyze(const Level &level, const QVector<qint16> &window, bool silent,
+                               int sampleRate, float dt, Frame &frame)
+{
+    const int n = level.fftSize;
+    prepareTables(n);
+    const qint16 *pcm = window.constData();
+    const float scale = 1.0f / 32768.0f;
+
+    // 电平：RMS 按约 300ms 积分，峰值快速下落并保持最高点
+    for (int ch = 0; ch < 2; ++ch) {
+        float sum = 0;
+        float peak = 0;
+        if (!silent) {
+            for (int i = 0; i < n; ++i) {
+                float x = pcm[i * 2 + ch] * scale;
+                sum += x * x;
+                peak = qMax(peak, std::fabs(x));
+            }
+        }
+        float rms = toLevel(std::sqrt(sum / n));
+        frame.rms[ch] += (rms - frame.rms[ch]) * qMin(1.0f, dt / kRmsIntegrationS);
+        frame.peak[ch] = fall(frame.peak[ch], toLevel(peak), kMeterPeakFall, dt);
+        frame.peakHold[ch] = fall(frame.peakHold[ch], frame.peak[ch], kMeterHoldFall, dt);
+    }
+
+    // 示波器：最近一段的单声道波形
+    frame.scope.resize(kScopePoints);
+    for (int i = 0; i < kScopePoints; ++i) {
+        int idx = (i * n / kScopePoints) * 2;
+        frame.scope[i] = silent ? 0.0f : (pcm[idx] + pcm[idx + 1]) * 0.5f * scale;
+    }
+
+    // FFT：单声道 + Hann 窗，位反转后按蝶形逐级计算
+    float *re = m_re.data();
+    float *im = m_im.data();
+    for (int i = 0; i < n; ++i) {
+        int j = m_bitReverse[i];
+        re[j] = silent ? 0.0f : (pcm[i * 2] + pcm[i * 2 + 1]) * 0.5f * scale * m_window[i];
+        im[j] = 0.0f;
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; ++k) {
+                float wr = m_cos[k * step];
+                float wi = -m_sin[k * step];
+                int a = i + k;
+                int b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+
+    // 对数分段：每段取最大幅度；Hann 窗相干增益 0.5，换算为满量程正弦 = 1
+    if (frame.bands.size() != level.bands) {
+        frame.bands.fill(0.0f, level.bands);
+        frame.bandPeaks.fill(0.0f, level.bands);
+    }
+    float nyquist = sampleRate * 0.5f;
+    float high = qMin(kHighHz, nyquist);
+    float binHz = float(sampleRate) / n;
+    float ampScale = 4.0f / n;
+    for (int b = 0; b < level.bands; ++b) {
+        float f0 = kLowHz * std::pow(high / kLowHz, float(b) / level.bands);
+        float f1 = kLowHz * std::pow(high / kLowHz, float(b + 1) / level.bands);
+        int k0 = qBound(1, int(f0 / binHz), n / 2 - 1);
+        int k1 = qBound(k0 + 1, int(std::ceil(f1 / binHz)), n / 2);
+        float maxPower = 0;
+        for (int k = k0; k < k1; ++k) {
+            maxPower = qMax(maxPower, re[k] * re[k] + im[k] * im[k]);
+        }
+        float value = toLevel(std::sqrt(maxPower) * ampScale);
+        frame.bands[b] = fall(frame.bands[b], value, kBandFall, dt);
+        frame.bandPeaks[b] = fall(frame.bandPeaks[b], frame.bands[b], kBandPeakFall, dt);
+    }
+}
+
+void SpectrumAnalyzer::adapt(int missed)
+{
+    // 调用方持有 m_mutex；每秒评估一次
+    Level level = levelAt(m_level);
+    m_windowFrames++;
+    m_windowMissed += missed;
+    if (m_windowFrames < level.fps) {
+        return;
+    }
+
+    int oldLevel = m_level;
+    if ((m_windowMissed >= kMaxMissedPerWindow || m_stats.avgCostNs > kFrameBudgetNs)
+            && m_level < kLevelCount - 1) {
+        m_level++;
+        m_calmWindows = 0;
+    } else if (m_windowMissed == 0 && m_stats.avgCostNs < kFrameBudgetNs / 3 && m_level > 0) {
+        if (++m_calmWindows >= kCalmWindowsToUpgrade) {
+            m_level--;
+            m_calmWindows = 0;
+        }
+    } else {
+        m_calmWindows = 0;
+    }
+    m_windowFrames = 0;
+    m_windowMissed = 0;
+
+    if (m_level != oldLevel) {
+        Level next = levelAt(m_level);
+        qDebug() << "SpectrumAnalyzer: level" << oldLevel << "->" << m_level
+                 << "fft" << next.fftSize << "bands" << next.bands << "fps" << next.fps
+                 << "avg cost" << m_stats.avgCostNs / 1000 << "us";
+    }
+}
+
+void SpectrumAnalyzer::threadLoop()
+{
+    // 让出 CPU 给界面与解码；输出线程是 SCHED_FIFO，不会被这里抢占
+    setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), kAnalyzerNice);
+
+    QVector<qint16> window;
+    Frame frame;
+    qint64 nextNs = 0;
+    qint64 lastNs = 0;
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (!m_running) {
+            m_cond.wait(&m_mutex);
+            nextNs = 0;
+            continue;
+        }
+
+        Level level = levelAt(m_level);
+        qint64 periodNs = 1000000000LL / level.fps;
+        qint64 now = PlaybackClock::nowNs();
+        if (nextNs == 0) {
+            nextNs = now;
+            lastNs = now;
+        }
+        if (now < nextNs) {
+            m_cond.wait(&m_mutex, ulong((nextNs - now + 999999) / 1000000));
+            continue;
+        }
+
+        // 错过的帧不追赶，直接对齐到下一个周期
+        int missed = int((now - nextNs) / periodNs);
+        nextNs += qint64(missed + 1) * periodNs;
+        float dt = float(now - lastNs) / 1e9f;
+        lastNs = now;
+        locker.unlock();
+
+        // 取声卡此刻正在播放的那一段：跳过已写入设备但尚未播放的帧
+        PlaybackClock::Snapshot snapshot = m_clock->snapshot();
+        qint64 lag = qBound<qint64>(0, snapshot.maxFrame - snapshot.frameAt(now), m_tap->capacity() / 2);
+        window.resize(level.fftSize * 2);
+        bool silent = !snapshot.running || !m_tap->read(window.data(), level.fftSize, int(lag));
+
+        qint64 cpuStart = threadCpuNs();
+        analyze(level, window, silent, snapshot.sampleRate > 0 ? snapshot.sampleRate : 44100, dt, frame);
+        qint64 cost = threadCpuNs() - cpuStart;
+        frame.level = m_level;
+
+        // 界面还没取走上一帧时不再投递，记为跳帧
+        bool delivered = m_framePending.testAndSetOrdered(0, 1);
+        locker.relock();
+
+        m_frame = frame;
+        m_stats.frames++;
+        m_stats.late += quint64(missed);
+        if (!delivered) {
+            m_stats.skipped++;
+        }
+        m_stats.avgCostNs = m_stats.avgCostNs == 0 ? cost : m_stats.avgCostNs + (cost - m_stats.avgCostNs) / 8;
+        m_stats.maxCostNs = qMax(m_stats.maxCostNs, cost);
+        adapt(missed + (delivered ? 0 : 1));
+
+        if (delivered) {
+            QMetaObject::invokeMethod(this, [this]() {
+                m_framePending.storeRelease(0);
+                emit frameReady();
+            }, Qt::QueuedConnection);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <QObject>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class QThread;
+class PcmTap;
+class PlaybackClock;
+
+/**
+ * @brief 频谱与电平分析
+ *
+ * 工作线程按固定帧率从 PcmTap 取出声卡正在播放的那一段数据（按 PlaybackClock
+ * 的设备延迟对齐），计算频谱（FFT + 对数分段）、VU/峰值电平和示波器波形。
+ *
+ * 每帧有 CPU 时间预算：平均耗时超出预算，或因 CPU 繁忙出现迟到/界面来不及绘制时，
+ * 逐级减少 FFT 点数、频段数和帧率；持续空闲后再逐级恢复。
+ * 工作线程是普通优先级并降低 nice 值，音频输出线程（SCHED_FIFO）总是先于它运行。
+ */
+class SpectrumAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Frame {
+        QVector<float> bands;       // 0 ~ 1
+        QVector<float> bandPeaks;   // 峰值保持
+        float rms[2] = { 0, 0 };    // 0 ~ 1（-60 ~ 0 dBFS）
+        float peak[2] = { 0, 0 };
+        float peakHold[2] = { 0, 0 };
+        QVector<float> scope;       // -1 ~ 1，单声道
+        int level = 0;              // 当前质量等级，0 最高
+    };
+
+    struct Stats {
+        quint64 frames = 0;         // 已分析的帧
+        quint64 skipped = 0;        // 界面尚未取走上一帧，本帧未投递
+        quint64 late = 0;           // CPU 繁忙导致错过的帧
+        qint64 avgCostNs = 0;       // 每帧 CPU 时间（线程时间，指数平均）
+        qint64 maxCostNs = 0;
+        int level = 0;
+        int bands = 0;
+        int fps = 0;
+    };
+
+    SpectrumAnalyzer(PcmTap *tap, const PlaybackClock *clock, QObject *parent = nullptr);
+    ~SpectrumAnalyzer();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    Frame frame() const;
+    Stats stats() const;
+
+signals:
+    // 有新的一帧（主线程中发出）
+    void frameReady();
+
+private:
+    struct Level {
+        int fftSize;
+        int bands;
+        int fps;
+    };
+
+    static Level levelAt(int index);
+
+    void threadLoop();
+    void prepareTables(int fftSize);
+    void analyze(const Level &level, const QVector<qint16> &window, bool silent,
+                 int sampleRate, float dt, Frame &frame);
+    void adapt(int missed);
+
+    PcmTap *m_tap;
+    const PlaybackClock *m_clock;
+    QThread *m_thread;
+    QAtomicInt m_framePending;
+
+    // 工作线程独占
+    QVector<float> m_re;
+    QVector<float> m_im;
+    QVector<float> m_window;        // Hann 窗
+    QVector<float> m_cos;
+    QVector<float> m_sin;
+    QVector<int> m_bitReverse;
+    int m_tableSize;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    bool m_quit;
+    bool m_running;
+    Frame m_frame;
+    Stats m_stats;
+    int m_level;
+    int m_windowFrames;             // 当前 1 秒评估窗口内的帧数
+    int m_windowMissed;             // 窗口内迟到与跳帧的次数
+    int m_calmWindows;              // 连续空闲的评估窗口数
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,386 @@
+#include "streamdecoder.h"
+#include "mp3seektable.h"
+#ifdef HAVE_LIBMAD
+#include "mp3decoder.h"
+#endif
+#include <QUrl>
+#include <QFileInfo>
+#include <QDebug>
+#include <climits>
+#include <cstring>
+
+// 打开时等待响应头与第一段数据的时间
+static const int kOpenTimeoutMs = 10000;
+
+// 识别格式时查看的数据量
+static const int kProbeBytes = 8192;
+
+// MP3：每次交给 libmad 的数据量；缓冲区中不足一帧（最大 1441 字节）时算作欠载
+static const int kInputBytes = 16 * 1024;
+static const int kMinReadBytes = 2048;
+
+// Vorbis：回调读不到数据时 Tremor 当作流结束，缓冲区中至少有一页左右的数据才解码，
+// 回调中再等待一小段时间
+static const int kVorbisReadAhead = 8192;
+static const int kCallbackWaitMs = 1000;
+
+StreamDecoder::StreamDecoder()
+    : m_buffer(nullptr)
+    , m_codec(NoCodec)
+    , m_framesRead(0)
+{
+#ifdef HAVE_LIBMAD
+    mad_stream_init(&m_madStream);
+    mad_frame_init(&m_madFrame);
+    mad_synth_init(&m_madSynth);
+    m_input.resize(kInputBytes + MAD_BUFFER_GUARD);
+    m_inputEnded = false;
+    m_synthPos = 0;
+#endif
+#ifdef HAVE_TREMOR
+    m_vorbisOpened = false;
+    m_readWaitMs = kCallbackWaitMs;
+#endif
+}
+
+StreamDecoder::~StreamDecoder()
+{
+    // 先停止网络线程，界面可能还持有 HttpStream 读取最后的状态
+    if (m_stream) {
+        m_stream->stop();
+    }
+#ifdef HAVE_TREMOR
+    if (m_vorbisOpened) {
+        ov_clear(&m_vorbis);
+    }
+#endif
+#ifdef HAVE_LIBMAD
+    mad_synth_finish(&m_madSynth);
+    mad_frame_finish(&m_madFrame);
+    mad_stream_finish(&m_madStream);
+#endif
+}
+
+bool StreamDecoder::open(const QString &url)
+{
+    m_stream.reset(new HttpStream(url));
+    m_buffer = m_stream->buffer();
+    m_stream->start();
+
+    QString error;
+    if (!m_stream->waitForHeaders(kOpenTimeoutMs, error)) {
+        m_errorString = error;
+        return false;
+    }
+    if (!skipId3()) {
+        m_errorString = "网络流数据不足";
+        return false;
+    }
+
+    QString contentType = m_stream->status().contentType;
+    m_codec = detectCodec(url, contentType);
+    switch (m_codec) {
+#ifdef HAVE_LIBMAD
+    case Mp3Codec:
+        return openMp3();
+#endif
+#ifdef HAVE_TREMOR
+    case VorbisCodec:
+        return openVorbis();
+#endif
+    default:
+        break;
+    }
+    m_errorString = QString("不支持的网络流格式: %1")
+            .arg(contentType.isEmpty() ? QString("未知") : contentType);
+    return false;
+}
+
+StreamDecoder::Codec StreamDecoder::detectCodec(const QString &url, const QString &contentType)
+{
+    static const char *const kMp3Types[] = { "audio/mpeg", "audio/mp3", "audio/mpeg3", "audio/x-mpeg" };
+    static const char *const kVorbisTypes[] = { "application/ogg", "audio/ogg", "audio/vorbis", "audio/x-ogg" };
+    for (const char *type : kMp3Types) {
+        if (contentType == QLatin1String(type)) {
+            return Mp3Codec;
+        }
+    }
+    for (const char *type : kVorbisTypes) {
+        if (contentType == QLatin1String(type)) {
+            return VorbisCodec;
+        }
+    }
+
+    // 服务器没有给出（或给了 application/octet-stream）：看扩展名，再看数据开头
+    QString suffix = QFileInfo(QUrl(url).path()).suffix().toLower();
+    if (suffix == "mp3") {
+        return Mp3Codec;
+    }
+    if (suffix == "ogg" || suffix == "oga") {
+        return VorbisCodec;
+    }
+    char probe[kProbeBytes];
+    int size = m_buffer->peek(probe, kProbeBytes, kOpenTimeoutMs);
+    if (size >= 4 && memcmp(probe, "OggS", 4) == 0) {
+        return VorbisCodec;
+    }
+    if (Mp3SeekTable::findFrame(reinterpret_cast<const uchar *>(probe), 0, size, 0) >= 0) {
+        return Mp3Codec;
+    }
+    return NoCodec;
+}
+
+bool StreamDecoder::skipId3()
+{
+    // 按文件提供的 MP3 开头可能有 ID3v2 标签（常带封面），直接丢掉
+    char header[10];
+    if (m_buffer->peek(header, 10, kOpenTimeoutMs) < 10 || memcmp(header, "ID3", 3) != 0) {
+        return true;
+    }
+    const uchar *p = reinterpret_cast<const uchar *>(header);
+    qint64 size = 10 + ((p[6] & 0x7F) << 21 | (p[7] & 0x7F) << 14 | (p[8] & 0x7F) << 7 | (p[9] & 0x7F));
+    if (p[5] & 0x10) {
+        size += 10;     // 标签尾
+    }
+    char scratch[4096];
+    while (size > 0) {
+        int count = m_buffer->read(scratch, int(qMin<qint64>(size, sizeof(scratch))), kOpenTimeoutMs);
+        if (count <= 0) {
+            return false;
+        }
+        size -= count;
+    }
+    return true;
+}
+
+int StreamDecoder::read(qint16 *buffer, int maxFrames)
+{
+    int result = -1;
+    switch (m_codec) {
+#ifdef HAVE_LIBMAD
+    case Mp3Codec:
+        result = readMp3(buffer, maxFrames);
+        break;
+#endif
+#ifdef HAVE_TREMOR
+    case VorbisCodec:
+        result = readVorbis(buffer, maxFrames);
+        break;
+#endif
+    default:
+        Q_UNUSED(buffer);
+        Q_UNUSED(maxFrames);
+        break;
+    }
+    if (result > 0) {
+        m_framesRead += result;
+    }
+    return result;
+}
+
+bool StreamDecoder::seek(qint64 frame)
+{
+    // 刚打开还没读过的流可以"定位"到开头（预先打开的下一首被复用时）
+    if (frame == 0 && m_framesRead == 0) {
+        return true;
+    }
+    m_errorString = "网络流不支持定位";
+    return false;
+}
+
+#ifdef HAVE_LIBMAD
+
+bool StreamDecoder::openMp3()
+{
+    char probe[kProbeBytes];
+    int size = m_buffer->peek(probe, kProbeBytes, kOpenTimeoutMs);
+    const uchar *data = reinterpret_cast<const uchar *>(probe);
+    qint64 first = Mp3SeekTable::findFrame(data, 0, size, 0);
+    Mp3SeekTable::FrameHeader header;
+    if (first < 0 || !Mp3SeekTable::parseHeader(data + first, header)) {
+        m_errorString = "网络流中没有 MP3 帧";
+        return false;
+    }
+    m_format.sampleRate = header.sampleRate;
+    m_format.channels = header.channels;
+    // 按首帧码率换算缓冲时长（VBR 时是近似值）
+    m_buffer->setByteRate(header.bitrate / 8);
+    return true;
+}
+
+int StreamDecoder::fillInput()
+{
+    if (m_inputEnded) {
+        return -1;
+    }
+    // 播放中缓冲区不足一帧：记为欠载，等重新攒够目标时长再继续
+    if (!m_buffer->ready(kMinReadBytes)) {
+        return 0;
+    }
+
+    size_t remaining = 0;
+    if (m_madStream.buffer && m_madStream.next_frame) {
+        remaining = size_t(m_madStream.bufend - m_madStream.next_frame);
+        if (remaining >= size_t(kInputBytes)) {
+            remaining = 0;      // 整块都找不到帧头，丢弃
+        }
+        memmove(m_input.data(), m_madStream.next_frame, remaining);
+    }
+    int count = m_buffer->read(reinterpret_cast<char *>(m_input.data()) + remaining,
+                               kInputBytes - int(remaining));
+    if (count < 0 && m_buffer->stats().ended) {
+        // 流已结束：补 MAD_BUFFER_GUARD 个 0 解出最后一帧
+        memset(m_input.data() + remaining, 0, MAD_BUFFER_GUARD);
+        count = MAD_BUFFER_GUARD;
+        m_inputEnded = true;
+    } else if (count < 0) {
+        count = 0;
+    }
+    // 剩余数据已移到开头，即使没有读到新数据也要重新指向
+    mad_stream_buffer(&m_madStream, m_input.constData(), remaining + size_t(count));
+    m_madStream.error = MAD_ERROR_NONE;
+    return count > 0 ? 1 : 0;
+}
+
+int StreamDecoder::decodeMp3Frame()
+{
+    for (;;) {
+        if (m_madStream.buffer && mad_frame_decode(&m_madFrame, &m_madStream) == 0) {
+            break;
+        }
+        if (!m_madStream.buffer || m_madStream.error == MAD_ERROR_BUFLEN) {
+            int result = fillInput();
+            if (result <= 0) {
+                return result;
+            }
+            continue;
+        }
+        if (!MAD_RECOVERABLE(m_madStream.error)) {
+            m_errorString = QString("MP3 解码失败: %1").arg(mad_stream_errorstr(&m_madStream));
+            return -2;
+        }
+        if (m_madStream.error >= MAD_ERROR_BADCRC) {
+            // 重连后开头的帧缺少主数据：输出一帧静音
+            mad_frame_mute(&m_madFrame);
+            break;
+        }
+    }
+    if (int(m_madFrame.header.samplerate) != m_format.sampleRate) {
+        m_errorString = "网络流的采样率改变了";
+        return -2;
+    }
+    mad_synth_frame(&m_madSynth, &m_madFrame);
+    m_synthPos = 0;
+    return 1;
+}
+
+int StreamDecoder::readMp3(qint16 *buffer, int maxFrames)
+{
+    int channels = m_format.channels;
+    int done = 0;
+    while (done < maxFrames) {
+        int available = m_madSynth.pcm.length - m_synthPos;
+        if (available <= 0) {
+            int result = decodeMp3Frame();
+            if (result > 0) {
+                continue;
+            }
+            if (done > 0) {
+                break;
+            }
+            // 0：缓冲中；-1：流结束；-2：出错
+            return result == 0 ? kPending : (result == -1 ? 0 : -1);
+        }
+        int frames = qMin(available, maxFrames - done);
+        Mp3Decoder::convert(m_madSynth, m_synthPos, channels, buffer + done * channels, frames);
+        m_synthPos += frames;
+        done += frames;
+    }
+    return done;
+}
+
+#endif // HAVE_LIBMAD
+
+#ifdef HAVE_TREMOR
+
+size_t StreamDecoder::vorbisRead(void *ptr, size_t size, size_t count, void *source)
+{
+    StreamDecoder *decoder = static_cast<StreamDecoder *>(source);
+    if (size == 0) {
+        return 0;
+    }
+    // Tremor 按字节读取（size 为 1），有多少给多少；等不到数据时返回 0，Tremor 视为
+    // 暂时结束，readVorbis() 据缓冲区状态区分真正的结束
+    int wanted = int(qMin<size_t>(size * count, INT_MAX));
+    int got = decoder->m_buffer->read(static_cast<char *>(ptr), wanted, decoder->m_readWaitMs);
+    return got > 0 ? size_t(got) / size : 0;
+}
+
+bool StreamDecoder::openVorbis()
+{
+    ov_callbacks callbacks;
+    callbacks.read_func = &StreamDecoder::vorbisRead;
+    callbacks.seek_func = nullptr;      // 不可定位：Tremor 按流式读取，不找文件尾
+    callbacks.close_func = nullptr;
+    callbacks.tell_func = nullptr;
+
+    // 头部（含注释）可能比较长，打开时允许等得久一些
+    m_readWaitMs = kOpenTimeoutMs;
+    int result = ov_open_callbacks(this, &m_vorbis, nullptr, 0, callbacks);
+    m_readWaitMs = kCallbackWaitMs;
+    if (result != 0) {
+        m_errorString = "网络流不是有效的 Ogg Vorbis";
+        return false;
+    }
+    m_vorbisOpened = true;
+
+    vorbis_info *info = ov_info(&m_vorbis, -1);
+    if (!info) {
+        m_errorString = "Ogg Vorbis 缺少流信息";
+        return false;
+    }
+    m_format.sampleRate = int(info->rate);
+    m_format.channels = info->channels;
+    if (info->bitrate_nominal > 0) {
+        m_buffer->setByteRate(int(info->bitrate_nominal / 8));
+    }
+    return true;
+}
+
+int StreamDecoder::readVorbis(qint16 *buffer, int maxFrames)
+{
+    int bytesPerFrame = m_format.channels * int(sizeof(qint16));
+    int done = 0;
+    bool ended = false;
+    while (done < maxFrames) {
+        if (!m_buffer->ready(kVorbisReadAhead)) {
+            break;
+        }
+        int section = 0;
+        long bytes = ov_read(&m_vorbis, reinterpret_cast<char *>(buffer + done * m_format.channels),
+                             (maxFrames - done) * bytesPerFrame, &section);
+        if (bytes == 0) {
+            ended = m_buffer->stats().state == JitterBuffer::Finished;
+            break;
+        }
+        if (bytes == OV_HOLE) {
+            continue;       // 重连后数据不连续
+        }
+        if (bytes < 0) {
+            m_errorString = "Ogg Vorbis 数据损坏";
+            return done > 0 ? done : -1;
+        }
+        vorbis_info *info = ov_info(&m_vorbis, section);
+        if (info && (info->channels != m_format.channels || int(info->rate) != m_format.sampleRate)) {
+            m_errorString = "网络流的格式改变了";
+            return done > 0 ? done : -1;
+        }
+        done += int(bytes / bytesPerFrame);
+    }
+    if (done > 0) {
+        return done;
+    }
+    return ended ? 0 : kPending;
+}
+
+#endif // HAVE_TREMOR
@@ -0,0 +1,78 @@
+#ifndef STREAMDECODER_H
+#define STREAMDECODER_H
+
+#include "audiodecoder.h"
+#include "httpstream.h"
+#include <QVector>
+#ifdef HAVE_LIBMAD
+#include <mad.h>
+#endif
+#ifdef HAVE_TREMOR
+#include <tremor/ivorbisfile.h>
+#endif
+
+/**
+ * @brief 网络流解码器（http:// 地址）
+ *
+ * 由 HttpStream 在网络线程接收数据写入 JitterBuffer，解码线程只从缓冲区读取，
+ * 网络阻塞不会卡住解码线程。按 Content-Type（没有时按扩展名和数据开头）选择
+ * libmad 解码 MP3 或 Tremor 解码 Ogg Vorbis；对应的库没有编入时报告不支持。
+ *
+ * 缓冲区处于预缓冲状态（起播或欠载后）时 read() 立即返回 Pending，由引擎稍后
+ * 重试，不当作结束。网络流没有总长度，也不能定位。
+ */
+class StreamDecoder : public AudioDecoder
+{
+public:
+    StreamDecoder();
+    ~StreamDecoder() override;
+
+    bool open(const QString &url) override;
+    AudioFormat format() const override { return m_format; }
+    qint64 totalFrames() const override { return -1; }
+    int read(qint16 *buffer, int maxFrames) override;
+    bool seek(qint64 frame) override;
+    QSharedPointer<HttpStream> networkStream() const override { return m_stream; }
+
+private:
+    enum Codec {
+        NoCodec = 0,
+        Mp3Codec,
+        VorbisCodec
+    };
+
+    Codec detectCodec(const QString &url, const QString &contentType);
+    bool skipId3();
+
+#ifdef HAVE_LIBMAD
+    bool openMp3();
+    int readMp3(qint16 *buffer, int maxFrames);
+    int decodeMp3Frame();
+    int fillInput();
+
+    mad_stream m_madStream;
+    mad_frame m_madFrame;
+    mad_synth m_madSynth;
+    QVector<uchar> m_input;         // 送给 libmad 的数据，末尾留出 MAD_BUFFER_GUARD
+    bool m_inputEnded;
+    int m_synthPos;
+#endif
+
+#ifdef HAVE_TREMOR
+    static size_t vorbisRead(void *ptr, size_t size, size_t count, void *source);
+    bool openVorbis();
+    int readVorbis(qint16 *buffer, int maxFrames);
+
+    OggVorbis_File m_vorbis;
+    bool m_vorbisOpened;
+    int m_readWaitMs;               // 回调中等待数据的时间
+#endif
+
+    QSharedPointer<HttpStream> m_stream;
+    JitterBuffer *m_buffer;
+    Codec m_codec;
+    AudioFormat m_format;
+    qint64 m_framesRead;
+};
+
+#endif // STREAMDECODER_H
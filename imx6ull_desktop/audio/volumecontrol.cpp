@@ -0,0 +1,215 @@
+#include "volumecontrol.h"
+#include "audioengine.h"
+#include "boardthread.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QDebug>
+#include <alsa/asoundlib.h>
+#include <cmath>
+
+// 与 AudioEngine 使用同一声卡
+static const char *kMixerCard = "default";
+
+// 软件音量的动态范围：1% 对应 -60dB
+static const double kSoftwareRangeDb = 60.0;
+
+VolumeControl::VolumeControl(AudioEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_thread(nullptr)
+    , m_mixer(nullptr)
+    , m_quit(false)
+    , m_pending(-1)
+    , m_volume(100)
+    , m_hardware(false)
+    , m_requests(0)
+    , m_applied(0)
+{
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("VolumeControl");
+    m_thread->start();
+}
+
+VolumeControl::~VolumeControl()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void VolumeControl::setVolume(int percent)
+{
+    QMutexLocker locker(&m_mutex);
+    m_volume = qBound(0, percent, 100);
+    m_pending = m_volume;
+    m_requests++;
+    m_cond.wakeAll();
+}
+
+int VolumeControl::volume() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_volume;
+}
+
+bool VolumeControl::isHardware() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hardware;
+}
+
+quint64 VolumeControl::requestCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_requests;
+}
+
+quint64 VolumeControl::applyCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_applied;
+}
+
+bool VolumeControl::openMixer()
+{
+    int err = snd_mixer_open(&m_mixer, 0);
+    if (err < 0) {
+        m_mixer = nullptr;
+        qDebug() << "VolumeControl: snd_mixer_open failed," << snd_strerror(err);
+        return false;
+    }
+    if ((err = snd_mixer_attach(m_mixer, kMixerCard)) < 0
+            || (err = snd_mixer_selem_register(m_mixer, nullptr, nullptr)) < 0
+            || (err = snd_mixer_load(m_mixer)) < 0) {
+        qDebug() << "VolumeControl: cannot load mixer" << kMixerCard << snd_strerror(err);
+        closeMixer();
+        return false;
+    }
+
+    // 有 Master 时只调 Master；wm8960 没有 Master，调耳机与喇叭两路；再退到 PCM
+    QStringList present;
+    for (snd_mixer_elem_t *elem = snd_mixer_first_elem(m_mixer); elem; elem = snd_mixer_elem_next(elem)) {
+        if (snd_mixer_selem_is_active(elem) && snd_mixer_selem_has_playback_volume(elem)) {
+            present << QString::fromLatin1(snd_mixer_selem_get_name(elem));
+        }
+    }
+
+    static const char *const preferred[][2] = {
+        { "Master", nullptr },
+        { "Headphone", "Speaker" },
+        { "PCM", nullptr },
+        { "Playback", nullptr },
+    };
+    for (const auto &group : preferred) {
+        m_controls.clear();
+        for (const char *name : group) {
+            if (name && present.contains(QLatin1String(name))) {
+                m_controls << QLatin1String(name);
+            }
+        }
+        if (!m_controls.isEmpty()) {
+            return true;
+        }
+    }
+
+    qDebug() << "VolumeControl: no usable playback control, available:" << present;
+    closeMixer();
+    return false;
+}
+
+void VolumeControl::closeMixer()
+{
+    if (m_mixer) {
+        snd_mixer_close(m_mixer);
+        m_mixer = nullptr;
+    }
+    m_controls.clear();
+}
+
+bool VolumeControl::applyHardware(int percent)
+{
+    bool ok = true;
+    for (const QString &name : m_controls) {
+        snd_mixer_selem_id_t *sid;
+        snd_mixer_selem_id_alloca(&sid);
+        snd_mixer_selem_id_set_index(sid, 0);
+        snd_mixer_selem_id_set_name(sid, name.toLatin1().constData());
+
+        snd_mixer_elem_t *elem = snd_mixer_find_selem(m_mixer, sid);
+        if (!elem) {
+            ok = false;
+            continue;
+        }
+
+        // 与 amixer "N%" 相同，按原始范围线性换算
+        long minValue = 0;
+        long maxValue = 0;
+        snd_mixer_selem_get_playback_volume_range(elem, &minValue, &maxValue);
+        long value = minValue + (maxValue - minValue) * percent / 100;
+        if (snd_mixer_selem_set_playback_volume_all(elem, value) < 0) {
+            ok = false;
+        }
+        if (snd_mixer_selem_has_playback_switch(elem)) {
+            snd_mixer_selem_set_playback_switch_all(elem, percent > 0 ? 1 : 0);
+        }
+    }
+    return ok;
+}
+
+void VolumeControl::applySoftware(int percent)
+{
+    float gain = 0.0f;
+    if (percent > 0) {
+        double db = (percent / 100.0 - 1.0) * kSoftwareRangeDb;
+        gain = float(std::pow(10.0, db / 20.0));
+    }
+    m_engine->setGain(gain);
+}
+
+void VolumeControl::threadLoop()
+{
+    bool hardware = openMixer();
+    QString controls = m_controls.join(", ");
+    qDebug() << "VolumeControl: hardware mixer:" << hardware << controls;
+
+    // 使用硬件音量时软件增益保持单位增益
+    if (hardware) {
+        m_engine->setGain(1.0f);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_hardware = hardware;
+    }
+    emit backendReady(hardware, controls);
+
+    QMutexLocker locker(&m_mutex);
+
+    while (!m_quit) {
+        if (m_pending < 0) {
+            m_cond.wait(&m_mutex);
+            continue;
+        }
+
+        // 只执行最新的值，期间到达的请求覆盖 m_pending
+        int percent = m_pending;
+        m_pending = -1;
+        m_applied++;
+        locker.unlock();
+
+        if (hardware && applyHardware(percent)) {
+            m_engine->setGain(1.0f);
+        } else {
+            applySoftware(percent);
+        }
+
+        locker.relock();
+    }
+
+    locker.unlock();
+    closeMixer();
+}
@@ -0,0 +1,71 @@
+#ifndef VOLUMECONTROL_H
+#define VOLUMECONTROL_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+class AudioEngine;
+struct _snd_mixer;
+
+/**
+ * @brief 音量控制
+ *
+ * 通过 ALSA mixer API 在独立线程中设置声卡音量，不再启动 amixer 进程。
+ * setVolume() 只记录最新值并唤醒工作线程，拖动滑块时未执行的旧值会被合并掉。
+ * 声卡上找不到可用的播放音量控件时，改为调节 AudioEngine 的软件增益。
+ *
+ * 工作线程会访问 engine，必须先于 engine 销毁。
+ */
+class VolumeControl : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VolumeControl(AudioEngine *engine, QObject *parent = nullptr);
+    ~VolumeControl();
+
+    // 0 ~ 100，立即返回
+    void setVolume(int percent);
+    int volume() const;
+
+    // 是否使用硬件音量（探测完成前返回 false）
+    bool isHardware() const;
+
+    // 收到的请求数与实际执行数，差值为被合并的请求
+    quint64 requestCount() const;
+    quint64 applyCount() const;
+
+signals:
+    // 工作线程完成声卡探测后发出（跨线程，排队到接收者线程）
+    void backendReady(bool hardware, const QString &controls);
+
+private:
+    void threadLoop();
+    bool openMixer();
+    void closeMixer();
+    bool applyHardware(int percent);
+    void applySoftware(int percent);
+
+    AudioEngine *m_engine;
+    QThread *m_thread;
+
+    // 工作线程独占
+    _snd_mixer *m_mixer;
+    QStringList m_controls;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    bool m_quit;
+    int m_pending;          // 待执行的音量，-1 表示没有
+    int m_volume;
+    bool m_hardware;
+    quint64 m_requests;
+    quint64 m_applied;
+};
+
+#endif // VOLUMECONTROL_H
@@ -0,0 +1,159 @@
+#include "vorbisdecoder.h"
+#include <cstring>
+#include <cstdio>
+#include <sys/mman.h>
+
+VorbisDecoder::VorbisDecoder()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_pos(0)
+    , m_opened(false)
+    , m_totalFrames(-1)
+{
+}
+
+VorbisDecoder::~VorbisDecoder()
+{
+    close();
+}
+
+void VorbisDecoder::close()
+{
+    if (m_opened) {
+        ov_clear(&m_vorbis);
+        m_opened = false;
+    }
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+}
+
+size_t VorbisDecoder::readCallback(void *ptr, size_t size, size_t count, void *source)
+{
+    VorbisDecoder *decoder = static_cast<VorbisDecoder *>(source);
+    if (size == 0) {
+        return 0;
+    }
+    qint64 available = decoder->m_size - decoder->m_pos;
+    size_t items = qMin<size_t>(count, size_t(qMax<qint64>(available, 0)) / size);
+    memcpy(ptr, decoder->m_data + decoder->m_pos, items * size);
+    decoder->m_pos += qint64(items * size);
+    return items;
+}
+
+int VorbisDecoder::seekCallback(void *source, ogg_int64_t offset, int whence)
+{
+    VorbisDecoder *decoder = static_cast<VorbisDecoder *>(source);
+    qint64 pos;
+    switch (whence) {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = decoder->m_pos + offset;
+        break;
+    case SEEK_END:
+        pos = decoder->m_size + offset;
+        break;
+    default:
+        return -1;
+    }
+    if (pos < 0 || pos > decoder->m_size) {
+        return -1;
+    }
+    decoder->m_pos = pos;
+    return 0;
+}
+
+long VorbisDecoder::tellCallback(void *source)
+{
+    return long(static_cast<VorbisDecoder *>(source)->m_pos);
+}
+
+bool VorbisDecoder::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开文件: %1").arg(m_file.errorString());
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        m_errorString = "无法映射 Ogg 文件";
+        return false;
+    }
+    madvise(const_cast<uchar *>(m_data), size_t(m_size), MADV_SEQUENTIAL);
+    m_pos = 0;
+
+    ov_callbacks callbacks;
+    callbacks.read_func = &VorbisDecoder::readCallback;
+    callbacks.seek_func = &VorbisDecoder::seekCallback;
+    callbacks.close_func = nullptr;     // 映射由 close() 释放
+    callbacks.tell_func = &VorbisDecoder::tellCallback;
+    if (ov_open_callbacks(this, &m_vorbis, nullptr, 0, callbacks) != 0) {
+        m_errorString = "不是有效的 Ogg Vorbis 文件";
+        return false;
+    }
+    m_opened = true;
+
+    vorbis_info *info = ov_info(&m_vorbis, -1);
+    if (!info) {
+        m_errorString = "Ogg Vorbis 缺少流信息";
+        return false;
+    }
+    m_format.sampleRate = int(info->rate);
+    m_format.channels = info->channels;
+    ogg_int64_t total = ov_pcm_total(&m_vorbis, -1);
+    m_totalFrames = total >= 0 ? qint64(total) : -1;
+    return true;
+}
+
+int VorbisDecoder::read(qint16 *buffer, int maxFrames)
+{
+    if (!m_opened) {
+        return -1;
+    }
+    int bytesPerFrame = m_format.channels * int(sizeof(qint16));
+    int done = 0;
+    while (done < maxFrames) {
+        int section = 0;
+        long bytes = ov_read(&m_vorbis, reinterpret_cast<char *>(buffer + done * m_format.channels),
+                             (maxFrames - done) * bytesPerFrame, &section);
+        if (bytes == 0) {
+            break;
+        }
+        if (bytes == OV_HOLE) {
+            continue;       // 数据中有缺口，跳过
+        }
+        if (bytes < 0) {
+            m_errorString = "Ogg Vorbis 数据损坏";
+            return done > 0 ? done : -1;
+        }
+        vorbis_info *info = ov_info(&m_vorbis, section);
+        if (info && (info->channels != m_format.channels || int(info->rate) != m_format.sampleRate)) {
+            m_errorString = "串联的 Ogg Vorbis 流格式不一致";
+            break;
+        }
+        done += int(bytes / bytesPerFrame);
+    }
+    return done;
+}
+
+bool VorbisDecoder::seek(qint64 frame)
+{
+    if (!m_opened) {
+        return false;
+    }
+    if (m_totalFrames >= 0) {
+        frame = qBound<qint64>(0, frame, m_totalFrames);
+    }
+    if (ov_pcm_seek(&m_vorbis, ogg_int64_t(frame)) != 0) {
+        m_errorString = "Ogg Vorbis 定位失败";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#ifndef VORBISDECODER_H
+#define VORBISDECODER_H
+
+#include "audiodecoder.h"
+#include <QFile>
+#include <tremor/ivorbisfile.h>
+
+/**
+ * @brief Ogg Vorbis 解码器（Tremor，整数运算）
+ *
+ * Tremor 是 libvorbis 的定点实现，不使用浮点，ov_read() 直接输出主机字节序的 S16，
+ * 这里让它写进调用者的缓冲区。文件只读映射，通过 ov_callbacks 从内存读取。
+ *
+ * 只支持各段格式相同的串联流；格式在中途改变时停止解码。
+ */
+class VorbisDecoder : public AudioDecoder
+{
+public:
+    VorbisDecoder();
+    ~VorbisDecoder() override;
+
+    bool open(const QString &path) override;
+    AudioFormat format() const override { return m_format; }
+    qint64 totalFrames() const override { return m_totalFrames; }
+    int read(qint16 *buffer, int maxFrames) override;
+    bool seek(qint64 frame) override;
+
+private:
+    static size_t readCallback(void *ptr, size_t size, size_t count, void *source);
+    static int seekCallback(void *source, ogg_int64_t offset, int whence);
+    static long tellCallback(void *source);
+
+    void close();
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    qint64 m_pos;                   // 回调的读取位置
+    OggVorbis_File m_vorbis;
+    bool m_opened;
+    AudioFormat m_format;
+    qint64 m_totalFrames;
+};
+
+#endif // VORBISDECODER_H
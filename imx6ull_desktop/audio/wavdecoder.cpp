@@ -0,0 +1,232 @@
+#include "wavdecoder.h"
+#include <QtEndian>
+#include <cstring>
+#include <sys/mman.h>
+
+// WAVE 格式标签
+static const quint16 kFormatPcm = 0x0001;
+static const quint16 kFormatFloat = 0x0003;
+static const quint16 kFormatExtensible = 0xFFFE;
+
+WavDecoder::WavDecoder()
+    : m_bitsPerSample(0)
+    , m_blockAlign(0)
+    , m_isFloat(false)
+    , m_dataOffset(0)
+    , m_dataSize(0)
+    , m_position(0)
+    , m_memoryMapEnabled(true)
+    , m_map(nullptr)
+{
+}
+
+WavDecoder::~WavDecoder()
+{
+    unmap();
+    m_file.close();
+}
+
+void WavDecoder::unmap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+}
+
+bool WavDecoder::open(const QString &path)
+{
+    unmap();
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("无法打开文件: %1").arg(m_file.errorString());
+        return false;
+    }
+    if (!parseHeader()) {
+        m_file.close();
+        return false;
+    }
+
+    // 整个文件只读映射；顺序读取提示内核加大预读，解码线程很少因缺页而等待 SD 卡
+    if (m_memoryMapEnabled && m_dataSize > 0) {
+        m_map = m_file.map(0, m_dataOffset + m_dataSize);
+        if (m_map) {
+            madvise(m_map, size_t(m_dataOffset + m_dataSize), MADV_SEQUENTIAL);
+        }
+    }
+    return seek(0);
+}
+
+bool WavDecoder::parseHeader()
+{
+    char riff[12];
+    if (m_file.read(riff, 12) != 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        m_errorString = "不是有效的 WAV 文件";
+        return false;
+    }
+
+    bool haveFormat = false;
+    quint16 formatTag = 0;
+
+    // 逐个遍历块，直到找到 data 块
+    for (;;) {
+        char header[8];
+        if (m_file.read(header, 8) != 8) {
+            m_errorString = "WAV 文件缺少 data 块";
+            return false;
+        }
+        quint32 chunkSize = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header + 4));
+        qint64 chunkStart = m_file.pos();
+
+        if (memcmp(header, "fmt ", 4) == 0) {
+            QByteArray fmt = m_file.read(qMin<quint32>(chunkSize, 40));
+            if (fmt.size() < 16) {
+                m_errorString = "WAV fmt 块不完整";
+                return false;
+            }
+            const uchar *p = reinterpret_cast<const uchar *>(fmt.constData());
+            formatTag = qFromLittleEndian<quint16>(p);
+            m_format.channels = qFromLittleEndian<quint16>(p + 2);
+            m_format.sampleRate = int(qFromLittleEndian<quint32>(p + 4));
+            m_blockAlign = qFromLittleEndian<quint16>(p + 12);
+            m_bitsPerSample = qFromLittleEndian<quint16>(p + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE：真实格式在子格式 GUID 的前两个字节
+            if (formatTag == kFormatExtensible && fmt.size() >= 26) {
+                formatTag = qFromLittleEndian<quint16>(p + 24);
+            }
+            haveFormat = true;
+        } else if (memcmp(header, "data", 4) == 0) {
+            if (!haveFormat) {
+                m_errorString = "WAV 文件缺少 fmt 块";
+                return false;
+            }
+            m_dataOffset = chunkStart;
+            // 录音中断的文件 data 长度可能为 0 或超出文件，以实际大小为准
+            qint64 remaining = m_file.size() - chunkStart;
+            m_dataSize = (chunkSize == 0 || qint64(chunkSize) > remaining) ? remaining : qint64(chunkSize);
+            break;
+        }
+
+        // 块按偶数字节对齐
+        if (!m_file.seek(chunkStart + chunkSize + (chunkSize & 1))) {
+            m_errorString = "WAV 文件已截断";
+            return false;
+        }
+    }
+
+    m_isFloat = (formatTag == kFormatFloat);
+    bool supported = (formatTag == kFormatPcm && (m_bitsPerSample == 8 || m_bitsPerSample == 16
+                                                  || m_bitsPerSample == 24 || m_bitsPerSample == 32))
+                     || (m_isFloat && m_bitsPerSample == 32);
+    if (!supported || !m_format.isValid() || m_format.channels > 8
+            || m_blockAlign != m_format.channels * m_bitsPerSample / 8) {
+        m_errorString = QString("不支持的 WAV 编码（格式 %1，%2 位）").arg(formatTag).arg(m_bitsPerSample);
+        return false;
+    }
+    return true;
+}
+
+qint64 WavDecoder::totalFrames() const
+{
+    return m_blockAlign > 0 ? m_dataSize / m_blockAlign : -1;
+}
+
+bool WavDecoder::seek(qint64 frame)
+{
+    frame = qBound<qint64>(0, frame, totalFrames());
+    if (!m_map && !m_file.seek(m_dataOffset + frame * m_blockAlign)) {
+        m_errorString = "WAV 定位失败";
+        return false;
+    }
+    m_position = frame;
+    return true;
+}
+
+int WavDecoder::readDirect(const qint16 **data, int maxFrames)
+{
+    // 16 位小端 PCM 与输出格式相同，直接交出映射区（data 块起点按规范为偶数字节）
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (m_map && m_bitsPerSample == 16 && (m_dataOffset & 1) == 0) {
+        qint64 frames = qMin<qint64>(maxFrames, totalFrames() - m_position);
+        if (frames <= 0) {
+            return 0;
+        }
+        *data = reinterpret_cast<const qint16 *>(m_map + m_dataOffset + m_position * m_blockAlign);
+        m_position += frames;
+        return int(frames);
+    }
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(maxFrames);
+#endif
+    return -1;
+}
+
+int WavDecoder::read(qint16 *buffer, int maxFrames)
+{
+    qint64 frames = qMin<qint64>(maxFrames, totalFrames() - m_position);
+    if (frames <= 0) {
+        return 0;
+    }
+
+    const uchar *src = nullptr;
+    if (m_map) {
+        src = m_map + m_dataOffset + m_position * m_blockAlign;
+    } else {
+        int bytes = int(frames) * m_blockAlign;
+        if (m_raw.size() < bytes) {
+            m_raw.resize(bytes);
+        }
+        qint64 got = m_file.read(m_raw.data(), bytes);
+        if (got < 0) {
+            m_errorString = QString("读取失败: %1").arg(m_file.errorString());
+            return -1;
+        }
+        frames = got / m_blockAlign;
+        src = reinterpret_cast<const uchar *>(m_raw.constData());
+    }
+
+    convert(src, buffer, int(frames) * m_format.channels);
+    m_position += frames;
+    return int(frames);
+}
+
+void WavDecoder::convert(const uchar *src, qint16 *buffer, int samples) const
+{
+    switch (m_bitsPerSample) {
+    case 8:
+        // 8 位 WAV 为无符号
+        for (int i = 0; i < samples; ++i) {
+            buffer[i] = qint16((int(src[i]) - 128) << 8);
+        }
+        break;
+    case 16:
+        for (int i = 0; i < samples; ++i) {
+            buffer[i] = qFromLittleEndian<qint16>(src + i * 2);
+        }
+        break;
+    case 24:
+        // 取高 16 位
+        for (int i = 0; i < samples; ++i) {
+            buffer[i] = qint16(src[i * 3 + 1] | (src[i * 3 + 2] << 8));
+        }
+        break;
+    case 32:
+        if (m_isFloat) {
+            for (int i = 0; i < samples; ++i) {
+                quint32 bits = qFromLittleEndian<quint32>(src + i * 4);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                value = qBound(-1.0f, value, 1.0f);
+                buffer[i] = qint16(value * 32767.0f);
+            }
+        } else {
+            for (int i = 0; i < samples; ++i) {
+                buffer[i] = qint16(qFromLittleEndian<qint32>(src + i * 4) >> 16);
+            }
+        }
+        break;
+    }
+}
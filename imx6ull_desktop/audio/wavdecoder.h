@@ -0,0 +1,53 @@
+#ifndef WAVDECODER_H
+#define WAVDECODER_H
+
+#include "audiodecoder.h"
+#include <QFile>
+#include <QByteArray>
+
+/**
+ * @brief RIFF/WAVE 解码器
+ *
+ * 支持 8/16/24/32 位整数 PCM 与 32 位浮点（含 WAVE_FORMAT_EXTENSIBLE），统一转换为 S16。
+ *
+ * 默认把整个文件映射到内存：转换直接从映射区读取，不经过 read() 的内核复制；
+ * 16 位 PCM 不需要转换，readDirect() 直接返回映射区中的数据。
+ * 映射失败（例如超出 32 位地址空间）时退回按块读取。
+ */
+class WavDecoder : public AudioDecoder
+{
+public:
+    WavDecoder();
+    ~WavDecoder() override;
+
+    bool open(const QString &path) override;
+    AudioFormat format() const override { return m_format; }
+    qint64 totalFrames() const override;
+    int read(qint16 *buffer, int maxFrames) override;
+    int readDirect(const qint16 **data, int maxFrames) override;
+    bool seek(qint64 frame) override;
+
+    // 是否使用内存映射，在 open() 之前设置（基准测试用于对比两种方式）
+    void setMemoryMapEnabled(bool enabled) { m_memoryMapEnabled = enabled; }
+    bool isMemoryMapped() const { return m_map != nullptr; }
+
+private:
+    bool parseHeader();
+    void convert(const uchar *src, qint16 *buffer, int samples) const;
+    void unmap();
+
+private:
+    QFile m_file;
+    AudioFormat m_format;
+    int m_bitsPerSample;
+    int m_blockAlign;       // 每帧字节数
+    bool m_isFloat;
+    qint64 m_dataOffset;    // data 块在文件中的偏移
+    qint64 m_dataSize;      // data 块字节数
+    qint64 m_position;      // 当前帧
+    QByteArray m_raw;       // 原始数据读取缓冲，重复使用（未映射时）
+    bool m_memoryMapEnabled;
+    uchar *m_map;           // 整个文件的只读映射
+};
+
+#endif // WAVDECODER_H
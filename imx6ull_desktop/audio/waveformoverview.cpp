@@ -0,0 +1,196 @@
+#include "waveformoverview.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <cmath>
+#include <cstdlib>
+
+// 缓存文件格式
+static const quint32 kCacheMagic = 0x5746564F;     // "WFVO"
+static const quint32 kCacheVersion = 1;
+
+// 8 位量化：|-32768| 也算满幅
+static int quantize(double amplitude)
+{
+    return qBound(0, int(amplitude * 255.0 / 32768.0 + 0.5), 255);
+}
+
+WaveformOverview::WaveformOverview()
+    : m_channels(0)
+    , m_blockFrames(kInitialBlockFrames)
+    , m_framesInBlock(0)
+{
+}
+
+void WaveformOverview::begin(int channels)
+{
+    m_channels = qMax(1, channels);
+    m_blockFrames = kInitialBlockFrames;
+    m_framesInBlock = 0;
+    m_current = Block();
+    m_blocks.clear();
+    m_blocks.reserve(kMaxBlocks);
+    m_peaks.clear();
+    m_rms.clear();
+}
+
+void WaveformOverview::process(const qint16 *samples, int frames)
+{
+    while (frames > 0) {
+        int count = int(qMin<qint64>(frames, m_blockFrames - m_framesInBlock));
+        int peak = m_current.peak;
+        qint64 sumSquares = 0;
+        int total = count * m_channels;
+        for (int i = 0; i < total; ++i) {
+            int value = samples[i];
+            peak = qMax(peak, std::abs(value));
+            sumSquares += value * value;
+        }
+        m_current.peak = peak;
+        m_current.sumSquares += sumSquares;
+        m_current.samples += total;
+
+        samples += total;
+        frames -= count;
+        m_framesInBlock += count;
+        if (m_framesInBlock >= m_blockFrames) {
+            closeBlock();
+        }
+    }
+}
+
+void WaveformOverview::closeBlock()
+{
+    if (m_current.samples > 0) {
+        m_blocks.append(m_current);
+    }
+    m_current = Block();
+    m_framesInBlock = 0;
+
+    // 块数到上限：相邻两块合并，之后的块长加倍
+    if (m_blocks.size() >= kMaxBlocks) {
+        int half = m_blocks.size() / 2;
+        for (int i = 0; i < half; ++i) {
+            const Block &a = m_blocks[2 * i];
+            const Block &b = m_blocks[2 * i + 1];
+            Block merged;
+            merged.peak = qMax(a.peak, b.peak);
+            merged.sumSquares = a.sumSquares + b.sumSquares;
+            merged.samples = a.samples + b.samples;
+            m_blocks[i] = merged;
+        }
+        if (m_blocks.size() % 2) {
+            m_blocks[half] = m_blocks.last();
+            ++half;
+        }
+        m_blocks.resize(half);
+        m_blockFrames *= 2;
+    }
+}
+
+void WaveformOverview::finish()
+{
+    closeBlock();
+    m_peaks.clear();
+    m_rms.clear();
+    int count = m_blocks.size();
+    if (count == 0) {
+        return;
+    }
+
+    // 块数不足 kBuckets 时（很短的曲目）相邻几段取同一块
+    m_peaks.resize(kBuckets);
+    m_rms.resize(kBuckets);
+    for (int i = 0; i < kBuckets; ++i) {
+        int from = i * count / kBuckets;
+        int to = qMax(from + 1, (i + 1) * count / kBuckets);
+        Block bucket;
+        for (int j = from; j < to; ++j) {
+            bucket.peak = qMax(bucket.peak, m_blocks[j].peak);
+            bucket.sumSquares += m_blocks[j].sumSquares;
+            bucket.samples += m_blocks[j].samples;
+        }
+        m_peaks[i] = quint8(quantize(bucket.peak));
+        m_rms[i] = quint8(quantize(std::sqrt(double(bucket.sumSquares) / bucket.samples)));
+    }
+
+    m_blocks.clear();
+    m_blocks.squeeze();
+}
+
+int WaveformOverview::maxPeak() const
+{
+    int result = 0;
+    for (int i = 0; i < m_peaks.size(); ++i) {
+        result = qMax(result, int(m_peaks[i]));
+    }
+    return result;
+}
+
+QString WaveformOverview::cacheFile(const QString &path)
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/waveform";
+    QByteArray hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return dir + "/" + QString::fromLatin1(hash) + ".wfm";
+}
+
+bool WaveformOverview::isCached(const QString &path)
+{
+    return QFile::exists(cacheFile(path));
+}
+
+bool WaveformOverview::load(const QString &path)
+{
+    m_peaks.clear();
+    m_rms.clear();
+    QFileInfo info(path);
+    QFile file(cacheFile(path));
+    if (!info.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version;
+    qint64 mtime, size;
+    in >> magic >> version;
+    if (magic != kCacheMagic || version != kCacheVersion) {
+        return false;
+    }
+    in >> mtime >> size;
+    if (mtime != info.lastModified().toSecsSinceEpoch() || size != info.size()) {
+        return false;   // 文件已修改，需要重新生成
+    }
+
+    QVector<quint8> peaks, rms;
+    in >> peaks >> rms;
+    if (in.status() != QDataStream::Ok || peaks.size() != kBuckets || rms.size() != kBuckets) {
+        return false;
+    }
+    m_peaks = peaks;
+    m_rms = rms;
+    return true;
+}
+
+bool WaveformOverview::save(const QString &path) const
+{
+    QFileInfo info(path);
+    QString file = cacheFile(path);
+    QDir().mkpath(QFileInfo(file).path());
+
+    QSaveFile out(file);
+    if (!out.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << kCacheMagic << kCacheVersion
+           << qint64(info.lastModified().toSecsSinceEpoch()) << qint64(info.size())
+           << m_peaks << m_rms;
+    return stream.status() == QDataStream::Ok && out.commit();
+}
@@ -0,0 +1,79 @@
+#ifndef WAVEFORMOVERVIEW_H
+#define WAVEFORMOVERVIEW_H
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 整首曲目的波形概览（进度条背景）
+ *
+ * 把曲目等分为 kBuckets 段，每段记录样本峰值与均方根，各量化为 8 位（满幅为 255），
+ * 整首曲目只有几百字节。
+ *
+ * 计算时总长度可以未知：先按 kInitialBlockFrames 帧一块累加，块数达到 kMaxBlocks
+ * 时相邻两块合并、块长加倍，内存与曲目长度无关；finish() 再把各块分到 kBuckets 段。
+ *
+ * 结果按路径的 SHA-1 保存在缓存目录下，文件修改时间或大小变化后失效。
+ * 整首曲目要解码一遍，只在后台进行（LoudnessAnalyzer 分析曲目时顺便生成）。
+ *
+ * 只在一个线程中使用，不是线程安全的。
+ */
+class WaveformOverview
+{
+public:
+    static const int kBuckets = 256;
+
+    WaveformOverview();
+
+    // 开始累加一首曲目
+    void begin(int channels);
+
+    // 处理 frames 帧交错样本，可多次调用
+    void process(const qint16 *samples, int frames);
+
+    // 结束累加，生成各段的峰值与均方根
+    void finish();
+
+    bool isEmpty() const { return m_peaks.isEmpty(); }
+    int size() const { return m_peaks.size(); }
+
+    // 第 index 段的峰值与均方根，0 ~ 255
+    int peak(int index) const { return m_peaks[index]; }
+    int rms(int index) const { return m_rms[index]; }
+
+    // 所有段中最大的峰值，绘制时据此归一化
+    int maxPeak() const;
+
+    // 读取缓存，没有缓存或文件已变化时返回 false
+    bool load(const QString &path);
+
+    // 写入缓存
+    bool save(const QString &path) const;
+
+    // 只检查缓存文件是否存在，不读取内容
+    static bool isCached(const QString &path);
+
+private:
+    static const int kInitialBlockFrames = 256;
+    static const int kMaxBlocks = kBuckets * 4;
+
+    struct Block {
+        int peak = 0;
+        qint64 sumSquares = 0;
+        qint64 samples = 0;
+    };
+
+    void closeBlock();
+    static QString cacheFile(const QString &path);
+
+    int m_channels;
+    qint64 m_blockFrames;           // 当前的块长
+    qint64 m_framesInBlock;
+    Block m_current;
+    QVector<Block> m_blocks;
+
+    QVector<quint8> m_peaks;
+    QVector<quint8> m_rms;
+};
+
+#endif // WAVEFORMOVERVIEW_H
@@ -1,49 +1,88 @@
 #include "cdwidget.h"
+#include "boardclock.h"
+#include <QMouseEvent>
+#include <cmath>
+
+// 旋转速度：每秒 60 度（原先每 50ms 3 度）
+static const qreal kDegreesPerSecond = 60.0;
 
 CDWidget::CDWidget(QWidget *parent)
     : QWidget(parent)
+    , m_clock(BoardClock::instance())
     , m_rotationTimer(nullptr)
     , m_rotationAngle(0)
+    , m_rotationStartNs(0)
     , m_isRotating(false)
 {
     // 加载CD图片
     m_cdImage.load(":/image/cd.png");
     
-    // 初始化旋转定时器
-    m_rotationTimer = new QTimer(this);
-    connect(m_rotationTimer, &QTimer::timeout, this, &CDWidget::rotateCD);
+    // 每50ms请求一次重绘；角度按时间计算，重绘延迟不会让转速漂移。
+    // 上一次重绘请求尚未处理时不再重复投递
+    m_rotationTimer = m_clock->createTimer("cd-rotation", this);
+    connect(m_rotationTimer, &BoardTimer::timeout, this, [this](qint64 deadlineNs) {
+        Q_UNUSED(deadlineNs);
+        if (m_repaintPending.testAndSetOrdered(0, 1)) {
+            QMetaObject::invokeMethod(this, "rotateCD", Qt::QueuedConnection);
+        }
+    }, Qt::DirectConnection);
     
     // 设置固定大小
     setFixedSize(280, 280);
 }
 
+CDWidget::~CDWidget()
+{
+    stopRotation();
+}
+
 void CDWidget::startRotation()
 {
+    if (m_isRotating) {
+        return;
+    }
     m_isRotating = true;
-    m_rotationTimer->start(50); // 每50ms旋转一次
+    m_rotationStartNs = m_clock->nowNs();
+    m_rotationTimer->start(50 * 1000000LL);
 }
 
 void CDWidget::stopRotation()
 {
-    m_isRotating = false;
     m_rotationTimer->stop();
+    if (m_isRotating) {
+        m_rotationAngle = currentAngle();
+        m_isRotating = false;
+    }
 }
 
 void CDWidget::resetRotation()
 {
-    m_isRotating = false;
-    m_rotationTimer->stop();
+    stopRotation();
     m_rotationAngle = 0;
     update();
 }
 
+void CDWidget::setCover(const QImage &cover)
+{
+    if (cover.isNull() && m_cover.isNull()) {
+        return;
+    }
+    m_cover = cover;
+    update();
+}
+
+qreal CDWidget::currentAngle() const
+{
+    if (!m_isRotating) {
+        return m_rotationAngle;
+    }
+    qreal elapsed = (m_clock->nowNs() - m_rotationStartNs) / 1e9;
+    return std::fmod(m_rotationAngle + elapsed * kDegreesPerSecond, 360.0);
+}
+
 void CDWidget::rotateCD()
 {
-    // 每次增加角度
-    if (m_rotationAngle >= 360)
-        m_rotationAngle = 0;
-    
-    m_rotationAngle += 3; // 每次旋转3度
+    m_repaintPending.storeRelease(0);
     
     // 触发重绘
     update();
@@ -53,7 +92,7 @@ void CDWidget::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event);
     
-    if (m_cdImage.isNull()) {
+    if (m_cdImage.isNull() && m_cover.isNull()) {
         return;
     }
     
@@ -69,11 +108,23 @@ void CDWidget::paintEvent(QPaintEvent *event)
     painter.translate(rect.width() / 2, rect.height() / 2);
     
     // 旋转
-    painter.rotate(m_rotationAngle);
+    painter.rotate(currentAngle());
     
     // 恢复坐标系
     painter.translate(-rect.width() / 2, -rect.height() / 2);
     
-    // 绘制CD图片
-    painter.drawPixmap(rect.toRect(), m_cdImage);
+    // 绘制封面或CD图片；封面已按控件大小解码，旋转之外无需缩放
+    if (!m_cover.isNull()) {
+        painter.drawImage(QPointF(0, 0), m_cover);
+    } else {
+        painter.drawPixmap(rect.toRect(), m_cdImage);
+    }
+}
+
+void CDWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (rect().contains(event->pos())) {
+        emit clicked();
+    }
+    QWidget::mouseReleaseEvent(event);
 }
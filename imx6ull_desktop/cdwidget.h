@@ -4,7 +4,11 @@
 #include <QWidget>
 #include <QPainter>
 #include <QPixmap>
-#include <QTimer>
+#include <QImage>
+#include <QAtomicInt>
+
+class BoardClock;
+class BoardTimer;
 
 class CDWidget : public QWidget
 {
@@ -12,22 +16,37 @@ class CDWidget : public QWidget
 
 public:
     explicit CDWidget(QWidget *parent = nullptr);
+    ~CDWidget();
     
     void startRotation();
     void stopRotation();
     void resetRotation();
+    
+    // 显示曲目封面（已裁成圆形的缩略图），空图像时显示默认的 CD 图片
+    void setCover(const QImage &cover);
+
+signals:
+    void clicked();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
 
 private slots:
     void rotateCD();
 
 private:
-    QTimer *m_rotationTimer;
-    int m_rotationAngle;
+    qreal currentAngle() const;
+
+private:
+    BoardClock *m_clock;
+    BoardTimer *m_rotationTimer;
+    QAtomicInt m_repaintPending;
+    qreal m_rotationAngle;      // 停止时的角度
+    qint64 m_rotationStartNs;   // 开始旋转的单调时钟时刻
     bool m_isRotating;
     QPixmap m_cdImage;
+    QImage m_cover;
 };
 
 #endif // CDWIDGET_H
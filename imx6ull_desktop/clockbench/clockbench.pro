@@ -0,0 +1,26 @@
+# 仿真时钟回放（命令行）：用 SimulatedClock 在几秒内跑完数小时的采样、空闲检测与进度节拍
+# 只依赖 QtCore，不编入 imx6ull_desktop；在主机上 qmake && make 后运行 ./clockbench [小时数]
+
+QT       = core
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 传感器采样器与应用共用同一份源码
+INCLUDEPATH += $$PWD/..
+
+SOURCES += \
+    main.cpp \
+    clockbenchmark.cpp \
+    idlemonitor.cpp \
+    ../sensorsampler.cpp
+
+HEADERS += \
+    clockbenchmark.h \
+    idlemonitor.h \
+    ../sensorsampler.h
+
+# 板级 I/O 公共库（调度器与时钟）
+include(../../boardio/boardio.pri)
@@ -0,0 +1,219 @@
+#include "clockbenchmark.h"
+#include "boardclock.h"
+#include "sensorsampler.h"
+#include "idlemonitor.h"
+#include <QTextStream>
+#include <QElapsedTimer>
+
+static const qint64 kNsPerSecond = 1000000000LL;
+
+// 与传感器页面、主界面、音乐进度条相同的参数
+static const qint64 kSamplePeriodNs = 500 * 1000000LL;
+static const qint64 kIdleTimeoutNs = 5 * 60 * kNsPerSecond;
+static const qint64 kIdleCheckNs = kNsPerSecond;
+static const qint64 kProgressPeriodNs = 40 * 1000000LL;
+
+// 空闲场景：每轮先有 10 分钟每 30 秒一次输入，再 10 分钟无输入
+static const qint64 kActivePhaseNs = 10 * 60 * kNsPerSecond;
+static const qint64 kIdlePhaseNs = 10 * 60 * kNsPerSecond;
+static const qint64 kActivityIntervalNs = 30 * kNsPerSecond;
+
+// 注入的数据源每隔这么多次失败一次
+static const int kFailEvery = 97;
+
+// 仿真时间从一个非零值开始，避免把 0 当作特殊值的错误被掩盖
+static const qint64 kStartNs = 1000 * kNsPerSecond;
+
+/**
+ * @brief 检查结果汇总
+ */
+class Checker
+{
+public:
+    explicit Checker(QTextStream &out) : m_out(out), m_failures(0) {}
+
+    void expect(bool ok, const QString &what)
+    {
+        m_out << QString("  [%1] %2\n").arg(ok ? "通过" : "失败", what);
+        if (!ok) {
+            ++m_failures;
+        }
+    }
+
+    int failures() const { return m_failures; }
+
+private:
+    QTextStream &m_out;
+    int m_failures;
+};
+
+/**
+ * @brief 进度节拍的接收者：timeout 按队列投递过来，在主线程中处理
+ */
+class TickReceiver : public QObject
+{
+public:
+    TickReceiver(BoardClock *clock, BoardTimer *timer)
+        : m_clock(clock)
+        , m_ticks(0)
+        , m_lastDeadlineNs(-1)
+        , m_badSpacing(0)
+        , m_late(0)
+    {
+        connect(timer, &BoardTimer::timeout, this, [this](qint64 deadlineNs) {
+            if (m_lastDeadlineNs >= 0 && deadlineNs - m_lastDeadlineNs != kProgressPeriodNs) {
+                ++m_badSpacing;
+            }
+            // 仿真时钟在同一时刻处理完投递的事件，处理时间应等于截止时间
+            if (m_clock->nowNs() != deadlineNs) {
+                ++m_late;
+            }
+            m_lastDeadlineNs = deadlineNs;
+            ++m_ticks;
+        }, Qt::QueuedConnection);
+    }
+
+    BoardClock *m_clock;
+    quint64 m_ticks;
+    qint64 m_lastDeadlineNs;
+    quint64 m_badSpacing;
+    quint64 m_late;
+};
+
+int ClockBenchmark::run(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    bool ok = true;
+    int hours = arguments.isEmpty() ? 8 : arguments.value(0).toInt(&ok);
+    if (!ok || hours <= 0) {
+        out << QString("用法: clockbench [小时数，默认 8]\n");
+        return 2;
+    }
+
+    // 各子系统创建时从 BoardClock::instance() 取时钟，必须先替换
+    SimulatedClock clock(kStartNs);
+    BoardClock::setInstance(&clock);
+    Checker check(out);
+    qint64 durationNs = qint64(hours) * 3600 * kNsPerSecond;
+    qint64 endNs = kStartNs + durationNs;
+
+    // ---- 传感器采样 ----
+    SensorSampler sampler;
+    quint64 sourceCalls = 0;
+    quint64 samples = 0;
+    quint64 failures = 0;
+    quint64 badSpacing = 0;
+    quint64 notAtDeadline = 0;
+    qint64 lastSampleNs = -1;
+    sampler.setSource([&sourceCalls](int &raw, float &scale) {
+        ++sourceCalls;
+        raw = int(sourceCalls % 4096);
+        scale = 0.805664f;
+        return sourceCalls % kFailEvery != 0;
+    });
+    auto onSample = [&](qint64 sampleNs) {
+        if (lastSampleNs >= 0 && sampleNs - lastSampleNs != kSamplePeriodNs) {
+            ++badSpacing;
+        }
+        if (sampleNs != clock.nowNs()) {
+            ++notAtDeadline;
+        }
+        lastSampleNs = sampleNs;
+    };
+    QObject::connect(&sampler, &SensorSampler::sampleReady,
+                     [&](qint64 sampleNs, int, float, float) { ++samples; onSample(sampleNs); });
+    QObject::connect(&sampler, &SensorSampler::sampleFailed,
+                     [&](qint64 sampleNs) { ++failures; onSample(sampleNs); });
+
+    // ---- 空闲检测 ----
+    IdleMonitor monitor(kIdleTimeoutNs);
+    qint64 lastActivityNs = clock.nowNs();
+    quint64 idleEntries = 0;
+    quint64 idleExits = 0;
+    quint64 badIdleOnset = 0;
+    qint64 worstOnsetNs = 0;
+    QObject::connect(&monitor, &IdleMonitor::idleChanged, [&](bool idle) {
+        if (!idle) {
+            ++idleExits;
+            return;
+        }
+        ++idleEntries;
+        qint64 onsetNs = clock.nowNs() - lastActivityNs;
+        worstOnsetNs = qMax(worstOnsetNs, onsetNs);
+        if (onsetNs < kIdleTimeoutNs || onsetNs > kIdleTimeoutNs + kIdleCheckNs) {
+            ++badIdleOnset;
+        }
+    });
+
+    // ---- 进度节拍 ----
+    BoardTimer *progressTimer = clock.createTimer("music-progress");
+    TickReceiver receiver(&clock, progressTimer);
+
+    QElapsedTimer wall;
+    wall.start();
+    sampler.start(kSamplePeriodNs);
+    progressTimer->start(kProgressPeriodNs);
+
+    quint64 fired = 0;
+    quint64 cycles = 0;
+    bool idleDuringActivity = false;
+    for (qint64 cycleNs = kStartNs; cycleNs < endNs; cycleNs += kActivePhaseNs + kIdlePhaseNs) {
+        ++cycles;
+        for (qint64 t = cycleNs; t < cycleNs + kActivePhaseNs && t < endNs; t += kActivityIntervalNs) {
+            fired += clock.advanceTo(t);
+            // 有输入期间输入间隔远小于超时，不应进入空闲（每轮第一次输入前除外）
+            if (t != cycleNs && monitor.isIdle()) {
+                idleDuringActivity = true;
+            }
+            monitor.reportActivity();
+            lastActivityNs = clock.nowNs();
+        }
+    }
+    fired += clock.advanceTo(endNs);
+    qint64 wallMs = wall.elapsed();
+
+    sampler.stop();
+    progressTimer->stop();
+
+    quint64 periods = quint64(durationNs / kSamplePeriodNs);
+    quint64 progressTicks = quint64(durationNs / kProgressPeriodNs);
+    out << QString("仿真 %1 小时，触发定时器 %2 次，墙钟耗时 %3 ms（%4 倍速）\n")
+           .arg(hours).arg(fired).arg(wallMs)
+           .arg(wallMs > 0 ? durationNs / 1000000 / wallMs : 0);
+
+    out << QString("传感器采样: 成功 %1 次，失败 %2 次\n").arg(samples).arg(failures);
+    // start() 立即采一次，之后每个周期一次
+    check.expect(sourceCalls == periods + 1,
+                 QString("读取数据源 %1 次，应为 %2").arg(sourceCalls).arg(periods + 1));
+    check.expect(failures == sourceCalls / kFailEvery,
+                 QString("失败 %1 次，应为 %2").arg(failures).arg(sourceCalls / kFailEvery));
+    check.expect(samples + failures == sourceCalls, "每次读取都有且只有一个结果");
+    check.expect(badSpacing == 0, QString("相邻采样时刻间隔不等于周期: %1 次").arg(badSpacing));
+    check.expect(notAtDeadline == 0, QString("采样时刻与当时的时钟不符: %1 次").arg(notAtDeadline));
+    check.expect(sampler.timingStats().runs == periods,
+                 QString("定时器统计 %1 次，应为 %2").arg(sampler.timingStats().runs).arg(periods));
+
+    out << QString("空闲检测: 进入空闲 %1 次，恢复 %2 次，最长在输入后 %3 秒进入空闲\n")
+           .arg(idleEntries).arg(idleExits).arg(worstOnsetNs / double(kNsPerSecond), 0, 'f', 1);
+    // 每轮的无输入阶段进入一次空闲，下一轮第一次输入时恢复
+    check.expect(idleEntries == cycles, QString("进入空闲 %1 次，应为 %2").arg(idleEntries).arg(cycles));
+    check.expect(idleExits == cycles - 1, QString("恢复 %1 次，应为 %2").arg(idleExits).arg(cycles - 1));
+    check.expect(badIdleOnset == 0,
+                 QString("进入空闲的时刻超出 [超时, 超时 + 1 秒]: %1 次").arg(badIdleOnset));
+    check.expect(!idleDuringActivity, "有输入期间没有进入空闲");
+
+    out << QString("进度节拍: %1 次\n").arg(receiver.m_ticks);
+    check.expect(receiver.m_ticks == progressTicks,
+                 QString("节拍 %1 次，应为 %2").arg(receiver.m_ticks).arg(progressTicks));
+    check.expect(receiver.m_badSpacing == 0,
+                 QString("相邻节拍间隔不等于周期: %1 次").arg(receiver.m_badSpacing));
+    check.expect(receiver.m_late == 0,
+                 QString("投递的节拍没有在截止时刻处理: %1 次").arg(receiver.m_late));
+
+    delete progressTimer;
+    BoardClock::setInstance(nullptr);
+
+    out << (check.failures() == 0 ? QString("全部通过\n")
+                                  : QString("%1 项失败\n").arg(check.failures()));
+    return check.failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+#ifndef CLOCKBENCHMARK_H
+#define CLOCKBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @brief 用仿真时钟回放定时管线（命令行，不启动界面，主机上即可运行）
+ *
+ *   clockbench [小时数]
+ *
+ * 独立的命令行程序（clockbench.pro），不编入 imx6ull_desktop；IdleMonitor 目前只有这里使用，
+ * 随之一起放在这个目录下。
+ *
+ * 把 SimulatedClock 通过 BoardClock::setInstance() 注入，在几秒内跑完数小时：
+ * - SensorSampler 按传感器页面的 500ms 周期采样（注入的数据源定期失败），
+ *   检查采样与失败次数、采样时刻间隔恰为一个周期且等于当时的时钟
+ * - IdleMonitor 交替经历 10 分钟有输入、10 分钟无输入，检查每次进入空闲的时刻
+ *   落在最后一次输入后 [超时, 超时 + 检查周期] 之内，以及空闲/恢复的次数
+ * - 40ms 的进度节拍经队列投递到接收者，检查节拍数以及在截止时刻被处理
+ *
+ * 输出各项计数与墙钟耗时，全部检查通过时返回 0。
+ */
+class ClockBenchmark
+{
+public:
+    static int run(const QStringList &arguments);
+};
+
+#endif // CLOCKBENCHMARK_H
@@ -0,0 +1,61 @@
+#include "idlemonitor.h"
+#include "boardclock.h"
+#include <QEvent>
+#include <QDebug>
+
+IdleMonitor::IdleMonitor(qint64 timeoutNs, BoardClock *clock, QObject *parent)
+    : QObject(parent)
+    , m_clock(clock ? clock : BoardClock::instance())
+    , m_checkTimer(nullptr)
+    , m_timeoutNs(timeoutNs)
+    , m_lastActivityNs(0)
+    , m_idle(false)
+{
+    m_lastActivityNs = m_clock->nowNs();
+
+    // 每秒检查一次，timeout 按队列投递到本对象所在线程
+    m_checkTimer = m_clock->createTimer("idle-check", this);
+    connect(m_checkTimer, &BoardTimer::timeout, this, &IdleMonitor::checkIdle);
+    m_checkTimer->start(1000 * 1000000LL);
+}
+
+qint64 IdleMonitor::idleNs() const
+{
+    return m_clock->nowNs() - m_lastActivityNs;
+}
+
+void IdleMonitor::reportActivity()
+{
+    m_lastActivityNs = m_clock->nowNs();
+
+    if (m_idle) {
+        m_idle = false;
+        qDebug() << "User active again";
+        emit idleChanged(false);
+    }
+}
+
+bool IdleMonitor::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+        reportActivity();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void IdleMonitor::checkIdle()
+{
+    if (!m_idle && idleNs() >= m_timeoutNs) {
+        m_idle = true;
+        qDebug() << "User idle for" << idleNs() / 1000000000LL << "s";
+        emit idleChanged(true);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef IDLEMONITOR_H
+#define IDLEMONITOR_H
+
+#include <QObject>
+
+class QEvent;
+class BoardClock;
+class BoardTimer;
+
+// 空闲检测：一段时间内没有触摸/按键输入时发出 idleChanged(true)
+class IdleMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IdleMonitor(qint64 timeoutNs, BoardClock *clock = nullptr, QObject *parent = nullptr);
+
+    bool isIdle() const { return m_idle; }
+    qint64 idleNs() const;
+
+    // 记录一次用户活动（事件过滤器会自动调用）
+    void reportActivity();
+
+signals:
+    void idleChanged(bool idle);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void checkIdle();
+
+private:
+    BoardClock *m_clock;
+    BoardTimer *m_checkTimer;
+    qint64 m_timeoutNs;
+    qint64 m_lastActivityNs;
+    bool m_idle;
+};
+
+#endif // IDLEMONITOR_H
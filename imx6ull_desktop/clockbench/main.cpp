@@ -0,0 +1,10 @@
+#include "clockbenchmark.h"
+
+#include <QCoreApplication>
+
+int main(int argc, char *argv[])
+{
+    // 仿真时钟回放，只用命令行，主机上即可运行
+    QCoreApplication app(argc, argv);
+    return ClockBenchmark::run(app.arguments().mid(1));
+}
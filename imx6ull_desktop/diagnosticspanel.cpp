@@ -0,0 +1,261 @@
+#include "diagnosticspanel.h"
+#include "audioengine.h"
+#include "loudnessanalyzer.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QDir>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QDebug>
+
+static const int kRefreshMs = 500;
+static const int kShownGlitches = 4;
+
+// 一个分布的柱状图：柱高按最大的桶归一化，下方标出各桶上界
+class HistogramView : public QWidget
+{
+public:
+    explicit HistogramView(AudioDiagnostics::Histogram histogram, QWidget *parent = nullptr)
+        : QWidget(parent)
+        , m_histogram(histogram)
+        , m_max(0)
+    {
+        setFixedHeight(72);
+        for (int i = 0; i < AudioDiagnostics::kBuckets; ++i) {
+            m_counts[i] = 0;
+        }
+    }
+
+    void setData(const quint32 *counts, qint64 maxValue)
+    {
+        for (int i = 0; i < AudioDiagnostics::kBuckets; ++i) {
+            m_counts[i] = counts[i];
+        }
+        m_max = maxValue;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event);
+
+        QPainter painter(this);
+        QFont font = painter.font();
+        font.setPixelSize(11);
+        painter.setFont(font);
+
+        quint64 total = 0;
+        quint32 peak = 1;
+        for (int i = 0; i < AudioDiagnostics::kBuckets; ++i) {
+            total += m_counts[i];
+            peak = qMax(peak, m_counts[i]);
+        }
+
+        const int titleHeight = 16;
+        const int labelHeight = 14;
+        painter.setPen(QColor(51, 51, 51));
+        painter.drawText(QRect(0, 0, width(), titleHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString("%1  样本 %2  最大 %3")
+                         .arg(AudioDiagnostics::histogramLabel(m_histogram)).arg(total).arg(m_max));
+
+        int buckets = AudioDiagnostics::kBuckets;
+        qreal slot = qreal(width()) / buckets;
+        int barTop = titleHeight + 2;
+        int barBottom = height() - labelHeight;
+        for (int i = 0; i < buckets; ++i) {
+            qreal h = qreal(barBottom - barTop) * m_counts[i] / peak;
+            QRectF bar(i * slot + 2, barBottom - h, slot - 4, h);
+            painter.fillRect(bar, i == buckets - 1 ? QColor(245, 87, 108) : QColor(118, 75, 162));
+
+            qint64 bound = AudioDiagnostics::bucketBound(m_histogram, i);
+            QString label = bound >= 0 ? QString::number(bound)
+                                       : QString(">%1").arg(AudioDiagnostics::bucketBound(m_histogram, i - 1));
+            painter.drawText(QRectF(i * slot, barBottom, slot, labelHeight), Qt::AlignCenter, label);
+        }
+    }
+
+private:
+    AudioDiagnostics::Histogram m_histogram;
+    quint32 m_counts[AudioDiagnostics::kBuckets];
+    qint64 m_max;
+};
+
+DiagnosticsPanel::DiagnosticsPanel(AudioEngine *engine, QWidget *parent)
+    : QWidget(parent)
+    , m_engine(engine)
+{
+    setupUI();
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(kRefreshMs);
+    connect(m_refreshTimer, &QTimer::timeout, this, &DiagnosticsPanel::refresh);
+}
+
+void DiagnosticsPanel::setupUI()
+{
+    setObjectName("diagnosticsPanel");
+    setAttribute(Qt::WA_StyledBackground, true);
+    setStyleSheet(
+        "#diagnosticsPanel { background: rgba(255, 255, 255, 0.96); border-radius: 10px; }"
+        "QLabel { color: #333; font-size: 12px; }"
+        "QPushButton { background: #667eea; color: white; border: none; border-radius: 5px;"
+        "              font-size: 13px; padding: 6px 14px; }"
+        "QPushButton:pressed { background: #764ba2; }");
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(16, 12, 16, 12);
+    layout->setSpacing(6);
+
+    QLabel *title = new QLabel("播放诊断", this);
+    title->setStyleSheet("font-size: 16px; font-weight: bold;");
+
+    m_countersLabel = new QLabel(this);
+    m_countersLabel->setWordWrap(true);
+
+    for (int h = 0; h < AudioDiagnostics::HistogramCount; ++h) {
+        m_histograms.append(new HistogramView(AudioDiagnostics::Histogram(h), this));
+    }
+
+    m_glitchesLabel = new QLabel(this);
+    m_glitchesLabel->setWordWrap(true);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setStyleSheet("color: #888; font-size: 11px;");
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    m_resetButton = new QPushButton("清零", this);
+    m_exportButton = new QPushButton("导出", this);
+    m_closeButton = new QPushButton("关闭", this);
+    connect(m_resetButton, &QPushButton::clicked, this, &DiagnosticsPanel::onResetClicked);
+    connect(m_exportButton, &QPushButton::clicked, this, &DiagnosticsPanel::onExportClicked);
+    connect(m_closeButton, &QPushButton::clicked, this, &QWidget::hide);
+    buttons->addWidget(m_resetButton);
+    buttons->addWidget(m_exportButton);
+    buttons->addStretch();
+    buttons->addWidget(m_closeButton);
+
+    layout->addWidget(title);
+    layout->addWidget(m_countersLabel);
+    for (HistogramView *view : m_histograms) {
+        layout->addWidget(view);
+    }
+    layout->addWidget(m_glitchesLabel);
+    layout->addStretch();
+    layout->addWidget(m_statusLabel);
+    layout->addLayout(buttons);
+}
+
+void DiagnosticsPanel::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    m_refreshTimer->start();
+}
+
+void DiagnosticsPanel::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer->stop();
+    QWidget::hideEvent(event);
+}
+
+void DiagnosticsPanel::refresh()
+{
+    AudioDiagnostics::Snapshot s = m_engine->diagnostics()->snapshot();
+    const quint64 *c = s.counters;
+
+    // 解码负载：解码耗时相对于解码出的音频时长
+    int rate = m_engine->playbackClock().snapshot().sampleRate;
+    double audioNs = rate > 0 ? c[AudioDiagnostics::DecodedFrames] * 1e9 / rate : 0.0;
+    auto percent = [audioNs](quint64 ns) {
+        return audioNs > 0 ? QString::number(ns * 100.0 / audioNs, 'f', 1) : QString("-");
+    };
+
+    QString counters = QString(
+        "统计 %1 s，写入 %2 个周期\n"
+        "设备欠载 %3（解码 %4 / I/O %5 / 调度 %6），缓冲区取空 %7，挂起 %8，超时 %9\n"
+        "解码 %10 块，耗时占音频时长 %11%（运行 %12%，等待 CPU %13%）")
+        .arg(s.elapsedNs / 1000000000LL)
+        .arg(c[AudioDiagnostics::PeriodsWritten])
+        .arg(c[AudioDiagnostics::DeviceUnderruns])
+        .arg(c[AudioDiagnostics::DecodeGlitches])
+        .arg(c[AudioDiagnostics::IoGlitches])
+        .arg(c[AudioDiagnostics::SchedulingGlitches])
+        .arg(c[AudioDiagnostics::RingStarvations])
+        .arg(c[AudioDiagnostics::DeviceSuspends])
+        .arg(c[AudioDiagnostics::DeviceTimeouts])
+        .arg(c[AudioDiagnostics::DecodeChunks])
+        .arg(percent(c[AudioDiagnostics::DecodeWallNs]))
+        .arg(percent(c[AudioDiagnostics::DecodeCpuNs]))
+        .arg(percent(c[AudioDiagnostics::DecodeRunqueueNs]));
+
+    // 均衡器按频段折算的开销，用于估计还能加多少个频段
+    quint64 bandFrames = c[AudioDiagnostics::EqualizerBandFrames];
+    double bandNs = bandFrames > 0 && rate > 0 ? c[AudioDiagnostics::EqualizerNs] * double(rate) / bandFrames : 0.0;
+    counters += QString("\n均衡器：%1 个频段，每频段每秒音频 %2 us（单核 %3%）")
+            .arg(m_engine->equalizer()->parameters().bandCount)
+            .arg(bandNs / 1000, 0, 'f', 0).arg(bandNs / 1e7, 0, 'f', 2);
+
+    // 后台响度分析的进度与当前允许的 CPU 占空比
+    LoudnessAnalyzer::Stats loudness = LoudnessAnalyzer::instance()->stats();
+    counters += QString("\n响度分析：已有 %1 首，排队 %2 首，本次分析 %3 首（音频 %4 s，耗时 %5 s），占空比 %6%")
+            .arg(loudness.cached).arg(loudness.pending).arg(loudness.analyzed)
+            .arg(loudness.audioMs / 1000).arg(loudness.busyMs / 1000).arg(loudness.sharePercent);
+
+    // 网络流的抖动缓冲：目标随欠载放大、稳定后缩小
+    HttpStream::Status stream;
+    if (m_engine->streamStatus(stream)) {
+        counters += QString("\n网络流：缓冲 %1 / 目标 %2 ms，欠载 %3，重连 %4，接收 %5 kbps，共 %6 KB")
+                .arg(stream.buffer.levelMs).arg(stream.buffer.targetMs)
+                .arg(stream.buffer.underruns).arg(stream.reconnects)
+                .arg(stream.receiveKbps).arg(stream.buffer.bytesIn / 1024);
+    }
+    m_countersLabel->setText(counters);
+
+    for (int h = 0; h < m_histograms.size(); ++h) {
+        m_histograms[h]->setData(s.buckets[h], s.maxValue[h]);
+    }
+
+    // 最近几次欠载，最新的在前
+    QStringList lines;
+    qint64 now = PlaybackClock::nowNs();
+    for (int i = s.glitches.size() - 1; i >= 0 && lines.size() < kShownGlitches; --i) {
+        const AudioDiagnostics::Glitch &g = s.glitches[i];
+        lines << QString("%1 s 前  %2  %3  填充 %4%  迟到 %5 us  解码 %6/%7/%8 us")
+                 .arg((now - g.timestampNs) / 1000000000LL)
+                 .arg(AudioDiagnostics::causeName(g.cause))
+                 .arg(g.ringStarved ? "取空" : "未取空")
+                 .arg(g.ringFillPercent)
+                 .arg(g.outputLateUs)
+                 .arg(g.decodeWallUs).arg(g.decodeCpuUs).arg(g.decodeWaitUs);
+    }
+    m_glitchesLabel->setText(lines.isEmpty() ? QString("没有欠载")
+                                             : "最近欠载（解码：总耗时/运行/等待 CPU）\n" + lines.join('\n'));
+}
+
+void DiagnosticsPanel::onResetClicked()
+{
+    m_engine->diagnostics()->reset();
+    m_statusLabel->clear();
+    refresh();
+}
+
+void DiagnosticsPanel::onExportClicked()
+{
+    // Prometheus 文本格式，可直接交给 node_exporter 的 textfile 收集器
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    QString path = QString("%1/audio-diagnostics-%2.prom")
+            .arg(dir, QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+
+    QByteArray data = m_engine->diagnostics()->exportText().toUtf8();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        m_statusLabel->setText(QString("导出失败：%1").arg(path));
+        return;
+    }
+    m_statusLabel->setText(QString("已导出：%1").arg(path));
+    qDebug() << "DiagnosticsPanel: exported" << path;
+}
@@ -0,0 +1,46 @@
+#ifndef DIAGNOSTICSPANEL_H
+#define DIAGNOSTICSPANEL_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QVector>
+#include "audiodiagnostics.h"
+
+class AudioEngine;
+class HistogramView;
+
+// 播放诊断面板：欠载计数与归因、缓冲区/解码/唤醒分布、最近的故障，可清零和导出
+// 只在显示时每 500ms 取一次快照
+class DiagnosticsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsPanel(AudioEngine *engine, QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void onResetClicked();
+    void onExportClicked();
+
+private:
+    void setupUI();
+
+    AudioEngine *m_engine;
+    QLabel *m_countersLabel;
+    QLabel *m_glitchesLabel;
+    QLabel *m_statusLabel;
+    QVector<HistogramView *> m_histograms;
+    QPushButton *m_resetButton;
+    QPushButton *m_exportButton;
+    QPushButton *m_closeButton;
+    QTimer *m_refreshTimer;
+};
+
+#endif // DIAGNOSTICSPANEL_H
@@ -22,7 +22,16 @@ SOURCES += \
     sliderwidget.cpp \
     appdialog.cpp \
     musicplayer.cpp \
-    cdwidget.cpp
+    playerservice.cpp \
+    cdwidget.cpp \
+    sensorsampler.cpp \
+    pwmgenerator.cpp \
+    playbackqueue.cpp \
+    playlistmodel.cpp \
+    playlistdelegate.cpp \
+    visualizerwidget.cpp \
+    waveformslider.cpp \
+    diagnosticspanel.cpp
 
 HEADERS += \
     mainwindow.h \
@@ -30,11 +39,29 @@ HEADERS += \
     sliderwidget.h \
     appdialog.h \
     musicplayer.h \
-    cdwidget.h
+    playerservice.h \
+    cdwidget.h \
+    sensorsampler.h \
+    pwmgenerator.h \
+    playbackqueue.h \
+    playlistmodel.h \
+    playlistdelegate.h \
+    visualizerwidget.h \
+    waveformslider.h \
+    diagnosticspanel.h
 
 FORMS += \
     mainwindow.ui
 
+# 板级 I/O 公共库（sysfs/设备节点异步访问）
+include(../boardio/boardio.pri)
+
+# 音频播放引擎（ALSA）
+include(audio/audio.pri)
+
+# 音乐库（持久化索引 + inotify 增量更新）
+include(library/library.pri)
+
 RESOURCES += \
     resources.qrc
 
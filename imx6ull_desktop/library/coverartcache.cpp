@@ -0,0 +1,402 @@
+#include "coverartcache.h"
+#include "tagreader.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFileInfo>
+#include <QFile>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include <QPainterPath>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <qmath.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+static const int kWorkerNice = 10;
+
+// 内存中的缩略图总量（KB），约 13 张 280×280 ARGB32
+static const int kMemoryBudgetKb = 4 * 1024;
+
+// 排队上限，超出时丢弃最早的预取
+static const int kMaxQueued = 16;
+
+// 唱片中心孔半径
+static const qreal kHoleRadius = 14.0;
+
+// 同目录下作为封面的图片，按优先级排列（不区分大小写）
+static const char *const kFolderImageNames[] = { "cover", "folder", "front", "album", "albumart" };
+static const char *const kFolderImageSuffixes[] = { "jpg", "jpeg", "png" };
+
+/**
+ * @brief 缩略图缓存文件头
+ *
+ * 头部之后为按 bytesPerLine 排列的像素，偏移 kPixelOffset 保证行首对齐；
+ * 只在本机使用，按本机字节序保存。
+ */
+struct ThumbnailHeader {
+    quint32 magic;
+    quint32 version;
+    qint64 sourceMtime;     // 来源文件（曲目或目录图片）的修改时间与大小，变化后缓存失效
+    qint64 sourceSize;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;          // QImage::Format
+};
+
+static const quint32 kThumbnailMagic = 0x4D504356;     // "MPCV"
+static const quint32 kThumbnailVersion = 1;
+static const int kPixelOffset = 64;
+
+struct ThumbnailMapping {
+    void *base;
+    size_t length;
+};
+
+// QImage 释放最后一个引用时解除映射（可能在任意线程）
+static void unmapThumbnail(void *info)
+{
+    ThumbnailMapping *mapping = static_cast<ThumbnailMapping *>(info);
+    munmap(mapping->base, mapping->length);
+    delete mapping;
+}
+
+// 把缩放后的图片裁成带中心孔的圆形唱片，边缘抗锯齿
+static QImage makeDisc(const QImage &source)
+{
+    const int size = CoverArtCache::kCoverSize;
+    QImage disc(size, size, QImage::Format_ARGB32_Premultiplied);
+    disc.fill(Qt::transparent);
+
+    QPainterPath path;
+    path.setFillRule(Qt::OddEvenFill);
+    path.addEllipse(QRectF(0, 0, size, size));
+    path.addEllipse(QPointF(size / 2.0, size / 2.0), kHoleRadius, kHoleRadius);
+
+    QPainter painter(&disc);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QBrush(source));
+    painter.drawPath(path);
+
+    painter.setBrush(Qt::NoBrush);
+    painter.setPen(QPen(QColor(0, 0, 0, 80), 2));
+    painter.drawEllipse(QRectF(1, 1, size - 2, size - 2));
+    painter.drawEllipse(QPointF(size / 2.0, size / 2.0), kHoleRadius, kHoleRadius);
+    return disc;
+}
+
+CoverArtCache *CoverArtCache::instance()
+{
+    static CoverArtCache *s_instance = nullptr;
+    if (!s_instance) {
+        QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        s_instance = new CoverArtCache(cacheDir + "/covers", QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+CoverArtCache::CoverArtCache(const QString &cacheDir, QObject *parent)
+    : QObject(parent)
+    , m_cacheDir(cacheDir)
+    , m_thread(nullptr)
+    , m_memory(kMemoryBudgetKb)
+    , m_quit(false)
+{
+    m_thread = new BoardThread([this] { workerLoop(); });
+    m_thread->setObjectName("CoverArt");
+    m_thread->start();
+}
+
+CoverArtCache::~CoverArtCache()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+QImage CoverArtCache::cover(const QString &path)
+{
+    QImage *image = m_memory.object(path);
+    if (image) {
+        return *image;
+    }
+    enqueue(path, true);
+    return QImage();
+}
+
+bool CoverArtCache::contains(const QString &path) const
+{
+    return m_memory.contains(path);
+}
+
+void CoverArtCache::prefetch(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        if (!path.isEmpty() && !m_memory.contains(path)) {
+            enqueue(path, false);
+        }
+    }
+}
+
+void CoverArtCache::enqueue(const QString &path, bool urgent)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_queued.contains(path)) {
+        if (!urgent) {
+            return;
+        }
+        m_queue.removeOne(path);
+    } else {
+        m_queued.insert(path);
+    }
+    if (urgent) {
+        m_queue.prepend(path);
+    } else {
+        m_queue.append(path);
+    }
+    while (m_queue.size() > kMaxQueued) {
+        m_queued.remove(m_queue.takeLast());
+    }
+    m_cond.wakeOne();
+}
+
+void CoverArtCache::onCoverLoaded(const QString &path, const QImage &image)
+{
+    // 没有封面的曲目也记下，避免反复提取
+    int costKb = qMax(1, int(image.sizeInBytes() / 1024));
+    m_memory.insert(path, new QImage(image), costKb);
+    emit coverReady(path);
+}
+
+void CoverArtCache::workerLoop()
+{
+    setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), kWorkerNice);
+    QDir().mkpath(m_cacheDir);
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (m_queue.isEmpty()) {
+            m_cond.wait(&m_mutex);
+            continue;
+        }
+        QString path = m_queue.takeFirst();
+        m_queued.remove(path);
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        QImage image = loadCover(path);
+        qDebug() << "CoverArt:" << QFileInfo(path).fileName() << (image.isNull() ? "none" : "ok")
+                 << "in" << timer.elapsed() << "ms";
+        QMetaObject::invokeMethod(this, "onCoverLoaded", Qt::QueuedConnection,
+                                  Q_ARG(QString, path), Q_ARG(QImage, image));
+
+        locker.relock();
+    }
+}
+
+QImage CoverArtCache::loadCover(const QString &path)
+{
+    QFileInfo track(path);
+    if (!track.exists()) {
+        return QImage();
+    }
+
+    QString cacheFile = thumbnailPath(path);
+    QImage image = readThumbnail(cacheFile, track);
+    if (!image.isNull()) {
+        return image;
+    }
+
+    // 内嵌封面：只读标签头部与图片帧
+    QByteArray picture = TagReader::readPicture(path);
+    if (!picture.isEmpty()) {
+        QBuffer buffer(&picture);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer);
+        image = decodeThumbnail(reader);
+        if (!image.isNull()) {
+            writeThumbnail(cacheFile, track, image);
+            return image;
+        }
+    }
+
+    return loadFolderCover(track.absolutePath());
+}
+
+QImage CoverArtCache::loadFolderCover(const QString &dirPath)
+{
+    QString imagePath = findFolderImage(dirPath);
+    if (imagePath.isEmpty()) {
+        return QImage();
+    }
+    if (imagePath == m_lastFolderImage) {
+        return m_lastFolderCover;
+    }
+
+    // 目录图片按图片路径缓存，同一专辑的曲目共用一个缓存文件
+    QFileInfo source(imagePath);
+    QString cacheFile = thumbnailPath(imagePath);
+    QImage image = readThumbnail(cacheFile, source);
+    if (image.isNull()) {
+        QImageReader reader(imagePath);
+        image = decodeThumbnail(reader);
+        if (!image.isNull()) {
+            writeThumbnail(cacheFile, source, image);
+        }
+    }
+    m_lastFolderImage = imagePath;
+    m_lastFolderCover = image;
+    return image;
+}
+
+QString CoverArtCache::findFolderImage(const QString &dirPath)
+{
+    QHash<QString, QString>::const_iterator it = m_folderImages.constFind(dirPath);
+    if (it != m_folderImages.constEnd()) {
+        return it.value();
+    }
+
+    // 名称过滤不区分大小写
+    QStringList filters;
+    for (const char *suffix : kFolderImageSuffixes) {
+        filters << QString("*.%1").arg(suffix);
+    }
+    QStringList files = QDir(dirPath).entryList(filters, QDir::Files | QDir::Readable);
+
+    QString found;
+    for (const char *name : kFolderImageNames) {
+        for (const QString &file : files) {
+            if (QFileInfo(file).completeBaseName().compare(QLatin1String(name), Qt::CaseInsensitive) == 0) {
+                found = dirPath + "/" + file;
+                break;
+            }
+        }
+        if (!found.isEmpty()) {
+            break;
+        }
+    }
+
+    // 只记住最近的一些目录，音乐库很大时不随目录数增长
+    if (m_folderImages.size() >= 256) {
+        m_folderImages.clear();
+    }
+    m_folderImages.insert(dirPath, found);
+    return found;
+}
+
+QString CoverArtCache::thumbnailPath(const QString &sourcePath) const
+{
+    QByteArray hash = QCryptographicHash::hash(sourcePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_cacheDir + "/" + QString::fromLatin1(hash) + ".thumb";
+}
+
+QImage CoverArtCache::readThumbnail(const QString &file, const QFileInfo &source) const
+{
+    int fd = ::open(QFile::encodeName(file).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return QImage();
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < kPixelOffset) {
+        ::close(fd);
+        return QImage();
+    }
+
+    // 在工作线程里把页面全部读入，界面线程绘制时不会缺页
+    size_t length = size_t(st.st_size);
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return QImage();
+    }
+
+    ThumbnailHeader header;
+    memcpy(&header, base, sizeof(header));
+    qint64 pixelBytes = qint64(header.bytesPerLine) * header.height;
+    bool valid = header.magic == kThumbnailMagic && header.version == kThumbnailVersion
+            && header.sourceMtime == source.lastModified().toSecsSinceEpoch()
+            && header.sourceSize == source.size()
+            && header.width == kCoverSize && header.height == kCoverSize
+            && header.format == QImage::Format_ARGB32_Premultiplied
+            && header.bytesPerLine >= header.width * 4
+            && kPixelOffset + pixelBytes <= qint64(length);
+    if (!valid) {
+        munmap(base, length);
+        return QImage();
+    }
+
+    ThumbnailMapping *mapping = new ThumbnailMapping { base, length };
+    return QImage(static_cast<const uchar *>(base) + kPixelOffset, header.width, header.height,
+                  header.bytesPerLine, QImage::Format(header.format), unmapThumbnail, mapping);
+}
+
+void CoverArtCache::writeThumbnail(const QString &file, const QFileInfo &source, const QImage &image) const
+{
+    ThumbnailHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kThumbnailMagic;
+    header.version = kThumbnailVersion;
+    header.sourceMtime = source.lastModified().toSecsSinceEpoch();
+    header.sourceSize = source.size();
+    header.width = image.width();
+    header.height = image.height();
+    header.bytesPerLine = image.bytesPerLine();
+    header.format = image.format();
+
+    QByteArray head(kPixelOffset, '\0');
+    memcpy(head.data(), &header, sizeof(header));
+
+    QSaveFile out(file);
+    qint64 pixelBytes = qint64(image.bytesPerLine()) * image.height();
+    if (!out.open(QIODevice::WriteOnly) || out.write(head) != head.size()
+            || out.write(reinterpret_cast<const char *>(image.constBits()), pixelBytes) != pixelBytes
+            || !out.commit()) {
+        qDebug() << "CoverArt: failed to write" << file;
+    }
+}
+
+QImage CoverArtCache::decodeThumbnail(QImageReader &reader)
+{
+    const int size = kCoverSize;
+    reader.setDecideFormatFromContent(true);
+
+    // 按能盖满显示区域的尺寸解码并裁掉居中区域以外的部分；
+    // JPEG 插件据此选择 libjpeg 的 DCT 缩放比例，只解码缩小后的像素
+    QSize original = reader.size();
+    if (original.isValid() && !original.isEmpty()) {
+        qreal scale = qMax(qreal(size) / original.width(), qreal(size) / original.height());
+        QSize scaled(qMax(size, qCeil(original.width() * scale)), qMax(size, qCeil(original.height() * scale)));
+        reader.setScaledSize(scaled);
+        reader.setScaledClipRect(QRect((scaled.width() - size) / 2, (scaled.height() - size) / 2, size, size));
+    }
+
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return QImage();
+    }
+    if (image.size() != QSize(size, size)) {
+        // 读不出尺寸的格式：解码原图后再缩放
+        image = image.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        image = image.copy((image.width() - size) / 2, (image.height() - size) / 2, size, size);
+    }
+    return makeDisc(image);
+}
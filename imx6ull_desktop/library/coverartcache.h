@@ -0,0 +1,93 @@
+#ifndef COVERARTCACHE_H
+#define COVERARTCACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+class QImageReader;
+class QFileInfo;
+
+/**
+ * @brief 曲目封面缩略图
+ *
+ * 封面来自文件内嵌的图片（ID3v2 APIC、FLAC PICTURE），没有时取同目录下的
+ * cover/folder/front 等图片。低优先级的工作线程提取并直接按显示尺寸解码
+ * （JPEG 由 libjpeg 在 DCT 阶段缩小，不解码原图），裁成圆形唱片后以预乘 ARGB32
+ * 原始像素存入缓存目录；之后同一曲目 mmap 缓存文件即可绘制，无需再解码。
+ *
+ * 界面线程持有按字节计费的 LRU，cover() 命中时立即返回；未命中时返回空图像并
+ * 排队提取，完成后发出 coverReady()。播放器提前 prefetch() 下一首，
+ * 换曲时封面已在内存中。
+ *
+ * 进程内只有一个实例，只能在界面线程中使用。
+ */
+class CoverArtCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CoverArtCache *instance();
+
+    // 缩略图边长，与 CDWidget 一致
+    static const int kCoverSize = 280;
+
+    // 内存中已有时返回封面（没有封面的曲目返回空图像），否则排队优先提取并返回空图像
+    QImage cover(const QString &path);
+
+    // 内存中已有（包括确认没有封面）
+    bool contains(const QString &path) const;
+
+    // 后台预先提取，不打断正在排队的 cover() 请求
+    void prefetch(const QStringList &paths);
+
+signals:
+    // 封面已提取（image 为空表示该曲目没有封面）
+    void coverReady(const QString &path);
+
+private slots:
+    void onCoverLoaded(const QString &path, const QImage &image);
+
+private:
+    explicit CoverArtCache(const QString &cacheDir, QObject *parent = nullptr);
+    ~CoverArtCache();
+
+    void enqueue(const QString &path, bool urgent);
+
+    // 以下在工作线程中执行
+    void workerLoop();
+    QImage loadCover(const QString &path);
+    QImage loadFolderCover(const QString &dirPath);
+    QString findFolderImage(const QString &dirPath);
+    QString thumbnailPath(const QString &sourcePath) const;
+    QImage readThumbnail(const QString &file, const QFileInfo &source) const;
+    void writeThumbnail(const QString &file, const QFileInfo &source, const QImage &image) const;
+    static QImage decodeThumbnail(QImageReader &reader);
+
+    QString m_cacheDir;
+    QThread *m_thread;
+
+    // 界面线程独占
+    QCache<QString, QImage> m_memory;   // 开销以 KB 计
+
+    // 工作线程独占
+    QHash<QString, QString> m_folderImages;     // 目录 → 目录图片路径（空表示没有）
+    QString m_lastFolderImage;                  // 同一专辑的曲目共享同一份像素
+    QImage m_lastFolderCover;
+
+    // 以下成员由 m_mutex 保护
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QList<QString> m_queue;             // 前面是 cover() 的请求，后面是预取
+    QSet<QString> m_queued;
+    bool m_quit;
+};
+
+#endif // COVERARTCACHE_H
@@ -0,0 +1,25 @@
+# 音乐库（持久化索引、目录监视、标签读取、搜索、收藏与歌单、封面缓存、响度分析、基准测试）
+# 由 imx6ull_desktop.pro 通过 include(library/library.pri) 引入
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/musiclibrary.cpp \
+    $$PWD/tagreader.cpp \
+    $$PWD/pinyin.cpp \
+    $$PWD/searchindex.cpp \
+    $$PWD/playliststore.cpp \
+    $$PWD/coverartcache.cpp \
+    $$PWD/loudnessanalyzer.cpp \
+    $$PWD/librarybenchmark.cpp
+
+HEADERS += \
+    $$PWD/musiclibrary.h \
+    $$PWD/tagreader.h \
+    $$PWD/pinyin.h \
+    $$PWD/searchindex.h \
+    $$PWD/playliststore.h \
+    $$PWD/coverartcache.h \
+    $$PWD/loudnessanalyzer.h \
+    $$PWD/librarybenchmark.h
@@ -0,0 +1,547 @@
+#include "librarybenchmark.h"
+#include "musiclibrary.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QTimer>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+// 生成曲库的结构：每张专辑 10 首，每位艺术家 10 张专辑
+static const int kDefaultFiles = 10000;
+static const int kTracksPerAlbum = 10;
+static const int kAlbumsPerArtist = 10;
+
+// 标记文件记录生成的文件数；以 . 开头，音乐库扫描时会跳过
+static const char kMarkerName[] = ".bench-tags";
+
+// 生成的曲目都是 4 分钟 44.1kHz 立体声，封面 32KB，头尾之间补齐的音频区长度
+static const int kTrackSeconds = 240;
+static const int kSampleRate = 44100;
+static const int kCoverBytes = 32 * 1024;
+static const int kAudioBytes = 96 * 1024;
+
+// MPEG-1 Layer III 128kbps 44.1kHz 联合立体声的帧头，帧长 417 字节，每帧 1152 个采样
+static const uchar kMpegHeader[4] = { 0xFF, 0xFB, 0x90, 0x64 };
+static const int kMpegFrameBytes = 417;
+static const int kMpegSideInfo = 32;
+static const int kMpegFrameSamples = 1152;
+
+// 读取全部元数据的最长等待时间
+static const int kTimeoutMs = 30 * 60 * 1000;
+
+static void appendBe32(QByteArray &out, quint32 v)
+{
+    const char b[4] = { char(v >> 24), char(v >> 16), char(v >> 8), char(v) };
+    out.append(b, 4);
+}
+
+static void appendLe32(QByteArray &out, quint32 v)
+{
+    const char b[4] = { char(v), char(v >> 8), char(v >> 16), char(v >> 24) };
+    out.append(b, 4);
+}
+
+static void appendLe16(QByteArray &out, quint16 v)
+{
+    const char b[2] = { char(v), char(v >> 8) };
+    out.append(b, 2);
+}
+
+static void appendSyncsafe(QByteArray &out, quint32 v)
+{
+    const char b[4] = { char((v >> 21) & 0x7F), char((v >> 14) & 0x7F), char((v >> 7) & 0x7F), char(v & 0x7F) };
+    out.append(b, 4);
+}
+
+// 假的 JPEG 封面：只有 SOI/APP0 标记，读标签时应整块跳过
+static QByteArray fakeCover()
+{
+    QByteArray cover(kCoverBytes, '\0');
+    cover[0] = char(0xFF);
+    cover[1] = char(0xD8);
+    cover[2] = char(0xFF);
+    cover[3] = char(0xE0);
+    return cover;
+}
+
+struct GeneratedTrack {
+    QString title;
+    QString artist;
+    QString album;
+    int index;
+};
+
+// ---- MP3：ID3v2.4（UTF-8 文本帧、APIC、填充）+ Xing 帧 + 一个普通帧，末尾 ID3v1 ----
+
+static QByteArray id3Frame(const char *id, const QByteArray &body)
+{
+    QByteArray frame(id, 4);
+    appendSyncsafe(frame, quint32(body.size()));
+    frame.append(2, '\0');
+    frame.append(body);
+    return frame;
+}
+
+static QByteArray id3Text(const QString &text)
+{
+    return QByteArray(1, '\x03') + text.toUtf8();
+}
+
+static QByteArray id3v1Field(const QByteArray &text)
+{
+    QByteArray field = text.left(30);
+    field.append(30 - field.size(), '\0');
+    return field;
+}
+
+static void buildMp3(const GeneratedTrack &track, QByteArray &head, QByteArray &tail)
+{
+    QByteArray frames;
+    frames += id3Frame("TIT2", id3Text(track.title));
+    frames += id3Frame("TPE1", id3Text(track.artist));
+    frames += id3Frame("TALB", id3Text(track.album));
+    QByteArray apic("\0image/jpeg\0\x03\0", 14);
+    frames += id3Frame("APIC", apic + fakeCover());
+    frames.append(2048, '\0');
+
+    head = QByteArray("ID3\x04\x00\x00", 6);
+    appendSyncsafe(head, quint32(frames.size()));
+    head += frames;
+
+    quint32 frameCount = quint32((qint64(kTrackSeconds) * kSampleRate + kMpegFrameSamples - 1) / kMpegFrameSamples);
+    QByteArray xing(kMpegFrameBytes, '\0');
+    memcpy(xing.data(), kMpegHeader, 4);
+    QByteArray xingTag("Xing");
+    appendBe32(xingTag, 0x01);
+    appendBe32(xingTag, frameCount);
+    xing.replace(4 + kMpegSideInfo, xingTag.size(), xingTag);
+    head += xing;
+
+    QByteArray frame(kMpegFrameBytes, '\0');
+    memcpy(frame.data(), kMpegHeader, 4);
+    head += frame;
+
+    // ID3v1 只能放 Latin-1，用编号代替中文
+    tail = "TAG";
+    tail += id3v1Field(QString("Track %1").arg(track.index).toLatin1());
+    tail += id3v1Field("Artist");
+    tail += id3v1Field("Album");
+    tail += "2024";
+    tail += id3v1Field(QByteArray());
+    tail.append(1, char(255));
+}
+
+// ---- FLAC：STREAMINFO、VORBIS_COMMENT、PICTURE ----
+
+static QByteArray vorbisComment(const GeneratedTrack &track)
+{
+    QByteArray vendor("bench-tags");
+    QByteArray items[3] = {
+        "TITLE=" + track.title.toUtf8(),
+        "ARTIST=" + track.artist.toUtf8(),
+        "ALBUM=" + track.album.toUtf8()
+    };
+    QByteArray comment;
+    appendLe32(comment, quint32(vendor.size()));
+    comment += vendor;
+    appendLe32(comment, 3);
+    for (const QByteArray &item : items) {
+        appendLe32(comment, quint32(item.size()));
+        comment += item;
+    }
+    return comment;
+}
+
+static void appendFlacBlock(QByteArray &out, int type, bool last, const QByteArray &body)
+{
+    appendBe32(out, (quint32(type | (last ? 0x80 : 0)) << 24) | quint32(body.size()));
+    out += body;
+}
+
+static void buildFlac(const GeneratedTrack &track, QByteArray &head)
+{
+    quint64 samples = quint64(kTrackSeconds) * kSampleRate;
+    QByteArray info;
+    info.append("\x10\x00\x10\x00", 4);         // 最小/最大块 4096
+    info.append(6, '\0');                       // 最小/最大帧长未知
+    info.append(char(kSampleRate >> 12));
+    info.append(char(kSampleRate >> 4));
+    info.append(char(((kSampleRate & 0x0F) << 4) | (1 << 1)));     // 2 声道
+    info.append(char((15 << 4) | int(samples >> 32)));             // 16 bit
+    appendBe32(info, quint32(samples));
+    info.append(16, '\0');                      // MD5
+
+    QByteArray picture;
+    QByteArray mime("image/jpeg");
+    appendBe32(picture, 3);
+    appendBe32(picture, quint32(mime.size()));
+    picture += mime;
+    appendBe32(picture, 0);                     // 描述
+    appendBe32(picture, 500);
+    appendBe32(picture, 500);
+    appendBe32(picture, 24);
+    appendBe32(picture, 0);
+    appendBe32(picture, kCoverBytes);
+    picture += fakeCover();
+
+    head = "fLaC";
+    appendFlacBlock(head, 0, false, info);
+    appendFlacBlock(head, 4, false, vorbisComment(track));
+    appendFlacBlock(head, 6, true, picture);
+}
+
+// ---- WAV：fmt、LIST INFO、data ----
+
+static void appendInfoItem(QByteArray &list, const char *id, const QString &text)
+{
+    QByteArray value = text.toUtf8();
+    value.append('\0');
+    list.append(id, 4);
+    appendLe32(list, quint32(value.size()));
+    list += value;
+    if (value.size() & 1) {
+        list.append('\0');
+    }
+}
+
+static void buildWav(const GeneratedTrack &track, QByteArray &head)
+{
+    QByteArray list("INFO");
+    appendInfoItem(list, "INAM", track.title);
+    appendInfoItem(list, "IART", track.artist);
+    appendInfoItem(list, "IPRD", track.album);
+
+    QByteArray chunks("WAVE");
+    chunks += "fmt ";
+    appendLe32(chunks, 16);
+    appendLe16(chunks, 1);
+    appendLe16(chunks, 2);
+    appendLe32(chunks, kSampleRate);
+    appendLe32(chunks, kSampleRate * 4);
+    appendLe16(chunks, 4);
+    appendLe16(chunks, 16);
+    chunks += "LIST";
+    appendLe32(chunks, quint32(list.size()));
+    chunks += list;
+    chunks += "data";
+    appendLe32(chunks, kAudioBytes);
+
+    head = "RIFF";
+    appendLe32(head, quint32(chunks.size() + kAudioBytes));
+    head += chunks;
+}
+
+// ---- Ogg Vorbis：标识头页、注释头页，末页的 granule 给出时长 ----
+
+static QByteArray oggPage(int headerType, quint64 granule, quint32 serial, quint32 sequence, const QByteArray &packet)
+{
+    QByteArray lacing;
+    int remaining = packet.size();
+    while (remaining >= 255) {
+        lacing.append(char(255));
+        remaining -= 255;
+    }
+    lacing.append(char(remaining));
+
+    // 解析时不校验 CRC，这里填 0
+    QByteArray page("OggS\0", 5);
+    page.append(char(headerType));
+    appendLe32(page, quint32(granule));
+    appendLe32(page, quint32(granule >> 32));
+    appendLe32(page, serial);
+    appendLe32(page, sequence);
+    appendLe32(page, 0);
+    page.append(char(lacing.size()));
+    page += lacing;
+    page += packet;
+    return page;
+}
+
+static void buildOgg(const GeneratedTrack &track, QByteArray &head, QByteArray &tail)
+{
+    quint32 serial = 0x5A000000u | quint32(track.index);
+
+    QByteArray ident("\x01vorbis", 7);
+    appendLe32(ident, 0);
+    ident.append(char(2));
+    appendLe32(ident, kSampleRate);
+    appendLe32(ident, 0);
+    appendLe32(ident, 160000);
+    appendLe32(ident, 0);
+    ident.append(char(0xB8));
+    ident.append(char(1));
+
+    QByteArray comment("\x03vorbis", 7);
+    comment += vorbisComment(track);
+    comment.append(char(1));
+
+    head = oggPage(0x02, 0, serial, 0, ident);
+    head += oggPage(0x00, 0, serial, 1, comment);
+    tail = oggPage(0x04, quint64(kTrackSeconds) * kSampleRate, serial, 2, QByteArray(200, '\0'));
+}
+
+// 写入头部与尾部，中间用 ftruncate 补齐（支持稀疏文件的文件系统上不占空间）
+static bool writeTrack(const QString &path, const QByteArray &head, qint64 size, const QByteArray &tail)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::write(fd, head.constData(), size_t(head.size())) == head.size()
+              && ::ftruncate(fd, off_t(size)) == 0
+              && (tail.isEmpty()
+                  || ::pwrite(fd, tail.constData(), size_t(tail.size()), off_t(size - tail.size())) == tail.size());
+    ::close(fd);
+    return ok;
+}
+
+static QString trackFileName(int index, const QString &suffix)
+{
+    return QString("%1 歌曲 %2.%3").arg(index % kTracksPerAlbum + 1, 2, 10, QChar('0'))
+           .arg(index, 5, 10, QChar('0')).arg(suffix);
+}
+
+// 生成的文件名去掉曲号就是标签中的标题
+static QString expectedTitle(const QString &path)
+{
+    return QFileInfo(path).completeBaseName().mid(3);
+}
+
+// MP3 : FLAC : WAV : Ogg = 6 : 2 : 1 : 1
+static QString trackSuffix(int index)
+{
+    int kind = index % 10;
+    return kind < 6 ? "mp3" : kind < 8 ? "flac" : kind < 9 ? "wav" : "ogg";
+}
+
+// 生成的文件中音乐库会列出的数量（没有编入解码器的格式不列出）
+static int listedTracks(int count)
+{
+    int listed = 0;
+    for (int i = 0; i < count; ++i) {
+        if (MusicLibrary::isAudioFile("track." + trackSuffix(i))) {
+            ++listed;
+        }
+    }
+    return listed;
+}
+
+static bool generateLibrary(const QString &rootPath, int count, QTextStream &out)
+{
+    QString dirPath;
+    for (int i = 0; i < count; ++i) {
+        int album = i / kTracksPerAlbum;
+        int artist = album / kAlbumsPerArtist;
+        GeneratedTrack track;
+        track.index = i;
+        track.title = QString("歌曲 %1").arg(i, 5, 10, QChar('0'));
+        track.artist = QString("歌手 %1").arg(artist, 3, 10, QChar('0'));
+        track.album = QString("专辑 %1").arg(album, 4, 10, QChar('0'));
+
+        if (i % kTracksPerAlbum == 0) {
+            dirPath = rootPath + '/' + track.artist + '/' + track.album;
+            if (!QDir().mkpath(dirPath)) {
+                out << QString("无法创建目录 %1\n").arg(dirPath);
+                return false;
+            }
+        }
+
+        QByteArray head;
+        QByteArray tail;
+        QString suffix = trackSuffix(i);
+        if (suffix == "mp3") {
+            buildMp3(track, head, tail);
+        } else if (suffix == "flac") {
+            buildFlac(track, head);
+        } else if (suffix == "wav") {
+            buildWav(track, head);
+        } else {
+            buildOgg(track, head, tail);
+        }
+
+        QString path = dirPath + '/' + trackFileName(i, suffix);
+        if (!writeTrack(path, head, head.size() + kAudioBytes + tail.size(), tail)) {
+            out << QString("无法写入 %1\n").arg(path);
+            return false;
+        }
+    }
+
+    QFile marker(rootPath + '/' + kMarkerName);
+    if (!marker.open(QIODevice::WriteOnly) || marker.write(QByteArray::number(count)) <= 0) {
+        return false;
+    }
+    return true;
+}
+
+// 先把脏页写回，再逐个文件丢掉页缓存，让读取从存储设备开始（目录项缓存不受影响）
+static int dropPageCache(const QString &rootPath)
+{
+    ::sync();
+    int files = 0;
+    QDirIterator it(rootPath, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        int fd = ::open(QFile::encodeName(it.next()).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0) {
+            ++files;
+        }
+        ::close(fd);
+    }
+    return files;
+}
+
+static qint64 cpuMs(const struct rusage &usage)
+{
+    return qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+           + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
+int LibraryBenchmark::runTags(const QStringList &arguments)
+{
+    QTextStream out(stdout);
+    bool ok = true;
+    int count = arguments.size() >= 2 ? arguments.value(1).toInt(&ok) : kDefaultFiles;
+    if (arguments.isEmpty() || !ok || count <= 0) {
+        out << QString("用法: --bench-tags <目录> [文件数，默认 %1]\n").arg(kDefaultFiles);
+        return 2;
+    }
+    QString rootPath = QDir(arguments.value(0)).absolutePath();
+    QDir root(rootPath);
+
+    // 空目录（或不存在）时生成；之前生成过的直接复用，并按标记中的文件数检查
+    int expected = 0;
+    QFile marker(root.filePath(kMarkerName));
+    if (marker.open(QIODevice::ReadOnly)) {
+        expected = marker.readAll().trimmed().toInt();
+        marker.close();
+        out << QString("复用 %1 中生成的 %2 个文件\n").arg(rootPath).arg(expected);
+    } else if (!root.exists() || root.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty()) {
+        out << QString("在 %1 中生成 %2 个文件...\n").arg(rootPath).arg(count);
+        out.flush();
+        QElapsedTimer timer;
+        timer.start();
+        if (!generateLibrary(rootPath, count, out)) {
+            return 1;
+        }
+        expected = count;
+        out << QString("生成耗时 %1 ms\n").arg(timer.elapsed());
+    } else {
+        out << QString("%1 中已有文件，直接测试现有曲库（不检查标签内容）\n").arg(rootPath);
+    }
+
+    out << QString("已清空 %1 个文件的页缓存\n").arg(dropPageCache(rootPath));
+    out.flush();
+
+    // 临时索引：每次都从零开始读取，也不会覆盖播放器自己的索引
+    QString indexPath = QDir::temp().filePath(QString("bench-tags-%1.idx").arg(QCoreApplication::applicationPid()));
+    QFile::remove(indexPath);
+    MusicLibrary *library = new MusicLibrary(rootPath, indexPath);
+
+    QEventLoop loop;
+    int tracks = -1;
+    qint64 reconcileMs = 0;
+    int metadataFiles = 0;
+    qint64 metadataMs = 0;
+    QObject::connect(library, &MusicLibrary::reconciled, &loop, [&](int n, qint64 elapsedMs) {
+        tracks = n;
+        reconcileMs = elapsedMs;
+        if (n == 0) {
+            loop.quit();
+        }
+    });
+    QObject::connect(library, &MusicLibrary::metadataFinished, &loop, [&](int files, qint64 elapsedMs) {
+        metadataFiles += files;
+        metadataMs += elapsedMs;
+        if (tracks >= 0 && metadataFiles >= tracks) {
+            loop.quit();
+        }
+    });
+    bool timedOut = false;
+    QTimer::singleShot(kTimeoutMs, &loop, [&]() {
+        timedOut = true;
+        loop.quit();
+    });
+
+    struct rusage before;
+    struct rusage after;
+    getrusage(RUSAGE_SELF, &before);
+    QElapsedTimer wall;
+    wall.start();
+    library->start();
+    loop.exec();
+    qint64 wallMs = wall.elapsed();
+    getrusage(RUSAGE_SELF, &after);
+
+    MusicLibrary::MetadataStats stats = library->metadataStats();
+    QVector<TrackRecord> records = library->tracks();
+    delete library;
+    QFile::remove(indexPath);
+
+    if (tracks <= 0) {
+        out << QString("%1 中没有音频文件\n").arg(rootPath);
+        return 1;
+    }
+
+    quint64 files = stats.parsed + stats.failed;
+    out << QString("对账 %1 个文件: %2 ms\n").arg(tracks).arg(reconcileMs);
+    out << QString("读取元数据 %1 个文件: %2 ms，%3 个/秒；从启动到全部读完 %4 ms%5\n")
+           .arg(metadataFiles).arg(metadataMs)
+           .arg(metadataMs > 0 ? qint64(metadataFiles) * 1000 / metadataMs : 0)
+           .arg(wallMs).arg(timedOut ? QString("（超时）") : QString());
+    out << QString("单个文件: 平均 %1 us，最长 %2 ms，平均读取 %3 字节，无法识别 %4 个\n")
+           .arg(files ? stats.totalNs / qint64(files) / 1000 : 0)
+           .arg(stats.maxNs / 1000000.0, 0, 'f', 1)
+           .arg(files ? stats.bytesRead / files : 0)
+           .arg(stats.failed);
+    out << QString("进程 CPU %1 ms，主缺页 %2 次，块设备读取 %3 KB\n")
+           .arg(cpuMs(after) - cpuMs(before))
+           .arg(after.ru_majflt - before.ru_majflt)
+           .arg((after.ru_inblock - before.ru_inblock) / 2);
+
+    if (expected == 0) {
+        return timedOut ? 1 : 0;
+    }
+    int listed = listedTracks(expected);
+    if (listed != expected) {
+        out << QString("未编入解码器的格式不计入：生成 %1 个文件，应列出 %2 首\n").arg(expected).arg(listed);
+    }
+
+    // 标签中的标题与文件名解析出的不同，能区分确实读到了标签
+    int unread = 0;
+    int wrongTitle = 0;
+    int noDuration = 0;
+    for (const TrackRecord &record : records) {
+        if (!(record.flags & TrackRecord::MetadataRead)) {
+            ++unread;
+        } else if (record.title != expectedTitle(record.path)) {
+            ++wrongTitle;
+        } else if (record.durationMs <= 0) {
+            ++noDuration;
+        }
+    }
+    int failures = 0;
+    auto expect = [&](bool pass, const QString &what) {
+        out << QString("  [%1] %2\n").arg(pass ? "通过" : "失败", what);
+        if (!pass) {
+            ++failures;
+        }
+    };
+    expect(!timedOut, "在时限内读完");
+    expect(records.size() == listed, QString("曲目 %1 首，应为 %2").arg(records.size()).arg(listed));
+    expect(unread == 0, QString("未读到元数据: %1 首").arg(unread));
+    expect(wrongTitle == 0, QString("标题与标签不符: %1 首").arg(wrongTitle));
+    expect(noDuration == 0, QString("没有时长: %1 首").arg(noDuration));
+
+    out << (failures == 0 ? QString("全部通过\n") : QString("%1 项失败\n").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
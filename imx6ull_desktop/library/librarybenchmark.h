@@ -0,0 +1,28 @@
+#ifndef LIBRARYBENCHMARK_H
+#define LIBRARYBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @brief 音乐库基准测试（命令行，不启动界面）
+ *
+ *   imx6ull_desktop --bench-tags <目录> [文件数，默认 10000]
+ *
+ * 目录为空时先生成一个测试曲库：每 10 首一张专辑、每 10 张专辑一位艺术家，
+ * MP3（ID3v2.4 + 32KB 封面 + Xing 帧 + ID3v1）、FLAC（STREAMINFO、Vorbis comment、
+ * 封面）、WAV（LIST INFO）、Ogg Vorbis（末页 granule）按 6:2:1:1 混合，标题为中文。
+ * 文件只写头尾，中间用 ftruncate 补齐（支持稀疏文件时几乎不占空间）。
+ * 目录中已有别的文件时直接测这些文件，例如 /music。
+ *
+ * 用临时索引构造一个 MusicLibrary，清掉这些文件的页缓存后启动，由与播放器相同的
+ * 元数据工作线程池把全部文件读完，输出对账耗时、读取总耗时与吞吐、单个文件的
+ * 平均与最长耗时、每个文件读取的字节数，以及进程 CPU 时间与块设备读取量。
+ * 对生成的曲库还检查每个文件都读到了标签中的标题与时长，全部正确时返回 0。
+ */
+class LibraryBenchmark
+{
+public:
+    static int runTags(const QStringList &arguments);
+};
+
+#endif // LIBRARYBENCHMARK_H
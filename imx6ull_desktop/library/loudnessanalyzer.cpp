@@ -0,0 +1,457 @@
+#include "loudnessanalyzer.h"
+#include "audiodecoder.h"
+#include "loudnessmeter.h"
+#include "mp3seektable.h"
+#include "playbackclock.h"
+#include "waveformoverview.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cmath>
+#include <cstdio>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+// 文件格式
+static const quint32 kCacheMagic = 0x4D504C44;     // "MPLD"
+static const quint32 kCacheVersion = 1;
+
+// 目标响度：ReplayGain 2.0 的参考电平
+static const float kTargetLufs = -18.0f;
+static const float kMinGainDb = -24.0f;
+static const float kMaxGainDb = 12.0f;          // SoftwareGain 的上限
+static const float kSilenceLufs = -70.0f;       // 低于绝对门限，视为无法校正
+
+// 每次解码的帧数，也是让出 CPU 的粒度（44.1kHz 下约 93ms 音频）
+static const int kChunkFrames = 4096;
+
+// 分析期间每隔多久重新统计 CPU 余量
+static const qint64 kShareIntervalNs = 500 * 1000000LL;
+// 其他任务与分析合计不超过的 CPU 比例，余量留给突发的界面与解码负载
+static const double kMaxTotalLoad = 0.8;
+// 分析最多占用的比例，以及低于多少时整段暂停
+static const double kMaxShare = 0.5;
+static const double kMinShare = 0.05;
+static const int kBusyPauseMs = 500;
+
+// 大量曲目首次分析时，每完成这么多首保存一次
+static const int kSaveEvery = 20;
+
+// SCHED_IDLE 不可用时退回最低的 nice 值
+static const int kAnalyzerNice = 19;
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// /proc/stat 第一行：所有 CPU 的累计节拍，idle 含 iowait
+static bool readCpuTicks(qint64 &total, qint64 &idle)
+{
+    FILE *file = fopen("/proc/stat", "re");
+    if (!file) {
+        return false;
+    }
+    long long user = 0, nice = 0, system = 0, idleTicks = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    int fields = fscanf(file, "cpu %lld %lld %lld %lld %lld %lld %lld %lld",
+                        &user, &nice, &system, &idleTicks, &iowait, &irq, &softirq, &steal);
+    fclose(file);
+    if (fields < 4) {
+        return false;
+    }
+    total = user + nice + system + idleTicks + iowait + irq + softirq + steal;
+    idle = idleTicks + iowait;
+    return true;
+}
+
+// 读过的文件不留在页缓存里挤掉正在播放的数据（正在映射的页不受影响）
+static void dropPageCache(const QString &path)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+LoudnessAnalyzer *LoudnessAnalyzer::instance()
+{
+    static LoudnessAnalyzer *s_instance = nullptr;
+    if (!s_instance) {
+        QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        s_instance = new LoudnessAnalyzer(cacheDir + "/loudness.idx", QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer(const QString &cachePath, QObject *parent)
+    : QObject(parent)
+    , m_cachePath(cachePath)
+    , m_thread(nullptr)
+    , m_lastTotalTicks(0)
+    , m_lastIdleTicks(0)
+    , m_lastCpuNs(0)
+    , m_lastSampleNs(0)
+    , m_rescan(false)
+    , m_dirty(false)
+    , m_quit(false)
+    , m_share(kMaxShare)
+{
+    m_thread = new BoardThread([this] { workerLoop(); });
+    m_thread->setObjectName("Loudness");
+    m_thread->start();
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void LoudnessAnalyzer::analyze(const QStringList &paths)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queue = paths;
+    m_wanted = QSet<QString>::fromList(paths);
+    m_rescan = true;
+    m_cond.wakeAll();
+}
+
+void LoudnessAnalyzer::prioritize(const QString &path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    bool overviewCached = WaveformOverview::isCached(path);
+    QMutexLocker locker(&m_mutex);
+    if ((m_entries.contains(path) && overviewCached) || m_failed.contains(path)) {
+        return;
+    }
+    m_queue.removeOne(path);
+    m_queue.prepend(path);
+    m_cond.wakeAll();
+}
+
+bool LoudnessAnalyzer::trackGain(const QString &path, float &gainDb) const
+{
+    QMutexLocker locker(&m_mutex);
+    QHash<QString, Entry>::const_iterator it = m_entries.constFind(path);
+    if (it == m_entries.constEnd() || it.value().lufs <= kSilenceLufs) {
+        return false;
+    }
+
+    // 放大不能让样本峰值超过满幅
+    float gain = kTargetLufs - it.value().lufs;
+    if (it.value().peak > 0) {
+        gain = qMin(gain, -20.0f * std::log10(it.value().peak));
+    }
+    gainDb = qBound(kMinGainDb, gain, kMaxGainDb);
+    return true;
+}
+
+LoudnessAnalyzer::Stats LoudnessAnalyzer::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.cached = m_entries.size();
+    stats.pending = m_queue.size();
+    stats.sharePercent = int(m_share * 100);
+    return stats;
+}
+
+void LoudnessAnalyzer::workerLoop()
+{
+    // 只在 CPU 空闲时运行；内核不支持时降到最低的 nice
+    struct sched_param param;
+    param.sched_priority = 0;
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), kAnalyzerNice);
+    }
+
+    loadCache();
+
+    int sinceSave = 0;
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        // 音乐库变化后删掉已不存在的曲目
+        if (m_rescan) {
+            m_rescan = false;
+            for (QHash<QString, Entry>::iterator it = m_entries.begin(); it != m_entries.end();) {
+                if (m_wanted.contains(it.key())) {
+                    ++it;
+                } else {
+                    it = m_entries.erase(it);
+                    m_dirty = true;
+                }
+            }
+            continue;
+        }
+
+        if (m_queue.isEmpty() || sinceSave >= kSaveEvery) {
+            if (m_dirty) {
+                m_dirty = false;
+                sinceSave = 0;
+                locker.unlock();
+                saveCache();
+                locker.relock();
+                continue;
+            }
+            if (m_queue.isEmpty()) {
+                m_cond.wait(&m_mutex);
+                continue;
+            }
+        }
+
+        QString path = m_queue.takeFirst();
+        if (m_failed.contains(path)) {
+            continue;
+        }
+        QHash<QString, Entry>::const_iterator cached = m_entries.constFind(path);
+        bool haveCached = cached != m_entries.constEnd();
+        Entry previous = haveCached ? cached.value() : Entry();
+        locker.unlock();
+
+        QFileInfo info(path);
+        Entry entry;
+        entry.mtime = info.lastModified().toSecsSinceEpoch();
+        entry.size = info.size();
+        // 升级前已分析过的曲目还没有波形概览，再解码一遍补上
+        if (!info.exists() || (haveCached && previous.mtime == entry.mtime && previous.size == entry.size
+                               && WaveformOverview::isCached(path))) {
+            locker.relock();
+            continue;
+        }
+
+        bool ok = measure(path, entry);
+
+        locker.relock();
+        if (m_quit) {
+            break;
+        }
+        if (!ok) {
+            m_failed.insert(path);
+            continue;
+        }
+        m_entries.insert(path, entry);
+        m_dirty = true;
+        ++sinceSave;
+        locker.unlock();
+        emit analyzed(path);
+        locker.relock();
+    }
+
+    bool dirty = m_dirty;
+    locker.unlock();
+    if (dirty) {
+        saveCache();
+    }
+}
+
+bool LoudnessAnalyzer::measure(const QString &path, Entry &entry)
+{
+    // MP3 顺便扫描帧头建立定位表：整个文件本来就要读一遍，之后拖动进度条不必再扫描
+    if (Mp3SeekTable::handles(path)) {
+        qint64 scanStart = PlaybackClock::nowNs();
+        Mp3SeekTable table;
+        if (!table.load(path) && table.build(path)) {
+            qDebug() << "Loudness: seek table" << QFileInfo(path).fileName() << table.frameCount() << "frames";
+            dropPageCache(path);
+        }
+        throttle(PlaybackClock::nowNs() - scanStart);
+    }
+
+    QScopedPointer<AudioDecoder> decoder(AudioDecoder::create(path));
+    if (!decoder || !decoder->open(path)) {
+        return false;
+    }
+    AudioFormat format = decoder->format();
+    LoudnessMeter meter(format.sampleRate, format.channels);
+    WaveformOverview overview;
+    overview.begin(format.channels);
+    QVector<qint16> buffer(kChunkFrames * format.channels);
+
+    qint64 startNs = PlaybackClock::nowNs();
+    qint64 busyNs = 0;
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_quit) {
+                return false;
+            }
+        }
+
+        qint64 chunkStart = PlaybackClock::nowNs();
+        const qint16 *data = nullptr;
+        int frames = decoder->readDirect(&data, kChunkFrames);
+        if (frames < 0) {
+            frames = decoder->read(buffer.data(), kChunkFrames);
+            data = buffer.constData();
+        }
+        if (frames < 0) {
+            qDebug() << "Loudness: decode error" << path << decoder->errorString();
+            return false;
+        }
+        if (frames == 0) {
+            break;
+        }
+        meter.process(data, frames);
+        overview.process(data, frames);
+
+        // 按墙上时间计入：读文件和缺页也占用了 SD 卡与内存带宽
+        qint64 workNs = PlaybackClock::nowNs() - chunkStart;
+        busyNs += workNs;
+        throttle(workNs);
+    }
+    decoder.reset();
+    dropPageCache(path);
+
+    entry.lufs = meter.hasLoudness() ? float(meter.integratedLufs()) : kSilenceLufs;
+    entry.peak = meter.peak();
+
+    overview.finish();
+    if (!overview.save(path)) {
+        qDebug() << "Loudness: failed to save waveform overview" << path;
+    }
+
+    qint64 audioMs = format.sampleRate > 0 ? meter.frames() * 1000 / format.sampleRate : 0;
+    qDebug() << "Loudness:" << QFileInfo(path).fileName() << entry.lufs << "LUFS peak" << entry.peak
+             << "audio" << audioMs << "ms, busy" << busyNs / 1000000 << "ms, elapsed"
+             << (PlaybackClock::nowNs() - startNs) / 1000000 << "ms";
+
+    QMutexLocker locker(&m_mutex);
+    m_stats.analyzed++;
+    m_stats.audioMs += audioMs;
+    m_stats.busyMs += busyNs / 1000000;
+    return true;
+}
+
+void LoudnessAnalyzer::updateShare()
+{
+    qint64 total, idle;
+    if (!readCpuTicks(total, idle)) {
+        return;
+    }
+    qint64 now = PlaybackClock::nowNs();
+    qint64 cpuNs = threadCpuNs();
+
+    if (m_lastSampleNs > 0 && total > m_lastTotalTicks) {
+        // 节拍为所有 CPU 之和；从忙碌时间中扣掉自己用掉的，剩下的是其他任务
+        static const double nsPerTick = 1e9 / sysconf(_SC_CLK_TCK);
+        static const int cpus = int(qMax(1L, sysconf(_SC_NPROCESSORS_ONLN)));
+        double capacityNs = (total - m_lastTotalTicks) * nsPerTick;
+        double busyNs = (total - m_lastTotalTicks - (idle - m_lastIdleTicks)) * nsPerTick;
+        double othersLoad = qMax(0.0, busyNs - (cpuNs - m_lastCpuNs)) / capacityNs;
+
+        // 允许的比例按整机计算，换算成单个线程的占空比
+        double share = qBound(0.0, kMaxTotalLoad - othersLoad, kMaxShare);
+        QMutexLocker locker(&m_mutex);
+        m_share = qMin(1.0, share * cpus);
+    }
+
+    m_lastTotalTicks = total;
+    m_lastIdleTicks = idle;
+    m_lastCpuNs = cpuNs;
+    m_lastSampleNs = now;
+}
+
+void LoudnessAnalyzer::throttle(qint64 workNs)
+{
+    if (PlaybackClock::nowNs() - m_lastSampleNs >= kShareIntervalNs) {
+        updateShare();
+    }
+
+    // 占空比 share：工作 workNs 后休息 workNs·(1 - share)/share；余量太少时整段暂停
+    QMutexLocker locker(&m_mutex);
+    qint64 sleepMs = m_share < kMinShare ? kBusyPauseMs
+                                         : qint64(workNs * (1.0 - m_share) / m_share / 1000000);
+    if (sleepMs > 0 && !m_quit) {
+        m_cond.wait(&m_mutex, (unsigned long)sleepMs);
+    }
+}
+
+void LoudnessAnalyzer::loadCache()
+{
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QByteArray data = file.readAll();
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_6);
+    in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != kCacheMagic || version != kCacheVersion) {
+        qDebug() << "LoudnessAnalyzer: ignoring unknown cache" << m_cachePath;
+        return;
+    }
+
+    QHash<QString, Entry> entries;
+    entries.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray path;
+        Entry entry;
+        in >> path >> entry.mtime >> entry.size >> entry.lufs >> entry.peak;
+        entries.insert(QString::fromUtf8(path), entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "LoudnessAnalyzer: truncated cache" << m_cachePath;
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    // 加载期间可能已经有新结果，以新结果为准
+    for (QHash<QString, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        if (!m_entries.contains(it.key())) {
+            m_entries.insert(it.key(), it.value());
+        }
+    }
+    qDebug() << "LoudnessAnalyzer:" << m_entries.size() << "cached tracks";
+}
+
+void LoudnessAnalyzer::saveCache()
+{
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_mutex);
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_6);
+        out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        out << kCacheMagic << kCacheVersion << quint32(m_entries.size());
+        for (QHash<QString, Entry>::const_iterator it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            const Entry &entry = it.value();
+            out << it.key().toUtf8() << entry.mtime << entry.size << entry.lufs << entry.peak;
+        }
+    }
+
+    QDir().mkpath(QFileInfo(m_cachePath).absolutePath());
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qDebug() << "LoudnessAnalyzer: failed to save" << m_cachePath;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+/**
+ * @brief 后台响度分析与按曲目的增益
+ *
+ * 工作线程逐个解码曲目，用 LoudnessMeter 计算 EBU R128 积分响度与样本峰值，
+ * 结果（连同文件的修改时间与大小）保存在缓存目录下的二进制文件中，文件变化后重新分析。
+ * 播放时按目标响度 -18 LUFS 计算增益交给 AudioEngine，峰值限制增益不致削波。
+ * MP3 文件还顺便扫描帧头，建立 Mp3SeekTable 的缓存，之后定位不必再扫描。
+ * 同一遍解码还生成进度条用的 WaveformOverview，按曲目单独缓存；analyzed() 发出时已写入。
+ *
+ * 工作线程以 SCHED_IDLE 运行，只在 CPU 没有其他可运行的任务时才得到时间片；
+ * 此外每隔一段时间从 /proc/stat 统计其他任务占用的 CPU，按剩余余量限制自己的占空比，
+ * 余量不足时暂停，不与播放解码和界面争抢 CPU、内存带宽和 SD 卡。
+ *
+ * 进程内只有一个实例，接口只在主线程调用。
+ */
+class LoudnessAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static LoudnessAnalyzer *instance();
+
+    // 需要分析的曲目（通常是整个音乐库），替换上一次的列表；
+    // 已分析且文件没有变化的跳过，不在列表中的缓存项删除
+    void analyze(const QStringList &paths);
+
+    // 让这首曲目排在最前面（当前或下一首）
+    void prioritize(const QString &path);
+
+    // 响度校正增益（dB），尚未分析或无法分析时返回 false
+    bool trackGain(const QString &path, float &gainDb) const;
+
+    /**
+     * @brief 分析统计
+     */
+    struct Stats {
+        int cached = 0;             // 已有结果的曲目
+        int pending = 0;            // 排队中的曲目
+        quint64 analyzed = 0;       // 本次运行分析的曲目
+        qint64 audioMs = 0;         // 其音频总时长
+        qint64 busyMs = 0;          // 分析耗时（不含让出 CPU 的时间）
+        int sharePercent = 0;       // 当前允许占用的 CPU 比例
+    };
+    Stats stats() const;
+
+signals:
+    // 一首曲目分析完成（跨线程发出，排队到接收者线程）
+    void analyzed(const QString &path);
+
+private:
+    explicit LoudnessAnalyzer(const QString &cachePath, QObject *parent = nullptr);
+    ~LoudnessAnalyzer();
+
+    struct Entry {
+        qint64 mtime = 0;
+        qint64 size = 0;
+        float lufs = 0;
+        float peak = 0;
+    };
+
+    // 以下在工作线程中执行
+    void workerLoop();
+    bool measure(const QString &path, Entry &entry);
+    void throttle(qint64 workNs);
+    void updateShare();
+    void loadCache();
+    void saveCache();
+
+    QString m_cachePath;
+    QThread *m_thread;
+
+    // 工作线程独占
+    qint64 m_lastTotalTicks;
+    qint64 m_lastIdleTicks;
+    qint64 m_lastCpuNs;
+    qint64 m_lastSampleNs;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    QHash<QString, Entry> m_entries;
+    QSet<QString> m_failed;             // 无法解码，本次运行不再尝试
+    QList<QString> m_queue;
+    QSet<QString> m_wanted;             // 最近一次 analyze() 的曲目
+    bool m_rescan;                      // analyze() 之后尚未清理缓存项
+    bool m_dirty;
+    bool m_quit;
+    Stats m_stats;
+    double m_share;
+};
+
+#endif // LOUDNESSANALYZER_H
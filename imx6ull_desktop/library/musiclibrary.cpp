@@ -0,0 +1,749 @@
+#include "musiclibrary.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+// 索引文件格式
+static const quint32 kIndexMagic = 0x4D4C4942;     // "MLIB"
+static const quint32 kIndexVersion = 1;
+
+// 目录变化合并窗口：拷贝整张专辑时只发布/保存一次
+static const int kDebounceMs = 500;
+
+// 持续有变化（如首次读取元数据）时，最长隔这么久向界面发布一次
+static const int kMaxPublishDelayMs = 2000;
+
+// 元数据读取以 I/O 等待为主，两个线程可以让 SD 卡请求重叠，单核上也有收益
+static const int kMetadataWorkers = 2;
+static const int kMetadataNice = 10;
+
+static const quint32 kWatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                  | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+MusicLibrary *MusicLibrary::instance()
+{
+    static MusicLibrary *s_instance = nullptr;
+    if (!s_instance) {
+        QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        s_instance = new MusicLibrary("/music", cacheDir + "/music-library.idx", QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+MusicLibrary::MusicLibrary(const QString &rootPath, const QString &indexPath, QObject *parent)
+    : QObject(parent)
+    , m_rootPath(rootPath)
+    , m_indexPath(indexPath)
+    , m_thread(nullptr)
+    , m_inotifyFd(-1)
+    , m_wakeFd(-1)
+    , m_dirty(false)
+    , m_metaBatchFiles(0)
+    , m_started(false)
+    , m_quit(false)
+    , m_loaded(false)
+    , m_reconciled(false)
+    , m_metaBusy(0)
+{
+}
+
+MusicLibrary::~MusicLibrary()
+{
+    if (m_thread) {
+        {
+            QMutexLocker locker(&m_mutex);
+            m_quit = true;
+            m_metaCond.wakeAll();
+        }
+        quint64 one = 1;
+        ssize_t ret = ::write(m_wakeFd, &one, sizeof(one));
+        Q_UNUSED(ret);
+        for (QThread *worker : m_workers) {
+            worker->wait();
+            delete worker;
+        }
+        m_thread->wait();
+        delete m_thread;
+    }
+
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd);
+    }
+    if (m_wakeFd >= 0) {
+        ::close(m_wakeFd);
+    }
+}
+
+void MusicLibrary::start()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_started) {
+            return;
+        }
+        m_started = true;
+    }
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_inotifyFd < 0) {
+        qDebug() << "MusicLibrary: inotify unavailable, errno" << errno;
+    }
+
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("MusicLibrary");
+    // 扫描与解析不应与界面和音频输出争抢 CPU
+    m_thread->start(QThread::LowPriority);
+
+    for (int i = 0; i < kMetadataWorkers; ++i) {
+        QThread *worker = new BoardThread([this] { workerLoop(); });
+        worker->setObjectName(QString("MusicMeta%1").arg(i));
+        worker->start(QThread::LowestPriority);
+        m_workers.append(worker);
+    }
+}
+
+QVector<TrackRecord> MusicLibrary::tracks() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_snapshot;
+}
+
+bool MusicLibrary::isLoaded() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_loaded;
+}
+
+bool MusicLibrary::isReconciled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_reconciled;
+}
+
+void MusicLibrary::prioritize(const QStringList &paths)
+{
+    QMutexLocker locker(&m_mutex);
+    m_metaUrgent.clear();
+    for (const QString &path : paths) {
+        if (m_metaQueued.contains(path)) {
+            m_metaUrgent.append(path);
+        }
+    }
+}
+
+MusicLibrary::MetadataStats MusicLibrary::metadataStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    MetadataStats stats = m_metaStats;
+    stats.pending = m_metaQueued.size();
+    return stats;
+}
+
+bool MusicLibrary::isAudioFile(const QString &fileName)
+{
+    int dot = fileName.lastIndexOf('.');
+    if (dot < 0) {
+        return false;
+    }
+    // 没有编入解码器的格式不列出，免得每首都报“不支持”
+    QString suffix = fileName.mid(dot + 1).toLower();
+#ifdef HAVE_LIBMAD
+    if (suffix == "mp3") {
+        return true;
+    }
+#endif
+#ifdef HAVE_TREMOR
+    if (suffix == "ogg") {
+        return true;
+    }
+#endif
+    return suffix == "wav" || suffix == "flac";
+}
+
+void MusicLibrary::parseFileName(TrackRecord &record) const
+{
+    // 从文件名解析艺术家和标题 (格式: 艺术家 - 歌名.mp3)
+    QString baseName = QFileInfo(record.path).completeBaseName();
+    QStringList parts = baseName.split(" - ");
+    if (parts.size() >= 2) {
+        record.artist = parts[0].trimmed();
+        record.title = parts[1].trimmed();
+    } else {
+        record.artist = "未知艺术家";
+        record.title = baseName;
+    }
+}
+
+bool MusicLibrary::loadIndex()
+{
+    QFile file(m_indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version, dirCount;
+    QByteArray root;
+    in >> magic >> version >> root >> dirCount;
+    if (in.status() != QDataStream::Ok || magic != kIndexMagic || version != kIndexVersion
+            || QString::fromUtf8(root) != m_rootPath) {
+        qDebug() << "MusicLibrary: ignoring stale index" << m_indexPath;
+        return false;
+    }
+
+    // 目录表：每首曲目只存目录编号与文件名
+    QVector<QString> dirs;
+    dirs.reserve(int(dirCount));
+    for (quint32 i = 0; i < dirCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray dir;
+        in >> dir;
+        dirs.append(QString::fromUtf8(dir));
+    }
+
+    quint32 trackCount;
+    in >> trackCount;
+    m_records.clear();
+    m_records.reserve(int(trackCount));
+    for (quint32 i = 0; i < trackCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 dirIndex;
+        QByteArray name, title, artist, album;
+        TrackRecord record;
+        in >> dirIndex >> name >> record.mtime >> record.size >> title >> artist >> album
+           >> record.durationMs >> record.flags;
+        if (dirIndex >= quint32(dirs.size())) {
+            break;
+        }
+        record.path = dirs[int(dirIndex)] + '/' + QString::fromUtf8(name);
+        record.title = QString::fromUtf8(title);
+        record.artist = QString::fromUtf8(artist);
+        record.album = QString::fromUtf8(album);
+        m_records.insert(record.path, record);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "MusicLibrary: index truncated, rebuilding";
+        m_records.clear();
+        return false;
+    }
+    return true;
+}
+
+bool MusicLibrary::saveIndex()
+{
+    QDir().mkpath(QFileInfo(m_indexPath).absolutePath());
+
+    // 先收集目录表
+    QHash<QString, quint32> dirIndex;
+    QVector<QString> dirs;
+    for (QHash<QString, TrackRecord>::const_iterator it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+        QString dir = it.key().left(it.key().lastIndexOf('/'));
+        if (!dirIndex.contains(dir)) {
+            dirIndex.insert(dir, quint32(dirs.size()));
+            dirs.append(dir);
+        }
+    }
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_6);
+        out << kIndexMagic << kIndexVersion << m_rootPath.toUtf8() << quint32(dirs.size());
+        for (const QString &dir : dirs) {
+            out << dir.toUtf8();
+        }
+        out << quint32(m_records.size());
+        for (QHash<QString, TrackRecord>::const_iterator it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+            const TrackRecord &record = it.value();
+            int slash = record.path.lastIndexOf('/');
+            out << dirIndex.value(record.path.left(slash)) << record.path.mid(slash + 1).toUtf8()
+                << record.mtime << record.size << record.title.toUtf8() << record.artist.toUtf8()
+                << record.album.toUtf8() << record.durationMs << record.flags;
+        }
+    }
+
+    // 写临时文件后原子替换，掉电不会留下半个索引
+    QSaveFile file(m_indexPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qDebug() << "MusicLibrary: failed to save index" << m_indexPath;
+        return false;
+    }
+    return true;
+}
+
+void MusicLibrary::addWatch(const QString &dirPath)
+{
+    if (m_inotifyFd < 0) {
+        return;
+    }
+    int wd = inotify_add_watch(m_inotifyFd, QFile::encodeName(dirPath).constData(), kWatchMask);
+    if (wd < 0) {
+        // ENOSPC：超出 fs.inotify.max_user_watches，该目录只在下次对账时更新
+        static bool s_warned = false;
+        if (!s_warned) {
+            qDebug() << "MusicLibrary: inotify_add_watch failed for" << dirPath << "errno" << errno;
+            s_warned = true;
+        }
+        return;
+    }
+    m_watches.insert(wd, dirPath);
+}
+
+void MusicLibrary::scanDirectory(const QString &dirPath, QHash<QString, TrackRecord> &seen)
+{
+    addWatch(dirPath);
+
+    QByteArray encoded = QFile::encodeName(dirPath);
+    DIR *dir = opendir(encoded.constData());
+    if (!dir) {
+        return;
+    }
+    int fd = dirfd(dir);
+
+    QStringList subdirs;
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') {
+            continue;   // 跳过 . .. 与隐藏文件
+        }
+
+        // 相对目录 fd 做 fstatat，避免每个文件都重新解析完整路径
+        struct stat st;
+        if (fstatat(fd, entry->d_name, &st, 0) < 0) {
+            continue;
+        }
+
+        QString name = QFile::decodeName(entry->d_name);
+        if (S_ISDIR(st.st_mode)) {
+            subdirs << dirPath + '/' + name;
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || !isAudioFile(name)) {
+            continue;
+        }
+
+        QString path = dirPath + '/' + name;
+        QHash<QString, TrackRecord>::const_iterator it = m_records.constFind(path);
+        if (it != m_records.constEnd() && it.value().mtime == qint64(st.st_mtime)
+                && it.value().size == qint64(st.st_size)) {
+            seen.insert(path, it.value());
+            queueMetadata(it.value());
+            continue;
+        }
+
+        // 新文件或已修改：重新解析
+        TrackRecord record;
+        record.path = path;
+        record.mtime = qint64(st.st_mtime);
+        record.size = qint64(st.st_size);
+        parseFileName(record);
+        seen.insert(path, record);
+        queueMetadata(record);
+        m_dirty = true;
+    }
+    closedir(dir);
+
+    for (const QString &subdir : subdirs) {
+        scanDirectory(subdir, seen);
+    }
+}
+
+bool MusicLibrary::updateFile(const QString &path)
+{
+    struct stat st;
+    if (stat(QFile::encodeName(path).constData(), &st) < 0 || !S_ISREG(st.st_mode)) {
+        return m_records.remove(path) > 0;
+    }
+
+    TrackRecord &record = m_records[path];
+    if (record.path == path && record.mtime == qint64(st.st_mtime) && record.size == qint64(st.st_size)) {
+        return false;
+    }
+    record = TrackRecord();
+    record.path = path;
+    record.mtime = qint64(st.st_mtime);
+    record.size = qint64(st.st_size);
+    parseFileName(record);
+    queueMetadata(record);
+    return true;
+}
+
+void MusicLibrary::removePrefix(const QString &dirPath)
+{
+    QString prefix = dirPath + '/';
+    for (QHash<QString, TrackRecord>::iterator it = m_records.begin(); it != m_records.end(); ) {
+        if (it.key().startsWith(prefix)) {
+            it = m_records.erase(it);
+            m_dirty = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MusicLibrary::reconcile()
+{
+    // 重新建立全部监视，已删除目录的 watch 会由内核以 IN_IGNORED 通知
+    QHash<QString, TrackRecord> seen;
+    seen.reserve(m_records.size());
+    scanDirectory(m_rootPath, seen);
+
+    if (seen.size() != m_records.size()) {
+        m_dirty = true;     // 有文件被删除
+    }
+    m_records.swap(seen);
+}
+
+void MusicLibrary::handleInotify()
+{
+    // inotify_event 需要按其自身对齐
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;) {
+        ssize_t len = ::read(m_inotifyFd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            break;
+        }
+
+        for (char *p = buffer; p < buffer + len; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // 事件丢失，整体对账一次
+                qDebug() << "MusicLibrary: inotify queue overflow, rescanning";
+                reconcile();
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_watches.remove(event->wd);
+                continue;
+            }
+
+            QString dirPath = m_watches.value(event->wd);
+            if (dirPath.isEmpty() || event->len == 0) {
+                continue;
+            }
+            QString name = QFile::decodeName(event->name);
+            if (name.startsWith('.')) {
+                continue;
+            }
+            QString path = dirPath + '/' + name;
+
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    // 新目录（或移入的目录树）：扫描整棵子树
+                    QHash<QString, TrackRecord> seen;
+                    scanDirectory(path, seen);
+                    for (QHash<QString, TrackRecord>::const_iterator it = seen.constBegin(); it != seen.constEnd(); ++it) {
+                        m_records.insert(it.key(), it.value());
+                    }
+                    m_dirty = true;
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                    removePrefix(path);
+                }
+                continue;
+            }
+
+            if (!isAudioFile(name)) {
+                continue;
+            }
+            // 文件只在写完（或整体移入）后处理，IN_CREATE 时内容可能还不完整
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                if (updateFile(path)) {
+                    m_dirty = true;
+                }
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                if (m_records.remove(path) > 0) {
+                    m_dirty = true;
+                }
+            }
+        }
+    }
+}
+
+void MusicLibrary::publish()
+{
+    QVector<TrackRecord> snapshot;
+    snapshot.reserve(m_records.size());
+    for (QHash<QString, TrackRecord>::const_iterator it = m_records.constBegin(); it != m_records.constEnd(); ++it) {
+        snapshot.append(it.value());
+    }
+    std::sort(snapshot.begin(), snapshot.end(), [](const TrackRecord &a, const TrackRecord &b) {
+        return a.path < b.path;
+    });
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_snapshot.swap(snapshot);
+    }
+    emit tracksChanged();
+}
+
+void MusicLibrary::queueMetadata(const TrackRecord &record)
+{
+    if (!(record.flags & (TrackRecord::MetadataRead | TrackRecord::MetadataFailed))) {
+        m_metaNew.append(record.path);
+    }
+}
+
+void MusicLibrary::flushMetadataQueue()
+{
+    if (m_metaNew.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_metaQueued.isEmpty() && m_metaBusy == 0) {
+        m_metaBatchTimer.start();
+        m_metaBatchFiles = 0;
+    }
+    for (const QString &path : m_metaNew) {
+        if (!m_metaQueued.contains(path)) {
+            m_metaQueued.insert(path);
+            m_metaQueue.append(path);
+        }
+    }
+    m_metaNew.clear();
+    m_metaCond.wakeAll();
+}
+
+void MusicLibrary::applyMetadata()
+{
+    QVector<MetadataResult> results;
+    bool drained;
+    {
+        QMutexLocker locker(&m_mutex);
+        results.swap(m_metaResults);
+        drained = m_metaQueued.isEmpty() && m_metaBusy == 0;
+    }
+
+    for (const MetadataResult &result : results) {
+        // 读取期间文件被删除或改写时丢弃结果，变化事件会重新排队
+        QHash<QString, TrackRecord>::iterator it = m_records.find(result.path);
+        if (it == m_records.end() || it->mtime != result.info.mtime || it->size != result.info.size) {
+            continue;
+        }
+        TrackRecord &record = it.value();
+        if (result.ok) {
+            if (!result.info.title.isEmpty()) {
+                record.title = result.info.title;
+            }
+            if (!result.info.artist.isEmpty()) {
+                record.artist = result.info.artist;
+            }
+            record.album = result.info.album;
+            record.durationMs = result.info.durationMs;
+            record.flags |= TrackRecord::MetadataRead;
+        } else {
+            record.flags |= TrackRecord::MetadataFailed;
+        }
+        m_dirty = true;
+    }
+    m_metaBatchFiles += results.size();
+
+    if (drained && m_metaBatchFiles > 0) {
+        MetadataStats stats = metadataStats();
+        qint64 elapsed = m_metaBatchTimer.elapsed();
+        quint64 files = stats.parsed + stats.failed;
+        qDebug() << "MusicLibrary: metadata for" << m_metaBatchFiles << "files in" << elapsed << "ms,"
+                 << "avg" << (files ? stats.totalNs / qint64(files) / 1000 : 0) << "us/file,"
+                 << "max" << stats.maxNs / 1000000 << "ms,"
+                 << "read" << (files ? stats.bytesRead / files : 0) << "bytes/file,"
+                 << "failed" << stats.failed;
+        emit metadataFinished(m_metaBatchFiles, elapsed);
+        m_metaBatchFiles = 0;
+    }
+}
+
+bool MusicLibrary::takeMetadataJobLocked(QString &path)
+{
+    // 先取可见区域，再按扫描顺序；已被取走的路径直接跳过
+    while (!m_metaUrgent.isEmpty()) {
+        path = m_metaUrgent.takeFirst();
+        if (m_metaQueued.remove(path)) {
+            return true;
+        }
+    }
+    while (!m_metaQueue.isEmpty()) {
+        path = m_metaQueue.takeFirst();
+        if (m_metaQueued.remove(path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MusicLibrary::workerLoop()
+{
+    // Linux 上 nice 值对单个线程生效，让出 CPU 给界面、解码与音频输出
+    setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), kMetadataNice);
+
+    QElapsedTimer timer;
+    for (;;) {
+        QString path;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_quit && !takeMetadataJobLocked(path)) {
+                m_metaCond.wait(&m_mutex);
+            }
+            if (m_quit) {
+                return;
+            }
+            ++m_metaBusy;
+        }
+
+        MetadataResult result;
+        result.path = path;
+        timer.start();
+        result.ok = TagReader::read(path, result.info);
+        result.costNs = timer.nsecsElapsed();
+
+        {
+            QMutexLocker locker(&m_mutex);
+            --m_metaBusy;
+            m_metaResults.append(result);
+            if (result.ok) {
+                ++m_metaStats.parsed;
+            } else {
+                ++m_metaStats.failed;
+            }
+            m_metaStats.bytesRead += result.info.bytesRead;
+            m_metaStats.totalNs += result.costNs;
+            m_metaStats.maxNs = qMax(m_metaStats.maxNs, result.costNs);
+        }
+
+        // 唤醒音乐库线程合并结果
+        quint64 one = 1;
+        ssize_t ret = ::write(m_wakeFd, &one, sizeof(one));
+        Q_UNUSED(ret);
+    }
+}
+
+void MusicLibrary::threadLoop()
+{
+    // 1. 加载索引，立即提供上次的列表
+    QElapsedTimer timer;
+    timer.start();
+    bool loaded = loadIndex();
+    qDebug() << "MusicLibrary: index" << (loaded ? "loaded" : "missing") << m_records.size()
+             << "tracks in" << timer.elapsed() << "ms";
+    {
+        QMutexLocker locker(&m_mutex);
+        m_loaded = true;
+    }
+    publish();
+
+    // 2. 与磁盘对账，只解析新增或修改过的文件
+    timer.restart();
+    m_dirty = !loaded;
+    reconcile();
+    qint64 elapsed = timer.elapsed();
+    qDebug() << "MusicLibrary: reconciled" << m_records.size() << "tracks in" << elapsed
+             << "ms, changed:" << m_dirty << "watches:" << m_watches.size()
+             << "metadata queued:" << m_metaNew.size();
+    if (m_dirty) {
+        publish();
+        saveIndex();
+        m_dirty = false;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_reconciled = true;
+    }
+    emit reconciled(m_records.size(), elapsed);
+    flushMetadataQueue();
+
+    // 3. 由 inotify 增量维护，同时合并元数据结果
+    struct pollfd fds[2];
+    fds[0].fd = m_inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFd;
+    fds[1].events = POLLIN;
+
+    // 发布随变化合并；索引只在安静下来后保存，避免读取元数据期间反复写闪存
+    bool unsaved = false;
+    QElapsedTimer quiet;
+    QElapsedTimer dirtySince;
+    quiet.start();
+    dirtySince.start();
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_quit) {
+                break;
+            }
+        }
+
+        // 没有 eventfd 时靠超时检查退出标志
+        int timeout = m_wakeFd < 0 ? 1000 : -1;
+        if (m_dirty) {
+            qint64 wait = qMin(kDebounceMs - quiet.elapsed(), kMaxPublishDelayMs - dirtySince.elapsed());
+            timeout = int(qMax<qint64>(0, wait));
+        } else if (unsaved) {
+            timeout = int(qMax<qint64>(0, kDebounceMs - quiet.elapsed()));
+        }
+
+        int ret = ::poll(fds, 2, timeout);
+        if (ret < 0 && errno != EINTR) {
+            qDebug() << "MusicLibrary: poll failed, errno" << errno;
+            break;
+        }
+
+        // 每次有新变化都重新计时，直到目录安静下来
+        bool wasDirty = m_dirty;
+        m_dirty = false;
+        if (ret > 0 && (fds[1].revents & POLLIN)) {
+            quint64 value;
+            ssize_t n = ::read(m_wakeFd, &value, sizeof(value));
+            Q_UNUSED(n);
+            applyMetadata();
+        }
+        if (ret > 0 && (fds[0].revents & POLLIN)) {
+            handleInotify();
+            flushMetadataQueue();
+        }
+        if (m_dirty) {
+            quiet.restart();
+            if (!wasDirty) {
+                dirtySince.restart();
+            }
+        }
+        m_dirty = m_dirty || wasDirty;
+
+        if (m_dirty && (quiet.elapsed() >= kDebounceMs || dirtySince.elapsed() >= kMaxPublishDelayMs)) {
+            publish();
+            m_dirty = false;
+            unsaved = true;
+        }
+        if (unsaved && !m_dirty && quiet.elapsed() >= kDebounceMs) {
+            saveIndex();
+            unsaved = false;
+        }
+    }
+
+    if (m_dirty || unsaved) {
+        saveIndex();
+    }
+}
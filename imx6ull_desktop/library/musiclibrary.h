@@ -0,0 +1,158 @@
+#ifndef MUSICLIBRARY_H
+#define MUSICLIBRARY_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include "tagreader.h"
+
+class QThread;
+
+/**
+ * @brief 音乐库中的一首曲目
+ */
+struct TrackRecord {
+    enum Flag {
+        MetadataRead = 0x1,     // 已从文件头读取标签与时长
+        MetadataFailed = 0x2    // 无法识别，只保留文件名解析结果
+    };
+
+    QString path;
+    qint64 mtime = 0;       // 修改时间（秒）
+    qint64 size = 0;
+    QString title;
+    QString artist;
+    QString album;
+    qint32 durationMs = 0;  // 0 表示未知
+    quint32 flags = 0;
+};
+
+/**
+ * @brief 音乐库
+ *
+ * 索引（路径、修改时间、大小、元数据）保存在缓存目录下的二进制文件中。
+ * 启动时先加载索引立即提供列表，再在后台线程递归扫描音乐目录与索引对账，
+ * 之后由 inotify 增量维护，只对新增或修改过的文件重新解析。
+ *
+ * 标签与时长由低优先级的工作线程池逐个读取，结果回到音乐库线程合并，
+ * 分批发布给界面；界面可用 prioritize() 让可见行先读取。
+ *
+ * 进程内只有一个实例，播放器每次打开都直接使用已有的列表。
+ */
+class MusicLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MusicLibrary *instance();
+
+    // 启动后台线程（只在第一次调用时生效）
+    void start();
+
+    QString rootPath() const { return m_rootPath; }
+
+    // 当前曲目列表（按路径排序），隐式共享，复制开销很小
+    QVector<TrackRecord> tracks() const;
+
+    // 索引已加载（或确认不存在）
+    bool isLoaded() const;
+
+    // 第一次目录对账已完成
+    bool isReconciled() const;
+
+    static bool isAudioFile(const QString &fileName);
+
+    // 让这些曲目的元数据优先读取（通常是列表可见区域），替换上一次的优先集合
+    void prioritize(const QStringList &paths);
+
+    /**
+     * @brief 元数据读取统计
+     */
+    struct MetadataStats {
+        quint64 parsed = 0;
+        quint64 failed = 0;
+        quint64 bytesRead = 0;
+        qint64 totalNs = 0;     // 各文件读取耗时之和
+        qint64 maxNs = 0;
+        int pending = 0;        // 队列中尚未读取的文件
+    };
+    MetadataStats metadataStats() const;
+
+signals:
+    // 列表发生变化（跨线程发出，排队到接收者线程）
+    void tracksChanged();
+    void reconciled(int tracks, qint64 elapsedMs);
+    // 一批元数据读取全部完成
+    void metadataFinished(int files, qint64 elapsedMs);
+
+private:
+    friend class LibraryBenchmark;     // 用临时索引构造独立实例
+
+    MusicLibrary(const QString &rootPath, const QString &indexPath, QObject *parent = nullptr);
+    ~MusicLibrary();
+
+    // 以下在后台线程中执行
+    void threadLoop();
+    bool loadIndex();
+    bool saveIndex();
+    void reconcile();
+    void scanDirectory(const QString &dirPath, QHash<QString, TrackRecord> &seen);
+    bool updateFile(const QString &path);
+    void removePrefix(const QString &dirPath);
+    void addWatch(const QString &dirPath);
+    void handleInotify();
+    void publish();
+    void parseFileName(TrackRecord &record) const;
+    void queueMetadata(const TrackRecord &record);
+    void flushMetadataQueue();
+    void applyMetadata();
+
+    // 以下在元数据工作线程中执行
+    void workerLoop();
+    bool takeMetadataJobLocked(QString &path);
+
+    struct MetadataResult {
+        QString path;
+        TagInfo info;
+        bool ok;
+        qint64 costNs;
+    };
+
+    QString m_rootPath;
+    QString m_indexPath;
+    QThread *m_thread;
+    QVector<QThread *> m_workers;
+
+    // 后台线程独占
+    QHash<QString, TrackRecord> m_records;
+    QHash<int, QString> m_watches;      // inotify watch → 目录
+    int m_inotifyFd;
+    int m_wakeFd;
+    bool m_dirty;
+    QStringList m_metaNew;              // 待提交给工作线程的路径
+    QElapsedTimer m_metaBatchTimer;
+    int m_metaBatchFiles;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QVector<TrackRecord> m_snapshot;
+    bool m_started;
+    bool m_quit;
+    bool m_loaded;
+    bool m_reconciled;
+    QWaitCondition m_metaCond;
+    QList<QString> m_metaQueue;         // 按扫描顺序
+    QList<QString> m_metaUrgent;        // 可见区域，优先
+    QSet<QString> m_metaQueued;         // 尚未被取走的路径
+    QVector<MetadataResult> m_metaResults;
+    int m_metaBusy;                     // 正在读取的文件数
+    MetadataStats m_metaStats;
+};
+
+#endif // MUSICLIBRARY_H
@@ -0,0 +1,102 @@
+#include "pinyin.h"
+#include <QTextCodec>
+#include <QByteArray>
+#include <QDebug>
+
+// CJK 统一表意文字基本区
+static const ushort kFirstHan = 0x4E00;
+static const ushort kLastHan = 0x9FA5;
+
+// GB2312 一级汉字中各首字母的起始编码（没有 i、u、v 开头的拼音）
+struct InitialRange {
+    ushort code;
+    char letter;
+};
+
+static const InitialRange kRanges[] = {
+    { 0xB0A1, 'a' }, { 0xB0C5, 'b' }, { 0xB2C1, 'c' }, { 0xB4EE, 'd' },
+    { 0xB6EA, 'e' }, { 0xB7A2, 'f' }, { 0xB8C1, 'g' }, { 0xB9FE, 'h' },
+    { 0xBBF7, 'j' }, { 0xBFA6, 'k' }, { 0xC0AC, 'l' }, { 0xC2E8, 'm' },
+    { 0xC4C3, 'n' }, { 0xC5B6, 'o' }, { 0xC5BE, 'p' }, { 0xC6DA, 'q' },
+    { 0xC8BB, 'r' }, { 0xC8F6, 's' }, { 0xCBFA, 't' }, { 0xCDDA, 'w' },
+    { 0xCEF4, 'x' }, { 0xD1B9, 'y' }, { 0xD4D1, 'z' },
+};
+
+// 一级汉字的最后一个编码
+static const ushort kLastLevel1 = 0xD7F9;
+
+static char initialForGbk(ushort code)
+{
+    if (code < kRanges[0].code || code > kLastLevel1) {
+        return 0;
+    }
+    char letter = 0;
+    for (const InitialRange &range : kRanges) {
+        if (code < range.code) {
+            break;
+        }
+        letter = range.letter;
+    }
+    return letter;
+}
+
+static QByteArray buildTable()
+{
+    int count = kLastHan - kFirstHan + 1;
+    QByteArray table(count, '\0');
+
+    QTextCodec *codec = QTextCodec::codecForName("GBK");
+    if (!codec) {
+        qDebug() << "Pinyin: GBK codec unavailable, no pinyin initials";
+        return table;
+    }
+
+    // 整个区间一次转换，基本区的字符在 GBK 中都是双字节
+    QString text(count, Qt::Uninitialized);
+    for (int i = 0; i < count; ++i) {
+        text[i] = QChar(ushort(kFirstHan + i));
+    }
+    QByteArray gbk = codec->fromUnicode(text);
+    if (gbk.size() != count * 2) {
+        qDebug() << "Pinyin: unexpected GBK output size" << gbk.size();
+        return table;
+    }
+
+    const uchar *p = reinterpret_cast<const uchar *>(gbk.constData());
+    for (int i = 0; i < count; ++i) {
+        table[i] = initialForGbk(ushort((p[i * 2] << 8) | p[i * 2 + 1]));
+    }
+    return table;
+}
+
+char Pinyin::initial(QChar ch)
+{
+    // C++11 保证局部静态变量只初始化一次
+    static const QByteArray table = buildTable();
+    ushort code = ch.unicode();
+    if (code < kFirstHan || code > kLastHan) {
+        return 0;
+    }
+    return table.at(code - kFirstHan);
+}
+
+QString Pinyin::initials(const QString &text)
+{
+    QString result;
+    bool inWord = false;
+    for (QChar ch : text) {
+        char letter = initial(ch);
+        if (letter) {
+            result += QLatin1Char(letter);
+            inWord = false;
+        } else if (ch.isLetterOrNumber() && ch.unicode() < 0x3000) {
+            if (!inWord) {
+                result += ch.toLower();
+            }
+            inWord = true;
+        } else {
+            inWord = false;
+        }
+    }
+    return result;
+}
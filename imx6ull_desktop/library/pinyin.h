@@ -0,0 +1,26 @@
+#ifndef PINYIN_H
+#define PINYIN_H
+
+#include <QString>
+
+/**
+ * @brief 汉字拼音首字母
+ *
+ * GB2312 一级汉字按拼音排序，编码区间即可确定首字母，不需要完整的拼音表。
+ * 第一次调用时把 CJK 基本区整体转换为 GBK，生成每个汉字的首字母表，之后查表。
+ * 二级汉字（按部首排序）和没有 GBK 编码的字符没有首字母。
+ *
+ * 线程安全。
+ */
+class Pinyin
+{
+public:
+    // 汉字的拼音首字母（小写），无法确定时返回 0
+    static char initial(QChar ch);
+
+    // 文本的首字母串：汉字取拼音首字母，其他文字的每个单词取第一个字母或数字，
+    // 例如 "周杰伦" → "zjl"，"Love 稻香" → "ldx"
+    static QString initials(const QString &text);
+};
+
+#endif // PINYIN_H
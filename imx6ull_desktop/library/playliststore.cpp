@@ -0,0 +1,217 @@
+#include "playliststore.h"
+#include "boardthread.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QDebug>
+
+// 文件格式
+static const quint32 kStoreMagic = 0x4D504C53;     // "MPLS"
+static const quint32 kStoreVersion = 1;
+
+static void writeList(QDataStream &out, const QStringList &paths)
+{
+    out << quint32(paths.size());
+    for (const QString &path : paths) {
+        out << path.toUtf8();
+    }
+}
+
+static QStringList readList(QDataStream &in)
+{
+    quint32 count;
+    in >> count;
+    QStringList paths;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray path;
+        in >> path;
+        paths.append(QString::fromUtf8(path));
+    }
+    return paths;
+}
+
+PlaylistStore *PlaylistStore::instance()
+{
+    static PlaylistStore *s_instance = nullptr;
+    if (!s_instance) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        s_instance = new PlaylistStore(dataDir + "/playlists.dat", QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+PlaylistStore::PlaylistStore(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+    , m_thread(nullptr)
+    , m_pending(false)
+    , m_quit(false)
+{
+    load();
+
+    m_thread = new BoardThread([this] { writerLoop(); });
+    m_thread->setObjectName("PlaylistStore");
+    m_thread->start(QThread::LowPriority);
+}
+
+PlaylistStore::~PlaylistStore()
+{
+    // 退出前写完最后一份
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void PlaylistStore::load()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QByteArray data = file.readAll();
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != kStoreMagic || version != kStoreVersion) {
+        qDebug() << "PlaylistStore: ignoring unknown file" << m_filePath;
+        return;
+    }
+
+    QStringList favorites = readList(in);
+    quint32 playlistCount;
+    in >> playlistCount;
+    QMap<QString, QStringList> playlists;
+    for (quint32 i = 0; i < playlistCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray name;
+        in >> name;
+        playlists.insert(QString::fromUtf8(name), readList(in));
+    }
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "PlaylistStore: truncated file" << m_filePath;
+        return;
+    }
+
+    m_favorites = favorites;
+    m_favoriteSet = QSet<QString>::fromList(favorites);
+    m_playlists = playlists;
+    qDebug() << "PlaylistStore:" << m_favorites.size() << "favorites," << m_playlists.size() << "playlists";
+}
+
+void PlaylistStore::scheduleSave()
+{
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_6);
+        out << kStoreMagic << kStoreVersion;
+        writeList(out, m_favorites);
+        out << quint32(m_playlists.size());
+        for (QMap<QString, QStringList>::const_iterator it = m_playlists.constBegin(); it != m_playlists.constEnd(); ++it) {
+            out << it.key().toUtf8();
+            writeList(out, it.value());
+        }
+    }
+
+    // 尚未写入的旧数据直接被替换
+    QMutexLocker locker(&m_mutex);
+    m_pendingData = data;
+    m_pending = true;
+    m_cond.wakeAll();
+}
+
+void PlaylistStore::setFavorite(const QString &path, bool favorite)
+{
+    if (favorite == m_favoriteSet.contains(path)) {
+        return;
+    }
+    if (favorite) {
+        m_favorites.append(path);
+        m_favoriteSet.insert(path);
+    } else {
+        m_favorites.removeOne(path);
+        m_favoriteSet.remove(path);
+    }
+    scheduleSave();
+    emit favoritesChanged();
+}
+
+bool PlaylistStore::createPlaylist(const QString &name)
+{
+    if (name.isEmpty() || m_playlists.contains(name)) {
+        return false;
+    }
+    m_playlists.insert(name, QStringList());
+    scheduleSave();
+    emit playlistsChanged();
+    return true;
+}
+
+void PlaylistStore::removePlaylist(const QString &name)
+{
+    if (m_playlists.remove(name) == 0) {
+        return;
+    }
+    scheduleSave();
+    emit playlistsChanged();
+}
+
+bool PlaylistStore::addToPlaylist(const QString &name, const QString &path)
+{
+    QMap<QString, QStringList>::iterator it = m_playlists.find(name);
+    if (it == m_playlists.end() || it.value().contains(path)) {
+        return false;
+    }
+    it.value().append(path);
+    scheduleSave();
+    emit playlistsChanged();
+    return true;
+}
+
+void PlaylistStore::removeFromPlaylist(const QString &name, const QString &path)
+{
+    QMap<QString, QStringList>::iterator it = m_playlists.find(name);
+    if (it == m_playlists.end() || !it.value().removeOne(path)) {
+        return;
+    }
+    scheduleSave();
+    emit playlistsChanged();
+}
+
+void PlaylistStore::writerLoop()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        if (!m_pending) {
+            if (m_quit) {
+                break;
+            }
+            m_cond.wait(&m_mutex);
+            continue;
+        }
+        QByteArray data = m_pendingData;
+        m_pendingData.clear();
+        m_pending = false;
+        locker.unlock();
+
+        // 写临时文件后原子替换，掉电不会丢掉整个收藏
+        QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+        QSaveFile file(m_filePath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+            qDebug() << "PlaylistStore: failed to save" << m_filePath;
+        }
+
+        locker.relock();
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef PLAYLISTSTORE_H
+#define PLAYLISTSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QSet>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+/**
+ * @brief 收藏与用户歌单
+ *
+ * 曲目按文件路径记录，音乐库重新扫描后仍然有效。数据保存在应用数据目录下的
+ * 二进制文件中，启动时同步读入（文件很小）；每次修改后把序列化结果交给写入线程，
+ * 由它用 QSaveFile 落盘，连续修改只写最后一份，界面线程不等待 SD 卡。
+ *
+ * 进程内只有一个实例，只在主线程中使用。
+ */
+class PlaylistStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PlaylistStore *instance();
+
+    // 收藏（按收藏的先后顺序）
+    QStringList favorites() const { return m_favorites; }
+    bool isFavorite(const QString &path) const { return m_favoriteSet.contains(path); }
+    void setFavorite(const QString &path, bool favorite);
+
+    // 歌单（按名称排序）
+    QStringList playlistNames() const { return m_playlists.keys(); }
+    bool hasPlaylist(const QString &name) const { return m_playlists.contains(name); }
+    QStringList playlist(const QString &name) const { return m_playlists.value(name); }
+    bool createPlaylist(const QString &name);
+    void removePlaylist(const QString &name);
+    // 已在歌单中时不重复添加，返回 false
+    bool addToPlaylist(const QString &name, const QString &path);
+    void removeFromPlaylist(const QString &name, const QString &path);
+
+signals:
+    void favoritesChanged();
+    void playlistsChanged();
+
+private:
+    explicit PlaylistStore(const QString &filePath, QObject *parent = nullptr);
+    ~PlaylistStore();
+
+    void load();
+    void scheduleSave();
+    void writerLoop();
+
+    QString m_filePath;
+    QStringList m_favorites;
+    QSet<QString> m_favoriteSet;
+    QMap<QString, QStringList> m_playlists;
+    QThread *m_thread;
+
+    // 以下成员由 m_mutex 保护
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QByteArray m_pendingData;
+    bool m_pending;
+    bool m_quit;
+};
+
+#endif // PLAYLISTSTORE_H
@@ -0,0 +1,289 @@
+#include "searchindex.h"
+#include "pinyin.h"
+#include "boardthread.h"
+#include <QThread>
+#include <QMutexLocker>
+#include <QStringRef>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 检索文本中各字段之间的分隔符，不会出现在规范化后的查询串里，
+// 跨字段的二元组不建索引，子串匹配也不会跨字段
+static const QChar kSeparator = QChar(0x1F);
+
+static const int kBuilderNice = 10;
+
+static inline quint32 bigramKey(QChar a, QChar b)
+{
+    return (quint32(a.unicode()) << 16) | b.unicode();
+}
+
+static QString searchText(const SearchIndex::Entry &entry)
+{
+    QString text;
+    text.reserve((entry.title.size() + entry.artist.size()) * 2 + 3);
+    text += entry.title.toLower();
+    text += kSeparator;
+    text += entry.artist.toLower();
+    text += kSeparator;
+    text += Pinyin::initials(entry.title);
+    text += kSeparator;
+    text += Pinyin::initials(entry.artist);
+    return text;
+}
+
+// 一段检索文本中出现的一元/二元组（去重）
+static void collectKeys(const QChar *text, int length, QVector<quint32> &keys)
+{
+    keys.clear();
+    for (int i = 0; i < length; ++i) {
+        if (text[i] == kSeparator) {
+            continue;
+        }
+        keys.append(text[i].unicode());
+        if (i + 1 < length && text[i + 1] != kSeparator) {
+            keys.append(bigramKey(text[i], text[i + 1]));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+// 在有序的 ids 中保留也出现在 [first, last) 中的元素
+static void intersect(QVector<int> &ids, const quint32 *first, const quint32 *last)
+{
+    int out = 0;
+    for (int i = 0; i < ids.size() && first != last; ++i) {
+        first = std::lower_bound(first, last, quint32(ids[i]));
+        if (first != last && *first == quint32(ids[i])) {
+            ids[out++] = ids[i];
+        }
+    }
+    ids.resize(out);
+}
+
+SearchIndex::SearchIndex(const QVector<Entry> &entries, quint64 generation)
+    : m_generation(generation)
+{
+    m_offsets.reserve(entries.size() + 1);
+    m_offsets.append(0);
+    for (const Entry &entry : entries) {
+        m_text += searchText(entry);
+        m_offsets.append(m_text.size());
+    }
+
+    // 两遍：先统计每个键的条目数，再按条目顺序填入，倒排表天然有序，
+    // 不需要先生成 (键, 条目) 对再整体排序
+    QHash<quint32, int> counts;
+    QVector<quint32> keys;
+    const QChar *text = m_text.constData();
+    for (int i = 0; i < entries.size(); ++i) {
+        collectKeys(text + m_offsets[i], m_offsets[i + 1] - m_offsets[i], keys);
+        for (quint32 key : keys) {
+            ++counts[key];
+        }
+    }
+
+    m_keys.reserve(counts.size());
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        m_keys.append(it.key());
+    }
+    std::sort(m_keys.begin(), m_keys.end());
+
+    QHash<quint32, int> cursors;
+    cursors.reserve(m_keys.size());
+    m_starts.resize(m_keys.size() + 1);
+    int total = 0;
+    for (int k = 0; k < m_keys.size(); ++k) {
+        m_starts[k] = total;
+        cursors.insert(m_keys[k], total);
+        total += counts.value(m_keys[k]);
+    }
+    m_starts[m_keys.size()] = total;
+    counts.clear();
+
+    m_ids.resize(total);
+    for (int i = 0; i < entries.size(); ++i) {
+        collectKeys(text + m_offsets[i], m_offsets[i + 1] - m_offsets[i], keys);
+        for (quint32 key : keys) {
+            m_ids[cursors[key]++] = quint32(i);
+        }
+    }
+}
+
+QString SearchIndex::normalize(const QString &query)
+{
+    QString result = query.trimmed().toLower();
+    result.remove(kSeparator);
+    return result;
+}
+
+int SearchIndex::postingsFor(quint32 key, const quint32 **ids) const
+{
+    auto it = std::lower_bound(m_keys.constBegin(), m_keys.constEnd(), key);
+    if (it == m_keys.constEnd() || *it != key) {
+        *ids = nullptr;
+        return 0;
+    }
+    int k = int(it - m_keys.constBegin());
+    *ids = m_ids.constData() + m_starts[k];
+    return m_starts[k + 1] - m_starts[k];
+}
+
+bool SearchIndex::contains(int entry, const QString &needle) const
+{
+    QStringRef text(&m_text, m_offsets[entry], m_offsets[entry + 1] - m_offsets[entry]);
+    return text.contains(needle);
+}
+
+QVector<int> SearchIndex::search(const QString &query) const
+{
+    return refine(QVector<int>(), query);
+}
+
+QVector<int> SearchIndex::refine(const QVector<int> &previous, const QString &query) const
+{
+    QString needle = normalize(query);
+    if (needle.isEmpty()) {
+        return QVector<int>();
+    }
+
+    struct Postings {
+        const quint32 *ids;
+        int count;
+    };
+    QVector<Postings> lists;
+    if (needle.size() == 1) {
+        Postings postings;
+        postings.count = postingsFor(needle[0].unicode(), &postings.ids);
+        lists.append(postings);
+    } else {
+        QVector<quint32> keys;
+        for (int i = 0; i + 1 < needle.size(); ++i) {
+            keys.append(bigramKey(needle[i], needle[i + 1]));
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (quint32 key : keys) {
+            Postings postings;
+            postings.count = postingsFor(key, &postings.ids);
+            lists.append(postings);
+        }
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const Postings &a, const Postings &b) {
+        return a.count < b.count;
+    });
+    if (lists.first().count == 0) {
+        return QVector<int>();
+    }
+
+    // 从最短的表（或上一次更短的结果）开始，逐个与其余的表求交集
+    QVector<int> result;
+    int next = 0;
+    if (!previous.isEmpty() && previous.size() < lists.first().count) {
+        result = previous;
+    } else {
+        const Postings &first = lists.first();
+        result.reserve(first.count);
+        for (int i = 0; i < first.count; ++i) {
+            result.append(int(first.ids[i]));
+        }
+        next = 1;
+        if (!previous.isEmpty()) {
+            intersect(result, reinterpret_cast<const quint32 *>(previous.constData()),
+                      reinterpret_cast<const quint32 *>(previous.constData()) + previous.size());
+        }
+    }
+    for (int i = next; i < lists.size() && !result.isEmpty(); ++i) {
+        intersect(result, lists[i].ids, lists[i].ids + lists[i].count);
+    }
+
+    // 二元组都出现不代表按顺序相连，三个字符以上需要确认子串
+    if (needle.size() > 2) {
+        int out = 0;
+        for (int i = 0; i < result.size(); ++i) {
+            if (contains(result[i], needle)) {
+                result[out++] = result[i];
+            }
+        }
+        result.resize(out);
+    }
+    return result;
+}
+
+SearchIndexBuilder::SearchIndexBuilder(QObject *parent)
+    : QObject(parent)
+    , m_thread(nullptr)
+    , m_quit(false)
+    , m_pending(false)
+    , m_generation(0)
+{
+    m_thread = new BoardThread([this] { threadLoop(); });
+    m_thread->setObjectName("SearchIndex");
+    m_thread->start();
+}
+
+SearchIndexBuilder::~SearchIndexBuilder()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void SearchIndexBuilder::rebuild(const QVector<SearchIndex::Entry> &entries, quint64 generation)
+{
+    QMutexLocker locker(&m_mutex);
+    m_entries = entries;
+    m_generation = generation;
+    m_pending = true;
+    m_cond.wakeAll();
+}
+
+QSharedPointer<const SearchIndex> SearchIndexBuilder::index() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_index;
+}
+
+void SearchIndexBuilder::threadLoop()
+{
+    setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), kBuilderNice);
+
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (!m_pending) {
+            m_cond.wait(&m_mutex);
+            continue;
+        }
+        QVector<SearchIndex::Entry> entries;
+        entries.swap(m_entries);
+        quint64 generation = m_generation;
+        m_pending = false;
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        QSharedPointer<const SearchIndex> index(new SearchIndex(entries, generation));
+        qDebug() << "SearchIndex:" << entries.size() << "entries in" << timer.elapsed() << "ms";
+
+        locker.relock();
+        // 建立期间又有新请求时，这份结果已经过时
+        if (m_pending) {
+            continue;
+        }
+        m_index = index;
+        locker.unlock();
+        emit ready();
+        locker.relock();
+    }
+}
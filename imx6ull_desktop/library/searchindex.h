@@ -0,0 +1,98 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+/**
+ * @brief 曲目标题/歌手的内存搜索索引
+ *
+ * 每首曲目的检索文本为：标题、歌手（小写）以及二者的拼音首字母。对检索文本中的
+ * 每个字符和相邻两个字符建立倒排表（按曲目下标升序），查询时取查询串各二元组的
+ * 倒排表从短到长求交集，再对候选做一次子串确认，不需要遍历全部曲目。
+ *
+ * 查询串在上一次查询之后追加了字符时，refine() 只在上一次的结果里确认，
+ * 逐字输入时代价随结果数量下降。
+ *
+ * 建好后只读，可以在线程间共享。
+ */
+class SearchIndex
+{
+public:
+    struct Entry {
+        QString title;
+        QString artist;
+    };
+
+    // 建立索引；generation 由调用方给出，用于判断索引是否对应当前列表
+    SearchIndex(const QVector<Entry> &entries, quint64 generation);
+
+    quint64 generation() const { return m_generation; }
+    int size() const { return m_offsets.size() - 1; }
+
+    // 返回检索文本包含查询串的条目下标（升序）；查询串为空时返回空
+    QVector<int> search(const QString &query) const;
+
+    // 在 previous（previousQuery 的结果）中查找包含 query 的条目；
+    // query 必须以 previousQuery 开头
+    QVector<int> refine(const QVector<int> &previous, const QString &query) const;
+
+    // 查询串的规范形式（去掉首尾空白、小写），调用方据此判断能否 refine()
+    static QString normalize(const QString &query);
+
+private:
+    bool contains(int entry, const QString &needle) const;
+    int postingsFor(quint32 key, const quint32 **ids) const;
+
+    quint64 m_generation;
+    QString m_text;                 // 所有条目的检索文本首尾相接
+    QVector<int> m_offsets;         // 条目 i 的检索文本为 [m_offsets[i], m_offsets[i + 1])
+    QVector<quint32> m_keys;        // 一元/二元组，升序
+    QVector<int> m_starts;          // m_keys[k] 的倒排表为 m_ids[m_starts[k] .. m_starts[k + 1])
+    QVector<quint32> m_ids;
+};
+
+/**
+ * @brief 在后台线程中建立 SearchIndex
+ *
+ * 曲目列表变化时提交新的条目，尚未开始的旧请求直接被替换；建好后在主线程发出 ready()。
+ * 线程降低 nice 值，不与界面和音频争抢 CPU。
+ */
+class SearchIndexBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndexBuilder(QObject *parent = nullptr);
+    ~SearchIndexBuilder();
+
+    void rebuild(const QVector<SearchIndex::Entry> &entries, quint64 generation);
+
+    // 最近建好的索引，尚未建好时为空
+    QSharedPointer<const SearchIndex> index() const;
+
+signals:
+    void ready();
+
+private:
+    void threadLoop();
+
+    QThread *m_thread;
+
+    // 以下成员由 m_mutex 保护
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    bool m_quit;
+    bool m_pending;
+    QVector<SearchIndex::Entry> m_entries;
+    quint64 m_generation;
+    QSharedPointer<const SearchIndex> m_index;
+};
+
+#endif // SEARCHINDEX_H
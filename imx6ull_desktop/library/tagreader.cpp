@@ -0,0 +1,725 @@
+#include "tagreader.h"
+#include <QFile>
+#include <QByteArray>
+#include <QTextCodec>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+namespace {
+
+// 单次读取上限：文本帧、Vorbis comment、Ogg/MP3 探测窗口
+const int kMaxFrameBytes = 4 * 1024;
+const int kMaxCommentBytes = 64 * 1024;
+const int kProbeBytes = 64 * 1024;
+const int kMaxBlocks = 128;
+const int kMaxPictureBytes = 4 * 1024 * 1024;
+
+// ID3 APIC 与 FLAC PICTURE 的图片类型：3 为封面正面
+const int kFrontCover = 3;
+
+/**
+ * @brief 有界 pread 读取，统计读取字节数
+ */
+struct FileReader {
+    int fd;
+    qint64 size;
+    quint32 bytesRead;
+
+    bool read(qint64 offset, void *buf, int len)
+    {
+        if (offset < 0 || len < 0 || offset + len > size) {
+            return false;
+        }
+        ssize_t n = ::pread(fd, buf, size_t(len), off_t(offset));
+        if (n != len) {
+            return false;
+        }
+        bytesRead += quint32(n);
+        return true;
+    }
+
+    // 读取不超过 len 字节，越过文件末尾时截短
+    QByteArray read(qint64 offset, int len)
+    {
+        if (offset < 0 || offset >= size || len <= 0) {
+            return QByteArray();
+        }
+        len = int(qMin<qint64>(len, size - offset));
+        QByteArray data(len, Qt::Uninitialized);
+        ssize_t n = ::pread(fd, data.data(), size_t(len), off_t(offset));
+        if (n <= 0) {
+            return QByteArray();
+        }
+        bytesRead += quint32(n);
+        data.resize(int(n));
+        return data;
+    }
+};
+
+inline quint32 be32(const uchar *p) { return (quint32(p[0]) << 24) | (quint32(p[1]) << 16) | (quint32(p[2]) << 8) | p[3]; }
+inline quint32 be24(const uchar *p) { return (quint32(p[0]) << 16) | (quint32(p[1]) << 8) | p[2]; }
+inline quint32 le32(const uchar *p) { return (quint32(p[3]) << 24) | (quint32(p[2]) << 16) | (quint32(p[1]) << 8) | p[0]; }
+inline quint16 le16(const uchar *p) { return quint16((p[1] << 8) | p[0]); }
+inline quint64 le64(const uchar *p) { return (quint64(le32(p + 4)) << 32) | le32(p); }
+inline quint32 syncsafe(const uchar *p) { return (quint32(p[0] & 0x7F) << 21) | (quint32(p[1] & 0x7F) << 14) | (quint32(p[2] & 0x7F) << 7) | (p[3] & 0x7F); }
+
+inline const uchar *bytes(const QByteArray &data) { return reinterpret_cast<const uchar *>(data.constData()); }
+
+QString trimmed(QString text)
+{
+    // 多值字段以 NUL 分隔，只取第一个
+    int nul = text.indexOf(QChar(0));
+    if (nul >= 0) {
+        text.truncate(nul);
+    }
+    return text.trimmed();
+}
+
+// 未声明编码的文本：先按 UTF-8 严格解码，再按 GBK（中文 MP3 常见），最后按 Latin-1
+QString decodeLegacy(const QByteArray &data)
+{
+    bool ascii = true;
+    for (char c : data) {
+        if (uchar(c) >= 0x80) {
+            ascii = false;
+            break;
+        }
+    }
+    if (ascii) {
+        return trimmed(QString::fromLatin1(data));
+    }
+
+    static QTextCodec *utf8 = QTextCodec::codecForName("UTF-8");
+    static QTextCodec *gbk = QTextCodec::codecForName("GBK");
+    QTextCodec *codecs[] = { utf8, gbk };
+    for (QTextCodec *codec : codecs) {
+        if (!codec) {
+            continue;
+        }
+        QTextCodec::ConverterState state;
+        QString text = codec->toUnicode(data.constData(), data.size(), &state);
+        if (state.invalidChars == 0) {
+            return trimmed(text);
+        }
+    }
+    return trimmed(QString::fromLatin1(data));
+}
+
+QString decodeId3Text(const QByteArray &frame)
+{
+    if (frame.isEmpty()) {
+        return QString();
+    }
+    QByteArray body = frame.mid(1);
+    switch (uchar(frame[0])) {
+    case 0:
+        return decodeLegacy(body);
+    case 1: {
+        // UTF-16，带 BOM
+        static QTextCodec *utf16 = QTextCodec::codecForName("UTF-16");
+        return utf16 ? trimmed(utf16->toUnicode(body)) : QString();
+    }
+    case 2: {
+        static QTextCodec *utf16be = QTextCodec::codecForName("UTF-16BE");
+        return utf16be ? trimmed(utf16be->toUnicode(body)) : QString();
+    }
+    case 3:
+        return trimmed(QString::fromUtf8(body));
+    default:
+        return QString();
+    }
+}
+
+void setIfEmpty(QString &field, const QString &value)
+{
+    if (field.isEmpty() && !value.isEmpty()) {
+        field = value;
+    }
+}
+
+/**
+ * @brief 内嵌图片：优先封面正面，否则取第一张
+ */
+struct Picture {
+    QByteArray data;
+    int type = -1;
+
+    bool wants(int pictureType) const
+    {
+        return type < 0 || (type != kFrontCover && pictureType == kFrontCover);
+    }
+};
+
+// ID3v2.4 单帧反同步：FF 00 还原为 FF
+QByteArray undoUnsync(const QByteArray &data)
+{
+    QByteArray out;
+    out.reserve(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        out.append(data[i]);
+        if (uchar(data[i]) == 0xFF && i + 1 < data.size() && data[i + 1] == 0) {
+            ++i;
+        }
+    }
+    return out;
+}
+
+// 跳过以 NUL 结尾的描述文本，UTF-16 编码以两个 NUL 结尾
+int skipId3String(const QByteArray &data, int pos, int encoding)
+{
+    if (encoding == 1 || encoding == 2) {
+        for (; pos + 1 < data.size(); pos += 2) {
+            if (data[pos] == 0 && data[pos + 1] == 0) {
+                return pos + 2;
+            }
+        }
+        return -1;
+    }
+    int nul = data.indexOf('\0', pos);
+    return nul < 0 ? -1 : nul + 1;
+}
+
+// APIC：编码、MIME、类型、描述、图片；v2.2 的 PIC 以 3 字节格式代替 MIME
+void parseId3Picture(const QByteArray &frame, bool v22, Picture &picture)
+{
+    if (frame.size() < 4) {
+        return;
+    }
+    int encoding = uchar(frame[0]);
+    int pos = 1;
+    if (v22) {
+        pos += 3;
+    } else {
+        pos = frame.indexOf('\0', pos);
+        if (pos < 0) {
+            return;
+        }
+        ++pos;
+    }
+    if (pos >= frame.size()) {
+        return;
+    }
+    int type = uchar(frame[pos]);
+    pos = skipId3String(frame, pos + 1, encoding);
+    if (pos < 0 || pos >= frame.size() || !picture.wants(type)) {
+        return;
+    }
+    picture.data = frame.mid(pos);
+    picture.type = type;
+}
+
+/**
+ * @brief 解析 ID3v2，返回标签总长度（即音频数据起点），没有标签返回 0
+ *
+ * 逐帧只读 10 字节帧头，只读取需要的文本帧；封面等大帧只在 picture 非空时读取。
+ */
+qint64 parseId3v2(FileReader &f, TagInfo &info, qint64 &lengthMs, Picture *picture = nullptr)
+{
+    uchar h[10];
+    if (!f.read(0, h, 10) || memcmp(h, "ID3", 3) != 0) {
+        return 0;
+    }
+    int major = h[3];
+    int flags = h[5];
+    qint64 tagEnd = 10 + qint64(syncsafe(h + 6));
+    qint64 audioStart = tagEnd + ((flags & 0x10) ? 10 : 0);
+    if (major < 2 || major > 4) {
+        return audioStart;
+    }
+    // v2.2/v2.3 的整体反同步需要先还原整个标签，极少见，放弃帧解析
+    if ((flags & 0x80) && major < 4) {
+        return audioStart;
+    }
+
+    qint64 pos = 10;
+    if ((flags & 0x40) && major >= 3) {
+        uchar ext[4];
+        if (!f.read(pos, ext, 4)) {
+            return audioStart;
+        }
+        pos += (major == 4) ? syncsafe(ext) : 4 + be32(ext);
+    }
+
+    const int headerLen = (major == 2) ? 6 : 10;
+    for (int count = 0; count < kMaxBlocks && pos + headerLen <= tagEnd; ++count) {
+        uchar fh[10];
+        if (!f.read(pos, fh, headerLen) || fh[0] == 0) {
+            break;      // 读取失败或进入填充区
+        }
+
+        QByteArray id;
+        quint32 frameSize;
+        if (major == 2) {
+            id = QByteArray(reinterpret_cast<const char *>(fh), 3);
+            frameSize = be24(fh + 3);
+        } else {
+            id = QByteArray(reinterpret_cast<const char *>(fh), 4);
+            frameSize = (major == 4) ? syncsafe(fh + 4) : be32(fh + 4);
+        }
+        qint64 body = pos + headerLen;
+        if (frameSize == 0 || body + frameSize > tagEnd) {
+            break;
+        }
+
+        QString *field = nullptr;
+        bool isLength = false;
+        if (id == "TIT2" || id == "TT2") {
+            field = &info.title;
+        } else if (id == "TPE1" || id == "TP1") {
+            field = &info.artist;
+        } else if (id == "TALB" || id == "TAL") {
+            field = &info.album;
+        } else if (id == "TLEN" || id == "TLE") {
+            isLength = true;
+        }
+
+        bool isPicture = picture && (id == "APIC" || id == "PIC");
+        if (isPicture && frameSize <= quint32(kMaxPictureBytes)) {
+            // v2.3 的压缩/加密帧不处理；v2.4 可能带数据长度前缀与单帧反同步
+            int frameFlags = (major >= 3) ? fh[9] : 0;
+            bool skip = (major == 3) ? (frameFlags & 0xC0) : (frameFlags & 0x0C);
+            if (!skip) {
+                QByteArray data = f.read(body, int(frameSize));
+                if (major == 4 && (frameFlags & 0x01)) {
+                    data.remove(0, 4);
+                }
+                if (major == 4 && (frameFlags & 0x02)) {
+                    data = undoUnsync(data);
+                }
+                parseId3Picture(data, major == 2, *picture);
+            }
+        }
+
+        if (field || isLength) {
+            QString text = decodeId3Text(f.read(body, int(qMin<quint32>(frameSize, kMaxFrameBytes))));
+            if (field) {
+                setIfEmpty(*field, text);
+            } else {
+                lengthMs = text.toLongLong();
+            }
+        }
+        pos = body + frameSize;
+    }
+    return audioStart;
+}
+
+// ID3v1 位于文件末尾 128 字节，只补充 ID3v2 中缺失的字段
+bool parseId3v1(FileReader &f, TagInfo &info)
+{
+    if (f.size < 128) {
+        return false;
+    }
+    QByteArray tag = f.read(f.size - 128, 128);
+    if (tag.size() != 128 || !tag.startsWith("TAG")) {
+        return false;
+    }
+    setIfEmpty(info.title, decodeLegacy(tag.mid(3, 30)));
+    setIfEmpty(info.artist, decodeLegacy(tag.mid(33, 30)));
+    setIfEmpty(info.album, decodeLegacy(tag.mid(63, 30)));
+    return true;
+}
+
+// MPEG 音频帧头
+struct MpegHeader {
+    int version;        // 0: MPEG-1, 1: MPEG-2, 2: MPEG-2.5
+    int layer;          // 1 ~ 3
+    int bitrate;        // bit/s
+    int sampleRate;
+    int samplesPerFrame;
+    int frameBytes;
+    bool mono;
+};
+
+bool parseMpegHeader(const uchar *p, MpegHeader &h)
+{
+    static const short kBitrates[2][3][15] = {
+        {   // MPEG-1：Layer I、II、III
+            { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+            { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+        },
+        {   // MPEG-2/2.5
+            { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+            { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+        },
+    };
+    static const int kSampleRates[3] = { 44100, 48000, 32000 };
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+    int versionBits = (p[1] >> 3) & 0x03;
+    int layerBits = (p[1] >> 1) & 0x03;
+    int bitrateIndex = p[2] >> 4;
+    int rateIndex = (p[2] >> 2) & 0x03;
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+        return false;   // 保留值或自由码率
+    }
+
+    h.version = (versionBits == 3) ? 0 : (versionBits == 2 ? 1 : 2);
+    h.layer = 4 - layerBits;
+    h.bitrate = kBitrates[h.version == 0 ? 0 : 1][h.layer - 1][bitrateIndex] * 1000;
+    h.sampleRate = kSampleRates[rateIndex] >> h.version;
+    h.mono = (p[3] >> 6) == 3;
+
+    int padding = (p[2] >> 1) & 0x01;
+    if (h.layer == 1) {
+        h.samplesPerFrame = 384;
+        h.frameBytes = (12 * h.bitrate / h.sampleRate + padding) * 4;
+    } else {
+        h.samplesPerFrame = (h.layer == 3 && h.version != 0) ? 576 : 1152;
+        h.frameBytes = h.samplesPerFrame / 8 * h.bitrate / h.sampleRate + padding;
+    }
+    return h.frameBytes > 4;
+}
+
+/**
+ * @brief MP3 时长：优先 Xing/Info 或 VBRI 中的总帧数，否则按首帧码率估算
+ */
+qint32 mp3Duration(FileReader &f, qint64 audioStart, qint64 audioEnd)
+{
+    QByteArray probe = f.read(audioStart, int(qMin<qint64>(kProbeBytes, audioEnd - audioStart)));
+    const uchar *p = bytes(probe);
+    int len = probe.size();
+
+    for (int i = 0; i + 4 <= len; ++i) {
+        MpegHeader h;
+        if (!parseMpegHeader(p + i, h)) {
+            continue;
+        }
+        // 下一帧头也要合法，避免把数据中的 0xFF 误认为同步字
+        int next = i + h.frameBytes;
+        MpegHeader n;
+        if (next + 4 <= len && (!parseMpegHeader(p + next, n) || n.sampleRate != h.sampleRate || n.layer != h.layer)) {
+            continue;
+        }
+
+        int sideInfo = (h.version == 0) ? (h.mono ? 17 : 32) : (h.mono ? 9 : 17);
+        int xing = i + 4 + sideInfo;
+        if (xing + 12 <= len && (memcmp(p + xing, "Xing", 4) == 0 || memcmp(p + xing, "Info", 4) == 0)) {
+            quint32 xingFlags = be32(p + xing + 4);
+            if (xingFlags & 0x01) {
+                quint64 frames = be32(p + xing + 8);
+                return qint32(frames * h.samplesPerFrame * 1000 / h.sampleRate);
+            }
+        }
+        int vbri = i + 4 + 32;
+        if (vbri + 18 <= len && memcmp(p + vbri, "VBRI", 4) == 0) {
+            quint64 frames = be32(p + vbri + 14);
+            return qint32(frames * h.samplesPerFrame * 1000 / h.sampleRate);
+        }
+
+        qint64 audioBytes = audioEnd - (audioStart + i);
+        return qint32(audioBytes * 8 * 1000 / h.bitrate);
+    }
+    return 0;
+}
+
+// Vorbis comment（FLAC 与 Ogg 共用），数据可能被截断，逐项检查边界
+void parseVorbisComment(const QByteArray &data, TagInfo &info)
+{
+    const uchar *p = bytes(data);
+    qint64 len = data.size();
+    qint64 pos = 0;
+    if (len < 8) {
+        return;
+    }
+    pos = 4 + qint64(le32(p));      // 跳过 vendor
+    if (pos + 4 > len) {
+        return;
+    }
+    quint32 count = le32(p + pos);
+    pos += 4;
+
+    for (quint32 i = 0; i < count && pos + 4 <= len; ++i) {
+        qint64 itemLen = le32(p + pos);
+        pos += 4;
+        if (pos + itemLen > len) {
+            break;
+        }
+        QByteArray item = QByteArray::fromRawData(data.constData() + pos, int(itemLen));
+        pos += itemLen;
+
+        int eq = item.indexOf('=');
+        if (eq <= 0) {
+            continue;
+        }
+        QByteArray key = item.left(eq).toUpper();
+        QString value = trimmed(QString::fromUtf8(item.constData() + eq + 1, item.size() - eq - 1));
+        if (key == "TITLE") {
+            setIfEmpty(info.title, value);
+        } else if (key == "ARTIST") {
+            setIfEmpty(info.artist, value);
+        } else if (key == "ALBUM") {
+            setIfEmpty(info.album, value);
+        }
+    }
+}
+
+// FLAC PICTURE 块：类型、MIME、描述、宽高等四个字段、图片长度与数据
+void parseFlacPicture(FileReader &f, qint64 pos, quint32 blockLen, Picture &picture)
+{
+    uchar h[8];
+    if (blockLen > quint32(kMaxPictureBytes) || !f.read(pos, h, 8)) {
+        return;
+    }
+    int type = int(be32(h));
+    if (!picture.wants(type)) {
+        return;
+    }
+    qint64 end = pos + blockLen;
+    qint64 p = pos + 8 + be32(h + 4);           // 跳过 MIME
+    if (!f.read(p, h, 4)) {
+        return;
+    }
+    p += 4 + be32(h) + 16;                      // 跳过描述与宽、高、位深、索引色数
+    if (!f.read(p, h, 4)) {
+        return;
+    }
+    qint64 dataLen = be32(h);
+    if (p + 4 + dataLen > end) {
+        return;
+    }
+    QByteArray data = f.read(p + 4, int(dataLen));
+    if (data.size() == dataLen) {
+        picture.data = data;
+        picture.type = type;
+    }
+}
+
+bool parseFlac(FileReader &f, qint64 start, TagInfo &info, Picture *picture = nullptr)
+{
+    uchar magic[4];
+    if (!f.read(start, magic, 4) || memcmp(magic, "fLaC", 4) != 0) {
+        return false;
+    }
+
+    qint64 pos = start + 4;
+    for (int count = 0; count < kMaxBlocks; ++count) {
+        uchar h[4];
+        if (!f.read(pos, h, 4)) {
+            break;
+        }
+        bool last = h[0] & 0x80;
+        int type = h[0] & 0x7F;
+        quint32 blockLen = be24(h + 1);
+
+        if (type == 0) {
+            // STREAMINFO：采样率 20 bit，总采样数 36 bit
+            uchar s[18];
+            if (f.read(pos + 4, s, 18)) {
+                quint32 rate = (quint32(s[10]) << 12) | (quint32(s[11]) << 4) | (s[12] >> 4);
+                quint64 samples = (quint64(s[13] & 0x0F) << 32) | be32(s + 14);
+                if (rate > 0) {
+                    info.durationMs = qint32(samples * 1000 / rate);
+                }
+            }
+        } else if (type == 4) {
+            parseVorbisComment(f.read(pos + 4, int(qMin<quint32>(blockLen, kMaxCommentBytes))), info);
+        } else if (type == 6 && picture) {
+            parseFlacPicture(f, pos + 4, blockLen, *picture);
+        }
+
+        pos += 4 + blockLen;
+        if (last) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool parseOgg(FileReader &f, TagInfo &info)
+{
+    // 从开头的页中拼出前两个逻辑包：标识头与注释头
+    QByteArray head = f.read(0, kProbeBytes);
+    const uchar *p = bytes(head);
+    int len = head.size();
+
+    QByteArray packets[2];
+    int packetIndex = 0;
+    quint32 serial = 0;
+    int pos = 0;
+    while (packetIndex < 2 && pos + 27 <= len && memcmp(p + pos, "OggS", 4) == 0) {
+        quint32 pageSerial = le32(p + pos + 14);
+        if (pos == 0) {
+            serial = pageSerial;
+        }
+        int segments = p[pos + 26];
+        int body = pos + 27 + segments;
+        if (body > len) {
+            break;
+        }
+        int offset = body;
+        for (int s = 0; s < segments && packetIndex < 2; ++s) {
+            int lacing = p[pos + 27 + s];
+            if (pageSerial == serial) {
+                packets[packetIndex].append(head.constData() + qMin(offset, len), qBound(0, len - offset, lacing));
+                if (lacing < 255) {
+                    ++packetIndex;
+                }
+            }
+            offset += lacing;
+        }
+        pos = offset;
+    }
+
+    qint64 rate = 0;
+    qint64 preSkip = 0;
+    const QByteArray &ident = packets[0];
+    if (ident.size() >= 16 && ident.startsWith("\x01vorbis")) {
+        rate = le32(bytes(ident) + 12);
+        parseVorbisComment(packets[1].mid(7), info);
+    } else if (ident.size() >= 12 && ident.startsWith("OpusHead")) {
+        rate = 48000;
+        preSkip = le16(bytes(ident) + 10);
+        parseVorbisComment(packets[1].mid(8), info);
+    } else {
+        return false;
+    }
+
+    // 时长：最后一页的 granule position
+    int tailLen = int(qMin<qint64>(kProbeBytes, f.size));
+    QByteArray tail = f.read(f.size - tailLen, tailLen);
+    const uchar *t = bytes(tail);
+    for (int i = tail.size() - 27; i >= 0; --i) {
+        if (t[i] == 'O' && memcmp(t + i, "OggS", 4) == 0 && le32(t + i + 14) == serial) {
+            qint64 granule = qint64(le64(t + i + 6));
+            if (granule > preSkip && rate > 0) {
+                info.durationMs = qint32((granule - preSkip) * 1000 / rate);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+bool parseWav(FileReader &f, TagInfo &info)
+{
+    uchar riff[12];
+    if (!f.read(0, riff, 12) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    quint32 byteRate = 0;
+    qint64 dataBytes = -1;
+    qint64 pos = 12;
+    for (int count = 0; count < kMaxBlocks; ++count) {
+        uchar h[8];
+        if (!f.read(pos, h, 8)) {
+            break;
+        }
+        qint64 chunkLen = le32(h + 4);
+        qint64 body = pos + 8;
+
+        if (memcmp(h, "fmt ", 4) == 0) {
+            uchar fmt[12];
+            if (f.read(body, fmt, 12)) {
+                byteRate = le32(fmt + 8);
+            }
+        } else if (memcmp(h, "data", 4) == 0) {
+            // 流式写入的文件 data 长度可能是 0 或 0xFFFFFFFF
+            dataBytes = (chunkLen == 0 || body + chunkLen > f.size) ? f.size - body : chunkLen;
+        } else if (memcmp(h, "LIST", 4) == 0) {
+            QByteArray list = f.read(body, int(qMin<qint64>(chunkLen, kMaxCommentBytes)));
+            if (list.startsWith("INFO")) {
+                const uchar *l = bytes(list);
+                int lp = 4;
+                while (lp + 8 <= list.size()) {
+                    int itemLen = int(le32(l + lp + 4));
+                    if (itemLen < 0 || lp + 8 + itemLen > list.size()) {
+                        break;
+                    }
+                    QString value = decodeLegacy(list.mid(lp + 8, itemLen));
+                    if (memcmp(l + lp, "INAM", 4) == 0) {
+                        setIfEmpty(info.title, value);
+                    } else if (memcmp(l + lp, "IART", 4) == 0) {
+                        setIfEmpty(info.artist, value);
+                    } else if (memcmp(l + lp, "IPRD", 4) == 0) {
+                        setIfEmpty(info.album, value);
+                    }
+                    lp += 8 + itemLen + (itemLen & 1);
+                }
+            }
+        }
+
+        pos = body + chunkLen + (chunkLen & 1);
+    }
+
+    if (byteRate > 0 && dataBytes > 0) {
+        info.durationMs = qint32(dataBytes * 1000 / byteRate);
+    }
+    return true;
+}
+
+} // namespace
+
+bool TagReader::read(const QString &path, TagInfo &info)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return false;
+    }
+    info.mtime = qint64(st.st_mtime);
+    info.size = qint64(st.st_size);
+
+    // 只做零散小块读取，关闭预读以免每个文件都从 SD 卡拉进几百 KB
+    posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+
+    FileReader f = { fd, info.size, 0 };
+    bool ok = false;
+    uchar magic[12];
+    if (f.read(0, magic, 12)) {
+        if (memcmp(magic, "OggS", 4) == 0) {
+            ok = parseOgg(f, info);
+        } else if (memcmp(magic, "RIFF", 4) == 0) {
+            ok = parseWav(f, info);
+        } else {
+            // MP3 或带 ID3v2 前缀的 FLAC
+            qint64 lengthMs = 0;
+            qint64 audioStart = parseId3v2(f, info, lengthMs);
+            if (parseFlac(f, audioStart, info)) {
+                ok = true;
+            } else {
+                qint64 audioEnd = parseId3v1(f, info) ? f.size - 128 : f.size;
+                info.durationMs = lengthMs > 0 ? qint32(lengthMs) : mp3Duration(f, audioStart, audioEnd);
+                ok = audioStart > 0 || info.durationMs > 0;
+            }
+        }
+    }
+
+    info.bytesRead = f.bytesRead;
+    ::close(fd);
+    return ok;
+}
+
+QByteArray TagReader::readPicture(const QString &path)
+{
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return QByteArray();
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        return QByteArray();
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+
+    FileReader f = { fd, qint64(st.st_size), 0 };
+    TagInfo info;
+    Picture picture;
+    qint64 lengthMs = 0;
+    qint64 audioStart = parseId3v2(f, info, lengthMs, &picture);
+    parseFlac(f, audioStart, info, &picture);
+
+    ::close(fd);
+    return picture.data;
+}
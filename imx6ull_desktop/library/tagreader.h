@@ -0,0 +1,39 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @brief 从音频文件头部读取到的元数据
+ */
+struct TagInfo {
+    QString title;
+    QString artist;
+    QString album;
+    qint32 durationMs = 0;  // 0 表示无法确定
+    qint64 mtime = 0;       // 读取时文件的修改时间与大小，用于丢弃过期结果
+    qint64 size = 0;
+    quint32 bytesRead = 0;  // 本次实际读取的字节数
+};
+
+/**
+ * @brief 标签与时长解析
+ *
+ * 支持 ID3v2/ID3v1 + MPEG 帧头（Xing/VBRI/CBR 估算）、FLAC STREAMINFO 与
+ * Vorbis comment、Ogg Vorbis/Opus、WAV fmt/data/LIST INFO。
+ *
+ * 只用有上限的 pread 读取需要的头部字节，不读整个文件；跳过封面等大帧。
+ * 可在任意线程调用，无共享状态。
+ */
+class TagReader
+{
+public:
+    // 识别出文件格式返回 true，即使其中没有任何标签
+    static bool read(const QString &path, TagInfo &info);
+
+    // 内嵌封面（ID3v2 APIC/PIC、FLAC PICTURE）的原始图片数据，没有时返回空
+    static QByteArray readPicture(const QString &path);
+};
+
+#endif // TAGREADER_H
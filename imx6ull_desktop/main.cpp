@@ -1,9 +1,35 @@
 #include "mainwindow.h"
+#include "audiobenchmark.h"
+#include "librarybenchmark.h"
 
 #include <QApplication>
 
+// 命令行基准测试：只用命令行，不启动界面
+struct BenchMode {
+    const char *name;
+    int (*run)(const QStringList &arguments);
+};
+
+static const BenchMode kBenchModes[] = {
+    { "--bench-audio", &AudioBenchmark::run },
+    { "--bench-resampler", &AudioBenchmark::runResampler },
+    { "--bench-decoders", &AudioBenchmark::runDecoders },
+    { "--bench-eq", &AudioBenchmark::runEqualizer },
+    { "--bench-stream", &AudioBenchmark::runStream },
+    { "--bench-tags", &LibraryBenchmark::runTags },
+};
+
 int main(int argc, char *argv[])
 {
+    if (argc >= 2) {
+        for (const BenchMode &mode : kBenchModes) {
+            if (qstrcmp(argv[1], mode.name) == 0) {
+                QCoreApplication app(argc, argv);
+                return mode.run(app.arguments().mid(2));
+            }
+        }
+    }
+
     QApplication a(argc, argv);
     
     MainWindow w;
@@ -2,6 +2,7 @@
 #include "ui_mainwindow.h"
 #include "iconwidget.h"
 #include "appdialog.h"
+#include "beeper.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
@@ -18,7 +19,7 @@ MainWindow::MainWindow(QWidget *parent)
     // 设置窗口属性
     setWindowTitle("IMX6ULL Desktop");
     
-    // 初始化应用列表（8个应用）
+    // 初始化应用列表（每页8个应用）
     m_apps = {
         {"LED控制", ""},
         {"传感器", ""},
@@ -27,7 +28,8 @@ MainWindow::MainWindow(QWidget *parent)
         {"多媒体", ""},
         {"文件管理", ""},
         {"系统信息", ""},
-        {"关于", ""}
+        {"关于", ""},
+        {"PWM发生器", ""}
     };
     
     setupUI();
@@ -87,13 +89,12 @@ void MainWindow::setupUI()
 
 void MainWindow::createPages()
 {
-    // 第一页显示所有8个图标（2行4列）
+    // 第一页显示前8个图标（2行4列）
     QWidget *page1 = createPage(0);
     m_sliderWidget->addPage(page1);
     
-    // 第二页为空桌面
-    QWidget *page2 = new QWidget();
-    page2->setStyleSheet("background-color: #f0f0f0;");
+    // 第二页显示其余图标
+    QWidget *page2 = createPage(1);
     m_sliderWidget->addPage(page2);
     
     updatePageIndicator();
@@ -101,8 +102,6 @@ void MainWindow::createPages()
 
 QWidget* MainWindow::createPage(int pageIndex)
 {
-    Q_UNUSED(pageIndex);  // 现在只创建第一页，忽略页码参数
-    
     QWidget *page = new QWidget();
     page->setStyleSheet("background-color: #f0f0f0;");
     
@@ -111,9 +110,12 @@ QWidget* MainWindow::createPage(int pageIndex)
     gridLayout->setContentsMargins(20, 30, 20, 30);
     gridLayout->setSpacing(15);
     
-    // 第一页显示所有8个图标（2行4列）
+    // 每页最多8个图标（2行4列）
+    const int appsPerPage = 8;
+    int first = pageIndex * appsPerPage;
+    int last = qMin(first + appsPerPage, m_apps.count());
     int row = 0, col = 0;
-    for (int i = 0; i < m_apps.count(); ++i) {
+    for (int i = first; i < last; ++i) {
         IconWidget *icon = new IconWidget(m_apps[i].iconPath, m_apps[i].name, page);
         connect(icon, &IconWidget::clicked, this, &MainWindow::onIconClicked);
         
@@ -136,6 +138,9 @@ void MainWindow::onIconClicked(const QString &appName)
 {
     qDebug() << "Opening app:" << appName;
     
+    // 按键音，在蜂鸣器线程中播放，不阻塞界面
+    Beeper::instance()->click();
+    
     // 创建并显示全屏应用对话框
     AppDialog *dialog = new AppDialog(appName, this);
     dialog->showFullScreen();
@@ -1,54 +1,126 @@
 #include "musicplayer.h"
+#include "boardclock.h"
+#include "musiclibrary.h"
+#include "playliststore.h"
+#include "coverartcache.h"
+#include "loudnessanalyzer.h"
+#include "spectrumanalyzer.h"
+#include "diagnosticspanel.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
-#include <QDir>
-#include <QFileInfo>
+#include <QHash>
+#include <QScrollBar>
+#include <QScroller>
+#include <QMenu>
+#include <QInputDialog>
+#include <QMessageBox>
+#include "playlistdelegate.h"
 #include <QDebug>
 #include <QFile>
 #include <QDateTime>
 #include <QPixmap>
+#include <QUrl>
+#include <algorithm>
 
 MusicPlayer::MusicPlayer(QWidget *parent)
     : QWidget(parent)
-    , m_currentIndex(-1)
-    , m_playMode(LoopMode)
-    , m_playerState(StoppedState)
-    , m_currentPosition(0)
-    , m_volumeLevel(70)
-    , m_playerProcess(nullptr)
+    , m_visualizer(nullptr)
+    , m_diagnosticsPanel(nullptr)
+    , m_service(PlayerService::instance())
+    , m_positionMs(0)
+    , m_streamTicks(0)
+    , m_clock(BoardClock::instance())
     , m_progressTimer(nullptr)
+    , m_coverArt(CoverArtCache::instance())
     , m_isSliderPressed(false)
-    , m_isPaused(false)
-    , m_pausePosition(0)
 {
     setupUI();
     loadStyleSheet();
-    scanMusicFiles();
     
-    // 初始化播放进程
-    m_playerProcess = new QProcess(this);
-    connect(m_playerProcess, SIGNAL(finished(int, QProcess::ExitStatus)),
-            this, SLOT(onPlayerFinished(int, QProcess::ExitStatus)));
-    connect(m_playerProcess, SIGNAL(error(QProcess::ProcessError)),
-            this, SLOT(onPlayerError(QProcess::ProcessError)));
+    // 播放服务第一次创建时启动播放引擎并加载音乐库，之后打开界面只读取它的状态
+    connect(m_service, &PlayerService::songsReset, this, &MusicPlayer::onSongsReset);
+    connect(m_service, &PlayerService::songsChanged, this, &MusicPlayer::onSongsChanged);
+    connect(m_service, &PlayerService::sourceChanged, this, &MusicPlayer::onSourceChanged);
+    connect(m_service, &PlayerService::currentChanged, this, &MusicPlayer::onCurrentChanged);
+    connect(m_service, &PlayerService::stateChanged, this, &MusicPlayer::onStateChanged);
+    connect(m_service, &PlayerService::durationChanged, this, &MusicPlayer::onDurationChanged);
+    connect(m_service, &PlayerService::errorOccurred, this, &MusicPlayer::onPlayerError);
+    connect(m_service, &PlayerService::searchIndexReady, this, &MusicPlayer::onSearchIndexReady);
     
-    // 初始化进度定时器
-    m_progressTimer = new QTimer(this);
-    connect(m_progressTimer, &QTimer::timeout, this, &MusicPlayer::updateProgress);
+    // 可视化：分析器属于播放服务，只在切到可视化视图时运行
+    m_visualizer = new VisualizerWidget(m_service->analyzer());
+    connect(m_visualizer, &VisualizerWidget::clicked, this, &MusicPlayer::onCoverClicked);
+    m_coverStack->addWidget(m_visualizer);
     
-    // 设置初始音量
-    setVolume(m_volumeLevel);
+    // 封面在后台提取，当前曲目的封面就绪后更新唱片
+    connect(m_coverArt, &CoverArtCache::coverReady, this, &MusicPlayer::onCoverReady);
+    
+    // 波形概览随响度分析在后台生成，当前曲目分析完成后换上
+    connect(LoudnessAnalyzer::instance(), &LoudnessAnalyzer::analyzed, this, &MusicPlayer::onTrackAnalyzed);
+    
+    // 收藏按钮跟随当前曲目的收藏状态，来源的变化由播放服务处理
+    connect(PlaylistStore::instance(), &PlaylistStore::favoritesChanged,
+            this, &MusicPlayer::updateFavoriteButton);
+    
+    // 初始化进度节拍：由时钟定时器按绝对时间产生，再投递到主线程刷新界面；
+    // 上一次刷新尚未处理时不再重复投递，避免 UI 繁忙时事件堆积
+    m_progressTimer = m_clock->createTimer("music-progress", this);
+    connect(m_progressTimer, &BoardTimer::timeout, this, [this](qint64 deadlineNs) {
+        Q_UNUSED(deadlineNs);
+        if (m_progressPending.testAndSetOrdered(0, 1)) {
+            QMetaObject::invokeMethod(this, "updateProgress", Qt::QueuedConnection);
+        }
+    }, Qt::DirectConnection);
+    
+    // 按服务的现有状态填充界面
+    m_playlistModel->reload();
+    updateModeButton();
+    onSourceChanged();
+    if (m_service->isStreaming()) {
+        showStream();
+    } else if (m_service->currentIndex() >= 0) {
+        showSong(m_service->currentIndex());
+        m_positionMs = m_service->state() == PlayerService::StoppedState ? 0 : m_service->position();
+        updateTimeLabels();
+        m_progressSlider->setValue(int(m_positionMs));
+    }
+    onStateChanged(m_service->state());
 }
 
 MusicPlayer::~MusicPlayer()
 {
-    if (m_playerProcess && m_playerProcess->state() == QProcess::Running) {
-        m_playerProcess->kill();
-        m_playerProcess->waitForFinished();
+    stopProgressTicks();
+    
+    // 可视化随界面销毁，分析器不必再运行；播放本身继续
+    m_service->analyzer()->stop();
+}
+
+void MusicPlayer::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    
+    // 隐藏期间界面照常跟随服务的信号更新，只有进度、唱片旋转与可视化停着，这里恢复
+    if (m_service->state() == PlayerService::PlayingState && !m_isSliderPressed) {
+        m_positionMs = m_service->position();
+        updateTimeLabels();
+        m_progressSlider->setValue(int(m_positionMs));
+    }
+    onStateChanged(m_service->state());
+    if (m_coverStack->currentWidget() == m_visualizer) {
+        m_service->analyzer()->start();
     }
 }
 
+void MusicPlayer::hideEvent(QHideEvent *event)
+{
+    // 对话框关闭后界面留着下次用，不可见时不刷新进度、不转唱片、不做频谱分析
+    stopProgressTicks();
+    m_cdWidget->stopRotation();
+    m_service->analyzer()->stop();
+    QWidget::hideEvent(event);
+}
+
 void MusicPlayer::setupUI()
 {
     // 主布局
@@ -64,20 +136,49 @@ void MusicPlayer::setupUI()
     leftLayout->setContentsMargins(0, 0, 0, 0);
     leftLayout->setSpacing(10);
     
-    // 播放列表标题
-    QLabel *playlistTitle = new QLabel("播放列表");
-    playlistTitle->setObjectName("playlistTitle");
-    playlistTitle->setFixedHeight(60);
-    playlistTitle->setAlignment(Qt::AlignCenter);
+    // 播放列表标题（显示当前来源）
+    m_playlistTitle = new QLabel("播放列表");
+    m_playlistTitle->setObjectName("playlistTitle");
+    m_playlistTitle->setFixedHeight(60);
+    m_playlistTitle->setAlignment(Qt::AlignCenter);
+    
+    // 搜索框：每输入一个字符就在内存索引中过滤，不重新扫描曲目
+    m_searchEdit = new QLineEdit();
+    m_searchEdit->setObjectName("searchEdit");
+    m_searchEdit->setFixedHeight(36);
+    m_searchEdit->setPlaceholderText("搜索歌名、歌手或拼音首字母");
+    m_searchEdit->setClearButtonEnabled(true);
+    connect(m_searchEdit, &QLineEdit::textChanged,
+            this, &MusicPlayer::onSearchTextChanged);
     
     // 播放列表
-    m_playlistWidget = new QListWidget();
+    // 模型直接读取播放服务的曲目数组，委托只绘制可见行；行高一致，视图不必逐行测量
+    m_playlistModel = new PlaylistModel(&m_service->songs(), this);
+    m_playlistWidget = new QListView();
     m_playlistWidget->setObjectName("playlistWidget");
+    m_playlistWidget->setModel(m_playlistModel);
+    m_playlistWidget->setItemDelegate(new PlaylistDelegate(m_playlistWidget));
+    m_playlistWidget->setUniformItemSizes(true);
+    m_playlistWidget->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_playlistWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_playlistWidget->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
     m_playlistWidget->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     m_playlistWidget->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    connect(m_playlistWidget, &QListWidget::itemClicked, 
+    connect(m_playlistWidget, &QListView::clicked, 
             this, &MusicPlayer::onSongSelected);
     
+    // 触摸屏上拖动即滚动，松手后按惯性减速
+    QScroller::grabGesture(m_playlistWidget->viewport(), QScroller::LeftMouseButtonGesture);
+    QScrollerProperties scrollerProperties = QScroller::scroller(m_playlistWidget->viewport())->scrollerProperties();
+    scrollerProperties.setScrollMetric(QScrollerProperties::VerticalOvershootPolicy,
+                                       QScrollerProperties::OvershootWhenScrollable);
+    scrollerProperties.setScrollMetric(QScrollerProperties::HorizontalOvershootPolicy,
+                                       QScrollerProperties::OvershootAlwaysOff);
+    scrollerProperties.setScrollMetric(QScrollerProperties::FrameRate, QScrollerProperties::Fps60);
+    QScroller::scroller(m_playlistWidget->viewport())->setScrollerProperties(scrollerProperties);
+    connect(m_playlistWidget->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MusicPlayer::prioritizeVisibleSongs);
+    
     // 列表底部控制按钮
     QWidget *listControlWidget = new QWidget();
     listControlWidget->setFixedHeight(80);
@@ -110,7 +211,8 @@ void MusicPlayer::setupUI()
     listControlLayout->addWidget(m_playPauseButton);
     listControlLayout->addWidget(m_nextButton);
     
-    leftLayout->addWidget(playlistTitle);
+    leftLayout->addWidget(m_playlistTitle);
+    leftLayout->addWidget(m_searchEdit);
     leftLayout->addWidget(m_playlistWidget);
     leftLayout->addSpacing(10);
     leftLayout->addWidget(listControlWidget);
@@ -126,6 +228,12 @@ void MusicPlayer::setupUI()
     // CD封面
     m_cdWidget = new CDWidget();
     m_cdWidget->setObjectName("cdLabel");
+    connect(m_cdWidget, &CDWidget::clicked, this, &MusicPlayer::onCoverClicked);
+    
+    // 点击封面在 CD 与可视化之间切换，可视化控件在构造函数中加入
+    m_coverStack = new QStackedWidget();
+    m_coverStack->setFixedSize(m_cdWidget->size());
+    m_coverStack->addWidget(m_cdWidget);
     
     // 歌曲信息
     m_songTitleLabel = new QLabel("未播放");
@@ -143,7 +251,7 @@ void MusicPlayer::setupUI()
     progressLayout->setContentsMargins(0, 0, 0, 0);
     progressLayout->setSpacing(5);
     
-    m_progressSlider = new QSlider(Qt::Horizontal);
+    m_progressSlider = new WaveformSlider();
     m_progressSlider->setObjectName("progressSlider");
     m_progressSlider->setMinimum(0);
     m_progressSlider->setMaximum(100);
@@ -224,15 +332,15 @@ void MusicPlayer::setupUI()
     m_volumeSlider->setObjectName("volumeSlider");
     m_volumeSlider->setMinimum(0);
     m_volumeSlider->setMaximum(100);
-    m_volumeSlider->setValue(m_volumeLevel);
+    m_volumeSlider->setValue(m_service->volume());
     connect(m_volumeSlider, &QSlider::valueChanged, 
-            this, &MusicPlayer::setVolume);
+            m_service, &PlayerService::setVolume);
     
     volumeLayout->addWidget(m_volumeSlider);
     
     // 组装右侧布局
     rightLayout->addSpacing(20);
-    rightLayout->addWidget(m_cdWidget, 0, Qt::AlignHCenter);
+    rightLayout->addWidget(m_coverStack, 0, Qt::AlignHCenter);
     rightLayout->addSpacing(20);
     rightLayout->addWidget(m_songTitleLabel);
     rightLayout->addSpacing(5);
@@ -273,6 +381,21 @@ void MusicPlayer::loadStyleSheet()
             background: rgba(255, 255, 255, 0.1);
         }
         
+        /* 搜索框 */
+        #searchEdit {
+            background: rgba(255, 255, 255, 0.2);
+            border: 1px solid rgba(255, 255, 255, 0.4);
+            border-radius: 18px;
+            color: white;
+            font-size: 14px;
+            padding: 0 12px;
+            margin: 0 10px;
+        }
+        
+        #searchEdit:focus {
+            border: 1px solid rgba(255, 255, 255, 0.8);
+        }
+        
         /* 播放列表 */
         #playlistWidget {
             background: rgba(255, 255, 255, 0.15);
@@ -282,20 +405,7 @@ void MusicPlayer::loadStyleSheet()
             padding: 5px;
         }
         
-        #playlistWidget::item {
-            padding: 15px 10px;
-            border-radius: 8px;
-            margin: 2px 5px;
-        }
-        
-        #playlistWidget::item:hover {
-            background: rgba(255, 255, 255, 0.2);
-        }
-        
-        #playlistWidget::item:selected {
-            background: rgba(255, 255, 255, 0.3);
-            color: white;
-        }
+        /* 行的背景与文字由 PlaylistDelegate 绘制 */
         
         /* 播放按钮 - 上一曲 */
         #btnPrevious {
@@ -371,39 +481,6 @@ void MusicPlayer::loadStyleSheet()
             font-size: 16px;
         }
         
-        /* 进度条 */
-        #progressSlider {
-            height: 6px;
-        }
-        
-        #progressSlider::groove:horizontal {
-            background: rgba(255, 255, 255, 0.3);
-            height: 6px;
-            border-radius: 3px;
-        }
-        
-        #progressSlider::sub-page:horizontal {
-            background: white;
-            border-radius: 3px;
-        }
-        
-        #progressSlider::handle:horizontal {
-            background: white;
-            width: 16px;
-            height: 16px;
-            margin: -5px 0;
-            border-radius: 8px;
-            border: 2px solid rgba(255, 255, 255, 0.8);
-        }
-        
-        #progressSlider::handle:horizontal:hover {
-            background: #f5f5f5;
-            width: 18px;
-            height: 18px;
-            margin: -6px 0;
-            border-radius: 9px;
-        }
-        
         /* 时间标签 */
         #timeLabel {
             color: white;
@@ -424,6 +501,10 @@ void MusicPlayer::loadStyleSheet()
             image: url(:/image/music_favorite_hover.png);
         }
         
+        #btnFavorite[favorite="true"] {
+            image: url(:/image/music_favorite_hover.png);
+        }
+        
         #btnMode {
             background: rgba(255, 255, 255, 0.25);
             border: 2px solid rgba(255, 255, 255, 0.5);
@@ -486,205 +567,330 @@ void MusicPlayer::loadStyleSheet()
             border-radius: 8px;
             border: 2px solid #f5576c;
         }
+        
+        /* 来源/歌单菜单 */
+        QMenu {
+            background: rgba(255, 255, 255, 0.95);
+            border: 1px solid rgba(0, 0, 0, 0.1);
+            font-size: 14px;
+            padding: 5px 0;
+        }
+        
+        QMenu::item {
+            padding: 8px 24px;
+            color: #333333;
+        }
+        
+        QMenu::item:selected {
+            background: #f5576c;
+            color: white;
+        }
+        
+        QMenu::item:disabled {
+            color: #aaaaaa;
+        }
     )";
     
     setStyleSheet(styleSheet);
 }
 
-void MusicPlayer::scanMusicFiles()
+void MusicPlayer::onSongsReset()
 {
-    // 扫描音乐目录
-    QString musicDir = "/music";
-    QDir dir(musicDir);
-    
-    if (!dir.exists()) {
-        qDebug() << "Music directory does not exist:" << musicDir;
-        return;
+    // 曲目下标变了，上一次的查询结果不能再用；列表只保存数据，视图按需取可见行
+    m_lastQuery.clear();
+    m_lastMatches.clear();
+    m_playlistModel->reload();
+}
+
+void MusicPlayer::onSongsChanged(int first, int last)
+{
+    // 一次通知整个变化范围，视图只重绘其中可见的行
+    m_playlistModel->refreshRows(first, last);
+    if (m_service->currentIndex() >= 0) {
+        updateTimeLabels();
     }
+}
+
+void MusicPlayer::onSourceChanged()
+{
+    switch (m_service->source()) {
+    case PlayerService::AllSongs:
+        m_playlistTitle->setText("播放列表");
+        break;
+    case PlayerService::FavoriteSongs:
+        m_playlistTitle->setText("我的收藏");
+        break;
+    case PlayerService::PlaylistSongs:
+        m_playlistTitle->setText(m_service->sourceName());
+        break;
+    }
+    applyFilter();
+    updateFavoriteButton();
+}
+
+void MusicPlayer::applyFilter()
+{
+    QString query = SearchIndex::normalize(m_searchEdit->text());
+    QSharedPointer<const SearchIndex> searchIndex = m_service->searchIndex();
+    bool indexUsable = searchIndex && searchIndex->generation() >= m_service->pathsGeneration();
+    bool allSongs = m_service->source() == PlayerService::AllSongs;
     
-    QStringList filters;
-    filters << "*.mp3" << "*.wav" << "*.flac" << "*.ogg";
-    QFileInfoList fileList = dir.entryInfoList(filters, QDir::Files);
-    
-    m_songs.clear();
-    m_playlistWidget->clear();
-    
-    foreach (const QFileInfo &fileInfo, fileList) {
-        SongInfo song;
-        song.filePath = fileInfo.absoluteFilePath();
-        song.fileName = fileInfo.fileName();
-        
-        // 尝试从文件名解析艺术家和标题 (格式: 艺术家 - 歌名.mp3)
-        QString baseName = fileInfo.completeBaseName();
-        QStringList parts = baseName.split(" - ");
-        if (parts.size() >= 2) {
-            song.artist = parts[0].trimmed();
-            song.title = parts[1].trimmed();
+    if (query.isEmpty() || !indexUsable) {
+        // 没有查询，或索引尚未建好：显示来源的全部曲目，索引就绪后再过滤
+        m_lastQuery.clear();
+        m_lastMatches.clear();
+        if (allSongs) {
+            m_playlistModel->clearRows();
         } else {
-            song.artist = "未知艺术家";
-            song.title = baseName;
+            m_playlistModel->setRows(m_service->sourceSongs());
         }
+    } else {
+        // 在上一次查询后追加字符时只在上一次的结果中确认
+        QVector<int> matches;
+        if (!m_lastQuery.isEmpty() && query.startsWith(m_lastQuery)) {
+            if (!m_lastMatches.isEmpty()) {
+                matches = searchIndex->refine(m_lastMatches, query);
+            }
+        } else {
+            matches = searchIndex->search(query);
+        }
+        m_lastQuery = query;
+        m_lastMatches = matches;
         
-        song.duration = 0; // 需要播放时才能获取实际时长
-        
-        m_songs.append(song);
-        
-        // 添加到列表
-        QString displayText = song.title + "\n" + song.artist;
-        m_playlistWidget->addItem(displayText);
+        // 结果按曲目下标升序，收藏与歌单保持来源中的顺序
+        QVector<int> rows;
+        if (allSongs) {
+            rows = matches;
+        } else {
+            for (int song : m_service->sourceSongs()) {
+                if (std::binary_search(matches.constBegin(), matches.constEnd(), song)) {
+                    rows.append(song);
+                }
+            }
+        }
+        m_playlistModel->setRows(rows);
     }
     
-    qDebug() << "Found" << m_songs.size() << "songs";
+    int row = m_playlistModel->rowOf(m_service->currentIndex());
+    if (row >= 0) {
+        m_playlistWidget->setCurrentIndex(m_playlistModel->index(row));
+    }
+    prioritizeVisibleSongs();
+}
+
+void MusicPlayer::onSearchTextChanged(const QString &text)
+{
+    Q_UNUSED(text);
+    applyFilter();
 }
 
-void MusicPlayer::playSong(int index)
+void MusicPlayer::onSearchIndexReady()
 {
-    if (index < 0 || index >= m_songs.size()) {
+    // 新索引（标签可能有变化）上重新执行当前查询
+    m_lastQuery.clear();
+    m_lastMatches.clear();
+    if (!m_searchEdit->text().trimmed().isEmpty()) {
+        applyFilter();
+    }
+}
+
+void MusicPlayer::updateFavoriteButton()
+{
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    bool favorite = current >= 0 && current < songs.size()
+                    && PlaylistStore::instance()->isFavorite(songs[current].filePath);
+    m_favoriteButton->setProperty("favorite", favorite ? "true" : "false");
+    m_favoriteButton->style()->unpolish(m_favoriteButton);
+    m_favoriteButton->style()->polish(m_favoriteButton);
+}
+
+void MusicPlayer::prioritizeVisibleSongs()
+{
+    int rowCount = m_playlistModel->rowCount();
+    if (rowCount == 0) {
         return;
     }
     
-    stopPlayback();
+    // 可见行及上下各一屏，滚动时让音乐库先读取这些曲目的标签
+    QRect area = m_playlistWidget->viewport()->rect();
+    int first = m_playlistWidget->indexAt(area.topLeft()).row();
+    int last = m_playlistWidget->indexAt(area.bottomLeft()).row();
+    if (first < 0) {
+        first = 0;
+    }
+    if (last < 0) {
+        last = rowCount - 1;
+    }
+    int margin = last - first + 1;
+    first = qMax(0, first - margin);
+    last = qMin(rowCount - 1, last + margin);
     
-    m_currentIndex = index;
-    const SongInfo &song = m_songs[index];
+    const QVector<SongInfo> &songs = m_service->songs();
+    QStringList paths;
+    for (int i = first; i <= last; ++i) {
+        int song = m_playlistModel->songAt(i);
+        if (song >= 0) {
+            paths << songs[song].filePath;
+        }
+    }
+    MusicLibrary::instance()->prioritize(paths);
+}
+
+void MusicPlayer::onCurrentChanged(int index)
+{
+    if (index >= 0) {
+        showSong(index);
+    } else if (m_service->isStreaming()) {
+        showStream();
+    }
+}
+
+void MusicPlayer::showSong(int index)
+{
+    const SongInfo &song = m_service->songs()[index];
     
-    // 更新UI
+    // 更新UI；搜索过滤后当前曲目可能不在列表中
     m_songTitleLabel->setText(song.title);
     m_artistLabel->setText(song.artist);
-    m_playlistWidget->setCurrentRow(index);
-    
-    // 使用aplay播放
-    QStringList args;
-    args << song.filePath;
+    int row = m_playlistModel->rowOf(index);
+    if (row >= 0) {
+        QModelIndex modelIndex = m_playlistModel->index(row);
+        m_playlistWidget->setCurrentIndex(modelIndex);
+        m_playlistWidget->scrollTo(modelIndex);
+    }
+    updateFavoriteButton();
     
-    m_playerProcess->start("aplay", args);
+    // 预取过的封面已在内存中，否则先显示默认图片，就绪后由 onCoverReady 更新
+    m_cdWidget->setCover(m_coverArt->cover(song.filePath));
+    showOverview(song.filePath);
     
-    if (m_playerProcess->waitForStarted()) {
-        m_playerState = PlayingState;
-        m_currentPosition = 0;
-        m_isPaused = false;
-        m_progressTimer->start(500); // 每0.5秒更新一次进度
-        updatePlayButton();
-        
-        // 启动CD旋转
-        m_cdWidget->startRotation();
-        
-        qDebug() << "Playing:" << song.filePath;
+    // 时长在解码线程打开文件后通过 durationChanged 返回
+    m_positionMs = 0;
+    m_progressSlider->setValue(0);
+    if (song.duration > 0) {
+        m_progressSlider->setMaximum(song.duration * 1000);
+        m_totalTimeLabel->setText(formatTime(song.duration));
     } else {
-        qDebug() << "Failed to start aplay";
+        m_totalTimeLabel->setText(formatTime(0));
     }
+    updateTimeLabels();
 }
 
-void MusicPlayer::stopPlayback()
+void MusicPlayer::showStream()
 {
-    if (m_playerProcess && m_playerProcess->state() != QProcess::NotRunning) {
-        m_playerProcess->kill();
-        m_playerProcess->waitForFinished(1000);
+    // 网络流不在列表中，没有封面与时长，进度条只显示已播放的时间
+    QUrl url(m_service->streamUrl());
+    m_songTitleLabel->setText(url.host());
+    m_artistLabel->setText("正在连接…");
+    m_playlistWidget->clearSelection();
+    updateFavoriteButton();
+    m_cdWidget->setCover(QImage());
+    m_progressSlider->clearOverview();
+    m_positionMs = 0;
+    m_progressSlider->setMaximum(0);
+    m_progressSlider->setValue(0);
+    m_totalTimeLabel->setText("直播");
+    updateTimeLabels();
+    m_streamTicks = 0;
+}
+
+// 缓冲状态一行：缓冲进度或缓冲时长/目标，接收速率，卡顿与重连次数
+static QString streamHealthText(const HttpStream::Status &status)
+{
+    const JitterBuffer::Stats &buffer = status.buffer;
+    QStringList parts;
+    switch (buffer.state) {
+    case JitterBuffer::Buffering:
+        parts << QString("缓冲中 %1%").arg(qMin(100, buffer.levelMs * 100 / qMax(1, buffer.targetMs)));
+        break;
+    case JitterBuffer::Playing:
+        parts << QString("缓冲 %1/%2 秒").arg(buffer.levelMs / 1000.0, 0, 'f', 1)
+                 .arg(buffer.targetMs / 1000.0, 0, 'f', 1);
+        break;
+    case JitterBuffer::Finished:
+        parts << "已播完";
+        break;
     }
-    
-    if (m_progressTimer) {
-        m_progressTimer->stop();
+    if (status.connected) {
+        parts << QString("%1 kbps").arg(status.receiveKbps);
+    } else if (!status.error.isEmpty()) {
+        parts << status.error;
+    } else if (!buffer.ended) {
+        parts << "重新连接中";
     }
-    
-    // 停止并重置CD旋转
-    m_cdWidget->resetRotation();
-    
-    m_playerState = StoppedState;
-    m_currentPosition = 0;
-    m_isPaused = false;
-    updatePlayButton();
+    if (buffer.underruns > 0) {
+        parts << QString("卡顿 %1 次").arg(buffer.underruns);
+    }
+    if (status.reconnects > 0) {
+        parts << QString("重连 %1 次").arg(status.reconnects);
+    }
+    return parts.join(" · ");
 }
 
-void MusicPlayer::pausePlayback()
+void MusicPlayer::updateStreamStatus()
 {
-    if (m_playerProcess && m_playerProcess->state() == QProcess::Running) {
-        // ALSA的aplay不支持暂停，所以我们记录位置并停止
-        m_pausePosition = m_currentPosition;
-        m_playerProcess->kill();
-        m_playerProcess->waitForFinished();
-        m_progressTimer->stop();
-        m_playerState = PausedState;
-        m_isPaused = true;
-        updatePlayButton();
-        
-        // 暂停CD旋转
-        m_cdWidget->stopRotation();
+    // 引擎打开网络流（连接并收到响应头）之前还没有状态
+    HttpStream::Status status;
+    if (!m_service->streamStatus(status)) {
+        return;
     }
+    QString title = !status.title.isEmpty() ? status.title
+                  : !status.name.isEmpty() ? status.name
+                  : QUrl(m_service->streamUrl()).host();
+    m_songTitleLabel->setText(title);
+    m_artistLabel->setText(streamHealthText(status));
 }
 
-void MusicPlayer::resumePlayback()
+void MusicPlayer::onStateChanged(PlayerService::PlayerState state)
 {
-    if (m_currentIndex >= 0 && m_currentIndex < m_songs.size()) {
-        const SongInfo &song = m_songs[m_currentIndex];
-        
-        // aplay不支持从特定位置开始播放
-        // 作为替代方案，我们重新开始播放
-        // 如果需要支持暂停/恢复，需要使用其他播放器如ffplay或自己实现
-        QStringList args;
-        args << song.filePath;
-        
-        m_playerProcess->start("aplay", args);
-        
-        if (m_playerProcess->waitForStarted()) {
-            m_playerState = PlayingState;
-            m_isPaused = false;
-            m_progressTimer->start(500);
-            updatePlayButton();
-            
-            // 恢复CD旋转
-            m_cdWidget->startRotation();
+    // 隐藏时只更新按钮，进度与旋转在重新显示时按当时的状态恢复
+    if (!isVisible()) {
+        if (state == PlayerService::StoppedState) {
+            m_positionMs = 0;
         }
+        updatePlayButton();
+        return;
     }
+    
+    switch (state) {
+    case PlayerService::StoppedState:
+        // 停止并重置CD旋转
+        stopProgressTicks();
+        m_cdWidget->resetRotation();
+        m_positionMs = 0;
+        break;
+    case PlayerService::PlayingState:
+        startProgressTicks();
+        m_cdWidget->startRotation();
+        break;
+    case PlayerService::PausedState:
+        // 暂停CD旋转
+        stopProgressTicks();
+        m_cdWidget->stopRotation();
+        break;
+    }
+    updatePlayButton();
 }
 
 void MusicPlayer::onPlayPauseClicked()
 {
-    if (m_playerState == StoppedState) {
-        if (m_songs.isEmpty()) {
-            return;
-        }
-        if (m_currentIndex < 0) {
-            m_currentIndex = 0;
-        }
-        playSong(m_currentIndex);
-    } else if (m_playerState == PlayingState) {
-        pausePlayback();
-    } else if (m_playerState == PausedState) {
-        resumePlayback();
-    }
+    m_service->playPause();
 }
 
 void MusicPlayer::onPreviousClicked()
 {
-    if (m_songs.isEmpty()) {
-        return;
-    }
-    
-    m_currentIndex--;
-    if (m_currentIndex < 0) {
-        m_currentIndex = m_songs.size() - 1;
-    }
-    
-    playSong(m_currentIndex);
+    m_service->previous();
 }
 
 void MusicPlayer::onNextClicked()
 {
-    if (m_songs.isEmpty()) {
-        return;
-    }
-    
-    m_currentIndex++;
-    if (m_currentIndex >= m_songs.size()) {
-        m_currentIndex = 0;
-    }
-    
-    playSong(m_currentIndex);
+    m_service->next();
 }
 
 void MusicPlayer::onModeClicked()
 {
-    m_playMode = static_cast<PlayMode>((m_playMode + 1) % 4);
+    m_service->setPlayMode(PlayerService::PlayMode((m_service->playMode() + 1) % 4));
     updateModeButton();
 }
 
@@ -703,20 +909,155 @@ void MusicPlayer::onVolumeClicked()
 
 void MusicPlayer::onFavoriteClicked()
 {
-    // 收藏功能的实现
-    qDebug() << "Favorite clicked";
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    if (current < 0 || current >= songs.size()) {
+        return;
+    }
+    
+    // 按钮状态在 favoritesChanged 中更新
+    PlaylistStore *store = PlaylistStore::instance();
+    const QString &path = songs[current].filePath;
+    store->setFavorite(path, !store->isFavorite(path));
 }
 
 void MusicPlayer::onMenuClicked()
 {
-    // 菜单功能的实现
-    qDebug() << "Menu clicked";
+    PlaylistStore *store = PlaylistStore::instance();
+    const QStringList names = store->playlistNames();
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    bool hasSong = current >= 0 && current < songs.size();
+    QString currentPath = hasSong ? songs[current].filePath : QString();
+    PlayerService::Source source = m_service->source();
+    QString sourceName = m_service->sourceName();
+    
+    // 来源切换
+    QMenu menu(this);
+    QAction *allAction = menu.addAction("全部歌曲");
+    allAction->setCheckable(true);
+    allAction->setChecked(source == PlayerService::AllSongs);
+    QAction *favoriteAction = menu.addAction("我的收藏");
+    favoriteAction->setCheckable(true);
+    favoriteAction->setChecked(source == PlayerService::FavoriteSongs);
+    QList<QAction *> playlistActions;
+    for (const QString &name : names) {
+        QAction *action = menu.addAction(name);
+        action->setCheckable(true);
+        action->setChecked(source == PlayerService::PlaylistSongs && sourceName == name);
+        playlistActions.append(action);
+    }
+    
+    // 歌单管理
+    menu.addSeparator();
+    QAction *createAction = menu.addAction("新建歌单…");
+    QMenu *addMenu = menu.addMenu("添加到歌单");
+    addMenu->setEnabled(hasSong && !names.isEmpty());
+    for (const QString &name : names) {
+        addMenu->addAction(name);
+    }
+    QAction *removeSongAction = menu.addAction("从歌单中移除");
+    removeSongAction->setEnabled(hasSong && source == PlayerService::PlaylistSongs
+                                 && store->playlist(sourceName).contains(currentPath));
+    QAction *deleteAction = menu.addAction("删除当前歌单");
+    deleteAction->setEnabled(source == PlayerService::PlaylistSongs);
+    
+    menu.addSeparator();
+    QMenu *equalizerMenu = menu.addMenu("均衡器");
+    for (int i = 0; i < Equalizer::presetCount(); ++i) {
+        QAction *action = equalizerMenu->addAction(Equalizer::presetName(i));
+        action->setCheckable(true);
+        action->setChecked(i == m_service->equalizerPreset());
+        action->setData(i);
+    }
+    QAction *streamAction = menu.addAction("网络电台…");
+    QAction *diagnosticsAction = menu.addAction("播放诊断");
+    
+    // 按钮在面板底部，菜单向上弹出
+    QPoint pos = m_menuButton->mapToGlobal(QPoint(0, 0));
+    QAction *chosen = menu.exec(QPoint(pos.x(), pos.y() - menu.sizeHint().height()));
+    if (!chosen) {
+        return;
+    }
+    
+    if (chosen == allAction) {
+        m_service->setSource(PlayerService::AllSongs);
+        m_playlistWidget->scrollToTop();
+    } else if (chosen == favoriteAction) {
+        m_service->setSource(PlayerService::FavoriteSongs);
+        m_playlistWidget->scrollToTop();
+    } else if (playlistActions.contains(chosen)) {
+        m_service->setSource(PlayerService::PlaylistSongs, chosen->text());
+        m_playlistWidget->scrollToTop();
+    } else if (chosen == createAction) {
+        bool ok = false;
+        QString name = QInputDialog::getText(this, "新建歌单", "歌单名称：",
+                                             QLineEdit::Normal, QString(), &ok).trimmed();
+        if (ok && !name.isEmpty()) {
+            store->createPlaylist(name);
+            m_service->setSource(PlayerService::PlaylistSongs, name);
+            m_playlistWidget->scrollToTop();
+        }
+    } else if (chosen->parent() == addMenu) {
+        store->addToPlaylist(chosen->text(), currentPath);
+    } else if (chosen == removeSongAction) {
+        store->removeFromPlaylist(sourceName, currentPath);
+    } else if (chosen->parent() == equalizerMenu) {
+        m_service->setEqualizerPreset(chosen->data().toInt());
+    } else if (chosen == streamAction) {
+        bool ok = false;
+        QString last = m_service->streamUrl();
+        QString url = QInputDialog::getText(this, "网络电台", "流地址（http://，MP3 或 Ogg Vorbis）：",
+                                            QLineEdit::Normal, last.isEmpty() ? QString("http://") : last,
+                                            &ok).trimmed();
+        if (ok && !url.isEmpty()) {
+            m_service->playStream(url);
+        }
+    } else if (chosen == diagnosticsAction) {
+        showDiagnostics();
+    } else if (chosen == deleteAction) {
+        if (QMessageBox::question(this, "删除歌单", QString("删除歌单“%1”？").arg(sourceName))
+                == QMessageBox::Yes) {
+            // 歌单不存在后播放服务回到全部歌曲
+            store->removePlaylist(sourceName);
+        }
+    }
 }
 
-void MusicPlayer::onSongSelected(QListWidgetItem *item)
+void MusicPlayer::showDiagnostics()
 {
-    int index = m_playlistWidget->row(item);
-    playSong(index);
+    // 覆盖在右侧面板上，关闭后保留，再次打开时继续显示累计的统计
+    if (!m_diagnosticsPanel) {
+        m_diagnosticsPanel = new DiagnosticsPanel(m_service->engine(), this);
+        m_diagnosticsPanel->setFixedSize(460, 420);
+    }
+    m_diagnosticsPanel->move(width() - m_diagnosticsPanel->width() - 30,
+                             (height() - m_diagnosticsPanel->height()) / 2);
+    m_diagnosticsPanel->show();
+    m_diagnosticsPanel->raise();
+}
+
+void MusicPlayer::onCoverClicked()
+{
+    // 依次切换：CD → 频谱 → 电平表 → 示波器 → CD
+    if (m_coverStack->currentWidget() == m_cdWidget) {
+        m_visualizer->setMode(VisualizerWidget::SpectrumMode);
+        m_coverStack->setCurrentWidget(m_visualizer);
+        m_service->analyzer()->start();
+    } else if (m_visualizer->mode() == VisualizerWidget::SpectrumMode) {
+        m_visualizer->setMode(VisualizerWidget::MeterMode);
+    } else if (m_visualizer->mode() == VisualizerWidget::MeterMode) {
+        m_visualizer->setMode(VisualizerWidget::ScopeMode);
+    } else {
+        // 回到 CD 时停止分析，不占用 CPU
+        m_service->analyzer()->stop();
+        m_coverStack->setCurrentWidget(m_cdWidget);
+    }
+}
+
+void MusicPlayer::onSongSelected(const QModelIndex &index)
+{
+    m_service->play(m_playlistModel->songAt(index.row()));
 }
 
 void MusicPlayer::onSliderPressed()
@@ -728,71 +1069,92 @@ void MusicPlayer::onSliderReleased()
 {
     m_isSliderPressed = false;
     
-    // aplay不支持seek功能
-    // 如果需要支持，需要使用其他播放器
-    qDebug() << "Seek is not supported with aplay";
+    if (m_service->state() == PlayerService::StoppedState) {
+        return;
+    }
+    
+    m_positionMs = m_progressSlider->value();
+    m_service->seek(m_positionMs);
+    updateTimeLabels();
+}
+
+void MusicPlayer::startProgressTicks()
+{
+    // 每帧（40ms）读取一次音频时钟，进度条误差在一帧以内
+    if (!m_progressTimer->isActive()) {
+        m_progressTimer->start(40 * 1000000LL);
+    }
+}
+
+void MusicPlayer::stopProgressTicks()
+{
+    // 返回后定时器线程不会再访问本对象
+    m_progressTimer->stop();
 }
 
 void MusicPlayer::updateProgress()
 {
-    if (m_playerState == PlayingState && !m_isSliderPressed) {
-        m_currentPosition++;
+    m_progressPending.storeRelease(0);
+    
+    if (m_service->state() == PlayerService::PlayingState && !m_isSliderPressed) {
+        // 位置取自声卡实际播放的帧数（无锁快照），不随节拍累计误差
+        m_positionMs = m_service->position();
         
-        if (!m_isSliderPressed && m_progressSlider->maximum() > 0) {
-            m_progressSlider->setValue(m_currentPosition);
+        if (m_progressSlider->maximum() > 0) {
+            m_progressSlider->setValue(int(m_positionMs));
         }
         
         updateTimeLabels();
+
+        // 网络流的缓冲状态约半秒刷新一次
+        if (m_service->isStreaming() && m_streamTicks++ % 12 == 0) {
+            updateStreamStatus();
+        }
     }
 }
 
-void MusicPlayer::onPlayerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+void MusicPlayer::onCoverReady(const QString &path)
 {
-    Q_UNUSED(exitCode);
-    Q_UNUSED(exitStatus);
-    
-    if (m_isPaused) {
-        return; // 如果是暂停导致的结束，不处理
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    if (current >= 0 && current < songs.size() && songs[current].filePath == path) {
+        m_cdWidget->setCover(m_coverArt->cover(path));
     }
-    
-    qDebug() << "Playback finished";
-    
-    // 根据播放模式处理
-    switch (m_playMode) {
-    case SequentialMode:
-        if (m_currentIndex < m_songs.size() - 1) {
-            onNextClicked();
-        } else {
-            stopPlayback();
-        }
-        break;
-        
-    case LoopMode:
-        onNextClicked();
-        break;
-        
-    case RandomMode: {
-        int randomIndex = qrand() % m_songs.size();
-        m_currentIndex = randomIndex;
-        playSong(m_currentIndex);
-        break;
+}
+
+void MusicPlayer::showOverview(const QString &path)
+{
+    // 缓存只有几百字节；尚未分析的曲目先显示细线，分析完成后由 onTrackAnalyzed 更新
+    WaveformOverview overview;
+    if (overview.load(path)) {
+        m_progressSlider->setOverview(overview);
+    } else {
+        m_progressSlider->clearOverview();
     }
-        
-    case SingleLoopMode:
-        playSong(m_currentIndex);
-        break;
+}
+
+void MusicPlayer::onTrackAnalyzed(const QString &path)
+{
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    if (current >= 0 && current < songs.size() && songs[current].filePath == path) {
+        showOverview(path);
     }
 }
 
-void MusicPlayer::onPlayerError(QProcess::ProcessError error)
+void MusicPlayer::onPlayerError(const QString &message)
+{
+    m_artistLabel->setText(message);
+}
+
+void MusicPlayer::onDurationChanged()
 {
-    qDebug() << "Player error:" << error;
-    stopPlayback();
+    updateTimeLabels();
 }
 
 void MusicPlayer::updatePlayButton()
 {
-    if (m_playerState == PlayingState) {
+    if (m_service->state() == PlayerService::PlayingState) {
         m_playPauseButton->setProperty("playing", "true");
     } else {
         m_playPauseButton->setProperty("playing", "false");
@@ -806,20 +1168,20 @@ void MusicPlayer::updateModeButton()
     QString tooltip;
     QString buttonText;
     
-    switch (m_playMode) {
-    case SequentialMode:
+    switch (m_service->playMode()) {
+    case PlayerService::SequentialMode:
         tooltip = "顺序播放";
         buttonText = "顺序";
         break;
-    case LoopMode:
+    case PlayerService::LoopMode:
         tooltip = "列表循环";
         buttonText = "循环";
         break;
-    case RandomMode:
+    case PlayerService::RandomMode:
         tooltip = "随机播放";
         buttonText = "随机";
         break;
-    case SingleLoopMode:
+    case PlayerService::SingleLoopMode:
         tooltip = "单曲循环";
         buttonText = "单曲";
         break;
@@ -831,30 +1193,21 @@ void MusicPlayer::updateModeButton()
 
 void MusicPlayer::updateTimeLabels()
 {
-    m_currentTimeLabel->setText(formatTime(m_currentPosition));
+    // 文本不变时 QLabel 不会重绘，每帧调用开销很小
+    m_currentTimeLabel->setText(formatTime(int(m_positionMs / 1000)));
     
-    if (m_currentIndex >= 0 && m_currentIndex < m_songs.size()) {
-        int duration = m_songs[m_currentIndex].duration;
+    const QVector<SongInfo> &songs = m_service->songs();
+    int current = m_service->currentIndex();
+    if (current >= 0 && current < songs.size()) {
+        int duration = songs[current].duration;
         if (duration > 0) {
             m_totalTimeLabel->setText(formatTime(duration));
-            m_progressSlider->setMaximum(duration);
+            qint64 durationMs = m_service->duration() > 0 ? m_service->duration() : duration * 1000LL;
+            m_progressSlider->setMaximum(int(durationMs));
         }
     }
 }
 
-void MusicPlayer::setVolume(int volume)
-{
-    m_volumeLevel = volume;
-    
-    // 使用amixer设置ALSA音量（如果失败不影响播放）
-    QProcess *volumeProcess = new QProcess();
-    volumeProcess->start("amixer", QStringList() << "set" << "Master" << QString::number(volume) + "%");
-    
-    // 异步执行，不等待完成
-    connect(volumeProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            volumeProcess, &QProcess::deleteLater);
-}
-
 QString MusicPlayer::formatTime(int seconds)
 {
     int minutes = seconds / 60;
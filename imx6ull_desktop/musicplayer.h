@@ -5,20 +5,24 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QSlider>
-#include <QListWidget>
-#include <QProcess>
-#include <QTimer>
+#include <QListView>
+#include <QLineEdit>
+#include <QStackedWidget>
 #include <QVector>
+#include <QAtomicInt>
 #include "cdwidget.h"
+#include "visualizerwidget.h"
+#include "waveformslider.h"
+#include "playerservice.h"
+#include "playlistmodel.h"
 
-struct SongInfo {
-    QString fileName;
-    QString filePath;
-    QString title;
-    QString artist;
-    int duration; // 歌曲时长（秒）
-};
+class BoardClock;
+class BoardTimer;
+class DiagnosticsPanel;
+class CoverArtCache;
 
+// 音乐播放器界面：播放服务的视图，关闭后播放继续。整个进程只建一次，
+// 对话框关闭时隐藏并交还给主窗口保存，重新打开时直接移入新的对话框，不重建界面
 class MusicPlayer : public QWidget
 {
     Q_OBJECT
@@ -27,18 +31,9 @@ public:
     explicit MusicPlayer(QWidget *parent = nullptr);
     ~MusicPlayer();
 
-    enum PlayMode {
-        SequentialMode = 0,
-        LoopMode,
-        RandomMode,
-        SingleLoopMode
-    };
-
-    enum PlayerState {
-        StoppedState = 0,
-        PlayingState,
-        PausedState
-    };
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private slots:
     void onPlayPauseClicked();
@@ -48,36 +43,55 @@ private slots:
     void onVolumeClicked();
     void onFavoriteClicked();
     void onMenuClicked();
-    void onSongSelected(QListWidgetItem *item);
+    void onSongSelected(const QModelIndex &index);
     void onSliderPressed();
     void onSliderReleased();
     void updateProgress();
-    void onPlayerFinished(int exitCode, QProcess::ExitStatus exitStatus);
-    void onPlayerError(QProcess::ProcessError error);
+    void prioritizeVisibleSongs();
+    void onCoverClicked();
+    void onSearchTextChanged(const QString &text);
+    void onSearchIndexReady();
+    void onSongsReset();
+    void onSongsChanged(int first, int last);
+    void onSourceChanged();
+    void onCurrentChanged(int index);
+    void onStateChanged(PlayerService::PlayerState state);
+    void onDurationChanged();
+    void onPlayerError(const QString &message);
+    void onCoverReady(const QString &path);
+    void onTrackAnalyzed(const QString &path);
 
 private:
     void setupUI();
     void loadStyleSheet();
-    void scanMusicFiles();
-    void playSong(int index);
-    void stopPlayback();
-    void pausePlayback();
-    void resumePlayback();
+    void showSong(int index);
+    void showStream();
+    void showOverview(const QString &path);
+    void updateStreamStatus();
     void updatePlayButton();
     void updateModeButton();
     void updateTimeLabels();
-    void setVolume(int volume);
+    void startProgressTicks();
+    void stopProgressTicks();
     QString formatTime(int seconds);
+    void applyFilter();
+    void updateFavoriteButton();
+    void showDiagnostics();
     
 private:
     // UI组件
+    QStackedWidget *m_coverStack;   // CD 封面与可视化共用同一位置
     CDWidget *m_cdWidget;
+    VisualizerWidget *m_visualizer;
+    QLabel *m_playlistTitle;
+    QLineEdit *m_searchEdit;
     QLabel *m_songTitleLabel;
     QLabel *m_artistLabel;
     QLabel *m_currentTimeLabel;
     QLabel *m_totalTimeLabel;
-    QSlider *m_progressSlider;
-    QListWidget *m_playlistWidget;
+    WaveformSlider *m_progressSlider;
+    QListView *m_playlistWidget;
+    PlaylistModel *m_playlistModel;
     
     QPushButton *m_playPauseButton;
     QPushButton *m_previousButton;
@@ -89,23 +103,27 @@ private:
     
     QSlider *m_volumeSlider;
     QWidget *m_volumePanel;
+    DiagnosticsPanel *m_diagnosticsPanel;   // 第一次打开时创建
+    
+    // 播放服务：引擎、曲目列表与播放状态都在其中，界面关闭后继续存在
+    PlayerService *m_service;
+    qint64 m_positionMs; // 显示的播放位置（毫秒），进度条也以毫秒为单位
+    
+    // 进度节拍只在界面存在时运行
+    BoardClock *m_clock;
+    BoardTimer *m_progressTimer;
+    QAtomicInt m_progressPending;
+    int m_streamTicks;              // 网络流的缓冲状态每几个节拍刷新一次
     
-    // 播放器数据
-    QVector<SongInfo> m_songs;
-    int m_currentIndex;
-    PlayMode m_playMode;
-    PlayerState m_playerState;
-    int m_currentPosition; // 当前播放位置（秒）
-    int m_volumeLevel; // 音量等级 0-100
+    // 封面缩略图：后台提取，内存中按 LRU 保留
+    CoverArtCache *m_coverArt;
     
-    // ALSA播放进程
-    QProcess *m_playerProcess;
-    QTimer *m_progressTimer;
+    // 搜索：在服务建好的索引中按输入逐字过滤
+    QString m_lastQuery;
+    QVector<int> m_lastMatches;
     
     // 控制标志
     bool m_isSliderPressed;
-    bool m_isPaused;
-    qint64 m_pausePosition;
 };
 
 #endif // MUSICPLAYER_H
@@ -1,4 +1,5 @@
 #include "musicplayer_simple.h"
+#include "boardio.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGridLayout>
@@ -652,7 +653,9 @@ void MusicPlayerSimple::updateTimeLabels()
 void MusicPlayerSimple::setVolume(int volume)
 {
     m_volumeLevel = volume;
-    QProcess::execute("amixer", QStringList() << "set" << "Master" << QString::number(volume) + "%");
+    // 交给 BoardIo 的 I/O 线程执行，拖动时只保留最新的音量值
+    BoardIo::instance()->exec("amixer-master", "amixer",
+                              QStringList() << "set" << "Master" << QString::number(volume) + "%");
 }
 
 QString MusicPlayerSimple::formatTime(int seconds)
@@ -0,0 +1,150 @@
+#include "playbackqueue.h"
+#include <algorithm>
+#include <numeric>
+
+PlaybackQueue::PlaybackQueue()
+    : m_mode(Sequential)
+    , m_count(0)
+    , m_current(-1)
+    , m_orderPos(-1)
+    , m_rng(std::random_device()())
+{
+}
+
+void PlaybackQueue::reset(int count, int current)
+{
+    m_count = qMax(0, count);
+    m_current = (current >= 0 && current < m_count) ? current : -1;
+    m_order.clear();
+    m_orderPos = -1;
+}
+
+void PlaybackQueue::setMode(Mode mode)
+{
+    if (m_mode != mode) {
+        m_mode = mode;
+        // 进入随机模式时从当前曲目开始新的一轮
+        m_order.clear();
+        m_orderPos = -1;
+    }
+}
+
+void PlaybackQueue::setCurrent(int index)
+{
+    if (index < 0 || index >= m_count || index == m_current) {
+        return;
+    }
+    m_current = index;
+
+    if (m_order.size() != m_count) {
+        return;     // 洗牌顺序在需要时再生成
+    }
+    // 把选中的曲目移到当前位置：尚未播放的从后面提前，已播放的放回当前位置
+    int pos = m_order.indexOf(index);
+    m_order.remove(pos);
+    if (pos > m_orderPos) {
+        m_order.insert(++m_orderPos, index);
+    } else {
+        m_order.insert(qMax(0, m_orderPos), index);
+        m_orderPos = qMax(0, m_orderPos);
+    }
+}
+
+void PlaybackQueue::reshuffle()
+{
+    m_order.resize(m_count);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    std::shuffle(m_order.begin(), m_order.end(), m_rng);
+
+    // 新一轮从当前曲目开始
+    m_orderPos = -1;
+    if (m_current >= 0) {
+        std::iter_swap(m_order.begin(), std::find(m_order.begin(), m_order.end(), m_current));
+        m_orderPos = 0;
+    }
+}
+
+int PlaybackQueue::shuffleNext()
+{
+    if (m_order.size() != m_count) {
+        reshuffle();
+    }
+    if (m_orderPos + 1 < m_order.size()) {
+        return m_order[m_orderPos + 1];
+    }
+
+    // 一轮结束：重新洗牌，新一轮第一首不能与刚播放的相同
+    std::shuffle(m_order.begin(), m_order.end(), m_rng);
+    if (m_count > 1 && m_order[0] == m_current) {
+        std::uniform_int_distribution<int> pick(1, m_count - 1);
+        std::swap(m_order[0], m_order[pick(m_rng)]);
+    }
+    m_orderPos = -1;
+    return m_order[0];
+}
+
+int PlaybackQueue::peekNext()
+{
+    if (m_count == 0) {
+        return -1;
+    }
+    if (m_current < 0) {
+        return m_mode == Random ? shuffleNext() : 0;
+    }
+
+    switch (m_mode) {
+    case Sequential:
+        return m_current + 1 < m_count ? m_current + 1 : -1;
+    case Loop:
+        return (m_current + 1) % m_count;
+    case Random:
+        return shuffleNext();
+    case SingleLoop:
+        return m_current;
+    }
+    return -1;
+}
+
+int PlaybackQueue::advance()
+{
+    int next = peekNext();
+    if (next < 0) {
+        return -1;
+    }
+    if (m_mode == Random) {
+        m_orderPos++;
+    }
+    m_current = next;
+    return next;
+}
+
+int PlaybackQueue::skipNext()
+{
+    if (m_count == 0) {
+        return -1;
+    }
+    if (m_mode == Random) {
+        int next = shuffleNext();
+        m_orderPos++;
+        m_current = next;
+        return next;
+    }
+    int next = (m_current + 1) % m_count;
+    setCurrent(next);
+    return next;
+}
+
+int PlaybackQueue::skipPrevious()
+{
+    if (m_count == 0) {
+        return -1;
+    }
+    // 随机模式沿洗牌顺序回退，回到本轮开头后按列表顺序
+    if (m_mode == Random && m_order.size() == m_count && m_orderPos > 0) {
+        m_current = m_order[--m_orderPos];
+        return m_current;
+    }
+    int previous = m_current <= 0 ? m_count - 1 : m_current - 1;
+    setCurrent(previous);
+    return previous;
+}
@@ -0,0 +1,56 @@
+#ifndef PLAYBACKQUEUE_H
+#define PLAYBACKQUEUE_H
+
+#include <QVector>
+#include <random>
+
+// 播放队列：按播放模式提前决定下一首，供引擎预先打开和解码
+// 随机模式使用洗牌顺序，一轮内每首只播放一次，两轮衔接处也不会连续重复
+class PlaybackQueue
+{
+public:
+    enum Mode {
+        Sequential = 0,
+        Loop,
+        Random,
+        SingleLoop
+    };
+
+    PlaybackQueue();
+
+    // 曲目数量变化时重置洗牌顺序，保留当前曲目
+    void reset(int count, int current);
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+    int current() const { return m_current; }
+
+    // 用户直接选择了某一首
+    void setCurrent(int index);
+
+    // 当前曲目自然结束后的下一首，没有时返回 -1；只查看不前进
+    int peekNext();
+
+    // 前进到自然结束后的下一首并返回
+    int advance();
+
+    // 上一首/下一首按钮：总是循环，单曲循环模式下也切换曲目
+    int skipNext();
+    int skipPrevious();
+
+private:
+    void reshuffle();
+    int shuffleNext();
+
+    Mode m_mode;
+    int m_count;
+    int m_current;
+
+    // 随机模式：m_order[m_orderPos] 为当前曲目
+    QVector<int> m_order;
+    int m_orderPos;
+    std::mt19937 m_rng;
+};
+
+#endif // PLAYBACKQUEUE_H
@@ -0,0 +1,521 @@
+#include "playerservice.h"
+#include "volumecontrol.h"
+#include "spectrumanalyzer.h"
+#include "musiclibrary.h"
+#include "playliststore.h"
+#include "coverartcache.h"
+#include "loudnessanalyzer.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDebug>
+#include <numeric>
+
+PlayerService *PlayerService::instance()
+{
+    static PlayerService *s_instance = nullptr;
+    if (!s_instance) {
+        s_instance = new PlayerService(QCoreApplication::instance());
+    }
+    return s_instance;
+}
+
+PlayerService::PlayerService(QObject *parent)
+    : QObject(parent)
+    , m_engine(nullptr)
+    , m_volumeControl(nullptr)
+    , m_analyzer(nullptr)
+    , m_source(AllSongs)
+    , m_currentIndex(-1)
+    , m_playMode(LoopMode)
+    , m_playerState(StoppedState)
+    , m_volumeLevel(70)
+    , m_equalizerPreset(0)
+    , m_streaming(false)
+    , m_coverArt(CoverArtCache::instance())
+    , m_loudness(LoudnessAnalyzer::instance())
+    , m_searchBuilder(nullptr)
+    , m_songsGeneration(0)
+    , m_pathsGeneration(0)
+{
+    // 初始化播放引擎，控制接口都是异步的，不会阻塞界面
+    m_engine = new AudioEngine(this);
+    connect(m_engine, &AudioEngine::finished, this, &PlayerService::onPlaybackFinished);
+    connect(m_engine, &AudioEngine::errorOccurred, this, &PlayerService::onPlayerError);
+    connect(m_engine, &AudioEngine::durationChanged, this, &PlayerService::onDurationChanged);
+    connect(m_engine, &AudioEngine::trackAdvanced, this, &PlayerService::onTrackAdvanced);
+    m_queue.setMode(PlaybackQueue::Mode(m_playMode));
+
+    // 音量通过 ALSA mixer 在工作线程中设置，没有硬件控件时用软件增益
+    m_volumeControl = new VolumeControl(m_engine, this);
+    m_volumeControl->setVolume(m_volumeLevel);
+
+    // 可视化分析器读取输出线程旁路出的 PCM，由视图在显示可视化时启动
+    m_analyzer = new SpectrumAnalyzer(m_engine->pcmTap(), &m_engine->playbackClock(), this);
+
+    m_searchBuilder = new SearchIndexBuilder(this);
+    connect(m_searchBuilder, &SearchIndexBuilder::ready, this, &PlayerService::onSearchIndexReady);
+
+    // 响度在后台分析，结果只影响之后开始播放的曲目，不在播放中途改变音量
+    connect(m_loudness, &LoudnessAnalyzer::analyzed, this, &PlayerService::onLoudnessAnalyzed);
+
+    // 收藏与歌单变化后重新计算当前来源
+    PlaylistStore *store = PlaylistStore::instance();
+    connect(store, &PlaylistStore::favoritesChanged, this, &PlayerService::onFavoritesChanged);
+    connect(store, &PlaylistStore::playlistsChanged, this, &PlayerService::onPlaylistsChanged);
+
+    // 音乐库先加载上次的索引，后台对账与目录监视发现变化时刷新列表；
+    // 刷新列表会通知引擎下一首，必须在引擎创建之后
+    MusicLibrary *library = MusicLibrary::instance();
+    connect(library, &MusicLibrary::tracksChanged, this, &PlayerService::scanMusicFiles);
+    library->start();
+    scanMusicFiles();
+}
+
+PlayerService::~PlayerService()
+{
+    // 音量线程与分析器都会访问播放引擎，先于引擎停止
+    delete m_volumeControl;
+    m_volumeControl = nullptr;
+    m_analyzer->stop();
+}
+
+void PlayerService::scanMusicFiles()
+{
+    // 曲目列表来自音乐库的持久化索引，目录扫描与监视都在音乐库线程中完成
+    MusicLibrary *library = MusicLibrary::instance();
+    const QVector<TrackRecord> tracks = library->tracks();
+
+    // 曲目没有增减（通常是后台读到了标签与时长）时只更新变化的行
+    bool samePaths = tracks.size() == m_songs.size();
+    for (int i = 0; samePaths && i < tracks.size(); ++i) {
+        samePaths = tracks[i].path == m_songs[i].filePath;
+    }
+    if (samePaths) {
+        int firstChanged = -1;
+        int lastChanged = -1;
+        for (int i = 0; i < tracks.size(); ++i) {
+            SongInfo &song = m_songs[i];
+            const TrackRecord &track = tracks[i];
+            int duration = track.durationMs > 0 ? int((track.durationMs + 500) / 1000) : song.duration;
+            if (song.title != track.title || song.artist != track.artist || song.duration != duration) {
+                song.title = track.title;
+                song.artist = track.artist;
+                song.duration = duration;
+                if (firstChanged < 0) {
+                    firstChanged = i;
+                }
+                lastChanged = i;
+            }
+        }
+        // 标签变化后重建搜索索引；曲目下标不变，旧索引在新索引就绪前仍可使用
+        if (firstChanged >= 0) {
+            ++m_songsGeneration;
+            rebuildSearchIndex();
+            emit songsChanged(firstChanged, lastChanged);
+        }
+        return;
+    }
+
+    // 列表刷新后按路径找回正在播放的歌曲，播放时得到的时长也保留下来
+    QString currentPath;
+    if (m_currentIndex >= 0 && m_currentIndex < m_songs.size()) {
+        currentPath = m_songs[m_currentIndex].filePath;
+    }
+    QHash<QString, int> knownDurations;
+    foreach (const SongInfo &song, m_songs) {
+        if (song.duration > 0) {
+            knownDurations.insert(song.filePath, song.duration);
+        }
+    }
+
+    m_songs.clear();
+    m_songs.reserve(tracks.size());
+    m_songByPath.clear();
+    m_songByPath.reserve(tracks.size());
+    m_currentIndex = -1;
+
+    foreach (const TrackRecord &track, tracks) {
+        SongInfo song;
+        song.filePath = track.path;
+        song.fileName = track.path.mid(track.path.lastIndexOf('/') + 1);
+        song.title = track.title;
+        song.artist = track.artist;
+        song.duration = track.durationMs > 0 ? int((track.durationMs + 500) / 1000)
+                                             : knownDurations.value(track.path, 0);
+
+        if (song.filePath == currentPath) {
+            m_currentIndex = m_songs.size();
+        }
+        m_songByPath.insert(song.filePath, m_songs.size());
+        m_songs.append(song);
+    }
+
+    // 曲目下标变了，旧的搜索索引不能再用，新索引就绪前列表不过滤
+    ++m_songsGeneration;
+    m_pathsGeneration = m_songsGeneration;
+    rebuildSearchIndex();
+
+    // 新增或修改过的曲目在后台分析响度
+    QStringList paths;
+    paths.reserve(m_songs.size());
+    for (const SongInfo &song : m_songs) {
+        paths << song.filePath;
+    }
+    m_loudness->analyze(paths);
+
+    qDebug() << "Found" << m_songs.size() << "songs";
+    emit songsReset();
+    updateSource();
+}
+
+void PlayerService::rebuildSearchIndex()
+{
+    // 字符串隐式共享，这里只复制引用
+    QVector<SearchIndex::Entry> entries;
+    entries.reserve(m_songs.size());
+    for (const SongInfo &song : m_songs) {
+        SearchIndex::Entry entry;
+        entry.title = song.title;
+        entry.artist = song.artist;
+        entries.append(entry);
+    }
+    m_searchBuilder->rebuild(entries, m_songsGeneration);
+}
+
+void PlayerService::onSearchIndexReady()
+{
+    QSharedPointer<const SearchIndex> index = m_searchBuilder->index();
+    if (!index || index->generation() < m_pathsGeneration) {
+        return;     // 曲目已增减，等待下一份索引
+    }
+    m_searchIndex = index;
+    emit searchIndexReady();
+}
+
+int PlayerService::songIndexOf(const QString &path) const
+{
+    return m_songByPath.value(path, -1);
+}
+
+int PlayerService::queueSong(int position) const
+{
+    return position >= 0 && position < m_sourceSongs.size() ? m_sourceSongs[position] : -1;
+}
+
+int PlayerService::queuePosition(int song) const
+{
+    if (song < 0) {
+        return -1;
+    }
+    if (m_source == AllSongs) {
+        return song < m_sourceSongs.size() ? song : -1;
+    }
+    return m_sourceSongs.indexOf(song);
+}
+
+void PlayerService::setSource(Source source, const QString &playlistName)
+{
+    m_source = source;
+    m_sourceName = source == PlaylistSongs ? playlistName : QString();
+    updateSource();
+}
+
+void PlayerService::updateSource()
+{
+    PlaylistStore *store = PlaylistStore::instance();
+    if (m_source == PlaylistSongs && !store->hasPlaylist(m_sourceName)) {
+        // 歌单已被删除
+        m_source = AllSongs;
+        m_sourceName.clear();
+    }
+
+    m_sourceSongs.clear();
+    switch (m_source) {
+    case AllSongs:
+        m_sourceSongs.resize(m_songs.size());
+        std::iota(m_sourceSongs.begin(), m_sourceSongs.end(), 0);
+        break;
+    case FavoriteSongs:
+    case PlaylistSongs: {
+        // 已不在音乐库中的曲目保留在记录里，只是不显示
+        const QStringList paths = m_source == FavoriteSongs ? store->favorites()
+                                                            : store->playlist(m_sourceName);
+        for (const QString &path : paths) {
+            int index = songIndexOf(path);
+            if (index >= 0) {
+                m_sourceSongs.append(index);
+            }
+        }
+        break;
+    }
+    }
+
+    m_queue.reset(m_sourceSongs.size(), queuePosition(m_currentIndex));
+    queueNextTrack();
+    emit sourceChanged();
+}
+
+void PlayerService::onFavoritesChanged()
+{
+    if (m_source == FavoriteSongs) {
+        updateSource();
+    }
+}
+
+void PlayerService::onPlaylistsChanged()
+{
+    if (m_source == PlaylistSongs) {
+        updateSource();
+    }
+}
+
+void PlayerService::play(int index)
+{
+    if (index < 0 || index >= m_songs.size()) {
+        return;
+    }
+
+    stopPlayback();
+    m_streaming = false;
+    setCurrent(index);
+
+    // 只投递播放请求，文件打开与解码都在引擎线程中完成
+    const SongInfo &song = m_songs[index];
+    m_engine->play(song.filePath, trackGainDb(song.filePath));
+    m_loudness->prioritize(song.filePath);
+
+    setState(PlayingState);
+    queueNextTrack();
+
+    qDebug() << "Playing:" << song.filePath;
+}
+
+void PlayerService::playStream(const QString &url)
+{
+    if (!HttpStream::handles(url)) {
+        emit errorOccurred(QString("只支持 http:// 地址: %1").arg(url));
+        return;
+    }
+
+    // 网络流不在队列中：没有下一首，结束（放弃重连）后停止
+    stopPlayback();
+    m_streaming = true;
+    m_streamUrl = url;
+    setCurrent(-1);
+    m_engine->play(url);
+    setState(PlayingState);
+    queueNextTrack();
+
+    qDebug() << "Streaming:" << url;
+}
+
+bool PlayerService::streamStatus(HttpStream::Status &status) const
+{
+    return m_streaming && m_engine->streamStatus(status);
+}
+
+void PlayerService::setCurrent(int index)
+{
+    m_currentIndex = index;
+    m_queue.setCurrent(queuePosition(index));
+    emit currentChanged(index);
+}
+
+void PlayerService::setState(PlayerState state)
+{
+    if (m_playerState != state) {
+        m_playerState = state;
+        emit stateChanged(state);
+    }
+}
+
+void PlayerService::queueNextTrack()
+{
+    if (m_currentIndex < 0 || m_playerState == StoppedState) {
+        m_nextPath.clear();
+        m_engine->setNext(QString());
+        return;
+    }
+
+    // 提前告诉引擎下一首，由它预先打开并在当前曲目结束时无缝衔接
+    int next = queueSong(m_queue.peekNext());
+    m_nextPath = next >= 0 ? m_songs[next].filePath : QString();
+    m_engine->setNext(m_nextPath, trackGainDb(m_nextPath));
+    m_loudness->prioritize(m_nextPath);
+
+    // 预取下一首以及列表中前后两首的封面，自动或手动换曲时封面已在内存中
+    QStringList covers;
+    if (next >= 0) {
+        covers << m_songs[next].filePath;
+    }
+    int position = m_queue.current();
+    for (int neighbor : { position + 1, position - 1 }) {
+        int song = queueSong(neighbor);
+        if (song >= 0 && song != next) {
+            covers << m_songs[song].filePath;
+        }
+    }
+    m_coverArt->prefetch(covers);
+}
+
+void PlayerService::stopPlayback()
+{
+    if (m_engine->state() != AudioEngine::StoppedState) {
+        m_engine->stop();
+    }
+    setState(StoppedState);
+}
+
+void PlayerService::playPause()
+{
+    if (m_playerState == StoppedState) {
+        if (m_streaming) {
+            playStream(m_streamUrl);
+            return;
+        }
+        int index = m_currentIndex >= 0 ? m_currentIndex : queueSong(0);
+        play(index);
+    } else if (m_playerState == PlayingState) {
+        // 暂停后从当前位置继续，不需要重新打开文件
+        if (m_engine->state() == AudioEngine::PlayingState) {
+            m_engine->pause();
+            setState(PausedState);
+        }
+    } else if (m_engine->state() == AudioEngine::PausedState) {
+        m_engine->resume();
+        setState(PlayingState);
+    }
+}
+
+void PlayerService::previous()
+{
+    if (!m_sourceSongs.isEmpty()) {
+        play(queueSong(m_queue.skipPrevious()));
+    }
+}
+
+void PlayerService::next()
+{
+    if (!m_sourceSongs.isEmpty()) {
+        play(queueSong(m_queue.skipNext()));
+    }
+}
+
+void PlayerService::seek(qint64 positionMs)
+{
+    // 定位请求异步执行，连续拖动只保留最后一次；网络流不能定位
+    if (m_playerState != StoppedState && !m_streaming) {
+        m_engine->seek(positionMs);
+    }
+}
+
+void PlayerService::setPlayMode(PlayMode mode)
+{
+    m_playMode = mode;
+    m_queue.setMode(PlaybackQueue::Mode(mode));
+
+    // 模式变化后下一首可能不同，重新通知引擎
+    queueNextTrack();
+}
+
+void PlayerService::setVolume(int volume)
+{
+    m_volumeLevel = volume;
+
+    // 只记录最新值，由音量线程通过 mixer API 设置，拖动滑块不会启动任何进程
+    m_volumeControl->setVolume(volume);
+}
+
+void PlayerService::setEqualizerPreset(int preset)
+{
+    if (preset < 0 || preset >= Equalizer::presetCount()) {
+        return;
+    }
+    m_equalizerPreset = preset;
+
+    // 参数无锁发布给输出线程，下一个周期交叉淡化到新的频响
+    m_engine->equalizer()->setParameters(Equalizer::preset(preset));
+}
+
+qint64 PlayerService::position() const
+{
+    // 位置取自声卡实际播放的帧数（无锁快照）
+    return m_engine->position();
+}
+
+qint64 PlayerService::duration() const
+{
+    return m_engine->duration();
+}
+
+void PlayerService::onPlaybackFinished()
+{
+    qDebug() << "Playback finished";
+
+    // 网络流放弃重连或服务器发完了文件：停止，不进入队列
+    if (m_streaming) {
+        stopPlayback();
+        return;
+    }
+
+    // 正常情况下下一首已经无缝接上（onTrackAdvanced）；走到这里说明没有下一首，
+    // 或下一首格式不同需要重新配置设备
+    int next = queueSong(m_queue.advance());
+    if (next < 0) {
+        stopPlayback();
+        return;
+    }
+    play(next);
+}
+
+void PlayerService::onTrackAdvanced(const QString &path)
+{
+    // 引擎已在样本边界切换到预先指定的下一首，只需同步状态
+    int index = queueSong(m_queue.advance());
+    if (index < 0 || m_songs[index].filePath != path) {
+        index = songIndexOf(path);
+        if (index < 0) {
+            return;     // 列表已刷新，曲目不在其中
+        }
+    }
+
+    setCurrent(index);
+    queueNextTrack();
+    qDebug() << "Gapless:" << path;
+}
+
+void PlayerService::onLoudnessAnalyzed(const QString &path)
+{
+    // 下一首刚分析完：更新交给引擎的增益
+    if (!m_nextPath.isEmpty() && path == m_nextPath) {
+        m_engine->setNext(m_nextPath, trackGainDb(m_nextPath));
+    }
+}
+
+float PlayerService::trackGainDb(const QString &path) const
+{
+    float gainDb = 0.0f;
+    if (path.isEmpty() || !m_loudness->trackGain(path, gainDb)) {
+        return 0.0f;
+    }
+    return gainDb;
+}
+
+void PlayerService::onPlayerError(const QString &message)
+{
+    qDebug() << "Player error:" << message;
+    qDebug() << "Audio diagnostics:" << m_engine->diagnostics()->summary();
+    stopPlayback();
+    emit errorOccurred(message);
+}
+
+void PlayerService::onDurationChanged(qint64 durationMs)
+{
+    if (m_currentIndex < 0 || m_currentIndex >= m_songs.size()) {
+        return;
+    }
+
+    // 打开文件后才知道实际时长
+    m_songs[m_currentIndex].duration = int((durationMs + 500) / 1000);
+    emit durationChanged();
+}
@@ -0,0 +1,164 @@
+#ifndef PLAYERSERVICE_H
+#define PLAYERSERVICE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include "audioengine.h"
+#include "playbackqueue.h"
+#include "playlistmodel.h"
+#include "searchindex.h"
+
+class VolumeControl;
+class SpectrumAnalyzer;
+class CoverArtCache;
+class LoudnessAnalyzer;
+
+// 播放服务：播放引擎、曲目列表、播放队列与播放状态，进程内只有一个实例，以应用对象为父对象
+// 关闭多媒体界面后继续播放；MusicPlayer 只是它的视图，重新打开时直接读取现有状态，不重新扫描曲目
+// 接口只在主线程调用
+class PlayerService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static PlayerService *instance();
+
+    // 与 PlaybackQueue::Mode 一一对应
+    enum PlayMode {
+        SequentialMode = PlaybackQueue::Sequential,
+        LoopMode = PlaybackQueue::Loop,
+        RandomMode = PlaybackQueue::Random,
+        SingleLoopMode = PlaybackQueue::SingleLoop
+    };
+
+    enum PlayerState {
+        StoppedState = 0,
+        PlayingState,
+        PausedState
+    };
+
+    // 列表来源：播放队列只在当前来源的曲目中前进
+    enum Source {
+        AllSongs = 0,
+        FavoriteSongs,
+        PlaylistSongs
+    };
+
+    // 曲目列表，增减后 songsReset()，只改内容时 songsChanged()
+    const QVector<SongInfo> &songs() const { return m_songs; }
+    int songIndexOf(const QString &path) const;
+
+    Source source() const { return m_source; }
+    QString sourceName() const { return m_sourceName; }
+    // 当前来源的曲目下标（按来源顺序）
+    const QVector<int> &sourceSongs() const { return m_sourceSongs; }
+
+    int currentIndex() const { return m_currentIndex; }
+    PlayerState state() const { return m_playerState; }
+    PlayMode playMode() const { return m_playMode; }
+    int volume() const { return m_volumeLevel; }
+    // 均衡器预设（Equalizer::preset() 的下标），0 为关闭
+    int equalizerPreset() const { return m_equalizerPreset; }
+
+    // 网络流：正在播放（或刚停止）的是 streamUrl() 时为 true，此时 currentIndex() 为 -1
+    bool isStreaming() const { return m_streaming; }
+    // 最近一次打开的网络流地址
+    QString streamUrl() const { return m_streamUrl; }
+    // 网络流的接收与缓冲状态，没有在播放网络流时返回 false
+    bool streamStatus(HttpStream::Status &status) const;
+
+    // 声卡实际播放到的位置与引擎得到的时长（毫秒）
+    qint64 position() const;
+    qint64 duration() const;
+
+    // 最近建好的搜索索引，生成号早于 pathsGeneration() 的索引下标已失效
+    QSharedPointer<const SearchIndex> searchIndex() const { return m_searchIndex; }
+    quint64 pathsGeneration() const { return m_pathsGeneration; }
+
+    AudioEngine *engine() const { return m_engine; }
+    SpectrumAnalyzer *analyzer() const { return m_analyzer; }
+
+    void play(int index);
+    // 播放 http:// 音频流（MP3 或 Ogg Vorbis），不属于曲目列表与播放队列
+    void playStream(const QString &url);
+    void playPause();
+    void previous();
+    void next();
+    void seek(qint64 positionMs);
+    void setPlayMode(PlayMode mode);
+    void setSource(Source source, const QString &playlistName = QString());
+    void setVolume(int volume);
+    void setEqualizerPreset(int preset);
+
+signals:
+    void songsReset();
+    void songsChanged(int first, int last);
+    void sourceChanged();
+    void currentChanged(int index);
+    void stateChanged(PlayerService::PlayerState state);
+    void durationChanged();
+    void errorOccurred(const QString &message);
+    void searchIndexReady();
+
+private slots:
+    void scanMusicFiles();
+    void onPlaybackFinished();
+    void onTrackAdvanced(const QString &path);
+    void onPlayerError(const QString &message);
+    void onDurationChanged(qint64 durationMs);
+    void onSearchIndexReady();
+    void onFavoritesChanged();
+    void onPlaylistsChanged();
+    void onLoudnessAnalyzed(const QString &path);
+
+private:
+    explicit PlayerService(QObject *parent = nullptr);
+    ~PlayerService();
+
+    void setCurrent(int index);
+    void setState(PlayerState state);
+    void stopPlayback();
+    void queueNextTrack();
+    void updateSource();
+    void rebuildSearchIndex();
+    int queueSong(int position) const;
+    int queuePosition(int song) const;
+    float trackGainDb(const QString &path) const;
+
+    // 进程内播放引擎（解码线程 + ALSA 输出线程）
+    AudioEngine *m_engine;
+    VolumeControl *m_volumeControl;
+    SpectrumAnalyzer *m_analyzer;
+
+    // 曲目与来源
+    QVector<SongInfo> m_songs;
+    QHash<QString, int> m_songByPath;
+    Source m_source;
+    QString m_sourceName;           // 歌单名
+    QVector<int> m_sourceSongs;     // 队列位置即其下标
+
+    // 播放状态
+    int m_currentIndex;
+    PlayMode m_playMode;
+    PlaybackQueue m_queue;
+    PlayerState m_playerState;
+    int m_volumeLevel;              // 音量等级 0-100
+    int m_equalizerPreset;
+    bool m_streaming;
+    QString m_streamUrl;
+
+    // 封面预取与响度增益
+    CoverArtCache *m_coverArt;
+    LoudnessAnalyzer *m_loudness;
+    QString m_nextPath;             // 已告诉引擎的下一首
+
+    // 搜索：索引在后台线程中建立，曲目列表每次更新后重建
+    SearchIndexBuilder *m_searchBuilder;
+    QSharedPointer<const SearchIndex> m_searchIndex;
+    quint64 m_songsGeneration;      // m_songs 每次更新加一
+    quint64 m_pathsGeneration;      // 曲目增减时的 m_songsGeneration
+};
+
+#endif // PLAYERSERVICE_H
@@ -0,0 +1,121 @@
+#include "playlistdelegate.h"
+#include "playlistmodel.h"
+#include <QPainter>
+#include <QFontMetrics>
+
+// 与原 QListWidget 样式表一致：行内边距 15px/10px，外边距 2px/5px，圆角 8px
+static const int kRowHeight = 64;
+static const int kMarginX = 5;
+static const int kMarginY = 2;
+static const int kPaddingX = 10;
+static const int kRadius = 8;
+static const int kDurationWidth = 48;
+
+// 约为一屏行数的二十多倍，来回滚动时不必重新排版
+static const int kCacheRows = 256;
+
+PlaylistDelegate::PlaylistDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_cache(kCacheRows)
+{
+}
+
+int PlaylistDelegate::rowHeight()
+{
+    return kRowHeight;
+}
+
+QSize PlaylistDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return QSize(option.rect.width(), kRowHeight);
+}
+
+const PlaylistDelegate::Layout *PlaylistDelegate::layoutFor(const QModelIndex &index, const QFont &font, int width) const
+{
+    // 字体变化（样式表更新）时全部重新排版
+    if (m_titleFont != font) {
+        m_titleFont = font;
+        m_artistFont = font;
+        m_artistFont.setPixelSize(qMax(1, font.pixelSize() > 0 ? font.pixelSize() - 2 : 12));
+        m_cache.clear();
+    }
+
+    QString title = index.data(PlaylistModel::TitleRole).toString();
+    QString artist = index.data(PlaylistModel::ArtistRole).toString();
+    int duration = index.data(PlaylistModel::DurationRole).toInt();
+
+    // 按曲目缓存：搜索过滤后行号变化，同一首歌的排版仍可复用
+    int song = index.data(PlaylistModel::SongRole).toInt();
+    Layout *layout = m_cache.object(song);
+    if (layout && layout->width == width && layout->duration == duration
+            && layout->title == title && layout->artist == artist) {
+        return layout;
+    }
+
+    layout = new Layout;
+    layout->title = title;
+    layout->artist = artist;
+    layout->duration = duration;
+    layout->width = width;
+
+    QFontMetrics titleMetrics(m_titleFont);
+    QFontMetrics artistMetrics(m_artistFont);
+    layout->titleText.setText(titleMetrics.elidedText(title, Qt::ElideRight, width));
+    layout->titleText.setTextFormat(Qt::PlainText);
+    layout->titleText.prepare(QTransform(), m_titleFont);
+    layout->artistText.setText(artistMetrics.elidedText(artist, Qt::ElideRight, width));
+    layout->artistText.setTextFormat(Qt::PlainText);
+    layout->artistText.prepare(QTransform(), m_artistFont);
+    if (duration > 0) {
+        layout->durationText.setText(QString("%1:%2").arg(duration / 60, 2, 10, QChar('0'))
+                                     .arg(duration % 60, 2, 10, QChar('0')));
+        layout->durationText.setTextFormat(Qt::PlainText);
+        layout->durationText.prepare(QTransform(), m_artistFont);
+    }
+
+    m_cache.insert(song, layout);
+    return layout;
+}
+
+void PlaylistDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                             const QModelIndex &index) const
+{
+    QRect rect = option.rect.adjusted(kMarginX, kMarginY, -kMarginX, -kMarginY);
+    int textWidth = rect.width() - 2 * kPaddingX - kDurationWidth;
+    const Layout *layout = layoutFor(index, option.font, textWidth);
+
+    painter->save();
+
+    QColor background;
+    if (option.state & QStyle::State_Selected) {
+        background = QColor(255, 255, 255, 77);
+    } else if (option.state & QStyle::State_MouseOver) {
+        background = QColor(255, 255, 255, 51);
+    }
+    if (background.isValid()) {
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(background);
+        painter->drawRoundedRect(rect, kRadius, kRadius);
+    }
+
+    int x = rect.left() + kPaddingX;
+    int titleHeight = QFontMetrics(m_titleFont).height();
+    int artistHeight = QFontMetrics(m_artistFont).height();
+    int top = rect.top() + (rect.height() - titleHeight - artistHeight - 2) / 2;
+
+    painter->setPen(Qt::white);
+    painter->setFont(m_titleFont);
+    painter->drawStaticText(x, top, layout->titleText);
+
+    painter->setPen(QColor(255, 255, 255, 180));
+    painter->setFont(m_artistFont);
+    painter->drawStaticText(x, top + titleHeight + 2, layout->artistText);
+    if (layout->duration > 0) {
+        int durationX = rect.right() - kPaddingX - int(layout->durationText.size().width());
+        painter->drawStaticText(durationX, rect.top() + (rect.height() - artistHeight) / 2, layout->durationText);
+    }
+
+    painter->restore();
+}
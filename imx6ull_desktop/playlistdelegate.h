@@ -0,0 +1,42 @@
+#ifndef PLAYLISTDELEGATE_H
+#define PLAYLISTDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QStaticText>
+#include <QCache>
+#include <QFont>
+
+// 播放列表行绘制：视图只为可见行调用，标题/艺术家/时长的排版结果按行缓存，
+// 滚动时重绘只需要画缓存好的 QStaticText
+class PlaylistDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    static int rowHeight();
+
+private:
+    struct Layout {
+        QString title;
+        QString artist;
+        int duration;
+        int width;
+        QStaticText titleText;
+        QStaticText artistText;
+        QStaticText durationText;
+    };
+
+    const Layout *layoutFor(const QModelIndex &index, const QFont &font, int width) const;
+
+    mutable QCache<int, Layout> m_cache;
+    mutable QFont m_titleFont;
+    mutable QFont m_artistFont;
+};
+
+#endif // PLAYLISTDELEGATE_H
@@ -0,0 +1,100 @@
+#include "playlistmodel.h"
+
+PlaylistModel::PlaylistModel(const QVector<SongInfo> *songs, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_songs(songs)
+    , m_filtered(false)
+{
+}
+
+int PlaylistModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_filtered ? m_rows.size() : m_songs->size();
+}
+
+QVariant PlaylistModel::data(const QModelIndex &index, int role) const
+{
+    int songIndex = index.isValid() ? songAt(index.row()) : -1;
+    if (songIndex < 0) {
+        return QVariant();
+    }
+
+    const SongInfo &song = m_songs->at(songIndex);
+    switch (role) {
+    case Qt::DisplayRole:
+        return song.title + "\n" + song.artist;
+    case TitleRole:
+        return song.title;
+    case ArtistRole:
+        return song.artist;
+    case DurationRole:
+        return song.duration;
+    case PathRole:
+        return song.filePath;
+    case SongRole:
+        return songIndex;
+    default:
+        return QVariant();
+    }
+}
+
+void PlaylistModel::reload()
+{
+    beginResetModel();
+    endResetModel();
+}
+
+void PlaylistModel::refreshRows(int first, int last)
+{
+    if (first < 0 || last < first || last >= m_songs->size()) {
+        return;
+    }
+    if (m_filtered) {
+        // 行表中的顺序与曲目下标无关，通知全部行，视图只重绘可见的部分
+        if (!m_rows.isEmpty()) {
+            emit dataChanged(index(0), index(m_rows.size() - 1));
+        }
+        return;
+    }
+    emit dataChanged(index(first), index(last));
+}
+
+void PlaylistModel::setRows(const QVector<int> &rows)
+{
+    beginResetModel();
+    m_rows = rows;
+    m_filtered = true;
+    endResetModel();
+}
+
+void PlaylistModel::clearRows()
+{
+    if (!m_filtered) {
+        return;
+    }
+    beginResetModel();
+    m_rows.clear();
+    m_filtered = false;
+    endResetModel();
+}
+
+int PlaylistModel::songAt(int row) const
+{
+    if (m_filtered) {
+        // 曲目数组刚更新、行表尚未重新设置时，行表中的下标可能越界
+        int song = row >= 0 && row < m_rows.size() ? m_rows[row] : -1;
+        return song < m_songs->size() ? song : -1;
+    }
+    return row >= 0 && row < m_songs->size() ? row : -1;
+}
+
+int PlaylistModel::rowOf(int song) const
+{
+    if (song < 0 || song >= m_songs->size()) {
+        return -1;
+    }
+    return m_filtered ? m_rows.indexOf(song) : song;
+}
@@ -0,0 +1,55 @@
+#ifndef PLAYLISTMODEL_H
+#define PLAYLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QString>
+
+struct SongInfo {
+    QString fileName;
+    QString filePath;
+    QString title;
+    QString artist;
+    int duration; // 歌曲时长（秒）
+};
+
+// 播放列表模型：直接读取播放器的曲目数组，不为每一行创建对象
+// 曲目数组由播放服务维护，增减后调用 reload()，只改内容时调用 refreshRows()
+// 设置了行表（搜索结果、收藏、歌单）时只显示其中的曲目，行号与曲目下标用 songAt()/rowOf() 换算
+class PlaylistModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Role {
+        TitleRole = Qt::UserRole + 1,
+        ArtistRole,
+        DurationRole,
+        PathRole,
+        SongRole        // 曲目在数组中的下标
+    };
+
+    explicit PlaylistModel(const QVector<SongInfo> *songs, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void reload();
+    // first/last 为曲目下标
+    void refreshRows(int first, int last);
+
+    // 只显示 rows 中的曲目（按给出的顺序）；clearRows() 恢复显示全部
+    void setRows(const QVector<int> &rows);
+    void clearRows();
+    bool isFiltered() const { return m_filtered; }
+
+    int songAt(int row) const;
+    int rowOf(int song) const;
+
+private:
+    const QVector<SongInfo> *m_songs;
+    QVector<int> m_rows;
+    bool m_filtered;
+};
+
+#endif // PLAYLISTMODEL_H
@@ -0,0 +1,337 @@
+#include "pwmgenerator.h"
+#include "pwmchannel.h"
+#include "periodicscheduler.h"
+#include "boardio.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cmath>
+
+// imx6ull 的 PWM3 控制器
+static const char *kPwm3Device = "2088000.pwm";
+
+PwmGenerator::PwmGenerator(QWidget *parent)
+    : QWidget(parent)
+    , m_channel(std::make_shared<PwmChannel>())
+    , m_runStats(std::make_shared<RunStats>())
+    , m_job(-1)
+    , m_starting(false)
+    , m_startGeneration(0)
+{
+    setupUI();
+
+    m_statsTimer = new QTimer(this);
+    connect(m_statsTimer, &QTimer::timeout, this, &PwmGenerator::refreshStats);
+}
+
+PwmGenerator::~PwmGenerator()
+{
+    stopGenerator();
+
+    // 在 I/O 线程中关闭通道；lambda 持有 shared_ptr，通道在关闭后才释放
+    std::shared_ptr<PwmChannel> channel = m_channel;
+    BoardIo::instance()->call([channel]() {
+        channel->close();
+        return true;
+    });
+}
+
+void PwmGenerator::setupUI()
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(10, 10, 10, 10);
+    layout->setSpacing(12);
+
+    QString labelStyle = "font-size: 14px; color: #333;";
+    QString inputStyle = "font-size: 14px; padding: 4px;";
+
+    QGridLayout *grid = new QGridLayout();
+    grid->setHorizontalSpacing(15);
+    grid->setVerticalSpacing(10);
+
+    // 波形类型
+    QLabel *profileLabel = new QLabel("波形", this);
+    profileLabel->setStyleSheet(labelStyle);
+    m_profileCombo = new QComboBox(this);
+    m_profileCombo->addItem("扫频", SweepProfile);
+    m_profileCombo->addItem("阶跃", StepProfile);
+    m_profileCombo->addItem("斜坡", RampProfile);
+    m_profileCombo->setStyleSheet(inputStyle);
+
+    // 频率范围
+    QLabel *freqLabel = new QLabel("频率 (Hz)", this);
+    freqLabel->setStyleSheet(labelStyle);
+    m_startFreqSpin = new QDoubleSpinBox(this);
+    m_startFreqSpin->setRange(1.0, 1000000.0);
+    m_startFreqSpin->setDecimals(1);
+    m_startFreqSpin->setValue(1000.0);
+    m_startFreqSpin->setStyleSheet(inputStyle);
+    m_endFreqSpin = new QDoubleSpinBox(this);
+    m_endFreqSpin->setRange(1.0, 1000000.0);
+    m_endFreqSpin->setDecimals(1);
+    m_endFreqSpin->setValue(5000.0);
+    m_endFreqSpin->setStyleSheet(inputStyle);
+
+    // 占空比范围
+    QLabel *dutyLabel = new QLabel("占空比 (%)", this);
+    dutyLabel->setStyleSheet(labelStyle);
+    m_dutyStartSpin = new QSpinBox(this);
+    m_dutyStartSpin->setRange(0, 100);
+    m_dutyStartSpin->setValue(50);
+    m_dutyStartSpin->setStyleSheet(inputStyle);
+    m_dutyEndSpin = new QSpinBox(this);
+    m_dutyEndSpin->setRange(0, 100);
+    m_dutyEndSpin->setValue(100);
+    m_dutyEndSpin->setStyleSheet(inputStyle);
+
+    // 循环时长与阶跃级数
+    QLabel *durationLabel = new QLabel("周期 (秒) / 级数", this);
+    durationLabel->setStyleSheet(labelStyle);
+    m_durationSpin = new QDoubleSpinBox(this);
+    m_durationSpin->setRange(0.1, 600.0);
+    m_durationSpin->setDecimals(1);
+    m_durationSpin->setValue(5.0);
+    m_durationSpin->setStyleSheet(inputStyle);
+    m_stepsSpin = new QSpinBox(this);
+    m_stepsSpin->setRange(2, 100);
+    m_stepsSpin->setValue(5);
+    m_stepsSpin->setStyleSheet(inputStyle);
+
+    // 更新率
+    QLabel *rateLabel = new QLabel("更新率", this);
+    rateLabel->setStyleSheet(labelStyle);
+    m_rateCombo = new QComboBox(this);
+    const int rates[] = { 50, 100, 200, 500, 1000 };
+    for (int rate : rates) {
+        m_rateCombo->addItem(QString("%1 Hz").arg(rate), rate);
+    }
+    m_rateCombo->setCurrentIndex(2);
+    m_rateCombo->setStyleSheet(inputStyle);
+
+    grid->addWidget(profileLabel, 0, 0);
+    grid->addWidget(m_profileCombo, 0, 1, 1, 2);
+    grid->addWidget(freqLabel, 1, 0);
+    grid->addWidget(m_startFreqSpin, 1, 1);
+    grid->addWidget(m_endFreqSpin, 1, 2);
+    grid->addWidget(dutyLabel, 2, 0);
+    grid->addWidget(m_dutyStartSpin, 2, 1);
+    grid->addWidget(m_dutyEndSpin, 2, 2);
+    grid->addWidget(durationLabel, 3, 0);
+    grid->addWidget(m_durationSpin, 3, 1);
+    grid->addWidget(m_stepsSpin, 3, 2);
+    grid->addWidget(rateLabel, 4, 0);
+    grid->addWidget(m_rateCombo, 4, 1, 1, 2);
+
+    // 启动/停止按钮
+    m_startButton = new QPushButton("启动输出", this);
+    m_startButton->setFixedHeight(45);
+    m_startButton->setStyleSheet(
+        "QPushButton {"
+        "   background-color: #4CAF50;"
+        "   color: white;"
+        "   border: none;"
+        "   border-radius: 8px;"
+        "   font-size: 16px;"
+        "   font-weight: bold;"
+        "}"
+        "QPushButton:pressed {"
+        "   background-color: #388E3C;"
+        "}"
+    );
+    connect(m_startButton, &QPushButton::clicked, this, &PwmGenerator::onStartStopClicked);
+
+    m_statusLabel = new QLabel("PWM3 未启动", this);
+    m_statusLabel->setAlignment(Qt::AlignCenter);
+    m_statusLabel->setStyleSheet("font-size: 14px; color: #666;");
+
+    m_statsLabel = new QLabel(this);
+    m_statsLabel->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    m_statsLabel->setStyleSheet("font-size: 13px; color: #333; background-color: #f5f5f5; border-radius: 8px; padding: 10px;");
+    m_statsLabel->setMinimumHeight(90);
+
+    layout->addLayout(grid);
+    layout->addWidget(m_startButton);
+    layout->addWidget(m_statusLabel);
+    layout->addWidget(m_statsLabel);
+    layout->addStretch();
+}
+
+PwmGenerator::Params PwmGenerator::currentParams() const
+{
+    Params params;
+    params.profile = static_cast<Profile>(m_profileCombo->currentData().toInt());
+    params.startHz = m_startFreqSpin->value();
+    params.endHz = m_endFreqSpin->value();
+    params.dutyStart = m_dutyStartSpin->value();
+    params.dutyEnd = m_dutyEndSpin->value();
+    params.durationSec = m_durationSpin->value();
+    params.steps = m_stepsSpin->value();
+    params.updateRateHz = m_rateCombo->currentData().toInt();
+    return params;
+}
+
+void PwmGenerator::evaluate(const Params &params, qint64 tNs, qint64 &periodNs, qint64 &dutyNs)
+{
+    qint64 cycleNs = qMax<qint64>(1, qint64(params.durationSec * 1e9));
+    double phase = double(tNs % cycleNs) / double(cycleNs);   // 0..1
+
+    double hz = params.startHz;
+    double duty = params.dutyStart;
+
+    switch (params.profile) {
+    case SweepProfile:
+        hz = params.startHz + (params.endHz - params.startHz) * phase;
+        break;
+    case StepProfile: {
+        int steps = qMax(2, params.steps);
+        int step = qMin(steps - 1, int(phase * steps));
+        duty = params.dutyStart + (params.dutyEnd - params.dutyStart) * step / double(steps - 1);
+        break;
+    }
+    case RampProfile:
+        duty = params.dutyStart + (params.dutyEnd - params.dutyStart) * phase;
+        break;
+    }
+
+    periodNs = qMax<qint64>(1, qint64(std::llround(1e9 / hz)));
+    dutyNs = qint64(std::llround(periodNs * duty / 100.0));
+}
+
+void PwmGenerator::onStartStopClicked()
+{
+    if (m_job >= 0 || m_starting) {
+        stopGenerator();
+    } else {
+        startGenerator();
+    }
+}
+
+void PwmGenerator::startGenerator()
+{
+    Params params = currentParams();
+
+    m_starting = true;
+    quint64 generation = ++m_startGeneration;
+    m_startButton->setText("停止输出");
+    m_statusLabel->setText("正在打开 PWM3...");
+
+    // 导出与打开通道可能阻塞，放到 I/O 线程中执行
+    std::shared_ptr<PwmChannel> channel = m_channel;
+    qint64 period0, duty0;
+    evaluate(params, 0, period0, duty0);
+    BoardIo::instance()->call([channel, period0, duty0]() {
+        if (!channel->isOpen()) {
+            int chip = PwmChannel::findChip(kPwm3Device);
+            if (chip < 0 || !channel->open(chip, 0)) {
+                return false;
+            }
+        }
+        return channel->apply(period0, duty0) && channel->setEnabled(true);
+    }, this, [this, params, generation](bool ok) {
+        if (generation != m_startGeneration || !m_starting || m_job >= 0) {
+            // 打开过程中已经点了停止（之后可能又重新启动），只有最近一次启动的结果有效
+            return;
+        }
+        m_starting = false;
+
+        if (!ok) {
+            m_statusLabel->setText("PWM3 打开失败，请检查 /sys/class/pwm 权限");
+            m_startButton->setText("启动输出");
+            return;
+        }
+
+        // 重置统计
+        std::shared_ptr<RunStats> stats = std::make_shared<RunStats>();
+        m_runStats = stats;
+        std::shared_ptr<PwmChannel> channel = m_channel;
+        qint64 startNs = PeriodicScheduler::nowNs();
+
+        // 每个节拍在调度线程中计算并写入；fd 常开，没有 open/close 与字符串分配
+        m_job = PeriodicScheduler::instance()->addJob("pwm3-generator",
+            1000000000LL / params.updateRateHz,
+            [channel, stats, params, startNs](qint64 deadlineNs, quint64 missed) {
+                qint64 periodNs, dutyNs;
+                evaluate(params, deadlineNs - startNs, periodNs, dutyNs);
+                bool written = channel->apply(periodNs, dutyNs);
+                qint64 errorNs = PeriodicScheduler::nowNs() - deadlineNs;
+
+                QMutexLocker locker(&stats->mutex);
+                stats->updates++;
+                stats->missed += missed;
+                if (!written) {
+                    stats->failures++;
+                }
+                stats->errorSumNs += errorNs;
+                stats->errorMaxNs = qMax(stats->errorMaxNs, errorNs);
+                stats->lastPeriodNs = periodNs;
+                stats->lastDutyNs = dutyNs;
+            });
+
+        m_statusLabel->setText(QString("PWM3 输出中（%1 Hz 更新）").arg(params.updateRateHz));
+        m_statsTimer->start(500);
+    });
+}
+
+void PwmGenerator::stopGenerator()
+{
+    m_starting = false;
+    ++m_startGeneration;
+
+    if (m_job >= 0) {
+        // 返回后调度线程不会再写通道
+        PeriodicScheduler::instance()->removeJob(m_job);
+        m_job = -1;
+        refreshStats();
+    }
+    m_statsTimer->stop();
+
+    std::shared_ptr<PwmChannel> channel = m_channel;
+    BoardIo::instance()->call([channel]() {
+        return channel->isOpen() ? channel->setEnabled(false) : true;
+    });
+
+    m_startButton->setText("启动输出");
+    m_statusLabel->setText("PWM3 已停止");
+}
+
+void PwmGenerator::refreshStats()
+{
+    if (m_job < 0) {
+        return;
+    }
+
+    PeriodicScheduler::JobStats job = PeriodicScheduler::instance()->stats(m_job);
+
+    quint64 updates, failures, missed;
+    qint64 errorSum, errorMax, period, duty;
+    {
+        QMutexLocker locker(&m_runStats->mutex);
+        updates = m_runStats->updates;
+        failures = m_runStats->failures;
+        missed = m_runStats->missed;
+        errorSum = m_runStats->errorSumNs;
+        errorMax = m_runStats->errorMaxNs;
+        period = m_runStats->lastPeriodNs;
+        duty = m_runStats->lastDutyNs;
+    }
+
+    double achievedHz = job.meanPeriodNs > 0 ? 1e9 / job.meanPeriodNs : 0.0;
+    double meanErrorUs = updates ? errorSum / double(updates) / 1000.0 : 0.0;
+
+    m_statsLabel->setText(QString(
+        "当前输出: %1 Hz, 占空比 %2%\n"
+        "实际更新率: %3 Hz (抖动 %4 us)\n"
+        "定时误差: 平均 %5 us, 最大 %6 us\n"
+        "更新 %7 次, 丢失节拍 %8, 写失败 %9")
+        .arg(period > 0 ? 1e9 / period : 0.0, 0, 'f', 1)
+        .arg(period > 0 ? 100.0 * duty / period : 0.0, 0, 'f', 1)
+        .arg(achievedHz, 0, 'f', 1)
+        .arg(job.jitterNs / 1000.0, 0, 'f', 1)
+        .arg(meanErrorUs, 0, 'f', 1)
+        .arg(errorMax / 1000.0, 0, 'f', 1)
+        .arg(updates)
+        .arg(missed)
+        .arg(failures));
+}
@@ -0,0 +1,89 @@
+#ifndef PWMGENERATOR_H
+#define PWMGENERATOR_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QTimer>
+#include <QMutex>
+#include <memory>
+
+class PwmChannel;
+
+// PWM3 波形发生器：扫频/阶跃/斜坡，由调度线程按固定更新率写入
+class PwmGenerator : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PwmGenerator(QWidget *parent = nullptr);
+    ~PwmGenerator();
+
+    enum Profile {
+        SweepProfile = 0,   // 频率线性扫描，占空比固定
+        StepProfile,        // 占空比分级跳变，频率固定
+        RampProfile         // 占空比线性斜坡，频率固定
+    };
+
+    struct Params {
+        Profile profile;
+        double startHz;
+        double endHz;
+        double dutyStart;   // 百分比
+        double dutyEnd;     // 百分比
+        double durationSec; // 一个循环的时长
+        int steps;          // 阶跃级数
+        int updateRateHz;
+    };
+
+    // 计算 t 时刻（相对开始，纳秒）的周期与占空比（纳秒），循环执行
+    static void evaluate(const Params &params, qint64 tNs, qint64 &periodNs, qint64 &dutyNs);
+
+private slots:
+    void onStartStopClicked();
+    void refreshStats();
+
+private:
+    void setupUI();
+    void startGenerator();
+    void stopGenerator();
+    Params currentParams() const;
+
+    // 调度线程写入、主线程读取的运行统计
+    struct RunStats {
+        QMutex mutex;
+        quint64 updates = 0;
+        quint64 failures = 0;
+        quint64 missed = 0;
+        qint64 errorSumNs = 0;
+        qint64 errorMaxNs = 0;
+        qint64 lastPeriodNs = 0;
+        qint64 lastDutyNs = 0;
+    };
+
+private:
+    QComboBox *m_profileCombo;
+    QDoubleSpinBox *m_startFreqSpin;
+    QDoubleSpinBox *m_endFreqSpin;
+    QSpinBox *m_dutyStartSpin;
+    QSpinBox *m_dutyEndSpin;
+    QDoubleSpinBox *m_durationSpin;
+    QSpinBox *m_stepsSpin;
+    QComboBox *m_rateCombo;
+    QPushButton *m_startButton;
+    QLabel *m_statusLabel;
+    QLabel *m_statsLabel;
+    QTimer *m_statsTimer;
+
+    // 通道在 BoardIo 线程中打开/关闭，运行时只由调度线程访问
+    std::shared_ptr<PwmChannel> m_channel;
+    std::shared_ptr<RunStats> m_runStats;
+    int m_job;
+    bool m_starting;
+    quint64 m_startGeneration;      // 每次启动/停止加一，旧的打开结果不再生效
+};
+
+#endif // PWMGENERATOR_H
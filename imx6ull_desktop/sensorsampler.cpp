@@ -0,0 +1,86 @@
+#include "sensorsampler.h"
+#include <QDebug>
+
+SensorSampler::SensorSampler(BoardClock *clock, QObject *parent)
+    : QObject(parent)
+    , m_clock(clock ? clock : BoardClock::instance())
+    , m_timer(nullptr)
+    , m_startNs(0)
+    , m_scale(0.0f)
+{
+    m_timer = m_clock->createTimer("adc-sampling", this);
+
+    // 直接在定时器线程中处理节拍，采样时刻取截止时间
+    connect(m_timer, &BoardTimer::timeout, this, &SensorSampler::onTick, Qt::DirectConnection);
+}
+
+SensorSampler::~SensorSampler()
+{
+    stop();
+}
+
+void SensorSampler::setSource(Source source)
+{
+    m_source = source;
+}
+
+void SensorSampler::start(qint64 periodNs)
+{
+    if (!m_source && !m_rawAttr.isValid()) {
+        m_scaleAttr = BoardAttr("/sys/bus/iio/devices/iio:device0/in_voltage_scale", BoardIo::ReadOnly);
+        m_rawAttr = BoardAttr("/sys/bus/iio/devices/iio:device0/in_voltage1_raw", BoardIo::ReadOnly);
+    }
+
+    m_startNs = m_clock->nowNs();
+    m_timer->start(periodNs);
+
+    // 立即读取一次数据
+    onTick(m_startNs);
+}
+
+void SensorSampler::stop()
+{
+    // 返回后定时器线程不会再调用 onTick
+    m_timer->stop();
+}
+
+PeriodicScheduler::JobStats SensorSampler::timingStats() const
+{
+    return m_timer->stats();
+}
+
+void SensorSampler::onTick(qint64 deadlineNs)
+{
+    if (m_source) {
+        int raw = 0;
+        float scale = 0.0f;
+        if (m_source(raw, scale)) {
+            // 计算实际电压值（mV 转 V）
+            emit sampleReady(deadlineNs, raw, scale, (scale * raw) / 1000.0f);
+        } else {
+            emit sampleFailed(deadlineNs);
+        }
+        return;
+    }
+
+    // 只负责把读请求排入 I/O 队列，结果回到主线程处理
+    // scale 与原始值按顺序排入队列，原始值回调时 scale 已经更新
+    m_scaleAttr.readFloat(this, [this](bool ok, float scale) {
+        if (ok) {
+            m_scale = scale;
+        } else {
+            qDebug() << "Failed to read ADC scale";
+        }
+    });
+
+    m_rawAttr.readInt(this, [this, deadlineNs](bool ok, int raw) {
+        if (ok && m_scale > 0.0f) {
+            emit sampleReady(deadlineNs, raw, m_scale, (m_scale * raw) / 1000.0f);
+        } else {
+            if (!ok) {
+                qDebug() << "Failed to read ADC raw value";
+            }
+            emit sampleFailed(deadlineNs);
+        }
+    });
+}
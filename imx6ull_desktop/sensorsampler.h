@@ -0,0 +1,51 @@
+#ifndef SENSORSAMPLER_H
+#define SENSORSAMPLER_H
+
+#include <QObject>
+#include <functional>
+#include "boardio.h"
+#include "boardclock.h"
+
+// ADC 采样管线：按时钟定时器采样，结果带上采样时刻
+class SensorSampler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 同步数据源：返回 false 表示读取失败（主机测试/仿真时注入）
+    typedef std::function<bool(int &raw, float &scale)> Source;
+
+    explicit SensorSampler(BoardClock *clock = nullptr, QObject *parent = nullptr);
+    ~SensorSampler();
+
+    // 不设置时从 IIO sysfs 异步读取
+    void setSource(Source source);
+
+    // 开始采样并立即采一次
+    void start(qint64 periodNs);
+    void stop();
+
+    qint64 startTimeNs() const { return m_startNs; }
+    PeriodicScheduler::JobStats timingStats() const;
+
+signals:
+    void sampleReady(qint64 sampleNs, int raw, float scale, float voltage);
+    void sampleFailed(qint64 sampleNs);
+
+private:
+    // 在定时器线程中执行，不能阻塞
+    void onTick(qint64 deadlineNs);
+
+private:
+    BoardClock *m_clock;
+    BoardTimer *m_timer;
+    Source m_source;
+    qint64 m_startNs;
+
+    // 默认数据源：IIO 节点只读，fd 由 BoardIo 缓存
+    BoardAttr m_scaleAttr;
+    BoardAttr m_rawAttr;
+    float m_scale;
+};
+
+#endif // SENSORSAMPLER_H
@@ -0,0 +1,168 @@
+#include "visualizerwidget.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QLinearGradient>
+#include <QMouseEvent>
+
+// 与 CD 封面同样大小，两者在同一位置切换显示
+static const int kWidgetSize = 280;
+static const int kStatusHeight = 18;
+
+VisualizerWidget::VisualizerWidget(SpectrumAnalyzer *analyzer, QWidget *parent)
+    : QWidget(parent)
+    , m_analyzer(analyzer)
+    , m_mode(SpectrumMode)
+{
+    setFixedSize(kWidgetSize, kWidgetSize);
+    setAttribute(Qt::WA_OpaquePaintEvent, false);
+    connect(m_analyzer, &SpectrumAnalyzer::frameReady, this, &VisualizerWidget::onFrameReady);
+}
+
+void VisualizerWidget::setMode(Mode mode)
+{
+    m_mode = mode;
+    update();
+}
+
+void VisualizerWidget::onFrameReady()
+{
+    // 只复制一份结果，绘制在下一次重绘时进行；隐藏时不重绘
+    m_frame = m_analyzer->frame();
+    if (isVisible()) {
+        update();
+    }
+}
+
+void VisualizerWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (rect().contains(event->pos())) {
+        emit clicked();
+    }
+    QWidget::mouseReleaseEvent(event);
+}
+
+void VisualizerWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(0, 0, 0, 60));
+    painter.drawRoundedRect(rect(), 16, 16);
+
+    QRectF area = QRectF(rect()).adjusted(16, 16, -16, -16 - kStatusHeight);
+    switch (m_mode) {
+    case SpectrumMode:
+        paintSpectrum(painter, area);
+        break;
+    case MeterMode:
+        paintMeters(painter, area);
+        break;
+    case ScopeMode:
+        paintScope(painter, area);
+        break;
+    }
+
+    // 当前质量等级与开销，便于在板子上观察降级情况
+    SpectrumAnalyzer::Stats stats = m_analyzer->stats();
+    QFont font = painter.font();
+    font.setPixelSize(11);
+    painter.setFont(font);
+    painter.setPen(QColor(255, 255, 255, 150));
+    QRectF statusRect(16, height() - 8 - kStatusHeight, width() - 32, kStatusHeight);
+    painter.drawText(statusRect, Qt::AlignCenter,
+                     QString("%1段 %2fps %3ms 跳帧%4")
+                     .arg(stats.bands).arg(stats.fps)
+                     .arg(stats.avgCostNs / 1e6, 0, 'f', 1)
+                     .arg(stats.skipped + stats.late));
+}
+
+void VisualizerWidget::paintSpectrum(QPainter &painter, const QRectF &area)
+{
+    int count = m_frame.bands.size();
+    if (count == 0) {
+        return;
+    }
+
+    // 柱子不需要抗锯齿，整数坐标填充最快
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    QLinearGradient gradient(area.bottomLeft(), area.topLeft());
+    gradient.setColorAt(0.0, QColor("#f093fb"));
+    gradient.setColorAt(1.0, QColor("#f5576c"));
+
+    qreal slot = area.width() / count;
+    qreal barWidth = qMax<qreal>(1.0, slot - 2);
+    for (int i = 0; i < count; ++i) {
+        qreal x = area.left() + i * slot + 1;
+        qreal h = m_frame.bands[i] * area.height();
+        painter.fillRect(QRectF(x, area.bottom() - h, barWidth, h), gradient);
+
+        qreal peakY = area.bottom() - m_frame.bandPeaks[i] * area.height();
+        painter.fillRect(QRectF(x, peakY - 2, barWidth, 2), QColor(255, 255, 255, 200));
+    }
+}
+
+void VisualizerWidget::paintMeters(QPainter &painter, const QRectF &area)
+{
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    // 左右声道各一根竖条：RMS 实心，瞬时峰值半透明，峰值保持为白线
+    qreal meterWidth = area.width() / 5;
+    const char *labels[2] = { "L", "R" };
+    for (int ch = 0; ch < 2; ++ch) {
+        qreal x = area.left() + meterWidth * (1 + ch * 2);
+        QRectF track(x, area.top(), meterWidth, area.height() - 16);
+        painter.fillRect(track, QColor(255, 255, 255, 30));
+
+        qreal peakH = m_frame.peak[ch] * track.height();
+        painter.fillRect(QRectF(x, track.bottom() - peakH, meterWidth, peakH), QColor(245, 87, 108, 110));
+        qreal rmsH = m_frame.rms[ch] * track.height();
+        painter.fillRect(QRectF(x, track.bottom() - rmsH, meterWidth, rmsH), QColor("#f5576c"));
+        qreal holdY = track.bottom() - m_frame.peakHold[ch] * track.height();
+        painter.fillRect(QRectF(x, holdY - 2, meterWidth, 2), Qt::white);
+
+        painter.setPen(Qt::white);
+        painter.drawText(QRectF(x, track.bottom(), meterWidth, 16), Qt::AlignCenter, labels[ch]);
+    }
+
+    // -6/-20/-40 dB 刻度（与分析器的 -60 ~ 0 dB 范围对应）
+    painter.setPen(QColor(255, 255, 255, 120));
+    QFont font = painter.font();
+    font.setPixelSize(10);
+    painter.setFont(font);
+    qreal trackHeight = area.height() - 16;
+    const int marks[3] = { -6, -20, -40 };
+    for (int db : marks) {
+        qreal y = area.top() + trackHeight * (-db / 60.0);
+        painter.drawLine(QPointF(area.left() + meterWidth * 0.6, y), QPointF(area.right() - meterWidth * 0.6, y));
+        painter.drawText(QRectF(area.left(), y - 7, meterWidth * 0.6, 14), Qt::AlignLeft | Qt::AlignVCenter,
+                         QString::number(db));
+    }
+}
+
+void VisualizerWidget::paintScope(QPainter &painter, const QRectF &area)
+{
+    int count = m_frame.scope.size();
+    if (count < 2) {
+        return;
+    }
+
+    painter.setPen(QPen(QColor(255, 255, 255, 60), 1));
+    painter.drawLine(QPointF(area.left(), area.center().y()), QPointF(area.right(), area.center().y()));
+
+    QPainterPath path;
+    qreal step = area.width() / (count - 1);
+    qreal half = area.height() / 2;
+    for (int i = 0; i < count; ++i) {
+        QPointF point(area.left() + i * step, area.center().y() - m_frame.scope[i] * half);
+        if (i == 0) {
+            path.moveTo(point);
+        } else {
+            path.lineTo(point);
+        }
+    }
+    painter.setPen(QPen(QColor("#f5576c"), 2));
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(path);
+}
@@ -0,0 +1,45 @@
+#ifndef VISUALIZERWIDGET_H
+#define VISUALIZERWIDGET_H
+
+#include <QWidget>
+#include "spectrumanalyzer.h"
+
+// 播放可视化：频谱柱、VU/峰值电平表、示波器三种视图
+// 数据来自 SpectrumAnalyzer 的工作线程，这里只负责绘制；点击切换视图
+class VisualizerWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        SpectrumMode = 0,
+        MeterMode,
+        ScopeMode
+    };
+
+    explicit VisualizerWidget(SpectrumAnalyzer *analyzer, QWidget *parent = nullptr);
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+signals:
+    void clicked();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private slots:
+    void onFrameReady();
+
+private:
+    void paintSpectrum(QPainter &painter, const QRectF &area);
+    void paintMeters(QPainter &painter, const QRectF &area);
+    void paintScope(QPainter &painter, const QRectF &area);
+
+    SpectrumAnalyzer *m_analyzer;
+    SpectrumAnalyzer::Frame m_frame;
+    Mode m_mode;
+};
+
+#endif // VISUALIZERWIDGET_H
@@ -0,0 +1,180 @@
+#include "waveformslider.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+
+static const int kSliderHeight = 36;
+// 没有概览时的细线
+static const int kGrooveHeight = 4;
+// 波形柱宽 2 像素，间隔 1 像素
+static const int kBarWidth = 2;
+static const int kBarStep = 3;
+// 播放位置的竖线
+static const int kCursorWidth = 2;
+
+WaveformSlider::WaveformSlider(QWidget *parent)
+    : QSlider(Qt::Horizontal, parent)
+    , m_cursorX(0)
+{
+    setFixedHeight(kSliderHeight);
+}
+
+void WaveformSlider::setOverview(const WaveformOverview &overview)
+{
+    m_overview = overview;
+    renderPixmaps();
+    update();
+}
+
+void WaveformSlider::clearOverview()
+{
+    if (m_overview.isEmpty()) {
+        return;
+    }
+    m_overview = WaveformOverview();
+    renderPixmaps();
+    update();
+}
+
+int WaveformSlider::cursorX() const
+{
+    qint64 range = qint64(maximum()) - minimum();
+    if (range <= 0) {
+        return 0;
+    }
+    return int((qint64(sliderPosition()) - minimum()) * width() / range);
+}
+
+int WaveformSlider::valueAt(int x) const
+{
+    qint64 range = qint64(maximum()) - minimum();
+    if (range <= 0 || width() <= 0) {
+        return minimum();
+    }
+    return minimum() + int(qint64(qBound(0, x, width())) * range / width());
+}
+
+void WaveformSlider::sliderChange(SliderChange change)
+{
+    // 进度每帧都在变，但多数时候还在同一个像素上：不重绘；
+    // 移动了也只重绘新旧位置之间的几列
+    if (change == SliderValueChange) {
+        int x = cursorX();
+        if (x != m_cursorX) {
+            int left = qMin(x, m_cursorX) - kCursorWidth;
+            int right = qMax(x, m_cursorX) + kCursorWidth;
+            m_cursorX = x;
+            update(QRect(left, 0, right - left, height()));
+        }
+        return;
+    }
+    QSlider::sliderChange(change);
+}
+
+void WaveformSlider::resizeEvent(QResizeEvent *event)
+{
+    QSlider::resizeEvent(event);
+    renderPixmaps();
+}
+
+void WaveformSlider::paintEvent(QPaintEvent *event)
+{
+    // 只贴缓存的图：位置左边取已播放的，右边取未播放的
+    QPainter painter(this);
+    QRect clip = event->rect();
+    m_cursorX = cursorX();
+
+    QRect played = clip.intersected(QRect(0, 0, m_cursorX, height()));
+    if (!played.isEmpty()) {
+        painter.drawPixmap(played.topLeft(), m_playedPixmap, played);
+    }
+    QRect remaining = clip.intersected(QRect(m_cursorX, 0, width() - m_cursorX, height()));
+    if (!remaining.isEmpty()) {
+        painter.drawPixmap(remaining.topLeft(), m_remainingPixmap, remaining);
+    }
+
+    if (maximum() > minimum()) {
+        painter.fillRect(QRect(m_cursorX - kCursorWidth / 2, 0, kCursorWidth, height()), Qt::white);
+    }
+}
+
+void WaveformSlider::renderPixmaps()
+{
+    if (width() <= 0 || height() <= 0) {
+        return;
+    }
+    m_playedPixmap = QPixmap(size());
+    m_remainingPixmap = QPixmap(size());
+    renderWave(m_playedPixmap, QColor(255, 255, 255));
+    renderWave(m_remainingPixmap, QColor(255, 255, 255, 80));
+}
+
+void WaveformSlider::renderWave(QPixmap &pixmap, const QColor &color) const
+{
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    int w = pixmap.width();
+    int mid = pixmap.height() / 2;
+
+    if (m_overview.isEmpty()) {
+        painter.fillRect(QRect(0, mid - kGrooveHeight / 2, w, kGrooveHeight), color);
+        return;
+    }
+
+    // 按整首曲目的最大峰值归一化，安静的曲目也占满高度；
+    // 均方根为实心柱，峰值在其上下画成半透明
+    QColor peakColor = color;
+    peakColor.setAlphaF(color.alphaF() * 0.45);
+    double scale = double(mid - 1) / qMax(1, m_overview.maxPeak());
+    int count = m_overview.size();
+    for (int x = 0; x + kBarWidth <= w; x += kBarStep) {
+        int from = x * count / w;
+        int to = qMax(from + 1, qMin(x + kBarStep, w) * count / w);
+        int peak = 0;
+        int rms = 0;
+        for (int i = from; i < to && i < count; ++i) {
+            peak = qMax(peak, m_overview.peak(i));
+            rms = qMax(rms, m_overview.rms(i));
+        }
+        int peakHalf = qMax(1, int(peak * scale + 0.5));
+        int rmsHalf = qMin(peakHalf, qMax(1, int(rms * scale + 0.5)));
+        painter.fillRect(QRect(x, mid - rmsHalf, kBarWidth, rmsHalf * 2), color);
+        if (peakHalf > rmsHalf) {
+            painter.fillRect(QRect(x, mid - peakHalf, kBarWidth, peakHalf - rmsHalf), peakColor);
+            painter.fillRect(QRect(x, mid + rmsHalf, kBarWidth, peakHalf - rmsHalf), peakColor);
+        }
+    }
+}
+
+void WaveformSlider::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || maximum() <= minimum()) {
+        event->ignore();
+        return;
+    }
+    // 与 QSlider 点击槽只翻页不同：直接跳到按下的位置并开始拖动
+    setSliderDown(true);
+    setSliderPosition(valueAt(event->x()));
+    event->accept();
+}
+
+void WaveformSlider::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!isSliderDown()) {
+        event->ignore();
+        return;
+    }
+    setSliderPosition(valueAt(event->x()));
+    event->accept();
+}
+
+void WaveformSlider::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || !isSliderDown()) {
+        event->ignore();
+        return;
+    }
+    setSliderPosition(valueAt(event->x()));
+    setSliderDown(false);
+    event->accept();
+}
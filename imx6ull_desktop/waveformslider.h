@@ -0,0 +1,43 @@
+#ifndef WAVEFORMSLIDER_H
+#define WAVEFORMSLIDER_H
+
+#include <QSlider>
+#include <QPixmap>
+#include "waveformoverview.h"
+
+// 播放进度条：以曲目的波形概览为背景，已播放部分高亮
+// 波形只在设置概览或改变大小时画进两张缓存的图（已播放/未播放），重绘时按播放位置
+// 各贴一部分；位置变化不到一个像素时不重绘，重绘也只限于新旧位置之间的几列。
+// 没有概览时（尚未分析、网络流）画一条细线。点击或拖动直接跳到对应位置
+class WaveformSlider : public QSlider
+{
+    Q_OBJECT
+
+public:
+    explicit WaveformSlider(QWidget *parent = nullptr);
+
+    void setOverview(const WaveformOverview &overview);
+    void clearOverview();
+    bool hasOverview() const { return !m_overview.isEmpty(); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void sliderChange(SliderChange change) override;
+
+private:
+    void renderPixmaps();
+    void renderWave(QPixmap &pixmap, const QColor &color) const;
+    int cursorX() const;
+    int valueAt(int x) const;
+
+    WaveformOverview m_overview;
+    QPixmap m_playedPixmap;
+    QPixmap m_remainingPixmap;
+    int m_cursorX;                  // 上次绘制的播放位置
+};
+
+#endif // WAVEFORMSLIDER_H
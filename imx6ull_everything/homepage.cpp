@@ -1,4 +1,5 @@
 #include "homepage.h"
+#include "beeper.h"
 #include <QDebug>
 
 HomePage::HomePage(QWidget *parent)
@@ -107,6 +108,7 @@ void HomePage::onButtonClicked()
     if (button) {
         int pageIndex = button->property("pageIndex").toInt();
         qDebug() << "Function button clicked, page index:" << pageIndex;
+        Beeper::instance()->click();
         emit functionButtonClicked(pageIndex);
     }
 }
@@ -31,6 +31,9 @@ HEADERS += \
 FORMS += \
     mainwindow.ui
 
+# 板级 I/O 公共库（sysfs/设备节点异步访问）
+include(../boardio/boardio.pri)
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -1,8 +1,11 @@
 #include "ledpage.h"
+#include "beeper.h"
 #include <QDebug>
 
 LedPage::LedPage(QWidget *parent)
     : BasePage(parent)
+    , ledTrigger("/sys/class/leds/red/trigger")
+    , ledBrightness("/sys/devices/platform/dtsleds/leds/red/brightness")
 {
     setupUI();
     qDebug() << "LedPage created (lazy loading)";
@@ -48,14 +51,19 @@ void LedPage::setupUI()
         "QPushButton:pressed { background-color: #229954; }"
     );
     connect(ledOnButton, &QPushButton::clicked, this, [this]() {
-        statusLabel->setText("LED 状态: 开启 ✓");
-        statusLabel->setStyleSheet(
-            "font-size: 18px; padding: 15px; "
-            "background-color: #2ecc71; color: white; "
-            "border-radius: 8px; font-weight: bold;"
-        );
-        // TODO: 实际的LED控制代码
-        qDebug() << "LED ON";
+        ledBrightness.write(1, this, [this](bool ok) {
+            if (!ok) {
+                showFailure();
+                return;
+            }
+            statusLabel->setText("LED 状态: 开启 ✓");
+            statusLabel->setStyleSheet(
+                "font-size: 18px; padding: 15px; "
+                "background-color: #2ecc71; color: white; "
+                "border-radius: 8px; font-weight: bold;"
+            );
+            qDebug() << "LED ON";
+        });
     });
     layout->addWidget(ledOnButton);
 
@@ -71,14 +79,19 @@ void LedPage::setupUI()
         "QPushButton:pressed { background-color: #a93226; }"
     );
     connect(ledOffButton, &QPushButton::clicked, this, [this]() {
-        statusLabel->setText("LED 状态: 关闭 ✗");
-        statusLabel->setStyleSheet(
-            "font-size: 18px; padding: 15px; "
-            "background-color: #95a5a6; color: white; "
-            "border-radius: 8px; font-weight: bold;"
-        );
-        // TODO: 实际的LED控制代码
-        qDebug() << "LED OFF";
+        ledBrightness.write(0, this, [this](bool ok) {
+            if (!ok) {
+                showFailure();
+                return;
+            }
+            statusLabel->setText("LED 状态: 关闭 ✗");
+            statusLabel->setStyleSheet(
+                "font-size: 18px; padding: 15px; "
+                "background-color: #95a5a6; color: white; "
+                "border-radius: 8px; font-weight: bold;"
+            );
+            qDebug() << "LED OFF";
+        });
     });
     layout->addWidget(ledOffButton);
 
@@ -101,10 +114,23 @@ void LedPage::setupUI()
     setStyleSheet("background-color: white;");
 }
 
+void LedPage::showFailure()
+{
+    Beeper::instance()->alarm();
+    statusLabel->setText("LED 状态: 操作失败");
+    statusLabel->setStyleSheet(
+        "font-size: 18px; padding: 15px; "
+        "background-color: #e74c3c; color: white; "
+        "border-radius: 8px;"
+    );
+    qDebug() << "Failed to write LED brightness";
+}
+
 void LedPage::onPageActivated()
 {
     qDebug() << "LedPage activated";
-    // 页面激活时的初始化操作
+    // 页面激活时关闭心跳灯触发器，由本页面接管 LED
+    ledTrigger.write(QByteArray("none"));
 }
 
 void LedPage::onPageDeactivated()
@@ -2,6 +2,7 @@
 #define LEDPAGE_H
 
 #include "basepage.h"
+#include "boardio.h"
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QLabel>
@@ -22,11 +23,16 @@ public:
 
 private:
     void setupUI();
+    void showFailure();
 
     QPushButton *backButton;
     QPushButton *ledOnButton;
     QPushButton *ledOffButton;
     QLabel *statusLabel;
+
+    // LED 的 sysfs 属性（fd 由 BoardIo 缓存）
+    BoardAttr ledTrigger;
+    BoardAttr ledBrightness;
 };
 
 #endif // LEDPAGE_H